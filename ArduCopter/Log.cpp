@@ -352,6 +352,8 @@ struct PACKED log_Rate_Thread_Dt {
     float dtAvg;
     float dtMax;
     float dtMin;
+    uint16_t samples;
+    uint16_t overruns;
 };
 
 // Write a Guided mode position target
@@ -401,7 +403,7 @@ void Copter::Log_Write_Guided_Attitude_Target(ModeGuided::SubMode target_type, f
     logger.WriteBlock(&pkt, sizeof(pkt));
 }
 
-void Copter::Log_Write_Rate_Thread_Dt(float dt, float dtAvg, float dtMax, float dtMin)
+void Copter::Log_Write_Rate_Thread_Dt(float dt, float dtAvg, float dtMax, float dtMin, uint16_t samples, uint16_t overruns)
 {
 #if AP_INERTIALSENSOR_FAST_SAMPLE_WINDOW_ENABLED
     const log_Rate_Thread_Dt pkt {
@@ -410,7 +412,9 @@ void Copter::Log_Write_Rate_Thread_Dt(float dt, float dtAvg, float dtMax, float
         dt              : dt,
         dtAvg           : dtAvg,
         dtMax           : dtMax,
-        dtMin           : dtMin
+        dtMin           : dtMin,
+        samples         : samples,
+        overruns        : overruns
     };
     logger.WriteBlock(&pkt, sizeof(pkt));
 #endif
@@ -565,9 +569,11 @@ const struct LogStructure Copter::log_structure[] = {
 // @Field: dtAvg: current time delta average
 // @Field: dtMax: Max time delta since last log output
 // @Field: dtMin: Min time delta since last log output
+// @Field: Cnt: gyro samples consumed by the rate controller since last log output
+// @Field: Ovr: gyro samples dropped because the fast rate buffer was full since last log output
 
     { LOG_RATE_THREAD_DT_MSG, sizeof(log_Rate_Thread_Dt),
-      "RTDT", "Qffff", "TimeUS,dt,dtAvg,dtMax,dtMin", "sssss", "F----" , true },
+      "RTDT", "QffffHH", "TimeUS,dt,dtAvg,dtMax,dtMin,Cnt,Ovr", "sssss--", "F------" , true },
 
 };
 
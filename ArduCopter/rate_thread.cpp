@@ -15,6 +15,7 @@
 #include "Copter.h"
 #include <AP_InertialSensor/AP_InertialSensor_rate_config.h>
 #if AP_INERTIALSENSOR_FAST_SAMPLE_WINDOW_ENABLED
+#include <AP_InertialSensor/FastRateBuffer.h>
 
 #pragma GCC optimize("O2")
 
@@ -67,15 +68,17 @@
 
  Design:
 
- 1. Filtered gyro samples are (sub-sampled and) pushed into an ObjectBuffer from the INS backend.
+ 1. Filtered gyro samples are (sub-sampled and) pushed into a lock-free single producer, single
+    consumer ring (FastRateBuffer) from the INS backend. If the ring is full the sample is dropped
+    and counted as an overrun, reported in the RTDT log message.
  2. The pushed sample is published to the INS front-end so that the rest of the vehicle only
     sees published values that have been used by the rate controller. When the rate thread is not 
     in use the filtered samples are effectively sub-sampled at the main loop rate. The EKF is unaffected
     as it uses delta angles calculated from the raw gyro values. (It might be possible to avoid publishing
     from the rate thread by only updating _gyro_filtered when a value is pushed).
- 3. A notification is sent that a sample is available
+ 3. A notification is sent that a sample is available if the rate thread is waiting for one
  4. The rate thread is blocked waiting for a sample. When it receives a notification it:
-    4a. Runs the rate controller
+    4a. Runs the rate controller on every sample available in the ring
     4b. Pushes the new pwm values. Periodically at the main loop rate all of the SRV_Channels::push()
         functionality is run as well.
  5. The rcout dshot thread is blocked waiting for a new pwm value. When it is signalled by the
@@ -185,6 +188,8 @@ void Copter::rate_controller_thread()
     uint32_t last_rate_increase_ms = 0;
 #if HAL_LOGGING_ENABLED
     uint32_t last_rtdt_log_ms = now_ms;
+    uint32_t rtdt_samples = 0;
+    uint32_t last_rtdt_overruns = ins.get_fast_rate_buffer_overruns();
 #endif
     uint32_t last_notch_sample_ms = now_ms;
     bool was_using_rate_thread = false;
@@ -231,9 +236,11 @@ void Copter::rate_controller_thread()
         }
         ins.set_rate_decimation(rate_decimation);
 
-        // wait for an IMU sample
-        Vector3f gyro;
-        if (!ins.get_next_gyro_sample(gyro)) {
+        // wait for an IMU sample and take any others that have arrived
+        // since, so that we catch up in one pass if we have fallen behind
+        Vector3f gyro[AP_INERTIAL_SENSOR_RATE_LOOP_BUFFER_SIZE];
+        const uint8_t nsamples = ins.get_next_gyro_samples(gyro, ARRAY_SIZE(gyro));
+        if (nsamples == 0) {
             continue;   // go around again
         }
 
@@ -250,7 +257,7 @@ void Copter::rate_controller_thread()
         last_run_us = now_us;
 
         // check if we are falling behind
-        if (ins.get_num_gyro_samples() > 2) {
+        if (nsamples > 3) {
             running_slow++;
         } else if (running_slow > 0) {
             running_slow--;
@@ -262,7 +269,10 @@ void Copter::rate_controller_thread()
         // run the rate controller on all available samples
         // it is important not to drop samples otherwise the filtering will be fubar
         // there is no need to output to the motors more than once for every batch of samples
-        attitude_control->rate_controller_run_dt(gyro + ahrs.get_gyro_drift(), sensor_dt);
+        const Vector3f gyro_drift = ahrs.get_gyro_drift();
+        for (uint8_t i = 0; i < nsamples; i++) {
+            attitude_control->rate_controller_run_dt(gyro[i] + gyro_drift, sensor_dt);
+        }
 
 #ifdef RATE_LOOP_TIMING_DEBUG
         rate_controller_time_us += AP_HAL::micros() - rate_now_us;
@@ -286,8 +296,13 @@ void Copter::rate_controller_thread()
         min_dt = MIN(dt, min_dt);
 
 #if HAL_LOGGING_ENABLED
+        rtdt_samples += nsamples;
         if (now_ms - last_rtdt_log_ms >= 100) {    // 10 Hz
-            Log_Write_Rate_Thread_Dt(dt, sensor_dt, max_dt, min_dt);
+            const uint32_t overruns = ins.get_fast_rate_buffer_overruns();
+            Log_Write_Rate_Thread_Dt(dt, sensor_dt, max_dt, min_dt,
+                                     MIN(rtdt_samples, UINT16_MAX), MIN(overruns - last_rtdt_overruns, UINT16_MAX));
+            rtdt_samples = 0;
+            last_rtdt_overruns = overruns;
             max_dt = sensor_dt;
             min_dt = sensor_dt;
             last_rtdt_log_ms = now_ms;
@@ -1,5 +1,6 @@
 #include "DataFlashFileReader.h"
 #include <AP_Filesystem/AP_Filesystem.h>
+#include <AP_Logger/AP_Logger_LZ.h>
 
 #include <fcntl.h>
 #include <string.h>
@@ -10,6 +11,11 @@
 #include <time.h>
 #include <cinttypes>
 
+#if REPLAY_MMAP_ENABLED
+#include <stdlib.h>
+#include <sys/mman.h>
+#endif
+
 #ifndef PRIu64
 #define PRIu64 "llu"
 #endif
@@ -19,7 +25,30 @@ AP_LoggerFileReader::AP_LoggerFileReader()
 
 AP_LoggerFileReader::~AP_LoggerFileReader()
 {
+#if REPLAY_MMAP_ENABLED
+    if (map_base != nullptr) {
+        munmap(map_base, map_length);
+    }
+    free_index();
+#endif
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    delete[] compressed.comp_buf;
+    delete[] compressed.dec_buf;
+    if (compressed.blocks > 0) {
+        ::printf("Replay compressed log: %u blocks  ratio %.2f  %.1f us/block to compress\n",
+                 unsigned(compressed.blocks),
+                 compressed.comp_bytes > 0 ? double(compressed.raw_bytes) / compressed.comp_bytes : 0.0,
+                 double(compressed.cpu_us) / compressed.blocks);
+    }
+#endif
     ::printf("Replay counts: %" PRIu64 " bytes  %u entries\n", bytes_read, message_count);
+    if (start_micros != 0) {
+        const double log_seconds = get_log_seconds();
+        const double wall_seconds = get_wall_seconds();
+        ::printf("Replay throughput: %.3f log-seconds in %.3f wall-seconds (%.1f log-s/wall-s)\n",
+                 log_seconds, wall_seconds,
+                 wall_seconds > 0 ? log_seconds / wall_seconds : 0.0);
+    }
 }
 
 bool AP_LoggerFileReader::open_log(const char *logfile)
@@ -33,9 +62,41 @@ bool AP_LoggerFileReader::open_log(const char *logfile)
     if (AP::FS().stat(logfile, &st) == 0) {
         file_size = st.st_size;
     }
+#if REPLAY_MMAP_ENABLED
+    map_log(logfile);
+#endif
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    check_compressed();
+#endif
+    start_micros = AP_HAL::micros64();
     return true;
 }
 
+#if REPLAY_MMAP_ENABLED
+/*
+  map the log into memory. On failure (e.g. a multi-GB log on a 32 bit
+  system) messages are read with read() instead
+ */
+void AP_LoggerFileReader::map_log(const char *logfile)
+{
+    if (file_size == 0 || file_size > SIZE_MAX) {
+        return;
+    }
+    const int mfd = ::open(logfile, O_RDONLY|O_CLOEXEC);
+    if (mfd == -1) {
+        return;
+    }
+    void *p = mmap(nullptr, file_size, PROT_READ|PROT_WRITE, MAP_PRIVATE, mfd, 0);
+    ::close(mfd);
+    if (p == MAP_FAILED) {
+        return;
+    }
+    madvise(p, file_size, MADV_SEQUENTIAL);
+    map_base = (uint8_t *)p;
+    map_length = file_size;
+}
+#endif
+
 ssize_t AP_LoggerFileReader::read_input(void *buffer, const size_t count)
 {
     uint64_t ret = AP::FS().read(fd, buffer, count);
@@ -57,10 +118,78 @@ void AP_LoggerFileReader::get_packet_counts(uint64_t dest[])
     memcpy(dest, packet_counts, sizeof(packet_counts));
 }
 
+// true if messages of format f start with a uint64_t TimeUS field
+static bool format_has_time_us(const struct log_Format &f)
+{
+    return f.length >= 3 + sizeof(uint64_t) &&
+        f.format[0] == 'Q' &&
+        strncmp(f.labels, "TimeUS", 6) == 0 &&
+        (f.labels[6] == ',' || f.labels[6] == '\0');
+}
+
+void AP_LoggerFileReader::set_format(const struct log_Format &f)
+{
+    memcpy(&formats[f.type], &f, sizeof(formats[f.type]));
+    has_time_us[f.type] = format_has_time_us(f);
+}
+
+void AP_LoggerFileReader::update_time_us(const uint8_t *msg)
+{
+    if (!has_time_us[msg[2]]) {
+        return;
+    }
+    memcpy(&last_time_us, &msg[3], sizeof(last_time_us));
+    if (first_time_us == 0) {
+        first_time_us = last_time_us;
+    }
+}
+
+// pass a complete message to the handlers
+bool AP_LoggerFileReader::process_msg(uint8_t *msg)
+{
+    packet_counts[msg[2]]++;
+
+    if (msg[2] == LOG_FORMAT_MSG) {
+        struct log_Format f;
+        memcpy(&f, msg, sizeof(f));
+        set_format(f);
+
+        message_count++;
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+        if (plain_fd != -1) {
+            return write_plain_msg(msg, sizeof(f));
+        }
+#endif
+        return handle_log_format_msg(f);
+    }
+
+    update_time_us(msg);
+
+    message_count++;
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    if (plain_fd != -1) {
+        return write_plain_msg(msg, formats[msg[2]].length);
+    }
+#endif
+    return handle_msg(formats[msg[2]], msg);
+}
+
 bool AP_LoggerFileReader::update()
 {
+#if REPLAY_MMAP_ENABLED
+    if (map_base != nullptr) {
+        return update_mapped();
+    }
+#endif
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    if (compressed.active) {
+        return update_compressed();
+    }
+#endif
+
     uint8_t hdr[3];
     if (read_input(hdr, 3) != 3) {
+        end_micros = AP_HAL::micros64();
         return false;
     }
     if (hdr[0] != HEAD_BYTE1 || hdr[1] != HEAD_BYTE2) {
@@ -74,38 +203,515 @@ bool AP_LoggerFileReader::update()
         ::printf("line %u pkt 0x%02x t=%u\n", message_count, hdr[2], AP_HAL::millis());
     }
 #endif
-    packet_counts[hdr[2]]++;
 
+    uint8_t length;
     if (hdr[2] == LOG_FORMAT_MSG) {
+        length = sizeof(struct log_Format);
+    } else {
+        length = formats[hdr[2]].length;
+        if (length == 0) {
+            // can't just throw these away as the format specifies the
+            // number of bytes in the message
+            ::printf("No format defined for type (%d)\n", hdr[2]);
+            exit(1);
+        }
+    }
+
+    uint8_t msg[length];
+
+    memcpy(msg, hdr, 3);
+    if (read_input(&msg[3], length-3) != length-3) {
+        return false;
+    }
+
+    return process_msg(msg);
+}
+
+#if REPLAY_MMAP_ENABLED
+/*
+  same as update() but handing out messages in place from the mapping
+ */
+bool AP_LoggerFileReader::update_mapped()
+{
+    if (map_offset + 3 > map_length) {
+        end_micros = AP_HAL::micros64();
+        return false;
+    }
+    uint8_t *msg = &map_base[map_offset];
+    if (msg[0] != HEAD_BYTE1 || msg[1] != HEAD_BYTE2) {
+        printf("bad log header\n");
+        return false;
+    }
+
+    uint8_t length;
+    if (msg[2] == LOG_FORMAT_MSG) {
+        length = sizeof(struct log_Format);
+    } else {
+        length = formats[msg[2]].length;
+        if (length == 0) {
+            // can't just throw these away as the format specifies the
+            // number of bytes in the message
+            ::printf("No format defined for type (%d)\n", msg[2]);
+            exit(1);
+        }
+    }
+    if (map_offset + length > map_length) {
+        return false;
+    }
+    map_offset += length;
+    bytes_read = map_offset;
+
+    return process_msg(msg);
+}
+
+// true if the last field of messages of format f is a uint8_t instance
+static bool format_has_instance(const struct log_Format &f)
+{
+    const size_t nformat = strnlen(f.format, sizeof(f.format));
+    const size_t nlabels = strnlen(f.labels, sizeof(f.labels));
+    if (nformat == 0 || f.format[nformat-1] != 'B') {
+        return false;
+    }
+    return (nlabels == 1 && f.labels[0] == 'I') ||
+        (nlabels > 1 && strncmp(&f.labels[nlabels-2], ",I", 2) == 0);
+}
+
+// add an offset to a realloc'd array, growing it as needed
+bool AP_LoggerFileReader::append_offset(uint64_t *&array, uint32_t &len, uint32_t &size, uint64_t ofs)
+{
+    if (len == size) {
+        const uint32_t new_size = MAX(size * 2, 1024U);
+        void *p = ::realloc(array, new_size * sizeof(array[0]));
+        if (p == nullptr) {
+            return false;
+        }
+        array = (uint64_t *)p;
+        size = new_size;
+    }
+    array[len++] = ofs;
+    return true;
+}
+
+bool AP_LoggerFileReader::build_index()
+{
+    if (map_base == nullptr) {
+        return false;
+    }
+    if (index_built) {
+        return true;
+    }
+
+    index_counts = NEW_NOTHROW uint32_t[LOGREADER_MAX_FORMATS];
+    index_first_offset = NEW_NOTHROW uint64_t[LOGREADER_MAX_FORMATS];
+    if (index_counts == nullptr || index_first_offset == nullptr) {
+        free_index();
+        return false;
+    }
+    memset(index_counts, 0, sizeof(uint32_t)*LOGREADER_MAX_FORMATS);
+
+    // message lengths and timestamp presence as seen by the scan,
+    // independent of how far update() has got
+    uint8_t lengths[LOGREADER_MAX_FORMATS] {};
+    bool timed[LOGREADER_MAX_FORMATS] {};
+    uint32_t time_index_size = 0;
+    uint16_t fmt_offsets_size = 0;
+    uint64_t next_index_time_us = 0;
+
+    // state kept for seeking. seek_slot holds the slot in
+    // seek_latest of each type and instance, plus one
+    SeekState seek_states[LOGREADER_MAX_FORMATS] {};
+    bool has_instance[LOGREADER_MAX_FORMATS] {};
+    uint8_t seek_slot[LOGREADER_MAX_FORMATS][LOGREADER_SEEK_MAX_INSTANCES] {};
+    uint64_t seek_latest[LOGREADER_SEEK_MAX_LATEST];
+    uint16_t seek_latest_len = 0;
+
+    uint64_t ofs = 0;
+    while (ofs + 3 <= map_length) {
+        const uint8_t *msg = &map_base[ofs];
+        if (msg[0] != HEAD_BYTE1 || msg[1] != HEAD_BYTE2) {
+            break;
+        }
+        const uint8_t type = msg[2];
+        uint8_t length;
+        if (type == LOG_FORMAT_MSG) {
+            struct log_Format f;
+            if (ofs + sizeof(f) > map_length) {
+                break;
+            }
+            memcpy(&f, msg, sizeof(f));
+            lengths[f.type] = f.length;
+            timed[f.type] = format_has_time_us(f);
+            seek_states[f.type] = seek_state(f);
+            has_instance[f.type] = format_has_instance(f);
+            if (fmt_offsets_len == fmt_offsets_size) {
+                fmt_offsets_size += 64;
+                void *p = ::realloc(fmt_offsets, fmt_offsets_size * sizeof(fmt_offsets[0]));
+                if (p == nullptr) {
+                    free_index();
+                    return false;
+                }
+                fmt_offsets = (uint64_t *)p;
+            }
+            fmt_offsets[fmt_offsets_len++] = ofs;
+            length = sizeof(f);
+        } else {
+            length = lengths[type];
+            if (length == 0 || ofs + length > map_length) {
+                break;
+            }
+            if (timed[type]) {
+                uint64_t time_us;
+                memcpy(&time_us, &msg[3], sizeof(time_us));
+                if (time_us >= next_index_time_us) {
+                    if (time_index_len == time_index_size) {
+                        time_index_size = MAX(time_index_size * 2, 1024U);
+                        void *p = ::realloc(time_index, time_index_size * sizeof(time_index[0]));
+                        if (p == nullptr) {
+                            free_index();
+                            return false;
+                        }
+                        time_index = (time_index_entry *)p;
+                    }
+                    // copy the state from before this message
+                    const uint32_t seek_start = seek_offsets_len;
+                    for (uint16_t i=0; i<seek_latest_len; i++) {
+                        if (!append_offset(seek_offsets, seek_offsets_len, seek_offsets_size, seek_latest[i])) {
+                            free_index();
+                            return false;
+                        }
+                    }
+                    time_index[time_index_len++] = { time_us, ofs, seek_start, seek_latest_len };
+                    next_index_time_us = time_us + LOGREADER_TIME_INDEX_INTERVAL_US;
+                }
+            }
+            bool keep_all = seek_states[type] == SeekState::ALL;
+            if (seek_states[type] == SeekState::LATEST) {
+                const uint8_t instance = has_instance[type] ? msg[length-1] : 0;
+                uint8_t *slot = instance < LOGREADER_SEEK_MAX_INSTANCES ? &seek_slot[type][instance] : nullptr;
+                if (slot != nullptr && *slot == 0 && seek_latest_len < LOGREADER_SEEK_MAX_LATEST) {
+                    *slot = ++seek_latest_len;
+                }
+                if (slot != nullptr && *slot != 0) {
+                    seek_latest[*slot-1] = ofs;
+                } else {
+                    keep_all = true;
+                }
+            }
+            if (keep_all && !append_offset(seek_all_offsets, seek_all_len, seek_all_size, ofs)) {
+                free_index();
+                return false;
+            }
+        }
+        if (index_counts[type]++ == 0) {
+            index_first_offset[type] = ofs;
+        }
+        ofs += length;
+    }
+
+    index_built = true;
+    return true;
+}
+
+// release the index so it can be built again
+void AP_LoggerFileReader::free_index()
+{
+    ::free(time_index);
+    time_index = nullptr;
+    time_index_len = 0;
+    ::free(fmt_offsets);
+    fmt_offsets = nullptr;
+    fmt_offsets_len = 0;
+    delete[] index_counts;
+    index_counts = nullptr;
+    delete[] index_first_offset;
+    index_first_offset = nullptr;
+    ::free(seek_all_offsets);
+    seek_all_offsets = nullptr;
+    seek_all_len = 0;
+    seek_all_size = 0;
+    ::free(seek_offsets);
+    seek_offsets = nullptr;
+    seek_offsets_len = 0;
+    seek_offsets_size = 0;
+    index_built = false;
+}
+
+uint32_t AP_LoggerFileReader::get_indexed_count(uint8_t type) const
+{
+    if (!index_built || type >= LOGREADER_MAX_FORMATS) {
+        return 0;
+    }
+    return index_counts[type];
+}
+
+bool AP_LoggerFileReader::get_indexed_first_offset(uint8_t type, uint64_t &offset) const
+{
+    if (get_indexed_count(type) == 0) {
+        return false;
+    }
+    offset = index_first_offset[type];
+    return true;
+}
+
+bool AP_LoggerFileReader::get_indexed_format(uint8_t type, struct log_Format &f) const
+{
+    if (!index_built) {
+        return false;
+    }
+    for (uint16_t i=fmt_offsets_len; i>0; i--) {
+        memcpy(&f, &map_base[fmt_offsets[i-1]], sizeof(f));
+        if (f.type == type) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int offset_compare(const void *v1, const void *v2)
+{
+    const uint64_t o1 = *(const uint64_t *)v1;
+    const uint64_t o2 = *(const uint64_t *)v2;
+    return o1 < o2 ? -1 : (o1 > o2 ? 1 : 0);
+}
+
+bool AP_LoggerFileReader::seek_time_us(uint64_t time_us)
+{
+    if (!build_index() || time_index_len == 0) {
+        return false;
+    }
+
+    // binary search for the last entry at or before time_us
+    uint32_t lo = 0;
+    uint32_t hi = time_index_len;
+    while (hi - lo > 1) {
+        const uint32_t mid = (lo + hi) / 2;
+        if (time_index[mid].time_us <= time_us) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    const time_index_entry &entry = time_index[lo];
+    const uint64_t offset = entry.offset;
+
+    // messages are only parseable with the formats defined before
+    // them, so forget any defined later which we've already read
+    memset(formats, 0, sizeof(formats));
+    memset(has_time_us, 0, sizeof(has_time_us));
+
+    for (uint16_t i=0; i<fmt_offsets_len && fmt_offsets[i] < offset; i++) {
         struct log_Format f;
-        memcpy(&f, hdr, 3);
-        if (read_input(&f.type, sizeof(f)-3) != sizeof(f)-3) {
+        memcpy(&f, &map_base[fmt_offsets[i]], sizeof(f));
+        set_format(f);
+        if (!handle_log_format_msg(f)) {
             return false;
         }
-        memcpy(&formats[f.type], &f, sizeof(formats[f.type]));
+    }
 
-        message_count++;
-        return handle_log_format_msg(f);
+    // the latest state before offset, in log order
+    uint64_t latest[LOGREADER_SEEK_MAX_LATEST];
+    memcpy(latest, &seek_offsets[entry.seek_start], entry.seek_count * sizeof(latest[0]));
+    qsort(latest, entry.seek_count, sizeof(latest[0]), offset_compare);
+
+    // merge it with all the SeekState::ALL messages before offset.
+    // The index scan checked these messages are intact
+    uint32_t a = 0;
+    uint16_t l = 0;
+    while (true) {
+        const bool more_all = a < seek_all_len && seek_all_offsets[a] < offset;
+        uint64_t ofs;
+        if (more_all && (l == entry.seek_count || seek_all_offsets[a] < latest[l])) {
+            ofs = seek_all_offsets[a++];
+        } else if (l < entry.seek_count) {
+            ofs = latest[l++];
+        } else {
+            break;
+        }
+        uint8_t *msg = &map_base[ofs];
+        const struct log_Format &f = formats[msg[2]];
+        if (f.length == 0) {
+            return false;
+        }
+        if (!handle_msg_before_seek(f, msg)) {
+            return false;
+        }
     }
 
-    const struct log_Format &f = formats[hdr[2]];
-    if (f.length == 0) {
-        // can't just throw these away as the format specifies the
-        // number of bytes in the message
-        ::printf("No format defined for type (%d)\n", hdr[2]);
+    map_offset = offset;
+    bytes_read = offset;
+    return true;
+}
+#endif  // REPLAY_MMAP_ENABLED
+
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+bool AP_LoggerFileReader::write_plain_log(const char *outfile)
+{
+    plain_fd = AP::FS().open(outfile, O_WRONLY|O_CREAT|O_TRUNC);
+    if (plain_fd == -1) {
+        return false;
+    }
+    plain_write_failed = false;
+    while (update()) {
+    }
+    if (AP::FS().close(plain_fd) != 0) {
+        plain_write_failed = true;
+    }
+    plain_fd = -1;
+    return !plain_write_failed;
+}
+
+bool AP_LoggerFileReader::write_plain_msg(const uint8_t *msg, uint8_t length)
+{
+    if (AP::FS().write(plain_fd, msg, length) != length) {
+        plain_write_failed = true;
+        return false;
+    }
+    return true;
+}
+
+/*
+  a compressed log starts with the FMT message for LZB
+ */
+void AP_LoggerFileReader::check_compressed(void)
+{
+    struct log_Format f;
+    const ssize_t n = AP::FS().read(fd, &f, sizeof(f));
+    AP::FS().lseek(fd, 0, SEEK_SET);
+    if (n != sizeof(f) ||
+        f.head1 != HEAD_BYTE1 || f.head2 != HEAD_BYTE2 || f.msgid != LOG_FORMAT_MSG ||
+        strncmp(f.name, "LZB", sizeof(f.name)) != 0 ||
+        f.length != sizeof(log_Compressed_Block)) {
+        return;
+    }
+
+    compressed.comp_buf = NEW_NOTHROW uint8_t[AP_LOGGER_LZ_COMPRESSED_MAX(AP_LOGGER_LZ_BLOCK_MAX)];
+    // room for a block plus the partial message left over from the last block
+    compressed.dec_buf = NEW_NOTHROW uint8_t[AP_LOGGER_LZ_BLOCK_MAX + UINT8_MAX];
+    if (compressed.comp_buf == nullptr || compressed.dec_buf == nullptr) {
+        ::printf("Out of memory for compressed log\n");
         exit(1);
     }
+    compressed.active = true;
+    compressed.msg_type = f.type;
 
-    uint8_t msg[f.length];
+#if REPLAY_MMAP_ENABLED
+    // messages can't be handed out from the mapping
+    if (map_base != nullptr) {
+        munmap(map_base, map_length);
+        map_base = nullptr;
+        map_length = 0;
+    }
+#endif
+}
 
-    memcpy(msg, hdr, 3);
-    if (read_input(&msg[3], f.length-3) != f.length-3) {
-        return false;
+/*
+  same as update() but handing out messages from decompressed blocks
+ */
+bool AP_LoggerFileReader::update_compressed(void)
+{
+    while (true) {
+        const uint32_t avail = compressed.dec_len - compressed.dec_ofs;
+        uint8_t *msg = &compressed.dec_buf[compressed.dec_ofs];
+        if (avail >= 3) {
+            if (msg[0] != HEAD_BYTE1 || msg[1] != HEAD_BYTE2) {
+                printf("bad log header\n");
+                return false;
+            }
+            uint8_t length;
+            if (msg[2] == LOG_FORMAT_MSG) {
+                length = sizeof(struct log_Format);
+            } else {
+                length = formats[msg[2]].length;
+                if (length == 0) {
+                    // can't just throw these away as the format specifies the
+                    // number of bytes in the message
+                    ::printf("No format defined for type (%d)\n", msg[2]);
+                    exit(1);
+                }
+            }
+            if (avail >= length) {
+                compressed.dec_ofs += length;
+                return process_msg(msg);
+            }
+        }
+        if (!read_compressed_block()) {
+            end_micros = AP_HAL::micros64();
+            return false;
+        }
     }
+}
 
-    message_count++;
-    return handle_msg(f, msg);
+/*
+  read LZB messages from the file until a whole block has been
+  received, then decompress it onto the end of dec_buf
+ */
+bool AP_LoggerFileReader::read_compressed_block(void)
+{
+    // keep any partial message from the last block
+    memmove(compressed.dec_buf, &compressed.dec_buf[compressed.dec_ofs], compressed.dec_len - compressed.dec_ofs);
+    compressed.dec_len -= compressed.dec_ofs;
+    compressed.dec_ofs = 0;
+
+    while (true) {
+        uint8_t hdr[3];
+        if (read_input(hdr, 3) != 3) {
+            return false;
+        }
+        if (hdr[0] != HEAD_BYTE1 || hdr[1] != HEAD_BYTE2) {
+            printf("bad log header\n");
+            return false;
+        }
+        if (hdr[2] == LOG_FORMAT_MSG) {
+            // the uncompressed FMT for LZB at the start of the file
+            struct log_Format f;
+            memcpy(&f, hdr, 3);
+            if (read_input(&f.type, sizeof(f)-3) != sizeof(f)-3) {
+                return false;
+            }
+            continue;
+        }
+        if (hdr[2] != compressed.msg_type) {
+            printf("unexpected message type %u in compressed log\n", hdr[2]);
+            return false;
+        }
+        struct log_Compressed_Block pkt;
+        memcpy(&pkt, hdr, 3);
+        if (read_input(&pkt.time_us, sizeof(pkt)-3) != sizeof(pkt)-3) {
+            return false;
+        }
+        if (pkt.offset != compressed.comp_fill ||
+            pkt.length > sizeof(pkt.data) ||
+            pkt.comp_len > AP_LOGGER_LZ_COMPRESSED_MAX(AP_LOGGER_LZ_BLOCK_MAX) ||
+            pkt.raw_len > AP_LOGGER_LZ_BLOCK_MAX ||
+            pkt.offset + pkt.length > pkt.comp_len) {
+            printf("bad compressed block %u\n", pkt.seq);
+            return false;
+        }
+        memcpy(&compressed.comp_buf[pkt.offset], pkt.data, pkt.length);
+        compressed.comp_fill += pkt.length;
+        if (compressed.comp_fill < pkt.comp_len) {
+            continue;
+        }
+
+        uint8_t *dest = &compressed.dec_buf[compressed.dec_len];
+        if (pkt.method == 0 && pkt.comp_len == pkt.raw_len) {
+            memcpy(dest, compressed.comp_buf, pkt.raw_len);
+        } else if (pkt.method != 1 ||
+                   AP_Logger_LZ::decompress(compressed.comp_buf, pkt.comp_len, dest, pkt.raw_len) != pkt.raw_len) {
+            printf("corrupt compressed block %u\n", pkt.seq);
+            return false;
+        }
+        compressed.dec_len += pkt.raw_len;
+        compressed.comp_fill = 0;
+
+        compressed.blocks++;
+        compressed.raw_bytes += pkt.raw_len;
+        compressed.comp_bytes += pkt.comp_len;
+        compressed.cpu_us += pkt.cpu_us;
+        return true;
+    }
 }
+#endif  // AP_LOGGER_FILE_COMPRESSION_ENABLED
 
 float AP_LoggerFileReader::get_percent_read()
 {
@@ -114,3 +720,20 @@ float AP_LoggerFileReader::get_percent_read()
     }
     return (float)(bytes_read * 100.0 / file_size);
 }
+
+double AP_LoggerFileReader::get_log_seconds() const
+{
+    if (last_time_us <= first_time_us) {
+        return 0;
+    }
+    return (last_time_us - first_time_us) * 1.0e-6;
+}
+
+double AP_LoggerFileReader::get_wall_seconds() const
+{
+    if (start_micros == 0) {
+        return 0;
+    }
+    const uint64_t now = end_micros != 0 ? end_micros : AP_HAL::micros64();
+    return (now - start_micros) * 1.0e-6;
+}
@@ -4,6 +4,19 @@
 
 #define LOGREADER_MAX_FORMATS 255 // must be >= highest MESSAGE
 
+// read logs through a read-only memory mapping where available
+#ifndef REPLAY_MMAP_ENABLED
+#define REPLAY_MMAP_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
+// spacing in log time of entries in the seek index
+#define LOGREADER_TIME_INDEX_INTERVAL_US 100000
+
+// limits on the state kept at each seek index entry, messages past
+// them are kept like SeekState::ALL messages
+#define LOGREADER_SEEK_MAX_INSTANCES 16
+#define LOGREADER_SEEK_MAX_LATEST 255
+
 class AP_LoggerFileReader
 {
 public:
@@ -17,10 +30,73 @@ public:
     virtual bool handle_log_format_msg(const struct log_Format &f) = 0;
     virtual bool handle_msg(const struct log_Format &f, uint8_t *msg) = 0;
 
+    /*
+      which of the messages before a seek point seek_time_us() passes
+      to handle_msg_before_seek(). NONE messages are skipped, ALL
+      messages (e.g. parameters) are all passed in log order, and for
+      LATEST messages only the last one of each type and instance
+      before the seek point is passed. The instance is the last field
+      if it is a uint8_t labelled "I"
+     */
+    enum class SeekState : uint8_t {
+        NONE,
+        LATEST,
+        ALL,
+    };
+    virtual SeekState seek_state(const struct log_Format &f) const { return SeekState::NONE; }
+
+    // called by seek_time_us() for the messages before the seek point
+    // chosen by seek_state(), so that state such as parameters can be kept
+    virtual bool handle_msg_before_seek(const struct log_Format &f, uint8_t *msg) { return true; }
+
     void format_type(uint16_t type, char dest[5]);
     void get_packet_counts(uint64_t dest[]);
     float get_percent_read(); // Get percentage of log file read
 
+    // span of log time read so far and wall-clock time spent reading it, in seconds
+    double get_log_seconds() const;
+    double get_wall_seconds() const;
+
+#if REPLAY_MMAP_ENABLED
+    /*
+      scan the whole mapped log once, recording the number and first
+      offset of each message type, a sparse time index, and at each
+      time index entry the offsets of the state seek_time_us() needs
+      to start from there. Returns false if the log is not mapped
+     */
+    bool build_index();
+
+    // number of messages of a type in the log, 0 if not indexed
+    uint32_t get_indexed_count(uint8_t type) const;
+
+    // offset of the first message of a type, false if there is none
+    bool get_indexed_first_offset(uint8_t type, uint64_t &offset) const;
+
+    // last format defined for a type, false if there is none
+    bool get_indexed_format(uint8_t type, struct log_Format &f) const;
+
+    /*
+      move the read position to the indexed message at or at most
+      LOGREADER_TIME_INDEX_INTERVAL_US before time_us. The formats
+      are forgotten and those defined before that point are passed to
+      handle_log_format_msg() again, then the messages before it
+      chosen by seek_state() are passed to handle_msg_before_seek()
+      in log order. Only indexed messages are visited, so the cost
+      does not grow with the distance seeked. Builds the index if
+      needed. Compressed logs are not mapped so can't be indexed
+     */
+    bool seek_time_us(uint64_t time_us);
+#endif
+
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    /*
+      write every message in the log to outfile instead of passing
+      them to the handlers, turning a compressed log into a plain log
+      which other tools can read
+     */
+    bool write_plain_log(const char *outfile);
+#endif
+
 protected:
     int fd = -1;
 
@@ -29,10 +105,96 @@ protected:
 private:
     ssize_t read_input(void *buf, size_t count);
 
+    // pass a complete message to the handlers
+    bool process_msg(uint8_t *msg);
+
+    void set_format(const struct log_Format &f);
+    void update_time_us(const uint8_t *msg);
+
+#if REPLAY_MMAP_ENABLED
+    void map_log(const char *logfile);
+    bool update_mapped();
+    void free_index();
+    bool append_offset(uint64_t *&array, uint32_t &len, uint32_t &size, uint64_t ofs);
+
+    // log file mapped copy-on-write, so handlers are given a pointer
+    // straight into the mapping
+    uint8_t *map_base = nullptr;
+    uint64_t map_length = 0;
+    uint64_t map_offset = 0;
+
+    // index built by build_index()
+    struct time_index_entry {
+        uint64_t time_us;
+        uint64_t offset;
+        // LATEST state before offset, in seek_offsets
+        uint32_t seek_start;
+        uint16_t seek_count;
+    };
+    bool index_built = false;
+    time_index_entry *time_index = nullptr;
+    uint32_t time_index_len = 0;
+    uint64_t *fmt_offsets = nullptr;
+    uint16_t fmt_offsets_len = 0;
+    uint32_t *index_counts = nullptr;
+    uint64_t *index_first_offset = nullptr;
+
+    // offsets of every SeekState::ALL message
+    uint64_t *seek_all_offsets = nullptr;
+    uint32_t seek_all_len = 0;
+    uint32_t seek_all_size = 0;
+
+    // offsets of the latest SeekState::LATEST message of each type
+    // and instance, copied at each time index entry
+    uint64_t *seek_offsets = nullptr;
+    uint32_t seek_offsets_len = 0;
+    uint32_t seek_offsets_size = 0;
+#endif
+
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    // file write_plain_log() is writing to
+    int plain_fd = -1;
+    bool plain_write_failed;
+    bool write_plain_msg(const uint8_t *msg, uint8_t length);
+
+    /*
+      compressed logs (LOG_FILE_COMP) start with the FMT for LZB
+      messages, and everything after it is carried in LZB messages.
+      Blocks are decompressed into dec_buf and messages are handed
+      out from there
+     */
+    void check_compressed(void);
+    bool update_compressed(void);
+    bool read_compressed_block(void);
+
+    struct {
+        bool active;
+        uint8_t msg_type;
+        uint8_t *comp_buf;
+        uint16_t comp_fill;     // bytes of the current block received so far
+        uint8_t *dec_buf;
+        uint32_t dec_len;
+        uint32_t dec_ofs;
+        // totals for reporting
+        uint32_t blocks;
+        uint64_t raw_bytes;
+        uint64_t comp_bytes;
+        uint64_t cpu_us;
+    } compressed;
+#endif
+
     uint64_t bytes_read = 0;
     uint64_t file_size = 0; // Total size of the log file
     uint32_t message_count = 0;
-    uint64_t start_micros;
+    uint64_t start_micros = 0;
+    uint64_t end_micros = 0;
+
+    // first and last TimeUS seen, used for throughput reporting
+    uint64_t first_time_us = 0;
+    uint64_t last_time_us = 0;
 
     uint64_t packet_counts[LOGREADER_MAX_FORMATS] = {};
+
+    // true for message types whose first field is a uint64_t TimeUS
+    bool has_time_us[LOGREADER_MAX_FORMATS] {};
 };
@@ -308,7 +308,8 @@ bool LR_MsgHandler_PARM::set_parameter(const char *name, const float value)
 {
     const char *ignore_parms[] = {
         "LOG_FILE_BUFSIZE",
-        "LOG_DISARMED"
+        "LOG_DISARMED",
+        "LOG_FILE_COMP"
     };
     for (uint8_t i=0; i < ARRAY_SIZE(ignore_parms); i++) {
         if (strncmp(name, ignore_parms[i], AP_MAX_NAME_SIZE) == 0) {
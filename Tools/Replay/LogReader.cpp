@@ -147,6 +147,54 @@ bool LogReader::handle_msg(const struct log_Format &f, uint8_t *msg) {
     return true;
 }
 
+/*
+  messages before a seek point are not written out and the EKF is
+  not run for them, but the parameters and the sensor state the DAL
+  holds are kept so the EKF can start from there. The DAL sensor
+  messages each carry the whole state of their sensor, so only the
+  latest of each is needed. EKF events such as resets before the seek
+  point are dropped, as the EKF starts afresh there
+ */
+LogReader::SeekState LogReader::seek_state(const struct log_Format &f) const
+{
+    static const char *latest_names[] = {
+        "RFRH", "RFRN",
+        "RISH", "RISI",
+        "RASH", "RASI",
+        "RBRH", "RBRI",
+        "RRNH", "RRNI",
+        "RGPH", "RGPI", "RGPJ",
+        "RMGH", "RMGI",
+        "RBCH", "RBCI",
+        "RVOH",
+        NULL
+    };
+    char name[5] {};
+    strncpy(name, f.name, 4);
+    if (strcmp(name, "PARM") == 0) {
+        return SeekState::ALL;
+    }
+    if (in_list(name, latest_names)) {
+        return SeekState::LATEST;
+    }
+    return SeekState::NONE;
+}
+
+bool LogReader::handle_msg_before_seek(const struct log_Format &f, uint8_t *msg)
+{
+    LR_MsgHandler *p = msgparser[f.type];
+    if (p == NULL) {
+        return true;
+    }
+    if (strncmp(f.name, "PARM", sizeof(f.name)) == 0) {
+        AP::logger().WriteBlock(msg, f.length);
+    }
+
+    p->process_message(msg);
+
+    return true;
+}
+
 /*
   see if a user parameter is set
  */
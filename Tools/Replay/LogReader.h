@@ -17,6 +17,8 @@ public:
 
     bool handle_log_format_msg(const struct log_Format &f) override;
     bool handle_msg(const struct log_Format &f, uint8_t *msg) override;
+    SeekState seek_state(const struct log_Format &f) const override;
+    bool handle_msg_before_seek(const struct log_Format &f, uint8_t *msg) override;
 
     static bool in_list(const char *type, const char *list[]);
 
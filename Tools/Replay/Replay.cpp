@@ -18,6 +18,8 @@
 #include "LogReader.h"
 
 #include <stdio.h>
+#include <limits.h>
+#include <cinttypes>
 #include <AP_HAL/utility/getopt_cpp.h>
 
 #include <AP_Vehicle/AP_Vehicle.h>
@@ -31,6 +33,14 @@
 #include <AP_HAL_Linux/Scheduler.h>
 #endif
 
+#if REPLAY_JOBS_ENABLED
+#include <errno.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 #define streq(x, y) (!strcmp(x, y))
 
 static ReplayVehicle replayvehicle;
@@ -129,14 +139,27 @@ void Replay::usage(void)
     ::printf("\t--force-ekf2 force enable EKF2\n");
     ::printf("\t--force-ekf3 force enable EKF3\n");
     ::printf("\t--progress  show a progress bar during replay\n");
+#if REPLAY_JOBS_ENABLED
+    ::printf("\t--jobs N  replay up to N of the given log files at once\n");
+#endif
+#if REPLAY_MMAP_ENABLED
+    ::printf("\t--seek SECONDS  start replaying at this log TimeUS (in seconds); only parameters and sensor state are taken from earlier\n");
+    ::printf("\t--index  print the number of messages of each type and exit\n");
+#endif
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    ::printf("\t--decompress FILENAME  write a compressed log out as a plain log and exit\n");
+#endif
 }
 
 enum param_key : uint8_t {
     FORCE_EKF2 = 1,
     FORCE_EKF3,
+    SEEK,
+    INDEX,
+    DECOMPRESS,
 };
 
-void Replay::_parse_command_line(uint8_t argc, char * const argv[])
+void Replay::_parse_command_line(uint32_t argc, char * const argv[])
 {
     const struct GetOptLong::option options[] = {
         // name           has_arg flag   val
@@ -146,11 +169,15 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
         {"force-ekf2",      false,  0, param_key::FORCE_EKF2},
         {"force-ekf3",      false,  0, param_key::FORCE_EKF3},
         {"progress",        false,  0, 'P'},
+        {"jobs",            true,   0, 'j'},
+        {"seek",            true,   0, param_key::SEEK},
+        {"index",           false,  0, param_key::INDEX},
+        {"decompress",      true,   0, param_key::DECOMPRESS},
         {"help",            false,  0, 'h'},
         {0, false, 0, 0}
     };
 
-    GetOptLong gopt(argc, argv, "p:F:Ph", options);
+    GetOptLong gopt(argc, argv, "p:F:Pj:h", options);
 
     int opt;
     while ((opt = gopt.getoption()) != -1) {
@@ -185,6 +212,26 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
             show_progress = true;
             break;
 
+        case 'j':
+            num_jobs = constrain_int16(atoi(gopt.optarg), 1, UINT8_MAX);
+            break;
+
+#if REPLAY_MMAP_ENABLED
+        case param_key::SEEK:
+            seek_seconds = atof(gopt.optarg);
+            break;
+
+        case param_key::INDEX:
+            show_index = true;
+            break;
+#endif
+
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+        case param_key::DECOMPRESS:
+            plain_filename = gopt.optarg;
+            break;
+#endif
+
         case 'h':
         default:
             usage();
@@ -197,6 +244,8 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
 
     if (argc > 0) {
         filename = argv[0];
+        filenames = argv;
+        num_filenames = argc;
     }
 }
 
@@ -252,15 +301,51 @@ void Replay::setup()
 {
     ::printf("Starting\n");
 
-    uint8_t argc;
-    char * const *argv;
+    uint8_t hal_argc;
+    char * const *argv = nullptr;
 
-    hal.util->commandline_arguments(argc, argv);
+    hal.util->commandline_arguments(hal_argc, argv);
+
+    // the HAL reports argc as a uint8_t, which wraps for batches of
+    // more than 255 logs, so count the arguments up to argv's
+    // terminating nullptr instead
+    uint32_t argc = hal_argc;
+    if (argv != nullptr) {
+        while (argv[argc] != nullptr) {
+            argc++;
+        }
+    }
+    if (argc > INT_MAX) {
+        ::printf("Too many arguments\n");
+        exit(1);
+    }
 
     if (argc > 0) {
         _parse_command_line(argc, argv);
     }
 
+#if REPLAY_MMAP_ENABLED
+    if (show_index && num_filenames > 1) {
+        ::printf("Only one log file can be indexed at a time\n");
+        exit(1);
+    }
+#endif
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    if (plain_filename != nullptr && num_filenames > 1) {
+        ::printf("Only one log file can be decompressed at a time\n");
+        exit(1);
+    }
+#endif
+
+    if (num_filenames > 1) {
+#if REPLAY_JOBS_ENABLED
+        run_jobs();
+#else
+        ::printf("Only one log file can be replayed at a time\n");
+        exit(1);
+#endif
+    }
+
     _vehicle.setup();
 
     set_user_parameters();
@@ -292,20 +377,264 @@ void Replay::setup()
         exit(1);
     }
 
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    if (plain_filename != nullptr) {
+        if (!reader.write_plain_log(plain_filename)) {
+            ::printf("write(%s): %m\n", plain_filename);
+            exit(1);
+        }
+        ::printf("Wrote %s\n", plain_filename);
+        exit(0);
+    }
+#endif
+#if REPLAY_MMAP_ENABLED
+    if (show_index) {
+        print_index();
+        exit(0);
+    }
+    if (seek_seconds >= 0) {
+        if (!reader.seek_time_us(uint64_t(seek_seconds * 1.0e6))) {
+            ::printf("Unable to seek to %.3fs in %s (compressed logs can't be indexed, use --decompress first)\n", seek_seconds, filename);
+            exit(1);
+        }
+        ::printf("Replaying from %.3fs\n", seek_seconds);
+    }
+#endif
+
     if (replay_force_ekf2) {
         write_EKF_formats();
     }
 }
 
-void Replay::loop()
+static void replay_exit(int status)
 {
-    if (!reader.update()) {
 #if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
     // If we don't tear down the threads then they continue to access
     // global state during object destruction.
-        ((Linux::Scheduler*)hal.scheduler)->teardown();
+    ((Linux::Scheduler*)hal.scheduler)->teardown();
 #endif
-        exit(0);
+    exit(status);
+}
+
+#if REPLAY_JOBS_ENABLED
+/*
+  find the throughput line printed by a child replay's log reader
+ */
+static bool read_job_throughput(const char *dir, double &log_seconds, double &wall_seconds)
+{
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/replay.txt", dir);
+    FILE *f = ::fopen(path, "r");
+    if (f == nullptr) {
+        return false;
+    }
+    char line[200];
+    bool ret = false;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "Replay throughput: %lf log-seconds in %lf", &log_seconds, &wall_seconds) == 2) {
+            ret = true;
+        }
+    }
+    ::fclose(f);
+    return ret;
+}
+
+/*
+  replay each log file given on the command line, running up to
+  num_jobs at once.
+
+  Replay relies on singletons (the DAL, logger, parameters and
+  storage) so logs can't share a process. Instead each log is
+  replayed by a new copy of this program in its own directory under
+  replay_jobs/, making its output log identical to a serial replay of
+  that log on its own. Never returns.
+ */
+void Replay::run_jobs()
+{
+    struct replay_job {
+        char *logpath;
+        char dir[32];
+        pid_t pid;
+    };
+    replay_job *jobs = NEW_NOTHROW replay_job[num_filenames];
+    if (jobs == nullptr) {
+        ::printf("Out of memory\n");
+        replay_exit(1);
+    }
+    if (mkdir("replay_jobs", 0755) != 0 && errno != EEXIST) {
+        ::printf("mkdir(replay_jobs): %m\n");
+        replay_exit(1);
+    }
+    for (uint32_t i=0; i<num_filenames; i++) {
+        // children run in their own directory so need an absolute path
+        jobs[i].logpath = realpath(filenames[i], nullptr);
+        if (jobs[i].logpath == nullptr) {
+            ::printf("open(%s): %m\n", filenames[i]);
+            replay_exit(1);
+        }
+        snprintf(jobs[i].dir, sizeof(jobs[i].dir), "replay_jobs/%03u", unsigned(i));
+        if (mkdir(jobs[i].dir, 0755) != 0 && errno != EEXIST) {
+            ::printf("mkdir(%s): %m\n", jobs[i].dir);
+            replay_exit(1);
+        }
+        jobs[i].pid = -1;
+    }
+
+    /*
+      build the child command line. User parameters are passed in
+      list order reversed so the child rebuilds an identical list
+     */
+    uint16_t num_params = 0;
+    for (const user_parameter *u=user_parameters; u; u=u->next) {
+        num_params++;
+    }
+    const uint16_t max_args = 8 + 2*num_params;
+    const char **child_argv = NEW_NOTHROW const char *[max_args];
+    char (*param_args)[40] = NEW_NOTHROW char[MAX(num_params, 1U)][40];
+    if (child_argv == nullptr || param_args == nullptr) {
+        ::printf("Out of memory\n");
+        replay_exit(1);
+    }
+    uint16_t nargs = 0;
+    child_argv[nargs++] = "Replay";
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+    child_argv[nargs++] = "--log-directory=logs";
+    child_argv[nargs++] = "--storage-directory=.";
+    // remaining arguments are passed through to Replay
+    child_argv[nargs++] = "--";
+#endif
+    uint16_t pidx = num_params;
+    for (const user_parameter *u=user_parameters; u; u=u->next) {
+        pidx--;
+        snprintf(param_args[pidx], sizeof(param_args[pidx]), "--parm=%s=%.9g", u->name, double(u->value));
+    }
+    for (uint16_t p=0; p<num_params; p++) {
+        child_argv[nargs++] = param_args[p];
+    }
+    if (replay_force_ekf2) {
+        child_argv[nargs++] = "--force-ekf2";
+    }
+    if (replay_force_ekf3) {
+        child_argv[nargs++] = "--force-ekf3";
+    }
+#if REPLAY_MMAP_ENABLED
+    char seek_arg[40];
+    if (seek_seconds >= 0) {
+        snprintf(seek_arg, sizeof(seek_arg), "--seek=%.6f", seek_seconds);
+        child_argv[nargs++] = seek_arg;
+    }
+#endif
+    const uint16_t log_arg = nargs++;
+    child_argv[nargs] = nullptr;
+
+    ::printf("Replaying %u logs with %u jobs\n", unsigned(num_filenames), unsigned(num_jobs));
+
+    const uint64_t start_us = AP_HAL::micros64();
+    double total_log_seconds = 0;
+    uint32_t next = 0;
+    uint32_t running = 0;
+    uint32_t failed = 0;
+    while (next < num_filenames || running > 0) {
+        if (next < num_filenames && running < num_jobs) {
+            replay_job &job = jobs[next++];
+            child_argv[log_arg] = job.logpath;
+            job.pid = fork();
+            if (job.pid == 0) {
+                // only async-signal-safe calls between fork and exec
+                if (chdir(job.dir) != 0) {
+                    _exit(1);
+                }
+                const int fd = ::open("replay.txt", O_WRONLY|O_CREAT|O_TRUNC, 0644);
+                if (fd != -1) {
+                    dup2(fd, 1);
+                    dup2(fd, 2);
+                    ::close(fd);
+                }
+                execv("/proc/self/exe", (char * const *)child_argv);
+                _exit(1);
+            }
+            if (job.pid == -1) {
+                ::printf("fork: %m\n");
+                failed++;
+                continue;
+            }
+            running++;
+            continue;
+        }
+
+        int status;
+        const pid_t pid = waitpid(-1, &status, 0);
+        if (pid == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        for (uint32_t i=0; i<next; i++) {
+            replay_job &job = jobs[i];
+            if (job.pid != pid) {
+                continue;
+            }
+            job.pid = -1;
+            running--;
+            double log_seconds, wall_seconds;
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 ||
+                !read_job_throughput(job.dir, log_seconds, wall_seconds)) {
+                ::printf("%s: failed, see %s/replay.txt\n", filenames[i], job.dir);
+                failed++;
+                break;
+            }
+            total_log_seconds += log_seconds;
+            ::printf("%s: %.1f log-seconds in %.1f wall-seconds (%.1f log-s/wall-s) -> %s\n",
+                     filenames[i], log_seconds, wall_seconds,
+                     wall_seconds > 0 ? log_seconds / wall_seconds : 0.0,
+                     job.dir);
+            break;
+        }
+    }
+
+    const double wall_seconds = (AP_HAL::micros64() - start_us) * 1.0e-6;
+    ::printf("Replayed %u logs (%u failed): %.1f log-seconds in %.1f wall-seconds (%.1f log-s/wall-s)\n",
+             unsigned(num_filenames), unsigned(failed), total_log_seconds, wall_seconds,
+             wall_seconds > 0 ? total_log_seconds / wall_seconds : 0.0);
+
+    replay_exit(failed == 0 ? 0 : 1);
+}
+#endif  // REPLAY_JOBS_ENABLED
+
+#if REPLAY_MMAP_ENABLED
+/*
+  print the number of messages of each type in the log and where the
+  first one is, using the index rather than replaying the log
+ */
+void Replay::print_index()
+{
+    if (!reader.build_index()) {
+        ::printf("Unable to index %s (compressed logs can't be indexed, use --decompress first)\n", filename);
+        exit(1);
+    }
+    for (uint16_t type=0; type<LOGREADER_MAX_FORMATS; type++) {
+        uint64_t offset;
+        if (!reader.get_indexed_first_offset(type, offset)) {
+            continue;
+        }
+        char name[5] {};
+        struct log_Format f;
+        if (type == LOG_FORMAT_MSG) {
+            strncpy_noterm(name, "FMT", sizeof(name)-1);
+        } else if (reader.get_indexed_format(type, f)) {
+            strncpy_noterm(name, f.name, sizeof(name)-1);
+        }
+        ::printf("Index: %-4s %10u messages, first at offset %" PRIu64 "\n",
+                 name, unsigned(reader.get_indexed_count(type)), offset);
+    }
+}
+#endif
+
+void Replay::loop()
+{
+    if (!reader.update()) {
+        replay_exit(0);
     }
     
     // Display progress bar if enabled
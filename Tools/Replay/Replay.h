@@ -21,6 +21,11 @@
 
 #define AP_PARAM_VEHICLE_NAME replayvehicle
 
+// allow several logs to be replayed concurrently in child processes
+#ifndef REPLAY_JOBS_ENABLED
+#define REPLAY_JOBS_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
 struct user_parameter {
     struct user_parameter *next;
     char name[17];
@@ -99,16 +104,35 @@ private:
     const char *filename;
     ReplayVehicle &_vehicle;
 
+    // all log files given on the command line, and the maximum
+    // number to replay at once
+    char * const *filenames;
+    uint32_t num_filenames;
+    uint8_t num_jobs = 1;
+
     LogReader reader{_vehicle.log_structure, _vehicle.ekf2, _vehicle.ekf3};
     bool show_progress = false;  // Flag to determine if progress bar should be shown
     uint32_t last_progress_update = 0; // Last time progress was displayed
+#if REPLAY_MMAP_ENABLED
+    double seek_seconds = -1;  // log time to start replaying from, negative for the start
+    bool show_index = false;   // print the message counts and exit
+#endif
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    const char *plain_filename;  // write the log uncompressed to this file and exit
+#endif
 
-    void _parse_command_line(uint8_t argc, char * const argv[]);
+    void _parse_command_line(uint32_t argc, char * const argv[]);
 
     void set_user_parameters(void);
     bool parse_param_line(char *line, char **vname, float &value);
     void load_param_file(const char *filename);
     void usage();
+#if REPLAY_JOBS_ENABLED
+    void run_jobs();
+#endif
+#if REPLAY_MMAP_ENABLED
+    void print_index();
+#endif
 
     void Write_Format(const struct LogStructure &s);
     void write_EKF_formats(void);
@@ -7,7 +7,9 @@ AP_FLAKE8_CLEAN
 import copy
 import math
 import os
+import re
 import shutil
+import struct
 import tempfile
 import time
 import numpy
@@ -7120,6 +7122,763 @@ class AutoTestCopter(vehicle_test_suite.TestSuite):
         if ex is not None:
             raise ex
 
+    def decode_isbs(self, m):
+        '''return the samples packed into an ISBS message as a list of (x,y,z)'''
+        data = struct.pack('<96h', *(list(m.d0) + list(m.d1) + list(m.d2)))[:m.len]
+        samples = []
+        last = [0, 0, 0]
+        ofs = 0
+        while ofs < len(data):
+            sample = []
+            for axis in range(3):
+                z = 0
+                shift = 0
+                while True:
+                    b = data[ofs]
+                    ofs += 1
+                    z |= (b & 0x7f) << shift
+                    shift += 7
+                    if b < 0x80:
+                        break
+                delta = (z >> 1) ^ -(z & 1)
+                last[axis] += delta
+                sample.append(last[axis])
+            samples.append(tuple(sample))
+        return samples
+
+    def IMUStreaming(self):
+        '''check continuous IMU streaming produces gap-free ISBS data at the sensor rate, matching the raw samples'''
+        self.set_parameters({
+            "INS_LOG_BAT_MASK": 1,
+            "INS_LOG_BAT_OPT": 8,
+            "LOG_DISARMED": 1,
+            # log raw ACC and GYR alongside the stream to check the
+            # decoded samples against
+            "LOG_BITMASK": int(self.get_parameter("LOG_BITMASK")) | (1 << 19),
+        })
+        self.reboot_sitl()
+        self.delay_sim_time(20)
+
+        dfreader = self.dfreader_for_current_onboard_log()
+        next_seqno = {}
+        sample_counts = {}
+        rates = []
+        decoded = {}
+        raw = {}
+        while True:
+            m = dfreader.recv_match(type=['ISBS', 'ISBR', 'ACC', 'GYR'])
+            if m is None:
+                break
+            mtype = m.get_type()
+            if mtype == 'ISBR':
+                rates.append(m)
+                continue
+            if mtype == 'ACC':
+                raw.setdefault((0, m.I), []).append((m.SampleUS, (m.AccX, m.AccY, m.AccZ)))
+                continue
+            if mtype == 'GYR':
+                raw.setdefault((1, m.I), []).append((m.SampleUS, (m.GyrX, m.GyrY, m.GyrZ)))
+                continue
+            key = (m.type, m.instance)
+            if key in next_seqno and m.N != next_seqno[key]:
+                raise NotAchievedException("ISBS gap for %s: expected N=%u got %u" % (str(key), next_seqno[key], m.N))
+            next_seqno[key] = (m.N + 1) & 0xffff
+            samples = self.decode_isbs(m)
+            if len(samples) != m.cnt:
+                raise NotAchievedException("ISBS decoded %u samples, expected %u" % (len(samples), m.cnt))
+            sample_counts[key] = sample_counts.get(key, 0) + m.cnt
+            decoded.setdefault(key, []).append((m.SampleUS, m.mul, samples))
+
+        if len(sample_counts) != 2:
+            raise NotAchievedException("Expected accel and gyro streams, got %s" % str(sample_counts))
+        self.progress("Samples streamed: %s" % str(sample_counts))
+
+        # each message's samples must be the raw samples it covers,
+        # scaled by the multiplier and truncated as the sampler does
+        for key in sorted(decoded.keys()):
+            raw_samples = raw.get(key, [])
+            if len(raw_samples) < 2:
+                raise NotAchievedException("No raw samples logged for %s" % str(key))
+            raw_us = [r[0] for r in raw_samples]
+            dt = sorted([raw_us[i+1] - raw_us[i] for i in range(len(raw_us)-1)])[len(raw_us)//2]
+            checked = 0
+            skipped = 0
+            for (sample_us, mul, samples) in decoded[key]:
+                # SampleUS is interpolated across the sampler's block,
+                # so it finds the first raw sample to within one
+                i = int(numpy.searchsorted(raw_us, sample_us))
+                best = None
+                for start in range(max(i-1, 0), i+2):
+                    window = raw_samples[start:start+len(samples)]
+                    if len(window) != len(samples):
+                        continue
+                    err = max([abs(s[axis] - int(mul * r[1][axis]))
+                               for (s, r) in zip(samples, window) for axis in range(3)])
+                    if best is None or err < best:
+                        best = err
+                        best_window = window
+                if best is None:
+                    # runs past the end of the raw samples
+                    skipped += 1
+                    continue
+                if best > 1:
+                    window_us = [r[0] for r in best_window]
+                    if max([window_us[j+1] - window_us[j] for j in range(len(window_us)-1)] + [0]) > 1.5 * dt:
+                        # a raw message was lost, not a stream sample
+                        skipped += 1
+                        continue
+                    raise NotAchievedException("ISBS for %s at %u differs from the raw samples by %u" %
+                                               (str(key), sample_us, best))
+                checked += 1
+            self.progress("ISBS for %s: %u messages match the raw samples, %u skipped" % (str(key), checked, skipped))
+            if checked < 100 or skipped > 0.05 * (checked + skipped):
+                raise NotAchievedException("Too few ISBS messages checked for %s" % str(key))
+
+        # skip the first report for each stream, logging may have been starting
+        for m in rates[2:]:
+            self.progress("ISBR type=%u RReq=%.0f RAch=%.0f Drop=%u CR=%.2f" %
+                          (m.type, m.RReq, m.RAch, m.Drop, m.CR))
+            if m.RAch < 0.9 * m.RReq:
+                raise NotAchievedException("Streaming rate %.0f below requested %.0f" % (m.RAch, m.RReq))
+            if m.CR <= 1:
+                raise NotAchievedException("Expected compression, got ratio %.2f" % m.CR)
+
+    def FastRateBufferNoLoss(self):
+        '''check the fast rate thread consumes every gyro sample at 4kHz'''
+        self.set_parameters({
+            "AHRS_EKF_TYPE": 10,
+            "SIM_RATE_HZ": 4000,
+            "INS_FAST_SAMPLE": 1,
+            "INS_GYRO_RATE": 2,  # 4kHz
+            "FSTRATE_ENABLE": 3,  # fixed rate
+            "FSTRATE_DIV": 1,
+            "LOG_DISARMED": 0,
+        })
+        self.reboot_sitl()
+
+        self.takeoff(10, mode="ALT_HOLD")
+        self.delay_sim_time(20)
+        self.do_RTL()
+
+        dfreader = self.dfreader_for_current_onboard_log()
+        rtdt = []
+        while True:
+            m = dfreader.recv_match(type='RTDT')
+            if m is None:
+                break
+            rtdt.append(m)
+        if len(rtdt) < 100:
+            raise NotAchievedException("Expected RTDT messages, got %u" % len(rtdt))
+
+        # skip the first second of messages while the rate thread settles
+        rtdt = rtdt[10:]
+        overruns = sum([m.Ovr for m in rtdt])
+        if overruns != 0:
+            raise NotAchievedException("Fast rate buffer dropped %u samples" % overruns)
+
+        # samples consumed between the first and last message must match the sensor rate
+        sample_hz = 1.0 / rtdt[-1].dtAvg
+        if abs(sample_hz - 4000) > 1:
+            raise NotAchievedException("Rate thread running at %.0fHz, expected 4000Hz" % sample_hz)
+        elapsed = (rtdt[-1].TimeUS - rtdt[0].TimeUS) * 1.0e-6
+        consumed = sum([m.Cnt for m in rtdt[1:]])
+        expected = elapsed * sample_hz
+        self.progress("Consumed %u of %.0f samples in %.1fs" % (consumed, expected, elapsed))
+        if abs(consumed - expected) > 0.01 * expected:
+            raise NotAchievedException("Rate thread consumed %u samples, expected %.0f" % (consumed, expected))
+
+    def fetch_param_pck(self, since):
+        '''download @PARAM/param.pck with a since= query, returning the
+        header flags, snapshot, total parameter count and the names of
+        the parameters in the file'''
+        data = self.fetch_file_via_ftp("@PARAM/param.pck?since=%u" % since, binary=True)
+        (magic, num_params, total_params, flags, snapshot) = struct.unpack("<HHHHQ", data[0:16])
+        if magic != 0x671d:
+            raise NotAchievedException("Bad param.pck magic 0x%x" % magic)
+        data = data[16:]
+        type_len = {1: 1, 2: 2, 3: 4, 4: 4}
+        names = []
+        last_name = ""
+        while True:
+            # skip pad bytes
+            while len(data) > 0 and data[0] == 0:
+                data = data[1:]
+            if len(data) == 0:
+                break
+            ptype, plen = struct.unpack("<BB", data[0:2])
+            name_len = ((plen >> 4) & 0x0F) + 1
+            common_len = plen & 0x0F
+            name = last_name[0:common_len] + data[2:2+name_len].decode('utf-8')
+            names.append(name)
+            last_name = name
+            data = data[2+name_len+type_len[ptype & 0x0F]:]
+        if len(names) != num_params:
+            raise NotAchievedException("param.pck header says %u parameters, got %u" % (num_params, len(names)))
+        self.progress("since=%u: flags=%u snapshot=%u %u/%u parameters" %
+                      (since, flags, snapshot, num_params, total_params))
+        return (flags, snapshot, total_params, names)
+
+    def set_param_via_tuning_knob(self, before_change=None):
+        '''set ATC_ANG_RLL_P and ATC_ANG_PIT_P to 4.5 with the RC6 tuning
+        knob, which changes them with set() rather than PARAM_SET.
+        before_change is called once the knob is set up, before it is
+        turned'''
+        self.set_parameters({
+            "RC6_OPTION": 219,  # RC6 used for tuning
+            "TUNE": 1,  # 1 is angle roll/pitch P
+            "TUNE_MIN": 3,
+            "TUNE_MAX": 6,
+        })
+        self.set_rc(6, 1000)
+        self.delay_sim_time(2)
+        if before_change is not None:
+            before_change()
+        self.set_rc(6, 1500)
+        tstart = self.get_sim_time()
+        while abs(self.get_parameter("ATC_ANG_RLL_P", verbose=False) - 4.5) > 0.01:
+            if self.get_sim_time_cached() - tstart > 10:
+                raise NotAchievedException("Tuning knob did not change ATC_ANG_RLL_P")
+            self.delay_sim_time(0.5)
+
+    def ParamDeltaDownload(self):
+        '''check param.pck?since= only sends the parameters which changed'''
+        self.start_subtest("since=0 sends all parameters")
+        (flags, snapshot, total, names) = self.fetch_param_pck(0)
+        if flags & 1:
+            raise NotAchievedException("Delta flag set for since=0")
+        if len(names) != total:
+            raise NotAchievedException("Expected all %u parameters, got %u" % (total, len(names)))
+
+        self.start_subtest("changes from PARAM_SET and set() on the vehicle are sent")
+        self.set_parameter("DISARM_DELAY", 7)
+        self.set_param_via_tuning_knob()
+        (flags, snapshot2, total, names) = self.fetch_param_pck(snapshot)
+        if not flags & 1:
+            raise NotAchievedException("Delta flag not set")
+        for name in "DISARM_DELAY", "ATC_ANG_RLL_P", "ATC_ANG_PIT_P":
+            if name not in names:
+                raise NotAchievedException("%s not in delta %s" % (name, str(names)))
+        if len(names) >= total:
+            raise NotAchievedException("Delta contained all parameters")
+
+        self.start_subtest("unchanged parameters are not sent again")
+        (flags, snapshot3, total, names) = self.fetch_param_pck(snapshot2)
+        if not flags & 1:
+            raise NotAchievedException("Delta flag not set")
+        if "DISARM_DELAY" in names or "ATC_ANG_RLL_P" in names:
+            raise NotAchievedException("Unchanged parameters in delta %s" % str(names))
+
+        self.start_subtest("an unknown snapshot falls back to all parameters")
+        (flags, snapshot, total, names) = self.fetch_param_pck(snapshot3 ^ (0xFFFF << 32))
+        if flags & 1 or len(names) != total:
+            raise NotAchievedException("Expected a full download for an unknown snapshot")
+
+        self.start_subtest("a snapshot from before a reboot falls back to all parameters")
+        self.reboot_sitl()
+        (flags, snapshot, total, names) = self.fetch_param_pck(snapshot3)
+        if flags & 1 or len(names) != total:
+            raise NotAchievedException("Expected a full download after a reboot")
+
+    def LogHeaderCached(self):
+        '''check the log header is copied from the startup cache'''
+        self.set_parameters({
+            "LOG_DISARMED": 0,
+            "LOG_FILE_DSRMROT": 1,
+        })
+        self.reboot_sitl()
+        self.wait_ready_to_arm()
+
+        def log_header():
+            '''make a log, return its header time, header source and parameters'''
+            self.arm_vehicle()
+            self.delay_sim_time(5)
+            path = self.current_onboard_log_filepath()
+            self.disarm_vehicle()
+            self.LoggingFormatSanityChecks(path)
+
+            dfreader = self.dfreader_for_path(path)
+            header = None
+            params = {}
+            while True:
+                m = dfreader.recv_match(type=['MSG', 'PARM'])
+                if m is None:
+                    break
+                if m.get_type() == 'PARM':
+                    params[m.Name] = m.Value
+                    continue
+                match = re.match(r"Log header (\d+)ms(.*)", m.Message)
+                if match is not None:
+                    self.progress("%s: %s" % (path, m.Message))
+                    header = (int(match.group(1)), match.group(2))
+            if header is None:
+                raise NotAchievedException("No log header message in %s" % path)
+            return (header, params)
+
+        headers = []
+        for i in range(4):
+            (header, params) = log_header()
+            headers.append(header)
+
+        if any([source == "" for (ms, source) in headers]):
+            raise NotAchievedException("Log header was not written from the cache")
+        # parameters saved by AP_Stats may force the parameters to be
+        # captured again, but the formats are only built once
+        cached = [ms for (ms, source) in headers if source == " (cached)"]
+        if len(cached) == 0:
+            raise NotAchievedException("Log header cache was never reused")
+        if max(cached) > headers[0][0]:
+            raise NotAchievedException("Cached log header slower than building it (%ums > %ums)" %
+                                       (max(cached), headers[0][0]))
+
+        self.start_subtest("a parameter changed with set() reaches the next log")
+        self.set_param_via_tuning_knob(before_change=log_header)
+        ((ms, source), params) = log_header()
+        if source != " (cache rebuilt)":
+            raise NotAchievedException("Parameters not captured again after set() (%s)" % source)
+        if abs(params["ATC_ANG_RLL_P"] - 4.5) > 0.01:
+            raise NotAchievedException("Log has ATC_ANG_RLL_P=%f, want 4.5" % params["ATC_ANG_RLL_P"])
+
+    def storage_writeback_stats(self):
+        '''return the StorageManager write-back counters from @SYS/storage.txt'''
+        content = self.fetch_file_via_ftp("@SYS/storage.txt")
+        lines = content.split("\n")
+        if lines[0] != "StorageV1":
+            raise NotAchievedException("Expected StorageV1 as first line not (%s)" % lines[0])
+        stats = {}
+        for line in lines[1:]:
+            if line == "":
+                continue
+            (name, value) = line.split()
+            stats[name] = int(value)
+        return stats
+
+    def StorageWriteBack(self):
+        '''check a large mission upload is coalesced before reaching storage'''
+        items = []
+        for i in range(700):
+            items.append((mavutil.mavlink.MAV_CMD_NAV_WAYPOINT, (i % 50) * 10, (i // 50) * 10, 20 + i % 7))
+
+        def upload_counts():
+            '''upload the mission, returning the change in the counters'''
+            before = self.storage_writeback_stats()
+            self.upload_simple_relhome_mission(items)
+            after = self.storage_writeback_stats()
+            diff = {name: after[name] - before[name] for name in after}
+            self.progress("Storage writes for a %u item upload: %s" % (len(items), str(diff)))
+            return diff
+
+        self.start_subtest("writes to each command are combined")
+        diff = upload_counts()
+        if diff["write_calls"] < 3 * len(items):
+            raise NotAchievedException("Expected at least %u writes, got %u" % (3 * len(items), diff["write_calls"]))
+        # commands arrive one at a time, so even if the idle flush runs
+        # between every command, the writes to each one are combined
+        if diff["flushes"] * 2 > diff["write_calls"]:
+            raise NotAchievedException("%u flushes for %u writes" % (diff["flushes"], diff["write_calls"]))
+
+        self.start_subtest("uploading the same mission again changes nothing")
+        diff = upload_counts()
+        if diff["hal_bytes"] * 10 > diff["write_bytes"]:
+            raise NotAchievedException("%u of %u bytes written again" % (diff["hal_bytes"], diff["write_bytes"]))
+
+    def MAVLinkStreamPriority(self):
+        '''check high priority streams keep their rate on a saturated link'''
+        baud = 57600
+        self.set_parameters({
+            "SERIAL0_BAUD": baud // 1000,
+            "SIM_BAUDLIMIT_EN": 1,
+            "LOG_DISARMED": 1,
+        })
+        self.reboot_sitl()
+
+        def ap_message_id(name):
+            '''index of name in the ap_message enum.  Assumes the features
+            guarding the entries before it are enabled in SITL'''
+            path = os.path.join(self.rootdir(), "libraries", "GCS_MAVLink", "ap_message.h")
+            in_enum = False
+            i = 0
+            with open(path) as f:
+                for line in f:
+                    line = line.strip()
+                    if line.startswith("enum ap_message"):
+                        in_enum = True
+                    elif in_enum and line.startswith("MSG_"):
+                        if re.match(r"%s\b" % name, line):
+                            return i
+                        i += 1
+            raise NotAchievedException("%s not in ap_message.h" % name)
+
+        # the low priority streams on their own ask for more than the
+        # link can carry
+        streams = {
+            "ATTITUDE": ("MSG_ATTITUDE", "high", 20),
+            "RC_CHANNELS": ("MSG_RC_CHANNELS", "normal", 10),
+            "RAW_IMU": ("MSG_RAW_IMU", "low", 50),
+            "SCALED_IMU2": ("MSG_SCALED_IMU2", "low", 50),
+            "SERVO_OUTPUT_RAW": ("MSG_SERVO_OUTPUT_RAW", "low", 50),
+        }
+        for (name, (ap_name, priority, rate)) in streams.items():
+            self.set_message_rate_hz(name, rate)
+
+        # let the link model and the achieved rates settle
+        self.delay_sim_time(20)
+        self.drain_mav()
+        counts = {name: 0 for name in streams.keys()}
+        tstart = self.get_sim_time()
+        while self.get_sim_time_cached() - tstart < 30:
+            m = self.mav.recv_match(type=list(streams.keys()), blocking=True, timeout=0.1)
+            if m is not None:
+                counts[m.get_type()] += 1
+        duration = self.get_sim_time_cached() - tstart
+
+        received = {}
+        fraction = {"high": [], "normal": [], "low": []}
+        for (name, (ap_name, priority, rate)) in streams.items():
+            received[name] = counts[name] / duration
+            fraction[priority].append(received[name] / rate)
+            self.progress("%s (%s): requested %.1fHz received %.1fHz" % (name, priority, rate, received[name]))
+
+        self.start_subtest("high priority streams keep their rate")
+        if min(fraction["high"]) < 0.9:
+            raise NotAchievedException("High priority stream slowed to %.0f%% of its rate" % (100 * min(fraction["high"])))
+
+        self.start_subtest("low priority streams are shed first")
+        if max(fraction["low"]) > 0.9:
+            raise NotAchievedException("Low priority streams were not slowed")
+        if max(fraction["low"]) >= min(fraction["normal"]):
+            raise NotAchievedException("Low priority stream got %.0f%% of its rate, normal %.0f%%" %
+                                       (100 * max(fraction["low"]), 100 * min(fraction["normal"])))
+
+        self.start_subtest("MAVR records the achieved rates")
+        ids = {ap_message_id(ap_name): name for (name, (ap_name, priority, rate)) in streams.items()}
+        mavr = {}
+        dfreader = self.dfreader_for_current_onboard_log()
+        while True:
+            m = dfreader.recv_match(type='MAVR')
+            if m is None:
+                break
+            if m.chan == 0 and m.id in ids:
+                mavr[ids[m.id]] = m
+        for (name, (ap_name, priority, rate)) in streams.items():
+            if name not in mavr:
+                raise NotAchievedException("No MAVR for %s" % name)
+            m = mavr[name]
+            self.progress("MAVR %s: RReq=%.1f RAch=%.1f Skp=%u BW=%u" % (name, m.RReq, m.RAch, m.Skp, m.BW))
+            if abs(m.RReq - rate) > 0.1 * rate:
+                raise NotAchievedException("MAVR %s requested %.1fHz, want %.1fHz" % (name, m.RReq, rate))
+            if abs(m.RAch - received[name]) > 0.2 * rate:
+                raise NotAchievedException("MAVR %s achieved %.1fHz, received %.1fHz" % (name, m.RAch, received[name]))
+            if priority == "low" and m.Skp == 0:
+                raise NotAchievedException("MAVR %s shows no skipped messages" % name)
+            if m.BW > baud / 10:
+                raise NotAchievedException("MAVR link estimate %u above the link's %u bytes/s" % (m.BW, baud / 10))
+
+        self.reboot_sitl()
+
+    def MAVFTPConcurrentBursts(self):
+        '''check two burst reads share a throttled link and both arrive intact'''
+        baud = 57600
+        self.set_parameters({
+            "SERIAL0_BAUD": baud // 1000,
+            "SIM_BAUDLIMIT_EN": 1,
+        })
+        self.reboot_sitl()
+        link_bytes_per_second = baud / 10
+
+        # files in the SITL working directory, which the vehicle
+        # reads with relative paths
+        files = {}
+        for (session, size) in (0, 25000), (1, 37000):
+            filename = "ftp-burst-%u.bin" % session
+            content = os.urandom(size)
+            with open(filename, "wb") as f:
+                f.write(content)
+            files[session] = {
+                "filename": filename,
+                "content": content,
+                "received": bytearray(),
+                "first_packet": None,
+                "last_packet": None,
+                "last_request": None,
+            }
+
+        FTP_OP_TerminateSession = 1
+        FTP_OP_ResetSessions = 2
+        FTP_OP_OpenFileRO = 4
+        FTP_OP_BurstReadFile = 15
+        FTP_OP_Ack = 128
+        max_read = 239
+        seq = [0]
+
+        def send(session, opcode, offset=0, data=b"", size=None):
+            if size is None:
+                size = len(data)
+            payload = bytearray(251)
+            struct.pack_into("<HBBBBBBI", payload, 0, seq[0], session, opcode, size, 0, 0, 0, offset)
+            payload[12:12+len(data)] = data
+            seq[0] = (seq[0] + 1) % 65536
+            self.mav.mav.file_transfer_protocol_send(0, self.sysid_thismav(), 1, list(payload))
+
+        def decode(m):
+            '''returns (session, opcode, size, req_opcode, burst_complete, offset, data)'''
+            payload = bytes(m.payload)
+            (seqnum, session, opcode, size, req_opcode, complete, pad, offset) = struct.unpack_from("<HBBBBBBI", payload)
+            return (session, opcode, size, req_opcode, complete, offset, payload[12:12+size])
+
+        def request_reply(session, opcode, data=b""):
+            '''send a request and wait for its reply'''
+            send(session, opcode, data=data)
+            tstart = self.get_sim_time_cached()
+            while True:
+                if self.get_sim_time_cached() - tstart > 10:
+                    raise NotAchievedException("No reply to FTP opcode %u" % opcode)
+                m = self.mav.recv_match(type='FILE_TRANSFER_PROTOCOL', blocking=True, timeout=1)
+                if m is None:
+                    continue
+                reply = decode(m)
+                if reply[0] == session and reply[3] == opcode:
+                    return reply
+
+        def request_burst(session, now):
+            f = files[session]
+            send(session, FTP_OP_BurstReadFile, offset=len(f["received"]), size=max_read)
+            f["last_request"] = now
+
+        try:
+            request_reply(0, FTP_OP_ResetSessions)
+            for (session, f) in files.items():
+                reply = request_reply(session, FTP_OP_OpenFileRO, data=f["filename"].encode('ascii'))
+                if reply[1] != FTP_OP_Ack:
+                    raise NotAchievedException("Failed to open %s" % f["filename"])
+                size = struct.unpack("<I", reply[6][:4])[0]
+                if size != len(f["content"]):
+                    raise NotAchievedException("%s: size %u, want %u" % (f["filename"], size, len(f["content"])))
+
+            tstart = self.get_sim_time_cached()
+            for session in files.keys():
+                request_burst(session, tstart)
+            while True:
+                now = self.get_sim_time_cached()
+                if all([len(f["received"]) == len(f["content"]) for f in files.values()]):
+                    break
+                if now - tstart > 120:
+                    raise NotAchievedException("Burst reads did not complete")
+                # restart a burst which has stopped arriving
+                for (session, f) in files.items():
+                    if len(f["received"]) == len(f["content"]):
+                        continue
+                    last = max(f["last_request"], f["last_packet"] or 0)
+                    if now - last > 3:
+                        self.progress("Re-requesting session %u at %u" % (session, len(f["received"])))
+                        request_burst(session, now)
+                m = self.mav.recv_match(type='FILE_TRANSFER_PROTOCOL', blocking=True, timeout=1)
+                if m is None:
+                    continue
+                (session, opcode, size, req_opcode, complete, offset, data) = decode(m)
+                if req_opcode != FTP_OP_BurstReadFile or session not in files:
+                    continue
+                f = files[session]
+                if opcode == FTP_OP_Ack and offset == len(f["received"]):
+                    f["received"].extend(data)
+                    if f["first_packet"] is None:
+                        f["first_packet"] = now
+                    f["last_packet"] = now
+                if complete and len(f["received"]) < len(f["content"]):
+                    # a short burst or lost packets; carry on from the
+                    # first byte we don't have
+                    request_burst(session, now)
+            tend = self.get_sim_time_cached()
+        finally:
+            for session in files.keys():
+                send(session, FTP_OP_TerminateSession)
+            for f in files.values():
+                os.unlink(f["filename"])
+
+        for f in files.values():
+            if bytes(f["received"]) != f["content"]:
+                raise NotAchievedException("%s corrupted" % f["filename"])
+
+        # the bursts must have been sent at the same time, not one
+        # after the other
+        if files[0]["first_packet"] > files[1]["last_packet"] or files[1]["first_packet"] > files[0]["last_packet"]:
+            raise NotAchievedException("Burst reads were not interleaved")
+
+        # each burst starts at a third of the link, so the two together
+        # must get more than one burst alone could
+        total = sum([len(f["content"]) for f in files.values()])
+        rate = total / max(tend - tstart, 0.001)
+        self.progress("Read %u bytes in %.1fs (%.0f bytes/s, link %.0f bytes/s)" %
+                      (total, tend - tstart, rate, link_bytes_per_second))
+        if rate < 0.35 * link_bytes_per_second:
+            raise NotAchievedException("Burst reads achieved %.0f bytes/s, want at least %.0f" %
+                                       (rate, 0.35 * link_bytes_per_second))
+
+    def DataFlashThroughput(self):
+        '''check block logging writes in batches, erases ahead and reports read speed'''
+        self.context_push()
+        ex = None
+        mavproxy = self.start_mavproxy()
+        try:
+            self.set_parameters({
+                "LOG_BACKEND_TYPE": 4,
+                "LOG_FILE_DSRMROT": 1,
+                "LOG_BITMASK": 131071,
+            })
+            self.reboot_sitl()
+            mavproxy.send("module load log\n")
+            mavproxy.send("log erase\n")
+            mavproxy.expect("Chip erase complete")
+
+            self.wait_ready_to_arm()
+            self.set_autodisarm_delay(0)
+            self.arm_vehicle()
+            self.delay_sim_time(20)
+            self.disarm_vehicle()
+            self.delay_sim_time(5)
+
+            mavproxy.send("log list\n")
+            mavproxy.expect("Log ([0-9]+)  numLogs ([0-9]+) lastLog ([0-9]+) size ([0-9]+)", timeout=120)
+            lastlog = int(mavproxy.match.group(3))
+            filename = "logs/dataflash-throughput.BIN"
+            mavproxy.send("log download %u %s\n" % (lastlog, filename))
+            mavproxy.expect(r"Log read (\d+)kB in (\d+)ms \((\d+)kB/s\)", timeout=120)
+            self.progress("Read %skB from flash in %sms (%skB/s)" % mavproxy.match.groups())
+            mavproxy.expect("Finished downloading", timeout=120)
+            self.validate_log_file(filename)
+
+            write_bytes = 0
+            erases = 0
+            erases_ahead = 0
+            dfreader = self.dfreader_for_path(filename)
+            while True:
+                m = dfreader.recv_match(type='BKS')
+                if m is None:
+                    break
+                write_bytes += m.WB
+                erases += m.Er
+                erases_ahead += m.ErA
+            self.progress("Wrote %u bytes, %u erases of which %u ahead of the write point" %
+                          (write_bytes, erases, erases_ahead))
+            if write_bytes == 0:
+                raise NotAchievedException("No flash writes logged in BKS")
+            if erases_ahead == 0:
+                raise NotAchievedException("No blocks erased ahead of the write point")
+
+        except Exception as e:
+            self.print_exception_caught(e)
+            ex = e
+        mavproxy.send("module unload log\n")
+        self.stop_mavproxy(mavproxy)
+        self.context_pop()
+        self.reboot_sitl()
+        if ex is not None:
+            raise ex
+
+    def DataFlashWrapped(self):
+        '''check block logging after the write point has wrapped over old logs'''
+        self.context_push()
+        ex = None
+        mavproxy = self.start_mavproxy()
+
+        def log_list():
+            mavproxy.send("log list\n")
+            logs = {}
+            while True:
+                mavproxy.expect("Log ([0-9]+)  numLogs ([0-9]+) lastLog ([0-9]+) size ([0-9]+)", timeout=120)
+                logs[int(mavproxy.match.group(1))] = int(mavproxy.match.group(4))
+                if len(logs) >= int(mavproxy.match.group(2)):
+                    return logs
+
+        def fly_log(seconds):
+            self.arm_vehicle()
+            self.delay_sim_time(seconds)
+            self.disarm_vehicle()
+            self.delay_sim_time(5)
+
+        def download(log_num, filename):
+            mavproxy.send("log download %u %s\n" % (log_num, filename))
+            mavproxy.expect("Finished downloading", timeout=300)
+            self.validate_log_file(filename)
+
+        try:
+            self.set_parameters({
+                "LOG_BACKEND_TYPE": 4,
+                "LOG_FILE_DSRMROT": 1,
+                "LOG_BITMASK": 131071,
+            })
+            self.reboot_sitl()
+            mavproxy.send("module load log\n")
+            mavproxy.send("log erase\n")
+            mavproxy.expect("Chip erase complete")
+
+            self.wait_ready_to_arm()
+            self.set_autodisarm_delay(0)
+
+            # SIM_JEDEC is an MX25L3206E; the last block holds the
+            # format version
+            chip_size = 63 * 256 * 256
+
+            # size the logs from the rate the first one was written
+            # at so that each fills about 40% of the chip, a single
+            # log filling it would stop with the chip full
+            fly_log(10)
+            logs = log_list()
+            rate = logs[1] / 10.0
+            if rate == 0:
+                raise NotAchievedException("Nothing logged")
+            seconds = int(0.4 * chip_size / rate) + 1
+            self.progress("Logging at %.0f bytes/s, %us per log" % (rate, seconds))
+
+            for i in range(8):
+                fly_log(seconds)
+                logs = log_list()
+                self.progress("Logs: %s" % str(logs))
+                if 1 not in logs:
+                    break
+            if 1 in logs:
+                raise NotAchievedException("Logs did not wrap")
+            if sum(logs.values()) > chip_size:
+                raise NotAchievedException("Logs claim %u bytes on a %u byte chip" %
+                                           (sum(logs.values()), chip_size))
+            lognums = sorted(logs.keys())
+            if lognums != list(range(lognums[0], lognums[-1] + 1)):
+                raise NotAchievedException("Logs not contiguous: %s" % str(lognums))
+
+            # the oldest log lost its start when it was written over,
+            # it must now start in the block after the write point
+            oldest = "logs/dataflash-wrapped-oldest.BIN"
+            download(lognums[0], oldest)
+            # the newest log wrapped over the end of the chip
+            newest = "logs/dataflash-wrapped-newest.BIN"
+            download(lognums[-1], newest)
+
+            erases_ahead = 0
+            dfreader = self.dfreader_for_path(newest)
+            while True:
+                m = dfreader.recv_match(type='BKS')
+                if m is None:
+                    break
+                erases_ahead += m.ErA
+            self.progress("%u blocks erased ahead while writing over old logs" % erases_ahead)
+            if erases_ahead == 0:
+                raise NotAchievedException("No blocks erased ahead of the write point over old logs")
+
+            # erasing ahead must not have lost any more logs than
+            # the write point itself had reached
+            logs_after = log_list()
+            if logs_after != logs:
+                raise NotAchievedException("Log list changed from %s to %s" % (str(logs), str(logs_after)))
+
+        except Exception as e:
+            self.print_exception_caught(e)
+            ex = e
+        mavproxy.send("module unload log\n")
+        self.stop_mavproxy(mavproxy)
+        self.context_pop()
+        self.reboot_sitl()
+        if ex is not None:
+            raise ex
+
     def GyroFFTHarmonic(self):
         """Use dynamic harmonic notch to control motor noise with harmonic matching of the first harmonic."""
         self.test_gyro_fft_harmonic(False)
@@ -10384,6 +11143,71 @@ class AutoTestCopter(vehicle_test_suite.TestSuite):
 
         return current_log_filepath
 
+    def test_replay_parallel_ekf3_cores_bit(self):
+        # onboard the EKF3 cores run on their own threads; Replay runs
+        # them in series, so check_replay confirms the outputs match
+        self.set_parameter("EK3_OPTIONS", 4)
+        return self.test_replay_gps_bit()
+
+    def test_replay_compressed_log_bit(self):
+        # Replay must read the compressed log to reproduce the EKF
+        # outputs; its own log is written uncompressed for check_replay
+        self.set_parameter("LOG_FILE_COMP", 1)
+        log_filepath = self.test_replay_gps_bit()
+
+        # only the LZB messages are visible without decompression
+        dfreader = self.dfreader_for_path(log_filepath)
+        raw_len = 0
+        comp_len = 0
+        cpu_us = 0
+        blocks = 0
+        while True:
+            m = dfreader.recv_match()
+            if m is None:
+                break
+            if m.get_type() == 'FMT':
+                continue
+            if m.get_type() != 'LZB':
+                raise NotAchievedException("Uncompressed %s message in compressed log" % m.get_type())
+            if m.Ofs == 0:
+                blocks += 1
+                raw_len += m.RLen
+                comp_len += m.CLen
+                cpu_us += m.CPU
+        if blocks == 0:
+            raise NotAchievedException("No compressed blocks in log")
+        ratio = raw_len / float(comp_len)
+        self.progress("%u blocks, compression ratio %.2f, %.0fus/block" % (blocks, ratio, cpu_us / float(blocks)))
+        if ratio < 1.3:
+            raise NotAchievedException("Poor compression ratio %.2f" % ratio)
+
+        # Replay can write the log back out for other tools to read
+        plain_filepath = os.path.join(util.topdir(), "logs", "decompressed.BIN")
+        util.run_cmd(
+            ['build/sitl/tool/Replay', '--decompress', plain_filepath, log_filepath],
+            directory=util.topdir(),
+            checkfail=True,
+        )
+        # a block cut short when the log was closed can't be decompressed
+        plain_len = os.path.getsize(plain_filepath)
+        if plain_len > raw_len or raw_len - plain_len > 2 * 4096:
+            raise NotAchievedException("Decompressed log is %u bytes, blocks held %u" % (plain_len, raw_len))
+        counts = {}
+        dfreader = self.dfreader_for_path(plain_filepath)
+        while True:
+            m = dfreader.recv_match()
+            if m is None:
+                break
+            counts[m.get_type()] = counts.get(m.get_type(), 0) + 1
+        if 'LZB' in counts:
+            raise NotAchievedException("LZB messages in decompressed log")
+        for mtype in 'PARM', 'RFRH':
+            if counts.get(mtype, 0) == 0:
+                raise NotAchievedException("No %s messages in decompressed log" % mtype)
+        os.unlink(plain_filepath)
+
+        return log_filepath
+
     def test_replay_beacon_bit(self):
         self.set_parameters({
             "LOG_REPLAY": 1,
@@ -10789,11 +11613,71 @@ class AutoTestCopter(vehicle_test_suite.TestSuite):
             ('GPS', self.test_replay_gps_bit),
             ('Beacon', self.test_replay_beacon_bit),
             ('OpticalFlow', self.test_replay_optical_flow_bit),
+            ('ParallelEKF3Cores', self.test_replay_parallel_ekf3_cores_bit),
+            ('CompressedLog', self.test_replay_compressed_log_bit),
         ]
         for (name, func) in bits:
             self.start_subtest("%s" % name)
             self.test_replay_bit(func)
 
+        self.start_subtest("IndexAndSeek")
+        self.test_replay_index_and_seek()
+
+    def test_replay_index_and_seek(self):
+        self.context_push()
+        log_filepath = self.test_replay_gps_bit()
+        self.context_pop()
+
+        counts = {}
+        first_us = None
+        last_us = None
+        dfreader = self.dfreader_for_path(log_filepath)
+        while True:
+            m = dfreader.recv_match(type=['IMU', 'PARM', 'RFRH'])
+            if m is None:
+                break
+            counts[m.get_type()] = counts.get(m.get_type(), 0) + 1
+            if m.get_type() == 'RFRH':
+                if first_us is None:
+                    first_us = m.TimeUS
+                last_us = m.TimeUS
+
+        self.progress("Checking the index counts match a full read of the log")
+        output = util.run_cmd(
+            ['build/sitl/tool/Replay', '--index', log_filepath],
+            directory=util.topdir(),
+            output=True,
+        ).decode('utf-8', errors='replace')
+        index = {}
+        for line in output.split("\n"):
+            match = re.match(r"Index: (\S+)\s+(\d+) messages", line)
+            if match is not None:
+                index[match.group(1)] = int(match.group(2))
+        for (name, count) in counts.items():
+            if index.get(name) != count:
+                raise NotAchievedException("Index has %s %s messages, log has %u" % (str(index.get(name)), name, count))
+
+        self.progress("Checking replay can start part way through the log")
+        seek_us = (first_us + last_us) // 2
+        replay_log_filepath = self.run_replay(log_filepath, args=['--seek=%f' % (seek_us * 1.0e-6)])
+        dfreader = self.dfreader_for_path(replay_log_filepath)
+        replay_counts = {}
+        while True:
+            m = dfreader.recv_match(type=['PARM', 'RFRH', 'XKF1'])
+            if m is None:
+                break
+            mtype = m.get_type()
+            if replay_counts.get(mtype, 0) == 0 and mtype != 'PARM':
+                # the seek lands on an indexed message up to 0.1s early
+                if m.TimeUS < seek_us - 200000:
+                    raise NotAchievedException("%s at %uus before seek point %uus" % (mtype, m.TimeUS, seek_us))
+            replay_counts[mtype] = replay_counts.get(mtype, 0) + 1
+        for mtype in 'PARM', 'RFRH', 'XKF1':
+            if replay_counts.get(mtype, 0) == 0:
+                raise NotAchievedException("No %s messages in replay from seek point" % mtype)
+        if replay_counts['RFRH'] >= counts['RFRH']:
+            raise NotAchievedException("Replay from seek point replayed the whole log")
+
     def test_replay_bit(self, bit):
 
         self.context_push()
@@ -12203,6 +13087,7 @@ class AutoTestCopter(vehicle_test_suite.TestSuite):
              self.MAV_CMD_NAV_VTOL_LAND,
              self.clear_roi,
              self.ReadOnlyDefaults,
+             self.ParameterDownloadLinks,
         ])
         return ret
 
@@ -13666,6 +14551,83 @@ RTL_ALT 111
         self.assert_parameter_value("RTL_ALT", 111)
         self.assert_parameter_value('RTL_ALT_FINAL', 101)
 
+    def download_parameters_concurrently(self, mavs, timeout=300):
+        '''request the full parameter list on each of mavs at once and
+        return the sim-time each link took to receive every parameter'''
+        for mav in mavs:
+            self.drain_mav(mav)
+        tstart = self.get_sim_time()
+        for mav in mavs:
+            mav.mav.param_request_list_send(self.sysid_thismav(), 1)
+        seen_ids = [set() for mav in mavs]
+        expected_count = [None for mav in mavs]
+        duration = [None for mav in mavs]
+        while None in duration:
+            now = self.get_sim_time_cached()
+            if now - tstart > timeout:
+                raise AutoTestTimeoutException("Failed to download parameters (have %s of %s)" %
+                                               (str([len(x) for x in seen_ids]), str(expected_count)))
+            for i, mav in enumerate(mavs):
+                while True:
+                    m = mav.recv_match(type='PARAM_VALUE', blocking=False)
+                    if m is None:
+                        break
+                    if m.param_index == 65535:
+                        continue
+                    expected_count[i] = m.param_count
+                    seen_ids[i].add(m.param_id)
+                    if duration[i] is None and len(seen_ids[i]) == expected_count[i]:
+                        duration[i] = now - tstart
+        return duration
+
+    def ParameterDownloadLinks(self):
+        '''benchmark full parameter list download on 1, 2 and 4 concurrent links'''
+        port = self.spare_network_port()
+        self.set_parameter("SERIAL5_PROTOCOL", 2)
+        self.customise_SITL_commandline([
+            "--serial5=tcp:%u" % port,
+        ])
+
+        mavs = [self.mav]
+        for (i, p) in enumerate([self.adjust_ardupilot_port(5762),
+                                 self.adjust_ardupilot_port(5763),
+                                 port]):
+            mavs.append(mavutil.mavlink_connection(
+                "tcp:localhost:%u" % p,
+                robust_parsing=True,
+                source_system=7+i,
+                source_component=7+i,
+            ))
+
+        ex = None
+        try:
+            results = {}
+            for count in 1, 2, 4:
+                self.start_subtest("Download on %u links" % count)
+                duration = self.download_parameters_concurrently(mavs[:count])
+                results[count] = max(duration)
+                self.progress("%u links: %s" % (count, " ".join(["%.1fs" % d for d in duration])))
+                for mav in mavs:
+                    self.drain_mav(mav)
+
+            for count in sorted(results.keys()):
+                self.progress("Full parameter download on %u links took %.1fs" % (count, results[count]))
+
+            # each link has its own queues and bandwidth, so adding
+            # links should not multiply the time taken
+            if results[4] > 3 * results[1]:
+                raise NotAchievedException("Download on 4 links too slow (%.1fs vs %.1fs)" %
+                                           (results[4], results[1]))
+        except Exception as e:
+            self.print_exception_caught(e)
+            ex = e
+
+        for mav in mavs[1:]:
+            mav.close()
+
+        if ex is not None:
+            raise ex
+
     def ScriptingFlipMode(self):
         '''test adding custom mode from scripting'''
         # Really it would be nice to check for the AVAILABLE_MODES message, but pymavlink does not understand them yet.
@@ -14177,6 +15139,15 @@ RTL_ALT 111
             Test(self.GyroFFTHarmonic, attempts=4, speedup=8),
             Test(self.GyroFFTAverage, attempts=1, speedup=8),
             Test(self.GyroFFTContinuousAveraging, attempts=4, speedup=8),
+            self.IMUStreaming,
+            self.FastRateBufferNoLoss,
+            self.ParamDeltaDownload,
+            self.LogHeaderCached,
+            self.DataFlashThroughput,
+            self.DataFlashWrapped,
+            self.StorageWriteBack,
+            self.MAVLinkStreamPriority,
+            self.MAVFTPConcurrentBursts,
             self.WPYawBehaviour1RTL,
             self.GyroFFTPostFilter,
             self.GyroFFTMotorNoiseCheck,
@@ -14193,10 +14193,12 @@ switch value'''
         # heading seemingly indefinitely.
         self.reboot_sitl()
 
-    def run_replay(self, filepath):
+    def run_replay(self, filepath, args=None):
         '''runs replay in filepath, returns filepath to Replay logfile'''
+        if args is None:
+            args = []
         util.run_cmd(
-            ['build/sitl/tool/Replay', filepath],
+            ['build/sitl/tool/Replay'] + args + [filepath],
             directory=util.topdir(),
             checkfail=True,
             show=True,
@@ -14405,13 +14407,13 @@ switch value'''
         if abs(new_gpi_alt2 - m.alt) > 100:
             raise NotAchievedException("Failover not detected")
 
-    def fetch_file_via_ftp(self, path, timeout=20):
+    def fetch_file_via_ftp(self, path, timeout=20, binary=False):
         '''returns the content of the FTP'able file at path'''
         self.progress("Retrieving (%s) using MAVProxy" % path)
         mavproxy = self.start_mavproxy()
         mavproxy.expect("Saved .* parameters to")
         ex = None
-        tmpfile = tempfile.NamedTemporaryFile(mode='r', delete=False)
+        tmpfile = tempfile.NamedTemporaryFile(mode='rb' if binary else 'r', delete=False)
         try:
             mavproxy.send("module load ftp\n")
             mavproxy.expect(["Loaded module ftp", "module ftp already loaded"])
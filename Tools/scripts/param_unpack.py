@@ -18,14 +18,20 @@ data = open(args.file,'rb').read()
 last_name = ""
 
 magic = 0x671b
+magic_with_snapshot = 0x671d
 
 # header of 6 bytes
 magic2,num_params,total_params = struct.unpack("<HHH", data[0:6])
-if magic != magic2:
+if magic2 == magic_with_snapshot:
+    # header of 16 bytes from a since= download
+    flags,snapshot = struct.unpack("<HQ", data[6:16])
+    print("Snapshot %u%s" % (snapshot, " (delta)" if flags & 1 else ""))
+    data = data[16:]
+elif magic != magic2:
     print("Bad magic 0x%x expected 0x%x" % (magic2, magic))
     sys.exit(1)
-
-data = data[6:]
+else:
+    data = data[6:]
 
 # mapping of data type to type length and format
 data_types = {
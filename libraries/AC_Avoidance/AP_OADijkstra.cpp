@@ -31,6 +31,7 @@
 #define OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK  32      // expanding arrays for fence points and paths to destination will grow in increments of 20 elements
 #define OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX        255     // index use to indicate we do not have a tentative short path for a node
 #define OA_DIJKSTRA_ERROR_REPORTING_INTERVAL_MS         5000    // failure messages sent to GCS every 5 seconds
+#define OA_DIJKSTRA_VISGRAPH_SLICE_US                   10000   // maximum time spent building the fence visgraph in a single call to update
 
 /// Constructor
 AP_OADijkstra::AP_OADijkstra(AP_Int16 &options) :
@@ -76,6 +77,7 @@ AP_OADijkstra::AP_OADijkstra_State AP_OADijkstra::update(const Location &current
     if (check_inclusion_polygon_updated()) {
         _inclusion_polygon_with_margin_ok = false;
         _polyfence_visgraph_ok = false;
+        _fence_visgraph_row = 0;
         _shortest_path_ok = false;
     }
 
@@ -83,6 +85,7 @@ AP_OADijkstra::AP_OADijkstra_State AP_OADijkstra::update(const Location &current
     if (check_exclusion_polygon_updated()) {
         _exclusion_polygon_with_margin_ok = false;
         _polyfence_visgraph_ok = false;
+        _fence_visgraph_row = 0;
         _shortest_path_ok = false;
     }
 
@@ -90,6 +93,7 @@ AP_OADijkstra::AP_OADijkstra_State AP_OADijkstra::update(const Location &current
     if (check_exclusion_circle_updated()) {
         _exclusion_circle_with_margin_ok = false;
         _polyfence_visgraph_ok = false;
+        _fence_visgraph_row = 0;
         _shortest_path_ok = false;
     }
 
@@ -128,14 +132,22 @@ AP_OADijkstra::AP_OADijkstra_State AP_OADijkstra::update(const Location &current
 
     // create visgraph for all fence (with margin) points
     if (!_polyfence_visgraph_ok) {
-        _polyfence_visgraph_ok = create_fence_visgraph(_error_id);
-        if (!_polyfence_visgraph_ok) {
+        bool visgraph_complete = false;
+        if (!create_fence_visgraph(_error_id, visgraph_complete)) {
             _shortest_path_ok = false;
             dest_to_next_dest_clear = _dest_to_next_dest_clear = false;
             report_error(_error_id);
             Write_OADijkstra(DIJKSTRA_STATE_ERROR, (uint8_t)_error_id, 0, 0, destination, destination);
             return DIJKSTRA_STATE_ERROR;
         }
+        if (!visgraph_complete) {
+            // visgraph will be completed over the next few calls
+            _shortest_path_ok = false;
+            dest_to_next_dest_clear = _dest_to_next_dest_clear = false;
+            Write_OADijkstra(DIJKSTRA_STATE_PROCESSING, 0, 0, 0, destination, destination);
+            return DIJKSTRA_STATE_PROCESSING;
+        }
+        _polyfence_visgraph_ok = true;
         // reset logging count to restart logging updated graph
         _log_num_points = 0;
         _log_visgraph_version++;
@@ -618,25 +630,32 @@ bool AP_OADijkstra::intersects_fence(const Vector2f &seg_start, const Vector2f &
         return false;
     }
 
-    // determine if segment crosses any of the inclusion polygons
-    uint16_t num_points = 0;
-    for (uint8_t i = 0; i < fence->polyfence().get_inclusion_polygon_count(); i++) {
-        const Vector2f* boundary = fence->polyfence().get_inclusion_polygon(i, num_points);
-        if (boundary != nullptr) {
-            Vector2f intersection;
-            if (Polygon_intersects(boundary, num_points, seg_start, seg_end, intersection)) {
-                return true;
+    if (_fence_grid.built()) {
+        // determine if segment crosses any of the inclusion or exclusion polygons using only nearby edges
+        if (_fence_grid.intersects(seg_start, seg_end)) {
+            return true;
+        }
+    } else {
+        // determine if segment crosses any of the inclusion polygons
+        uint16_t num_points = 0;
+        for (uint8_t i = 0; i < fence->polyfence().get_inclusion_polygon_count(); i++) {
+            const Vector2f* boundary = fence->polyfence().get_inclusion_polygon(i, num_points);
+            if (boundary != nullptr) {
+                Vector2f intersection;
+                if (Polygon_intersects(boundary, num_points, seg_start, seg_end, intersection)) {
+                    return true;
+                }
             }
         }
-    }
 
-    // determine if segment crosses any of the exclusion polygons
-    for (uint8_t i = 0; i < fence->polyfence().get_exclusion_polygon_count(); i++) {
-        const Vector2f* boundary = fence->polyfence().get_exclusion_polygon(i, num_points);
-        if (boundary != nullptr) {
-            Vector2f intersection;
-            if (Polygon_intersects(boundary, num_points, seg_start, seg_end, intersection)) {
-                return true;
+        // determine if segment crosses any of the exclusion polygons
+        for (uint8_t i = 0; i < fence->polyfence().get_exclusion_polygon_count(); i++) {
+            const Vector2f* boundary = fence->polyfence().get_exclusion_polygon(i, num_points);
+            if (boundary != nullptr) {
+                Vector2f intersection;
+                if (Polygon_intersects(boundary, num_points, seg_start, seg_end, intersection)) {
+                    return true;
+                }
             }
         }
     }
@@ -676,29 +695,98 @@ bool AP_OADijkstra::intersects_fence(const Vector2f &seg_start, const Vector2f &
     return false;
 }
 
+// build grid of inclusion and exclusion polygon edges used to speed up intersects_fence
+// on failure intersects_fence falls back to checking every edge
+void AP_OADijkstra::build_fence_grid()
+{
+    _fence_grid.clear();
+
+    const AC_Fence *fence = AC_Fence::get_singleton();
+    if (fence == nullptr) {
+        return;
+    }
+    const AC_PolyFence_loader &polyfence = fence->polyfence();
+    const uint8_t num_inclusion_polygons = polyfence.get_inclusion_polygon_count();
+    const uint8_t num_exclusion_polygons = polyfence.get_exclusion_polygon_count();
+
+    // count points so that all space can be allocated at once
+    uint32_t total_points = 0;
+    uint16_t num_points;
+    for (uint8_t i = 0; i < num_inclusion_polygons; i++) {
+        if (polyfence.get_inclusion_polygon(i, num_points) != nullptr) {
+            total_points += num_points;
+        }
+    }
+    for (uint8_t i = 0; i < num_exclusion_polygons; i++) {
+        if (polyfence.get_exclusion_polygon(i, num_points) != nullptr) {
+            total_points += num_points;
+        }
+    }
+    if ((total_points > UINT16_MAX) || !_fence_grid.reserve(total_points, num_inclusion_polygons + num_exclusion_polygons)) {
+        return;
+    }
+
+    // add polygons
+    for (uint8_t i = 0; i < num_inclusion_polygons; i++) {
+        const Vector2f* boundary = polyfence.get_inclusion_polygon(i, num_points);
+        if ((boundary != nullptr) && !_fence_grid.add_polygon(boundary, num_points)) {
+            _fence_grid.clear();
+            return;
+        }
+    }
+    for (uint8_t i = 0; i < num_exclusion_polygons; i++) {
+        const Vector2f* boundary = polyfence.get_exclusion_polygon(i, num_points);
+        if ((boundary != nullptr) && !_fence_grid.add_polygon(boundary, num_points)) {
+            _fence_grid.clear();
+            return;
+        }
+    }
+
+    if (!_fence_grid.build()) {
+        _fence_grid.clear();
+    }
+}
+
 // create visibility graph for all fence (with margin) points
-// returns true on success.  returns false on failure and err_id is updated
+// work is spread across calls, each call running for at most OA_DIJKSTRA_VISGRAPH_SLICE_US
+// returns true on success and sets complete to true once the graph has been fully built
+// returns false on failure and err_id is updated
 // requires these functions to have been run create_inclusion_polygon_with_margin, create_exclusion_polygon_with_margin, create_exclusion_circle_with_margin
-bool AP_OADijkstra::create_fence_visgraph(AP_OADijkstra_Error &err_id)
+bool AP_OADijkstra::create_fence_visgraph(AP_OADijkstra_Error &err_id, bool &complete)
 {
+    complete = false;
+
     // exit immediately if fence is not enabled
     const AC_Fence *fence = AC_Fence::get_singleton();
     if (fence == nullptr) {
+        _fence_visgraph_row = 0;
         err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_FENCE_DISABLED;
         return false;
     }
 
     // fail if more fence points than algorithm can handle
     if (total_numpoints() >= OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX) {
+        _fence_visgraph_row = 0;
         err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_TOO_MANY_FENCE_POINTS;
         return false;
     }
 
-    // clear fence points visibility graph
-    _fence_visgraph.clear();
+    if (_fence_visgraph_row == 0) {
+        // clear fence points visibility graph
+        _fence_visgraph.clear();
+
+        // index fence edges for faster intersection checks
+        build_fence_grid();
+    }
 
     // calculate distance from each point to all other points
-    for (uint8_t i = 0; i < total_numpoints() - 1; i++) {
+    const uint32_t start_us = AP_HAL::micros();
+    for (uint8_t i = _fence_visgraph_row; i < total_numpoints() - 1; i++) {
+        // continue on the next call if out of time (always completing at least one point per call)
+        if ((i > _fence_visgraph_row) && (AP_HAL::micros() - start_us > OA_DIJKSTRA_VISGRAPH_SLICE_US)) {
+            _fence_visgraph_row = i;
+            return true;
+        }
         Vector2f start_seg;
         if (get_point(i, start_seg)) {
             for (uint8_t j = i + 1; j < total_numpoints(); j++) {
@@ -710,6 +798,7 @@ bool AP_OADijkstra::create_fence_visgraph(AP_OADijkstra_Error &err_id)
                                                       {AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, j},
                                                       (start_seg - end_seg).length())) {
                             // failure to add a point can only be caused by out-of-memory
+                            _fence_visgraph_row = 0;
                             err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
                             return false;
                         }
@@ -719,6 +808,8 @@ bool AP_OADijkstra::create_fence_visgraph(AP_OADijkstra_Error &err_id)
         }
     }
 
+    _fence_visgraph_row = 0;
+    complete = true;
     return true;
 }
 
@@ -8,6 +8,7 @@
 #include <AP_Common/Location.h>
 #include <AP_Math/AP_Math.h>
 #include "AP_OAVisGraph.h"
+#include "AP_OASegmentGrid.h"
 #include <AP_Logger/AP_Logger_config.h>
 
 /*
@@ -31,7 +32,8 @@ public:
     enum AP_OADijkstra_State : uint8_t {
         DIJKSTRA_STATE_NOT_REQUIRED = 0,
         DIJKSTRA_STATE_ERROR,
-        DIJKSTRA_STATE_SUCCESS
+        DIJKSTRA_STATE_SUCCESS,
+        DIJKSTRA_STATE_PROCESSING       // visibility graph is still being built, call again
     };
 
     // calculate a destination to avoid the polygon fence
@@ -119,9 +121,15 @@ private:
     // returns true if line segment intersects polygon or circular fence
     bool intersects_fence(const Vector2f &seg_start, const Vector2f &seg_end) const;
 
+    // build grid of inclusion and exclusion polygon edges used to speed up intersects_fence
+    // on failure intersects_fence falls back to checking every edge
+    void build_fence_grid();
+
     // create visibility graph for all fence (with margin) points
-    // returns true on success.  returns false on failure and err_id is updated
-    bool create_fence_visgraph(AP_OADijkstra_Error &err_id);
+    // work is spread across calls, each call running for at most OA_DIJKSTRA_VISGRAPH_SLICE_US
+    // returns true on success and sets complete to true once the graph has been fully built
+    // returns false on failure and err_id is updated
+    bool create_fence_visgraph(AP_OADijkstra_Error &err_id, bool &complete);
 
     // calculate shortest path from origin to destination
     // returns true on success.  returns false on failure and err_id is updated
@@ -159,6 +167,8 @@ private:
 
     // visibility graphs
     AP_OAVisGraph _fence_visgraph;          // holds distances between all inclusion/exclusion fence points (with margin)
+    uint8_t _fence_visgraph_row;            // next fence point whose visibility is to be calculated by create_fence_visgraph (0 if starting afresh)
+    AP_OASegmentGrid _fence_grid;           // inclusion and exclusion polygon edges indexed by position
     AP_OAVisGraph _source_visgraph;         // holds distances from source point to all other nodes
     AP_OAVisGraph _destination_visgraph;    // holds distances from the destination to all other nodes
 
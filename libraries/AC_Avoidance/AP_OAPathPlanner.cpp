@@ -348,6 +348,9 @@ void AP_OAPathPlanner::avoidance_thread()
             case AP_OADijkstra::DIJKSTRA_STATE_SUCCESS:
                 res = OA_SUCCESS;
                 break;
+            case AP_OADijkstra::DIJKSTRA_STATE_PROCESSING:
+                res = OA_PROCESSING;
+                break;
             }
             path_planner_used = OAPathPlannerUsed::Dijkstras;
 #endif
@@ -395,6 +398,9 @@ void AP_OAPathPlanner::avoidance_thread()
             case AP_OADijkstra::DIJKSTRA_STATE_SUCCESS:
                 res = OA_SUCCESS;
                 break;
+            case AP_OADijkstra::DIJKSTRA_STATE_PROCESSING:
+                res = OA_PROCESSING;
+                break;
             }
             path_planner_used = OAPathPlannerUsed::Dijkstras;
 #endif
@@ -403,6 +409,11 @@ void AP_OAPathPlanner::avoidance_thread()
 
         } // switch
 
+        // Dijkstra's builds its visibility graph over several calls so run again without waiting for the next update
+        if (res == OA_PROCESSING) {
+            avoidance_latest_ms = now - OA_UPDATE_MS;
+        }
+
         {
             // give the main thread the avoidance result
             WITH_SEMAPHORE(_rsem);
@@ -0,0 +1,281 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AC_Avoidance_config.h"
+
+#if AP_OAPATHPLANNER_ENABLED
+
+#include "AP_OASegmentGrid.h"
+
+// margin (as a fraction of a cell) added around segments when finding the cells they pass through
+// ensures a point lying on a cell boundary is found in the cells on both sides
+#define OA_SEGMENT_GRID_CELL_MARGIN     1.0e-3f
+
+// free all memory and forget all polygons
+void AP_OASegmentGrid::clear()
+{
+    delete[] _pts;
+    delete[] _segs;
+    delete[] _seg_stamp;
+    delete[] _cell_start;
+    delete[] _cell_segs;
+    _pts = nullptr;
+    _segs = nullptr;
+    _seg_stamp = nullptr;
+    _cell_start = nullptr;
+    _cell_segs = nullptr;
+    _pts_max = 0;
+    _num_pts = 0;
+    _num_segs = 0;
+}
+
+// allocate space for num_polygons polygons with a combined total of num_points points
+// returns true on success
+bool AP_OASegmentGrid::reserve(uint16_t num_points, uint8_t num_polygons)
+{
+    clear();
+
+    // each polygon is stored closed which requires one extra point
+    const uint32_t pts_max = uint32_t(num_points) + num_polygons;
+    if (pts_max > UINT16_MAX) {
+        return false;
+    }
+    if (pts_max == 0) {
+        return true;
+    }
+
+    _pts = NEW_NOTHROW Vector2f[pts_max];
+    _segs = NEW_NOTHROW uint16_t[num_points];
+    _seg_stamp = NEW_NOTHROW uint16_t[num_points];
+    if ((_pts == nullptr) || (_segs == nullptr) || (_seg_stamp == nullptr)) {
+        clear();
+        return false;
+    }
+    _pts_max = pts_max;
+    return true;
+}
+
+// add a closed polygon.  the last point may optionally be the same as the first
+// returns false if there is not enough reserved space
+bool AP_OASegmentGrid::add_polygon(const Vector2f *points, uint16_t num_points)
+{
+    // treat as if the duplicate closing point was not passed in
+    if (Polygon_complete(points, num_points)) {
+        num_points--;
+    }
+
+    // a single point has no edges
+    if (num_points < 2) {
+        return true;
+    }
+
+    if (uint32_t(_num_pts) + num_points + 1 > _pts_max) {
+        return false;
+    }
+
+    for (uint16_t i = 0; i < num_points; i++) {
+        _segs[_num_segs++] = _num_pts;
+        _pts[_num_pts++] = points[i];
+    }
+    // close polygon
+    _pts[_num_pts++] = points[0];
+
+    return true;
+}
+
+// call fn(cell_index) for every cell the line segment from p1 to p2 may pass through
+// stops early if fn returns true
+template <typename F>
+void AP_OASegmentGrid::for_each_cell(const Vector2f &p1, const Vector2f &p2, F fn) const
+{
+    // convert to cell units relative to the grid's corner
+    const Vector2f a = (p1 - _grid_min) * _cell_size_inv;
+    const Vector2f b = (p2 - _grid_min) * _cell_size_inv;
+
+    const float xmin = MIN(a.x, b.x) - OA_SEGMENT_GRID_CELL_MARGIN;
+    const float xmax = MAX(a.x, b.x) + OA_SEGMENT_GRID_CELL_MARGIN;
+    const float ymin = MIN(a.y, b.y) - OA_SEGMENT_GRID_CELL_MARGIN;
+    const float ymax = MAX(a.y, b.y) + OA_SEGMENT_GRID_CELL_MARGIN;
+
+    // segment lies entirely outside the grid
+    if ((xmax < 0) || (ymax < 0) || (xmin > _nx) || (ymin > _ny)) {
+        return;
+    }
+
+    // range of columns the segment passes through
+    const uint8_t col_first = constrain_float(xmin, 0, _nx - 1);
+    const uint8_t col_last = constrain_float(xmax, 0, _nx - 1);
+
+    // near vertical segments are treated as covering their full y range in every column
+    const float dx = b.x - a.x;
+    const bool vertical = fabsf(dx) < OA_SEGMENT_GRID_CELL_MARGIN;
+    const float slope = vertical ? 0.0f : (b.y - a.y) / dx;
+
+    for (uint8_t col = col_first; col <= col_last; col++) {
+        float col_ymin = ymin;
+        float col_ymax = ymax;
+        if (!vertical) {
+            // y range of the segment within this column
+            const float ya = a.y + (MAX(xmin, float(col)) - a.x) * slope;
+            const float yb = a.y + (MIN(xmax, float(col + 1)) - a.x) * slope;
+            col_ymin = MAX(ymin, MIN(ya, yb) - OA_SEGMENT_GRID_CELL_MARGIN);
+            col_ymax = MIN(ymax, MAX(ya, yb) + OA_SEGMENT_GRID_CELL_MARGIN);
+        }
+        const uint8_t row_first = constrain_float(col_ymin, 0, _ny - 1);
+        const uint8_t row_last = constrain_float(col_ymax, 0, _ny - 1);
+        for (uint8_t row = row_first; row <= row_last; row++) {
+            if (fn(uint16_t(row) * _nx + col)) {
+                return;
+            }
+        }
+    }
+}
+
+// assign polygon edges to grid cells.  must be called after all polygons have been added
+// returns true on success.  on failure intersects() will always return false
+bool AP_OASegmentGrid::build()
+{
+    delete[] _cell_start;
+    delete[] _cell_segs;
+    _cell_start = nullptr;
+    _cell_segs = nullptr;
+
+    // find bounding box of all points
+    Vector2f pt_min, pt_max;
+    for (uint16_t i = 0; i < _num_pts; i++) {
+        if (i == 0) {
+            pt_min = pt_max = _pts[i];
+            continue;
+        }
+        pt_min.x = MIN(pt_min.x, _pts[i].x);
+        pt_min.y = MIN(pt_min.y, _pts[i].y);
+        pt_max.x = MAX(pt_max.x, _pts[i].x);
+        pt_max.y = MAX(pt_max.y, _pts[i].y);
+    }
+
+    // use roughly one cell per segment with square cells
+    const uint8_t dim = constrain_int16(ceilf(sqrtf(_num_segs)), 1, GRID_DIM_MAX);
+    const Vector2f size = pt_max - pt_min;
+    float cell_size = MAX(size.x, size.y) / dim;
+    if (!is_positive(cell_size)) {
+        cell_size = 1.0f;
+    }
+    _grid_min = pt_min;
+    _cell_size_inv = 1.0f / cell_size;
+    _nx = constrain_int16(size.x * _cell_size_inv + 1, 1, dim);
+    _ny = constrain_int16(size.y * _cell_size_inv + 1, 1, dim);
+    const uint16_t num_cells = uint16_t(_nx) * _ny;
+
+    _cell_start = NEW_NOTHROW uint16_t[num_cells + 1];
+    if (_cell_start == nullptr) {
+        return false;
+    }
+    memset(_cell_start, 0, sizeof(uint16_t) * (num_cells + 1));
+
+    // count number of segments in each cell
+    uint32_t total = 0;
+    for (uint16_t i = 0; i < _num_segs; i++) {
+        for_each_cell(_pts[_segs[i]], _pts[_segs[i]+1], [&](uint16_t cell) {
+            _cell_start[cell]++;
+            total++;
+            return false;
+        });
+    }
+    if (total > UINT16_MAX) {
+        delete[] _cell_start;
+        _cell_start = nullptr;
+        return false;
+    }
+
+    // convert counts to the index one past each cell's last segment
+    for (uint16_t c = 1; c < num_cells; c++) {
+        _cell_start[c] += _cell_start[c-1];
+    }
+    _cell_start[num_cells] = total;
+
+    _cell_segs = NEW_NOTHROW uint16_t[MAX(total, 1U)];
+    if (_cell_segs == nullptr) {
+        delete[] _cell_start;
+        _cell_start = nullptr;
+        return false;
+    }
+
+    // fill each cell from its end, leaving _cell_start holding the index of each cell's first segment
+    for (uint16_t i = 0; i < _num_segs; i++) {
+        for_each_cell(_pts[_segs[i]], _pts[_segs[i]+1], [&](uint16_t cell) {
+            _cell_segs[--_cell_start[cell]] = i;
+            return false;
+        });
+    }
+
+    // reset stamps used by intersects()
+    if (_num_segs > 0) {
+        memset(_seg_stamp, 0, sizeof(uint16_t) * _num_segs);
+    }
+    _stamp = 0;
+
+    return true;
+}
+
+// returns true if the line segment from p1 to p2 crosses any polygon edge
+bool AP_OASegmentGrid::intersects(const Vector2f &p1, const Vector2f &p2) const
+{
+    if (!built() || (_num_segs == 0)) {
+        return false;
+    }
+
+    // new stamp so that segments registered in several cells are tested only once
+    _stamp++;
+    if (_stamp == 0) {
+        memset(_seg_stamp, 0, sizeof(uint16_t) * _num_segs);
+        _stamp = 1;
+    }
+
+    bool ret = false;
+    for_each_cell(p1, p2, [&](uint16_t cell) {
+        for (uint16_t k = _cell_start[cell]; k < _cell_start[cell+1]; k++) {
+            const uint16_t seg = _cell_segs[k];
+            if (_seg_stamp[seg] == _stamp) {
+                continue;
+            }
+            _seg_stamp[seg] = _stamp;
+            const Vector2f &v1 = _pts[_segs[seg]];
+            const Vector2f &v2 = _pts[_segs[seg]+1];
+            // same quick rejection tests as Polygon_intersects
+            if (v1.x > p1.x && v2.x > p1.x && v1.x > p2.x && v2.x > p2.x) {
+                continue;
+            }
+            if (v1.y > p1.y && v2.y > p1.y && v1.y > p2.y && v2.y > p2.y) {
+                continue;
+            }
+            if (v1.x < p1.x && v2.x < p1.x && v1.x < p2.x && v2.x < p2.x) {
+                continue;
+            }
+            if (v1.y < p1.y && v2.y < p1.y && v1.y < p2.y && v2.y < p2.y) {
+                continue;
+            }
+            Vector2f intersection;
+            if (Vector2f::segment_intersection(v1, v2, p1, p2, intersection)) {
+                ret = true;
+                return true;
+            }
+        }
+        return false;
+    });
+
+    return ret;
+}
+
+#endif  // AP_OAPATHPLANNER_ENABLED
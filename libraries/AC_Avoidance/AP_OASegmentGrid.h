@@ -0,0 +1,79 @@
+#pragma once
+
+#include "AC_Avoidance_config.h"
+
+#if AP_OAPATHPLANNER_ENABLED
+
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+
+/*
+ * Uniform grid over the edges of a set of closed polygons.  Used to
+ * quickly find which polygon edges a line segment might cross without
+ * testing every edge of every polygon.
+ *
+ * usage: reserve() space for all polygon points, add_polygon() for each
+ * polygon, then build().  intersects() may then be called repeatedly.
+ */
+
+class AP_OASegmentGrid {
+public:
+
+    AP_OASegmentGrid() {}
+    ~AP_OASegmentGrid() { clear(); }
+
+    CLASS_NO_COPY(AP_OASegmentGrid);  /* Do not allow copies */
+
+    // free all memory and forget all polygons
+    void clear();
+
+    // allocate space for num_polygons polygons with a combined total of num_points points
+    // returns true on success
+    bool reserve(uint16_t num_points, uint8_t num_polygons);
+
+    // add a closed polygon.  the last point may optionally be the same as the first
+    // returns false if there is not enough reserved space
+    bool add_polygon(const Vector2f *points, uint16_t num_points);
+
+    // assign polygon edges to grid cells.  must be called after all polygons have been added
+    // returns true on success.  on failure intersects() will always return false
+    bool build();
+
+    // true once build() has succeeded
+    bool built() const { return _cell_start != nullptr; }
+
+    // returns true if the line segment from p1 to p2 crosses any polygon edge
+    bool intersects(const Vector2f &p1, const Vector2f &p2) const;
+
+    // number of polygon edges held
+    uint16_t num_segments() const { return _num_segs; }
+
+private:
+
+    static constexpr uint8_t GRID_DIM_MAX = 32;     // maximum number of cells along each axis
+
+    // call fn(cell_index) for every cell the line segment from p1 to p2 may pass through
+    template <typename F>
+    void for_each_cell(const Vector2f &p1, const Vector2f &p2, F fn) const;
+
+    // polygon points.  polygons are stored closed so segment k runs from _pts[_segs[k]] to _pts[_segs[k]+1]
+    Vector2f *_pts = nullptr;
+    uint16_t _pts_max = 0;      // number of elements allocated in _pts
+    uint16_t _num_pts = 0;      // number of points held in _pts
+    uint16_t *_segs = nullptr;  // index into _pts of the start of each segment
+    uint16_t _num_segs = 0;     // number of segments held in _segs
+
+    // grid in compressed row format.  segments in cell c are _cell_segs[_cell_start[c]] to _cell_segs[_cell_start[c+1]-1]
+    uint16_t *_cell_start = nullptr;
+    uint16_t *_cell_segs = nullptr;
+    Vector2f _grid_min;         // position of grid's bottom left corner
+    float _cell_size_inv = 1;   // 1 / length of each (square) cell's sides
+    uint8_t _nx = 1;            // number of cells along x axis
+    uint8_t _ny = 1;            // number of cells along y axis
+
+    // per segment stamp used to avoid testing a segment twice during one call to intersects()
+    mutable uint16_t *_seg_stamp = nullptr;
+    mutable uint16_t _stamp = 0;
+};
+
+#endif  // AP_OAPATHPLANNER_ENABLED
@@ -0,0 +1,130 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  measure the cost of building a Dijkstra's fence visibility graph,
+  checking every fence edge against every pair of fence points, with
+  and without the AP_OASegmentGrid index of fence edges
+ */
+#include <AP_gbenchmark.h>
+
+#include <AC_Avoidance/AP_OASegmentGrid.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#define MAX_VERTICES 500
+
+static Vector2f fence[MAX_VERTICES];        // inclusion polygon
+static Vector2f fence_margin[MAX_VERTICES]; // points just inside the inclusion polygon
+
+// create an irregular inclusion polygon of num_vertices points about 200m across
+static void make_fence(uint16_t num_vertices)
+{
+    for (uint16_t i = 0; i < num_vertices; i++) {
+        const float angle = M_2PI * i / num_vertices;
+        const float radius_cm = 10000.0f * (1.0f + 0.3f * sinf(7.0f * angle));
+        const Vector2f dir {cosf(angle), sinf(angle)};
+        fence[i] = dir * radius_cm;
+        fence_margin[i] = dir * (radius_cm * 0.95f);
+    }
+}
+
+// check segment against every fence edge
+static bool intersects_brute_force(uint16_t num_vertices, const Vector2f &p1, const Vector2f &p2)
+{
+    for (uint16_t i = 0; i < num_vertices; i++) {
+        const Vector2f &v1 = fence[i];
+        const Vector2f &v2 = fence[(i + 1) % num_vertices];
+        if (v1.x > p1.x && v2.x > p1.x && v1.x > p2.x && v2.x > p2.x) {
+            continue;
+        }
+        if (v1.y > p1.y && v2.y > p1.y && v1.y > p2.y && v2.y > p2.y) {
+            continue;
+        }
+        if (v1.x < p1.x && v2.x < p1.x && v1.x < p2.x && v2.x < p2.x) {
+            continue;
+        }
+        if (v1.y < p1.y && v2.y < p1.y && v1.y < p2.y && v2.y < p2.y) {
+            continue;
+        }
+        Vector2f intersection;
+        if (Vector2f::segment_intersection(v1, v2, p1, p2, intersection)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// number of visible pairs of fence points, checking every fence edge
+static uint32_t count_visible_brute_force(uint16_t num_vertices)
+{
+    uint32_t visible = 0;
+    for (uint16_t i = 0; i < num_vertices - 1; i++) {
+        for (uint16_t j = i + 1; j < num_vertices; j++) {
+            if (!intersects_brute_force(num_vertices, fence_margin[i], fence_margin[j])) {
+                visible++;
+            }
+        }
+    }
+    return visible;
+}
+
+static void BM_VisgraphBruteForce(benchmark::State& state)
+{
+    const uint16_t num_vertices = state.range(0);
+    make_fence(num_vertices);
+
+    while (state.KeepRunning()) {
+        uint32_t visible = count_visible_brute_force(num_vertices);
+        gbenchmark_escape(&visible);
+    }
+}
+
+static void BM_VisgraphSegmentGrid(benchmark::State& state)
+{
+    const uint16_t num_vertices = state.range(0);
+    make_fence(num_vertices);
+
+    // the grid must find exactly the same visible pairs
+    const uint32_t expected_visible = count_visible_brute_force(num_vertices);
+
+    while (state.KeepRunning()) {
+        // grid is rebuilt each time the fence changes so include it in the cost
+        AP_OASegmentGrid grid;
+        if (!grid.reserve(num_vertices, 1) ||
+            !grid.add_polygon(fence, num_vertices) ||
+            !grid.build()) {
+            state.SkipWithError("failed to build grid");
+            break;
+        }
+        uint32_t visible = 0;
+        for (uint16_t i = 0; i < num_vertices - 1; i++) {
+            for (uint16_t j = i + 1; j < num_vertices; j++) {
+                if (!grid.intersects(fence_margin[i], fence_margin[j])) {
+                    visible++;
+                }
+            }
+        }
+        if (visible != expected_visible) {
+            state.SkipWithError("grid and brute force visible counts differ");
+            break;
+        }
+        gbenchmark_escape(&visible);
+    }
+}
+
+BENCHMARK(BM_VisgraphBruteForce)->Arg(10)->Arg(50)->Arg(100)->Arg(250)->Arg(MAX_VERTICES);
+BENCHMARK(BM_VisgraphSegmentGrid)->Arg(10)->Arg(50)->Arg(100)->Arg(250)->Arg(MAX_VERTICES);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,258 @@
+#include <AP_gtest.h>
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
+
+#include <AC_Avoidance/AP_OASegmentGrid.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_OAPATHPLANNER_ENABLED
+
+/*
+  check AP_OASegmentGrid::intersects() gives the same answer as
+  checking the segment against every polygon edge with
+  Polygon_intersects(), which is what AP_OADijkstra did before the
+  grid was added
+ */
+
+#define MAX_POLYGONS        8
+#define MAX_POLYGON_POINTS  200
+
+struct TestFence {
+    Vector2f points[MAX_POLYGONS][MAX_POLYGON_POINTS];
+    uint16_t num_points[MAX_POLYGONS];
+    uint8_t num_polygons;
+    uint16_t total_points;
+};
+
+static uint32_t test_rand_state = 1;
+
+// simple repeatable pseudo random number in the range 0 to 1
+static float test_rand_float()
+{
+    test_rand_state = test_rand_state * 1103515245U + 12345U;
+    return ((test_rand_state >> 8) & 0xFFFF) / 65535.0f;
+}
+
+static float test_rand_range(float low, float high)
+{
+    return low + (high - low) * test_rand_float();
+}
+
+// add an irregular star shaped polygon around centre.  Points are
+// rounded to whole centimetres so vertices often share coordinates
+// with each other and with cell borders
+static void add_star_polygon(TestFence &fence, const Vector2f &centre, float radius, uint16_t num_points)
+{
+    const uint8_t p = fence.num_polygons++;
+    for (uint16_t i = 0; i < num_points; i++) {
+        const float angle = M_2PI * i / num_points;
+        const float r = radius * test_rand_range(0.5f, 1.0f);
+        fence.points[p][i] = Vector2f{roundf(centre.x + r * cosf(angle)),
+                                      roundf(centre.y + r * sinf(angle))};
+    }
+    fence.num_points[p] = num_points;
+    fence.total_points += num_points;
+}
+
+// inclusion polygon with random exclusion polygons inside it
+static void make_random_fence(TestFence &fence, uint16_t inclusion_points, uint8_t num_exclusions)
+{
+    fence = {};
+    add_star_polygon(fence, Vector2f{}, 10000, inclusion_points);
+    for (uint8_t i = 0; i < num_exclusions; i++) {
+        const Vector2f centre {test_rand_range(-5000, 5000), test_rand_range(-5000, 5000)};
+        add_star_polygon(fence, centre, test_rand_range(200, 2000), 3 + (test_rand_state % 20));
+    }
+}
+
+static bool build_grid(AP_OASegmentGrid &grid, const TestFence &fence)
+{
+    if (!grid.reserve(fence.total_points, fence.num_polygons)) {
+        return false;
+    }
+    for (uint8_t p = 0; p < fence.num_polygons; p++) {
+        if (!grid.add_polygon(fence.points[p], fence.num_points[p])) {
+            return false;
+        }
+    }
+    return grid.build();
+}
+
+static bool intersects_brute_force(const TestFence &fence, const Vector2f &p1, const Vector2f &p2)
+{
+    for (uint8_t p = 0; p < fence.num_polygons; p++) {
+        Vector2f intersection;
+        if (Polygon_intersects(fence.points[p], fence.num_points[p], p1, p2, intersection)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// compare grid and brute force for the segment from p1 to p2.  Both
+// directions are checked as segment_intersection() may give a
+// different answer for a touching segment once it is reversed
+static void check_segment(const AP_OASegmentGrid &grid, const TestFence &fence, const Vector2f &p1, const Vector2f &p2, uint32_t &num_intersecting)
+{
+    const bool expected = intersects_brute_force(fence, p1, p2);
+    EXPECT_EQ(grid.intersects(p1, p2), expected) << "(" << p1.x << "," << p1.y << ") to (" << p2.x << "," << p2.y << ")";
+    EXPECT_EQ(grid.intersects(p2, p1), intersects_brute_force(fence, p2, p1)) << "(" << p2.x << "," << p2.y << ") to (" << p1.x << "," << p1.y << ")";
+    if (expected) {
+        num_intersecting++;
+    }
+}
+
+/*
+  cell borders the same way as AP_OASegmentGrid::build(): square cells
+  with roughly one cell per segment, starting from the bottom left
+  corner of the bounding box of all points
+ */
+static void grid_geometry(const TestFence &fence, Vector2f &grid_min, Vector2f &grid_max, float &cell_size)
+{
+    grid_min = grid_max = fence.points[0][0];
+    for (uint8_t p = 0; p < fence.num_polygons; p++) {
+        for (uint16_t i = 0; i < fence.num_points[p]; i++) {
+            const Vector2f &v = fence.points[p][i];
+            grid_min.x = MIN(grid_min.x, v.x);
+            grid_min.y = MIN(grid_min.y, v.y);
+            grid_max.x = MAX(grid_max.x, v.x);
+            grid_max.y = MAX(grid_max.y, v.y);
+        }
+    }
+    const uint8_t dim = constrain_int16(ceilf(sqrtf(fence.total_points)), 1, 32);
+    const Vector2f size = grid_max - grid_min;
+    cell_size = MAX(size.x, size.y) / dim;
+}
+
+// random segments, some of which start or end outside the fence
+TEST(AP_OASegmentGrid, RandomSegments)
+{
+    test_rand_state = 1;
+    for (uint8_t n = 0; n < 20; n++) {
+        TestFence fence;
+        make_random_fence(fence, 10 + n * 9, n % MAX_POLYGONS);
+        AP_OASegmentGrid grid;
+        ASSERT_TRUE(build_grid(grid, fence));
+        EXPECT_EQ(grid.num_segments(), fence.total_points);
+
+        uint32_t num_intersecting = 0;
+        for (uint16_t i = 0; i < 2000; i++) {
+            const Vector2f p1 {test_rand_range(-12000, 12000), test_rand_range(-12000, 12000)};
+            // mix of short and long segments
+            const float len = (i % 2) ? 500 : 20000;
+            const Vector2f p2 = p1 + Vector2f{test_rand_range(-len, len), test_rand_range(-len, len)};
+            check_segment(grid, fence, p1, p2, num_intersecting);
+        }
+        // make sure both outcomes were tested
+        EXPECT_GT(num_intersecting, 0U);
+        EXPECT_LT(num_intersecting, 2000U);
+    }
+}
+
+// segments between fence vertices, as the visgraph build checks, which
+// touch edges at their end points
+TEST(AP_OASegmentGrid, VertexToVertex)
+{
+    test_rand_state = 2;
+    for (uint8_t n = 0; n < 5; n++) {
+        TestFence fence;
+        make_random_fence(fence, 30 + n * 20, 3 + n);
+        AP_OASegmentGrid grid;
+        ASSERT_TRUE(build_grid(grid, fence));
+
+        uint32_t num_intersecting = 0;
+        for (uint8_t p1 = 0; p1 < fence.num_polygons; p1++) {
+            for (uint16_t i = 0; i < fence.num_points[p1]; i++) {
+                for (uint8_t p2 = 0; p2 < fence.num_polygons; p2++) {
+                    for (uint16_t j = 0; j < fence.num_points[p2]; j += 3) {
+                        check_segment(grid, fence, fence.points[p1][i], fence.points[p2][j], num_intersecting);
+                    }
+                }
+            }
+        }
+        EXPECT_GT(num_intersecting, 0U);
+
+        // segments that stop exactly on an edge, or pass through a vertex
+        for (uint8_t p = 0; p < fence.num_polygons; p++) {
+            const uint16_t num_points = fence.num_points[p];
+            for (uint16_t i = 0; i < num_points; i++) {
+                const Vector2f &v1 = fence.points[p][i];
+                const Vector2f &v2 = fence.points[p][(i + 1) % num_points];
+                const Vector2f mid = (v1 + v2) * 0.5f;
+                const Vector2f outside {test_rand_range(-12000, 12000), test_rand_range(-12000, 12000)};
+                check_segment(grid, fence, outside, mid, num_intersecting);
+                check_segment(grid, fence, outside, v1, num_intersecting);
+                check_segment(grid, fence, outside, v1 + (v1 - outside), num_intersecting);
+            }
+        }
+    }
+}
+
+// horizontal and vertical segments lying along cell borders, and
+// polygons whose vertices and edges lie on cell borders
+TEST(AP_OASegmentGrid, CellBorders)
+{
+    test_rand_state = 3;
+    TestFence fence;
+    make_random_fence(fence, 100, 4);
+
+    // add an axis aligned staircase polygon of 8 points with vertices
+    // on cell corners.  It lies inside the fence's bounding box, so
+    // only its number of points changes the cells
+    fence.total_points += 8;
+    Vector2f grid_min, grid_max;
+    float cell_size;
+    grid_geometry(fence, grid_min, grid_max, cell_size);
+    const uint8_t p = fence.num_polygons++;
+    const Vector2f c = grid_min + Vector2f{cell_size, cell_size} * 4;
+    const float s = cell_size;
+    const Vector2f stairs[] {
+        c, c + Vector2f{3*s, 0}, c + Vector2f{3*s, s}, c + Vector2f{2*s, s},
+        c + Vector2f{2*s, 2*s}, c + Vector2f{s, 2*s}, c + Vector2f{s, 3*s}, c + Vector2f{0, 3*s},
+    };
+    memcpy(fence.points[p], stairs, sizeof(stairs));
+    fence.num_points[p] = ARRAY_SIZE(stairs);
+
+    AP_OASegmentGrid grid;
+    ASSERT_TRUE(build_grid(grid, fence));
+
+    uint32_t num_intersecting = 0;
+    const uint8_t num_cells = ceilf(MAX(grid_max.x - grid_min.x, grid_max.y - grid_min.y) / cell_size);
+    for (uint8_t k = 0; k <= num_cells; k++) {
+        const float border = k * cell_size;
+        // full length borders, and borders slightly beyond the grid
+        check_segment(grid, fence, grid_min + Vector2f{border, -s}, grid_min + Vector2f{border, grid_max.y - grid_min.y + s}, num_intersecting);
+        check_segment(grid, fence, grid_min + Vector2f{-s, border}, grid_min + Vector2f{grid_max.x - grid_min.x + s, border}, num_intersecting);
+        // one and two cell long pieces of each border
+        for (uint8_t j = 0; j < num_cells; j++) {
+            const float len = (j % 2 + 1) * cell_size;
+            check_segment(grid, fence, grid_min + Vector2f{border, j * s}, grid_min + Vector2f{border, j * s + len}, num_intersecting);
+            check_segment(grid, fence, grid_min + Vector2f{j * s, border}, grid_min + Vector2f{j * s + len, border}, num_intersecting);
+        }
+    }
+
+    // segments from the staircase corners, which lie on cell corners
+    for (uint8_t i = 0; i < ARRAY_SIZE(stairs); i++) {
+        for (uint8_t j = 0; j < ARRAY_SIZE(stairs); j++) {
+            check_segment(grid, fence, stairs[i], stairs[j], num_intersecting);
+        }
+        check_segment(grid, fence, stairs[i], stairs[i] + Vector2f{-2*s, 2*s}, num_intersecting);
+        check_segment(grid, fence, stairs[i], stairs[i] + Vector2f{2*s, -2*s}, num_intersecting);
+    }
+    EXPECT_GT(num_intersecting, 0U);
+}
+
+// an empty grid, or one whose build failed, reports no intersections
+TEST(AP_OASegmentGrid, Empty)
+{
+    AP_OASegmentGrid grid;
+    EXPECT_FALSE(grid.intersects(Vector2f{0, 0}, Vector2f{100, 100}));
+    ASSERT_TRUE(grid.reserve(0, 0));
+    ASSERT_TRUE(grid.build());
+    EXPECT_FALSE(grid.intersects(Vector2f{0, 0}, Vector2f{100, 100}));
+}
+
+#endif  // AP_OAPATHPLANNER_ENABLED
+
+AP_GTEST_MAIN()
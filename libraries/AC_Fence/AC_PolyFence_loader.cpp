@@ -227,9 +227,37 @@ bool AC_PolyFence_loader::breached() const
     return breached(loc);
 }
 
+// calculate bounding box of a polygon's points
+void AC_PolyFence_loader::BoundingBox::set(const Vector2f *points, const Vector2l *points_lla, uint8_t count)
+{
+    min_cm = max_cm = points[0];
+    min_lla = max_lla = points_lla[0];
+    for (uint8_t i=1; i<count; i++) {
+        min_cm.x = MIN(min_cm.x, points[i].x);
+        min_cm.y = MIN(min_cm.y, points[i].y);
+        max_cm.x = MAX(max_cm.x, points[i].x);
+        max_cm.y = MAX(max_cm.y, points[i].y);
+        min_lla.x = MIN(min_lla.x, points_lla[i].x);
+        min_lla.y = MIN(min_lla.y, points_lla[i].y);
+        max_lla.x = MAX(max_lla.x, points_lla[i].x);
+        max_lla.y = MAX(max_lla.y, points_lla[i].y);
+    }
+}
+
+// distance (in cm) from pos to the box, a lower bound on the distance to the polygon's edges
+float AC_PolyFence_loader::BoundingBox::distance_cm(const Vector2f &pos) const
+{
+    const float dx = MAX(MAX(min_cm.x - pos.x, pos.x - max_cm.x), 0.0f);
+    const float dy = MAX(MAX(min_cm.y - pos.y, pos.y - max_cm.y), 0.0f);
+    return norm(dx, dy);
+}
+
 // check if a position (expressed as lat/lng) is within the boundary
 //   returns true if location is outside the boundary
-bool AC_PolyFence_loader::breached(const Location& loc, float& distance_outside_fence) const
+//   distance_outside_fence is only calculated if it is not nullptr.
+//   Polygons whose bounding box shows they cannot contain the location
+//   or change the distance are skipped without examining their edges
+bool AC_PolyFence_loader::check_breach(const Location& loc, float *distance_outside_fence_ptr) const
 {
     if (!loaded() || total_fence_count() == 0) {
         return false;
@@ -241,6 +269,10 @@ bool AC_PolyFence_loader::breached(const Location& loc, float& distance_outside_
         return false;
     }
 
+    const bool want_distance = (distance_outside_fence_ptr != nullptr);
+    float unused_distance;
+    float &distance_outside_fence = want_distance ? *distance_outside_fence_ptr : unused_distance;
+
     const uint16_t num_inclusion = _num_loaded_circle_inclusion_boundaries + _num_loaded_inclusion_boundaries;
     uint16_t num_inclusion_outside = 0;
     distance_outside_fence = -FLT_MAX;
@@ -248,19 +280,33 @@ bool AC_PolyFence_loader::breached(const Location& loc, float& distance_outside_
     // check we are inside each inclusion zone:
     for (uint8_t i=0; i<_num_loaded_inclusion_boundaries; i++) {
         const InclusionBoundary &boundary = _loaded_inclusion_boundary[i];
+        const bool outside = boundary.bbox.outside(pos) || Polygon_outside(pos, boundary.points_lla, boundary.count);
+        if (outside) {
+            num_inclusion_outside++;
+        }
+        if (!want_distance) {
+            continue;
+        }
+        // skip distance calculation if the result could not change distance_outside_fence
+        if (outside) {
+            if (is_positive(distance_outside_fence) && (boundary.bbox.distance_cm(scaled_pos) * 0.01f >= distance_outside_fence)) {
+                continue;
+            }
+        } else if (distance_outside_fence >= 0) {
+            continue;
+        }
         float distance;
-        bool valid_distance = Polygon_closest_distance_point(boundary.points, boundary.count, scaled_pos, distance);
+        if (!Polygon_closest_distance_point(boundary.points, boundary.count, scaled_pos, distance)) {
+            continue;
+        }
         distance *= 0.01f; // convert back to meters
-        if (Polygon_outside(pos, boundary.points_lla, boundary.count)) {
-            num_inclusion_outside++;
-            if (valid_distance) {
-                if (is_positive(distance_outside_fence)) {
-                    distance_outside_fence = MIN(distance_outside_fence, distance);
-                } else {
-                    distance_outside_fence = distance;
-                }
+        if (outside) {
+            if (is_positive(distance_outside_fence)) {
+                distance_outside_fence = MIN(distance_outside_fence, distance);
+            } else {
+                distance_outside_fence = distance;
             }
-        } else if (valid_distance) {
+        } else {
             distance_outside_fence = MAX(distance_outside_fence, -distance);
         }
     }
@@ -269,18 +315,23 @@ bool AC_PolyFence_loader::breached(const Location& loc, float& distance_outside_
     for (uint8_t i=0; i<_num_loaded_exclusion_boundaries; i++) {
         const ExclusionBoundary &boundary = _loaded_exclusion_boundary[i];
         float distance;
-        bool valid_distance = Polygon_closest_distance_point(boundary.points, boundary.count, scaled_pos, distance);
-        distance *= 0.01f; // convert back to meters
-        if (!Polygon_outside(pos, boundary.points_lla, boundary.count)) {
-            if (valid_distance) {
-                distance_outside_fence = distance;
+        if (boundary.bbox.outside(pos) || Polygon_outside(pos, boundary.points_lla, boundary.count)) {
+            // skip distance calculation if the result could not change distance_outside_fence
+            if (want_distance &&
+                (distance_outside_fence < -boundary.bbox.distance_cm(scaled_pos) * 0.01f) &&
+                Polygon_closest_distance_point(boundary.points, boundary.count, scaled_pos, distance)) {
+                distance_outside_fence = MAX(distance_outside_fence, -distance * 0.01f);
+            }
+            continue;
+        }
+        if (want_distance) {
+            if (Polygon_closest_distance_point(boundary.points, boundary.count, scaled_pos, distance)) {
+                distance_outside_fence = distance * 0.01f;
             } else {
                 distance_outside_fence = 0.0f;
             }
-            return true;
-        } else if (valid_distance) {
-            distance_outside_fence = MAX(distance_outside_fence, -distance);
         }
+        return true;
     }
 
     for (uint8_t i=0; i<_num_loaded_circle_exclusion_boundaries; i++) {
@@ -784,6 +835,7 @@ bool AC_PolyFence_loader::load_from_storage()
                 storage_valid = false;
                 break;
             }
+            boundary.bbox.set(boundary.points, boundary.points_lla, boundary.count);
             _num_loaded_inclusion_boundaries++;
             break;
         }
@@ -803,6 +855,7 @@ bool AC_PolyFence_loader::load_from_storage()
                 storage_valid = false;
                 break;
             }
+            boundary.bbox.set(boundary.points, boundary.points_lla, boundary.count);
             _num_loaded_exclusion_boundaries++;
             break;
         }
@@ -54,6 +54,7 @@ public:
 
 class AC_PolyFence_loader
 {
+    friend class AC_PolyFence_loader_Test;
 
 public:
 
@@ -146,12 +147,14 @@ public:
     //  breached() - returns true if the vehicle has breached any fence
     bool breached() const WARN_IF_UNUSED;
     //  returns true if location is outside the boundary also returns the minimum distance to the fence
-    bool breached(const Location& loc, float& distance_outside_fence) const WARN_IF_UNUSED;
+    bool breached(const Location& loc, float& distance_outside_fence) const WARN_IF_UNUSED
+    {
+        return check_breach(loc, &distance_outside_fence);
+    }
     //  breached(Location&) - returns true if location is outside the boundary
     bool breached(const Location& loc) const WARN_IF_UNUSED
     {
-        float distance_outside_fence;
-        return breached(loc, distance_outside_fence);
+        return check_breach(loc, nullptr);
     }
 
     // returns true if a polygonal include fence could be returned
@@ -293,6 +296,32 @@ private:
     // example, in _loaded_offsets_from_origin
     void unload();
 
+    // returns true if location is outside the boundary.  The distance
+    // to the fence is only calculated if distance_outside_fence is
+    // not nullptr
+    bool check_breach(const Location& loc, float *distance_outside_fence) const WARN_IF_UNUSED;
+
+    // axis-aligned bounding box of a polygon, calculated when the
+    // polygon is loaded so that breach checks can skip polygons the
+    // vehicle is nowhere near
+    class BoundingBox {
+    public:
+        // calculate box from polygon points
+        void set(const Vector2f *points, const Vector2l *points_lla, uint8_t count);
+        // returns true if pos_lla is definitely outside the polygon
+        bool outside(const Vector2l &pos_lla) const {
+            return (pos_lla.x < min_lla.x) || (pos_lla.x > max_lla.x) ||
+                   (pos_lla.y < min_lla.y) || (pos_lla.y > max_lla.y);
+        }
+        // distance (in cm) from pos to the box, a lower bound on the distance to the polygon's edges
+        float distance_cm(const Vector2f &pos) const;
+    private:
+        Vector2f min_cm;
+        Vector2f max_cm;
+        Vector2l min_lla;
+        Vector2l max_lla;
+    };
+
     // pointer into _loaded_offsets_from_origin where the return point
     // can be found:
     Vector2f *_loaded_return_point;
@@ -306,6 +335,7 @@ private:
         Vector2f *points; // pointer into the _loaded_offsets_from_origin array
         Vector2l *points_lla; // pointer into the _loaded_points_lla array
         uint8_t count; // count of points in the boundary
+        BoundingBox bbox; // bounds of points
     };
     InclusionBoundary *_loaded_inclusion_boundary;
 
@@ -316,6 +346,7 @@ private:
         Vector2f *points; // pointer into the _loaded_offsets_from_origin array
         Vector2l *points_lla; // pointer into the _loaded_points_lla_lla array
         uint8_t count; // count of points in the boundary
+        BoundingBox bbox; // bounds of points
     };
     ExclusionBoundary *_loaded_exclusion_boundary;
 
@@ -0,0 +1,326 @@
+#include <AP_gtest.h>
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
+
+#include <AC_Fence/AC_Fence.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_FENCE_ENABLED
+
+/*
+  check AC_PolyFence_loader::check_breach(), which uses each
+  polygon's bounding box to skip polygons, gives the same breach
+  result and distance as examining every polygon, which is what
+  breached() did before the bounding boxes were added
+ */
+
+#define MAX_POLYGONS        10
+#define MAX_POLYGON_POINTS  12
+#define MAX_CIRCLES         3
+
+// fence with positions in metres north and east of the origin
+struct TestFence {
+    struct {
+        Vector2f points[MAX_POLYGON_POINTS];
+        uint8_t count;
+    } inclusion[MAX_POLYGONS], exclusion[MAX_POLYGONS];
+    uint8_t num_inclusion;
+    uint8_t num_exclusion;
+    struct {
+        Vector2f centre;
+        float radius;
+    } inclusion_circle[MAX_CIRCLES], exclusion_circle[MAX_CIRCLES];
+    uint8_t num_inclusion_circle;
+    uint8_t num_exclusion_circle;
+};
+
+static const Location origin { -353632610, 1491652300, 0, Location::AltFrame::ABSOLUTE };
+
+static uint32_t test_rand_state = 1;
+
+// simple repeatable pseudo random number in the range 0 to 1
+static float test_rand_float()
+{
+    test_rand_state = test_rand_state * 1103515245U + 12345U;
+    return ((test_rand_state >> 8) & 0xFFFF) / 65535.0f;
+}
+
+static float test_rand_range(float low, float high)
+{
+    return low + (high - low) * test_rand_float();
+}
+
+static uint8_t test_rand_int(uint8_t low, uint8_t high)
+{
+    return MIN(uint8_t(low + (high + 1 - low) * test_rand_float()), high);
+}
+
+static Vector2l offset_to_latlon(const Vector2f &ne)
+{
+    Location loc = origin;
+    loc.offset(ne.x, ne.y);
+    return Vector2l{loc.lat, loc.lng};
+}
+
+// irregular star shaped polygon around centre
+static uint8_t make_star_polygon(Vector2f *points, const Vector2f &centre, float radius)
+{
+    const uint8_t count = test_rand_int(3, MAX_POLYGON_POINTS);
+    for (uint8_t i = 0; i < count; i++) {
+        const float angle = M_2PI * i / count;
+        const float r = radius * test_rand_range(0.3f, 1.0f);
+        points[i] = Vector2f{centre.x + r * cosf(angle), centre.y + r * sinf(angle)};
+    }
+    return count;
+}
+
+// large inclusion polygons and circles around the origin with small
+// exclusion zones scattered over them
+static void make_random_fence(TestFence &fence)
+{
+    fence = {};
+    do {
+        fence.num_inclusion = test_rand_int(0, 2);
+        fence.num_exclusion = test_rand_int(0, MAX_POLYGONS);
+        fence.num_inclusion_circle = test_rand_int(0, 1);
+        fence.num_exclusion_circle = test_rand_int(0, MAX_CIRCLES);
+    } while (fence.num_inclusion + fence.num_exclusion + fence.num_inclusion_circle + fence.num_exclusion_circle == 0);
+
+    for (uint8_t i = 0; i < fence.num_inclusion; i++) {
+        const Vector2f centre {test_rand_range(-100, 100), test_rand_range(-100, 100)};
+        fence.inclusion[i].count = make_star_polygon(fence.inclusion[i].points, centre, test_rand_range(300, 600));
+    }
+    for (uint8_t i = 0; i < fence.num_exclusion; i++) {
+        const Vector2f centre {test_rand_range(-500, 500), test_rand_range(-500, 500)};
+        fence.exclusion[i].count = make_star_polygon(fence.exclusion[i].points, centre, test_rand_range(10, 150));
+    }
+    for (uint8_t i = 0; i < fence.num_inclusion_circle; i++) {
+        fence.inclusion_circle[i].centre = Vector2f{test_rand_range(-100, 100), test_rand_range(-100, 100)};
+        fence.inclusion_circle[i].radius = test_rand_range(200, 700);
+    }
+    for (uint8_t i = 0; i < fence.num_exclusion_circle; i++) {
+        fence.exclusion_circle[i].centre = Vector2f{test_rand_range(-500, 500), test_rand_range(-500, 500)};
+        fence.exclusion_circle[i].radius = test_rand_range(10, 100);
+    }
+}
+
+class AC_PolyFence_loader_Test {
+public:
+    // fill in the loaded fence the same way load_from_storage() does
+    static void load(AC_PolyFence_loader &loader, const TestFence &fence)
+    {
+        uint16_t total_points = 0;
+        for (uint8_t i = 0; i < fence.num_inclusion; i++) {
+            total_points += fence.inclusion[i].count;
+        }
+        for (uint8_t i = 0; i < fence.num_exclusion; i++) {
+            total_points += fence.exclusion[i].count;
+        }
+        loader._loaded_offsets_from_origin = new Vector2f[total_points];
+        loader._loaded_points_lla = new Vector2l[total_points];
+        loader._loaded_inclusion_boundary = new AC_PolyFence_loader::InclusionBoundary[fence.num_inclusion];
+        loader._loaded_exclusion_boundary = new AC_PolyFence_loader::ExclusionBoundary[fence.num_exclusion];
+        loader._loaded_circle_inclusion_boundary = new AC_PolyFence_loader::InclusionCircle[fence.num_inclusion_circle];
+        loader._loaded_circle_exclusion_boundary = new AC_PolyFence_loader::ExclusionCircle[fence.num_exclusion_circle];
+        loader.loaded_origin = origin;
+
+        Vector2f *next_point = loader._loaded_offsets_from_origin;
+        Vector2l *next_point_lla = loader._loaded_points_lla;
+        for (uint8_t i = 0; i < fence.num_inclusion; i++) {
+            AC_PolyFence_loader::InclusionBoundary &boundary = loader._loaded_inclusion_boundary[i];
+            boundary.points = next_point;
+            boundary.points_lla = next_point_lla;
+            boundary.count = fence.inclusion[i].count;
+            add_points(loader, fence.inclusion[i].points, boundary.count, next_point, next_point_lla);
+            boundary.bbox.set(boundary.points, boundary.points_lla, boundary.count);
+        }
+        loader._num_loaded_inclusion_boundaries = fence.num_inclusion;
+        for (uint8_t i = 0; i < fence.num_exclusion; i++) {
+            AC_PolyFence_loader::ExclusionBoundary &boundary = loader._loaded_exclusion_boundary[i];
+            boundary.points = next_point;
+            boundary.points_lla = next_point_lla;
+            boundary.count = fence.exclusion[i].count;
+            add_points(loader, fence.exclusion[i].points, boundary.count, next_point, next_point_lla);
+            boundary.bbox.set(boundary.points, boundary.points_lla, boundary.count);
+        }
+        loader._num_loaded_exclusion_boundaries = fence.num_exclusion;
+        for (uint8_t i = 0; i < fence.num_inclusion_circle; i++) {
+            AC_PolyFence_loader::InclusionCircle &circle = loader._loaded_circle_inclusion_boundary[i];
+            circle.point = offset_to_latlon(fence.inclusion_circle[i].centre);
+            IGNORE_RETURN(loader.scale_latlon_from_origin(origin, circle.point, circle.pos_cm));
+            circle.radius = fence.inclusion_circle[i].radius;
+        }
+        loader._num_loaded_circle_inclusion_boundaries = fence.num_inclusion_circle;
+        for (uint8_t i = 0; i < fence.num_exclusion_circle; i++) {
+            AC_PolyFence_loader::ExclusionCircle &circle = loader._loaded_circle_exclusion_boundary[i];
+            circle.point = offset_to_latlon(fence.exclusion_circle[i].centre);
+            IGNORE_RETURN(loader.scale_latlon_from_origin(origin, circle.point, circle.pos_cm));
+            circle.radius = fence.exclusion_circle[i].radius;
+        }
+        loader._num_loaded_circle_exclusion_boundaries = fence.num_exclusion_circle;
+        loader._load_time_ms = 1;
+    }
+
+    static void unload(AC_PolyFence_loader &loader)
+    {
+        loader.unload();
+        loader._load_time_ms = 0;
+    }
+
+    static bool check_breach(const AC_PolyFence_loader &loader, const Location &loc, float *distance_outside_fence)
+    {
+        return loader.check_breach(loc, distance_outside_fence);
+    }
+
+    // the breach check before bounding boxes were added, which
+    // examines every polygon
+    static bool breached_brute_force(const AC_PolyFence_loader &loader, const Location &loc, float &distance_outside_fence)
+    {
+        Vector2f scaled_pos;
+        Vector2l pos { loc.lat, loc.lng };
+        if (!loader.scale_latlon_from_origin(loader.loaded_origin, pos, scaled_pos)) {
+            return false;
+        }
+
+        const uint16_t num_inclusion = loader._num_loaded_circle_inclusion_boundaries + loader._num_loaded_inclusion_boundaries;
+        uint16_t num_inclusion_outside = 0;
+        distance_outside_fence = -FLT_MAX;
+
+        for (uint8_t i=0; i<loader._num_loaded_inclusion_boundaries; i++) {
+            const AC_PolyFence_loader::InclusionBoundary &boundary = loader._loaded_inclusion_boundary[i];
+            float distance;
+            bool valid_distance = Polygon_closest_distance_point(boundary.points, boundary.count, scaled_pos, distance);
+            distance *= 0.01f;
+            if (Polygon_outside(pos, boundary.points_lla, boundary.count)) {
+                num_inclusion_outside++;
+                if (valid_distance) {
+                    if (is_positive(distance_outside_fence)) {
+                        distance_outside_fence = MIN(distance_outside_fence, distance);
+                    } else {
+                        distance_outside_fence = distance;
+                    }
+                }
+            } else if (valid_distance) {
+                distance_outside_fence = MAX(distance_outside_fence, -distance);
+            }
+        }
+
+        for (uint8_t i=0; i<loader._num_loaded_exclusion_boundaries; i++) {
+            const AC_PolyFence_loader::ExclusionBoundary &boundary = loader._loaded_exclusion_boundary[i];
+            float distance;
+            bool valid_distance = Polygon_closest_distance_point(boundary.points, boundary.count, scaled_pos, distance);
+            distance *= 0.01f;
+            if (!Polygon_outside(pos, boundary.points_lla, boundary.count)) {
+                distance_outside_fence = valid_distance ? distance : 0.0f;
+                return true;
+            } else if (valid_distance) {
+                distance_outside_fence = MAX(distance_outside_fence, -distance);
+            }
+        }
+
+        for (uint8_t i=0; i<loader._num_loaded_circle_exclusion_boundaries; i++) {
+            const AC_PolyFence_loader::ExclusionCircle &circle = loader._loaded_circle_exclusion_boundary[i];
+            Location circle_center;
+            circle_center.lat = circle.point.x;
+            circle_center.lng = circle.point.y;
+            const float diff_cm = loc.get_distance(circle_center)*100.0f;
+            distance_outside_fence = MAX(distance_outside_fence, circle.radius - diff_cm*0.01f);
+            if (diff_cm < circle.radius * 100.0f) {
+                return true;
+            }
+        }
+
+        for (uint8_t i=0; i<loader._num_loaded_circle_inclusion_boundaries; i++) {
+            const AC_PolyFence_loader::InclusionCircle &circle = loader._loaded_circle_inclusion_boundary[i];
+            Location circle_center;
+            circle_center.lat = circle.point.x;
+            circle_center.lng = circle.point.y;
+            const float diff_cm = loc.get_distance(circle_center)*100.0f;
+            distance_outside_fence = MAX(distance_outside_fence, diff_cm*0.01f - circle.radius);
+            if (diff_cm > circle.radius * 100.0f) {
+                num_inclusion_outside++;
+            }
+        }
+
+        if (AC_Fence::option_enabled(AC_Fence::OPTIONS::INCLUSION_UNION, loader._options)) {
+            if (num_inclusion > 0 && num_inclusion == num_inclusion_outside) {
+                return true;
+            }
+        } else if (num_inclusion_outside > 0) {
+            return true;
+        }
+
+        if (is_equal(distance_outside_fence, -FLT_MAX)) {
+            distance_outside_fence = 0.0f;
+        }
+        return false;
+    }
+
+private:
+    static void add_points(const AC_PolyFence_loader &loader, const Vector2f *points, uint8_t count, Vector2f *&next_point, Vector2l *&next_point_lla)
+    {
+        for (uint8_t i = 0; i < count; i++) {
+            *next_point_lla = offset_to_latlon(points[i]);
+            IGNORE_RETURN(loader.scale_latlon_from_origin(origin, *next_point_lla, *next_point));
+            next_point++;
+            next_point_lla++;
+        }
+    }
+};
+
+// compare culled and brute force checks at loc, with and without a distance
+static void check_location(const AC_PolyFence_loader &loader, const Location &loc, uint32_t &num_breached)
+{
+    float expected_distance;
+    const bool expected = AC_PolyFence_loader_Test::breached_brute_force(loader, loc, expected_distance);
+    float distance;
+    EXPECT_EQ(AC_PolyFence_loader_Test::check_breach(loader, loc, &distance), expected) << loc.lat << "," << loc.lng;
+    EXPECT_NEAR(distance, expected_distance, 1e-3) << loc.lat << "," << loc.lng;
+    EXPECT_EQ(AC_PolyFence_loader_Test::check_breach(loader, loc, nullptr), expected) << loc.lat << "," << loc.lng;
+    if (expected) {
+        num_breached++;
+    }
+}
+
+// random fences with random locations over and around them, and at
+// polygon vertices where the bounding boxes are touched
+TEST(AC_PolyFence_loader, BreachMatchesBruteForce)
+{
+    test_rand_state = 1;
+    AP_Int8 total;
+    AP_Int16 options;
+    uint32_t num_breached = 0;
+    uint32_t num_checked = 0;
+    for (uint16_t n = 0; n < 200; n++) {
+        options.set((n % 2) ? int16_t(AC_Fence::OPTIONS::INCLUSION_UNION) : 0);
+        AC_PolyFence_loader loader { total, options };
+        TestFence fence;
+        make_random_fence(fence);
+        AC_PolyFence_loader_Test::load(loader, fence);
+
+        for (uint16_t i = 0; i < 500; i++) {
+            const Vector2l latlon = offset_to_latlon(Vector2f{test_rand_range(-800, 800), test_rand_range(-800, 800)});
+            const Location loc { latlon.x, latlon.y, 0, Location::AltFrame::ABSOLUTE };
+            check_location(loader, loc, num_breached);
+            num_checked++;
+        }
+        for (uint8_t i = 0; i < fence.num_exclusion; i++) {
+            for (uint8_t j = 0; j < fence.exclusion[i].count; j++) {
+                const Vector2l latlon = offset_to_latlon(fence.exclusion[i].points[j]);
+                const Location loc { latlon.x, latlon.y, 0, Location::AltFrame::ABSOLUTE };
+                check_location(loader, loc, num_breached);
+                num_checked++;
+            }
+        }
+
+        AC_PolyFence_loader_Test::unload(loader);
+    }
+    // make sure both outcomes were tested
+    EXPECT_GT(num_breached, num_checked / 10);
+    EXPECT_LT(num_breached, num_checked - num_checked / 10);
+}
+
+#endif  // AP_FENCE_ENABLED
+
+AP_GTEST_MAIN()
@@ -63,6 +63,12 @@ int AP_Filesystem_Param::open(const char *fname, int flags, bool allow_absolute_
     r.file_ofs = 0;
     r.open = true;
     r.with_defaults = false;
+    r.with_snapshot = false;
+    r.delta = false;
+#if AP_PARAM_CHANGE_JOURNAL_ENABLED
+    r.changed = nullptr;
+    r.num_changed = 0;
+#endif
     r.start = 0;
     r.count = 0;
     r.read_size = 0;
@@ -81,6 +87,7 @@ int AP_Filesystem_Param::open(const char *fname, int flags, bool allow_absolute_
     /*
       allow for URI style arguments param.pck?start=N&count=C
      */
+    uint64_t since_id = 0;
     const char *c = strchr(fname, '?');
     while (c && *c) {
         c++;
@@ -104,6 +111,15 @@ int AP_Filesystem_Param::open(const char *fname, int flags, bool allow_absolute_
             c = strchr(c, '&');
             continue;
         }
+#if AP_PARAM_CHANGE_JOURNAL_ENABLED
+        if (strncmp(c, "since=", 6) == 0) {
+            since_id = strtoull(c+6, nullptr, 10);
+            r.with_snapshot = true;
+            c += 6;
+            c = strchr(c, '&');
+            continue;
+        }
+#endif
 #if AP_PARAM_DEFAULTS_ENABLED
         if (strncmp(c, "withdefaults=", 13) == 0) {
             uint32_t v = strtoul(c+13, nullptr, 10);
@@ -118,15 +134,111 @@ int AP_Filesystem_Param::open(const char *fname, int flags, bool allow_absolute_
 #endif
     }
 
+#if AP_PARAM_CHANGE_JOURNAL_ENABLED
+    if (r.with_snapshot && !setup_delta(r, since_id)) {
+        goto failed;
+    }
+#endif
+
     return idx;
 
 failed:
     delete [] r.cursors;
+#if AP_PARAM_CHANGE_JOURNAL_ENABLED
+    delete [] r.changed;
+    r.changed = nullptr;
+#endif
     r.open = false;
     errno = EINVAL;
     return -1;
 }
 
+#if AP_PARAM_CHANGE_JOURNAL_ENABLED
+uint64_t AP_Filesystem_Param::snapshot_id(uint32_t seq)
+{
+    while (snapshot_nonce == 0) {
+        snapshot_nonce = (uint32_t(get_random16()) << 16) ^ get_random16() ^ AP_HAL::micros();
+    }
+    return (uint64_t(snapshot_nonce) << 32) | seq;
+}
+
+/*
+  get the change sequence number for a snapshot id from this boot.
+  The id holds the whole sequence number, which can advance at loop
+  rate, so it is never mistaken for a later one
+ */
+bool AP_Filesystem_Param::snapshot_seq(uint64_t id, uint32_t until_seq, uint32_t &seq)
+{
+    if (snapshot_nonce == 0 || uint32_t(id >> 32) != snapshot_nonce) {
+        return false;
+    }
+    seq = uint32_t(id);
+    return seq <= until_seq;
+}
+
+/*
+  setup a file opened with since=ID. If ID is the snapshot of an
+  earlier download this boot, and the change journal still covers
+  every change since then, only the changed parameters are sent.
+  Otherwise all parameters are sent
+ */
+bool AP_Filesystem_Param::setup_delta(struct rfile &r, uint64_t since_id)
+{
+    if (r.start != 0 || r.count != 0) {
+        // a delta can't be combined with a subset
+        return false;
+    }
+    r.until_seq = AP_Param::change_seq();
+    r.snapshot = snapshot_id(r.until_seq);
+#if AP_PARAM_CHANGE_JOURNAL_SET_ENABLED
+    r.delta = snapshot_seq(since_id, r.until_seq, r.since_seq) &&
+        AP_Param::change_journal_covers(r.since_seq);
+#else
+    // the journal doesn't see changes made with set(), so a delta
+    // could leave the GCS with stale values
+    r.delta = false;
+#endif
+    if (!r.delta) {
+        return true;
+    }
+    // take the set of changed variables now so that later changes
+    // can't make the parameters sent disagree with the header count
+    r.changed = NEW_NOTHROW AP_Param::ChangedVar[AP_PARAM_CHANGE_JOURNAL_SIZE];
+    if (r.changed == nullptr) {
+        // send everything
+        r.delta = false;
+        return true;
+    }
+    r.num_changed = AP_Param::changed_between(r.since_seq, r.until_seq, r.changed);
+
+    // count the changed parameters for the header
+    r.num_delta = 0;
+    AP_Param::ParamToken token {};
+    enum ap_var_type ptype;
+    for (AP_Param *ap = AP_Param::first(&token, &ptype);
+         ap != nullptr;
+         ap = AP_Param::next_scalar(&token, &ptype)) {
+        if (in_delta(r, ap)) {
+            r.num_delta++;
+        }
+    }
+    return true;
+}
+
+/*
+  true if ap was one of the variables changed when a delta was opened
+ */
+bool AP_Filesystem_Param::in_delta(const struct rfile &r, const AP_Param *ap) const
+{
+    for (uint8_t i=0; i<r.num_changed; i++) {
+        if (r.changed[i].contains(ap)) {
+            return true;
+        }
+    }
+    return false;
+}
+#endif  // AP_PARAM_CHANGE_JOURNAL_ENABLED
+
 int AP_Filesystem_Param::close(int fd)
 {
     if (fd < 0 || fd >= max_open_file || !file[fd].open) {
@@ -142,6 +254,10 @@ int AP_Filesystem_Param::close(int fd)
     r.open = false;
     delete [] r.cursors;
     r.cursors = nullptr;
+#if AP_PARAM_CHANGE_JOURNAL_ENABLED
+    delete [] r.changed;
+    r.changed = nullptr;
+#endif
     delete r.writebuf;
     r.writebuf = nullptr;
     return ret;
@@ -154,6 +270,13 @@ int AP_Filesystem_Param::close(int fd)
       uint16_t num_params
       uint16_t total_params
 
+    or when the since= query is given:
+      uint16_t magic = 0x671d
+      uint16_t num_params
+      uint16_t total_params
+      uint16_t flags        // bit 0: delta, bit 1: includes default values
+      uint64_t snapshot     // pass as since= to get later changes
+
     per-parameter:
 
     uint8_t type:4;         // AP_Param type NONE=0, INT8=1, INT16=2, INT32=3, FLOAT=4
@@ -191,8 +314,16 @@ uint8_t AP_Filesystem_Param::pack_param(const struct rfile &r, struct cursor &c,
         c.idx++;
         ap = AP_Param::next_scalar(&c.token, &ptype, &default_val);
     }
+#if AP_PARAM_CHANGE_JOURNAL_ENABLED
+    if (r.delta) {
+        // skip parameters not changed since the requested snapshot
+        while (ap != nullptr && !in_delta(r, ap)) {
+            ap = AP_Param::next_scalar(&c.token, &ptype, &default_val);
+        }
+    }
+#endif
     if (ap == nullptr || (r.count && c.idx >= r.count)) {
-        if (r.count == 0 && c.idx != AP_Param::count_parameters()) {
+        if (r.count == 0 && !r.delta && c.idx != AP_Param::count_parameters()) {
             // the parameter count is incorrect, invalidate so a
             // repeated param download avoids an error
             AP_Param::invalidate_count();
@@ -230,7 +361,7 @@ uint8_t AP_Filesystem_Param::pack_param(const struct rfile &r, struct cursor &c,
       won't get a corrupt value for a parameter
      */
     if (type_len > 1) {
-        const uint32_t ofs = c.token_ofs + sizeof(struct header) + packed_len;
+        const uint32_t ofs = c.token_ofs + header_len(r) + packed_len;
         const uint32_t ofs_mod = ofs % r.read_size;
         if (ofs_mod > 0 && ofs_mod < type_len) {
             const uint8_t pad = type_len - ofs_mod;
@@ -280,6 +411,56 @@ uint8_t AP_Filesystem_Param::pack_param(const struct rfile &r, struct cursor &c,
     return packed_len;
 }
 
+/*
+  length of the file header
+ */
+uint8_t AP_Filesystem_Param::header_len(const struct rfile &r) const
+{
+    return r.with_snapshot ? sizeof(struct header_snapshot) : sizeof(struct header);
+}
+
+/*
+  fill in the file header. The buffer must be at least the size of
+  header_snapshot
+ */
+bool AP_Filesystem_Param::fill_header(const struct rfile &r, uint8_t *buf) const
+{
+    struct header hdr;
+    hdr.total_params = AP_Param::count_parameters();
+    if (hdr.total_params <= r.start) {
+        return false;
+    }
+    hdr.num_params = hdr.total_params - r.start;
+    if (r.count > 0 && hdr.num_params > r.count) {
+        hdr.num_params = r.count;
+    }
+    if (r.with_defaults) {
+        hdr.magic = pmagic_with_default;
+    }
+    if (!r.with_snapshot) {
+        memcpy(buf, &hdr, sizeof(hdr));
+        return true;
+    }
+
+#if AP_PARAM_CHANGE_JOURNAL_ENABLED
+    struct header_snapshot shdr;
+    shdr.total_params = hdr.total_params;
+    shdr.num_params = r.delta ? r.num_delta : hdr.num_params;
+    shdr.flags = 0;
+    if (r.delta) {
+        shdr.flags |= uint16_t(SnapshotFlags::DELTA);
+    }
+    if (r.with_defaults) {
+        shdr.flags |= uint16_t(SnapshotFlags::DEFAULTS);
+    }
+    shdr.snapshot = r.snapshot;
+    memcpy(buf, &shdr, sizeof(shdr));
+    return true;
+#else
+    return false;
+#endif
+}
+
 /*
   seek the token to match file offset
  */
@@ -357,23 +538,15 @@ int32_t AP_Filesystem_Param::read(int fd, void *buf, uint32_t count)
         }
     }
 
-    if (r.file_ofs < sizeof(struct header)) {
-        struct header hdr;
-        hdr.total_params = AP_Param::count_parameters();
-        if (hdr.total_params <= r.start) {
+    const uint8_t hdr_len = header_len(r);
+    if (r.file_ofs < hdr_len) {
+        uint8_t hbuf[sizeof(struct header_snapshot)];
+        if (!fill_header(r, hbuf)) {
             errno = EINVAL;
             return -1;
         }
-        hdr.num_params = hdr.total_params - r.start;
-        if (r.count > 0 && hdr.num_params > r.count) {
-            hdr.num_params = r.count;
-        }
-        uint8_t n = MIN(sizeof(hdr) - r.file_ofs, count);
-        if (r.with_defaults) {
-            hdr.magic = pmagic_with_default;
-        }
-        const uint8_t *b = (const uint8_t *)&hdr;
-        memcpy(buf, &b[r.file_ofs], n);
+        uint8_t n = MIN(hdr_len - r.file_ofs, count);
+        memcpy(buf, &hbuf[r.file_ofs], n);
         count -= n;
         header_total += n;
         r.file_ofs += n;
@@ -383,7 +556,7 @@ int32_t AP_Filesystem_Param::read(int fd, void *buf, uint32_t count)
         }
     }
 
-    uint32_t data_ofs = r.file_ofs - sizeof(struct header);
+    uint32_t data_ofs = r.file_ofs - hdr_len;
     uint8_t best_i = 0;
     uint32_t best_ofs = r.cursors[0].token_ofs;
     size_t total = 0;
@@ -49,6 +49,8 @@ private:
     // Support both protocol versions
     static constexpr uint16_t pmagic = 0x671b;
     static constexpr uint16_t pmagic_with_default = 0x671c;
+    // header with a snapshot id, used when the since= query is given
+    static constexpr uint16_t pmagic_with_snapshot = 0x671d;
 
     // header at front of the file
     struct header {
@@ -57,6 +59,22 @@ private:
         uint16_t total_params; // for upload this is total file length
     };
 
+    // flags in header_snapshot
+    enum class SnapshotFlags : uint16_t {
+        DELTA = (1U<<0),        // only parameters changed since the requested snapshot
+        DEFAULTS = (1U<<1),     // default values are included
+    };
+
+    // header at front of the file when the since= query is given
+    struct header_snapshot {
+        uint16_t magic = pmagic_with_snapshot;
+        uint16_t num_params;
+        uint16_t total_params;
+        uint16_t flags;
+        uint64_t snapshot;
+    };
+    static_assert(sizeof(struct header_snapshot) == 16, "Bad header_snapshot size!");
+
     struct cursor {
         AP_Param::ParamToken token;
         uint32_t token_ofs;
@@ -69,6 +87,16 @@ private:
     struct rfile {
         bool open;
         bool with_defaults;
+        bool with_snapshot;     // since= query given
+        bool delta;             // only send parameters changed in since_seq..until_seq
+        uint16_t num_delta;     // number of parameters in a delta
+        uint32_t since_seq;
+        uint32_t until_seq;     // AP_Param change sequence number when opened
+        uint64_t snapshot;      // snapshot id for until_seq
+#if AP_PARAM_CHANGE_JOURNAL_ENABLED
+        AP_Param::ChangedVar *changed;  // variables changed in since_seq..until_seq
+        uint8_t num_changed;
+#endif
         uint16_t read_size;
         uint16_t start;
         uint16_t count;
@@ -78,10 +106,22 @@ private:
         ExpandingString *writebuf; // for upload
     } file[max_open_file];
 
+    uint8_t header_len(const struct rfile &r) const;
+    bool fill_header(const struct rfile &r, uint8_t *buf) const;
     bool token_seek(const struct rfile &r, const uint32_t data_ofs, struct cursor &c);
     uint8_t pack_param(const struct rfile &r, struct cursor &c, uint8_t *buf);
     bool check_file_name(const char *fname);
 
+#if AP_PARAM_CHANGE_JOURNAL_ENABLED
+    // snapshot ids are a per-boot nonce in the top 32 bits and an
+    // AP_Param change sequence number in the low 32 bits
+    uint32_t snapshot_nonce;
+    uint64_t snapshot_id(uint32_t seq);
+    bool snapshot_seq(uint64_t id, uint32_t until_seq, uint32_t &seq);
+    bool setup_delta(struct rfile &r, uint64_t since_id);
+    bool in_delta(const struct rfile &r, const AP_Param *ap) const;
+#endif
+
     // finish uploading parameters
     bool finish_upload(const rfile &r);
     bool param_upload_parse(const rfile &r, bool &need_retry);
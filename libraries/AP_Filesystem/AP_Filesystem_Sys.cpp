@@ -26,6 +26,7 @@
 #include <AP_CANManager/AP_CANManager.h>
 #include <AP_Scheduler/AP_Scheduler.h>
 #include <AP_Common/ExpandingString.h>
+#include <StorageManager/StorageManager.h>
 
 extern const AP_HAL::HAL& hal;
 
@@ -52,6 +53,9 @@ static const SysFileList sysfs_file_list[] = {
 #endif
     {"crash_dump.bin"},
     {"storage.bin"},
+#if STORAGE_WRITEBACK_ENABLED
+    {"storage.txt"},
+#endif
 #if AP_FILESYSTEM_SYS_FLASH_ENABLED
     {"flash.bin"},
 #endif
@@ -151,10 +155,16 @@ int AP_Filesystem_Sys::open(const char *fname, int flags, bool allow_absolute_pa
         // we read directly from the storage driver
         void *ptr = nullptr;
         size_t size = 0;
+        StorageManager::flush();
         if (hal.storage->get_storage_ptr(ptr, size)) {
             r.str->set_buffer((char*)ptr, size, size);
         }
     }
+#if STORAGE_WRITEBACK_ENABLED
+    if (strcmp(fname, "storage.txt") == 0) {
+        StorageManager::writeback_info(*r.str);
+    }
+#endif
 #if AP_FILESYSTEM_SYS_FLASH_ENABLED
     if (strcmp(fname, "flash.bin") == 0) {
         void *ptr = (void*)0x08000000;
@@ -0,0 +1,143 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  measure the cost of passing gyro samples from an IMU backend to the
+  rate thread, using an ObjectBuffer protected by a semaphore as the
+  fast rate buffer used to, and using the lock-free ObjectBuffer_SPSC
+ */
+#include <AP_gbenchmark.h>
+
+#include <AP_HAL/utility/RingBuffer.h>
+#include <AP_Math/AP_Math.h>
+
+#include <thread>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#define BUFFER_SIZE 8
+
+// push batch samples then drain them one at a time under a semaphore
+static void BM_ObjectBufferLocked(benchmark::State& state)
+{
+    const uint8_t batch = state.range(0);
+    ObjectBuffer<Vector3f> buf{BUFFER_SIZE};
+    HAL_Semaphore sem;
+    Vector3f gyro {0.1f, 0.2f, 0.3f};
+
+    while (state.KeepRunning()) {
+        for (uint8_t i = 0; i < batch; i++) {
+            WITH_SEMAPHORE(sem);
+            buf.push(gyro);
+        }
+        for (uint8_t i = 0; i < batch; i++) {
+            WITH_SEMAPHORE(sem);
+            buf.pop(gyro);
+        }
+        gbenchmark_escape(&gyro);
+    }
+}
+
+// push batch samples then drain them with a single batched pop
+static void BM_ObjectBufferSPSC(benchmark::State& state)
+{
+    const uint8_t batch = state.range(0);
+    ObjectBuffer_SPSC<Vector3f, BUFFER_SIZE> buf;
+    Vector3f gyro {0.1f, 0.2f, 0.3f};
+    Vector3f out[BUFFER_SIZE];
+
+    while (state.KeepRunning()) {
+        for (uint8_t i = 0; i < batch; i++) {
+            buf.push(gyro);
+        }
+        buf.pop(out, batch);
+        gbenchmark_escape(out);
+    }
+}
+
+BENCHMARK(BM_ObjectBufferLocked)->Arg(1)->Arg(2)->Arg(4)->Arg(8);
+BENCHMARK(BM_ObjectBufferSPSC)->Arg(1)->Arg(2)->Arg(4)->Arg(8);
+
+#define STREAM_SAMPLES 100000
+
+/*
+  producer thread pushes a stream of samples as fast as it can while
+  the benchmark thread drains them. Reports the fraction of samples
+  dropped because the buffer was full
+ */
+static void BM_ObjectBufferLockedStream(benchmark::State& state)
+{
+    std::atomic<uint32_t> dropped{0};
+    while (state.KeepRunning()) {
+        ObjectBuffer<Vector3f> buf{BUFFER_SIZE};
+        HAL_Semaphore sem;
+        std::thread producer([&]() {
+            const Vector3f gyro {0.1f, 0.2f, 0.3f};
+            for (uint32_t i = 0; i < STREAM_SAMPLES; i++) {
+                WITH_SEMAPHORE(sem);
+                if (!buf.push(gyro)) {
+                    dropped++;
+                }
+            }
+        });
+        uint32_t received = 0;
+        Vector3f gyro;
+        while (received + dropped < STREAM_SAMPLES) {
+            bool popped;
+            {
+                WITH_SEMAPHORE(sem);
+                popped = buf.pop(gyro);
+            }
+            if (popped) {
+                received++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        producer.join();
+    }
+    state.counters["dropped"] = float(dropped) / (STREAM_SAMPLES * state.iterations());
+}
+
+static void BM_ObjectBufferSPSCStream(benchmark::State& state)
+{
+    std::atomic<uint32_t> dropped{0};
+    while (state.KeepRunning()) {
+        ObjectBuffer_SPSC<Vector3f, BUFFER_SIZE> buf;
+        std::thread producer([&]() {
+            const Vector3f gyro {0.1f, 0.2f, 0.3f};
+            for (uint32_t i = 0; i < STREAM_SAMPLES; i++) {
+                if (!buf.push(gyro)) {
+                    dropped++;
+                }
+            }
+        });
+        uint32_t received = 0;
+        Vector3f gyro[BUFFER_SIZE];
+        while (received + dropped < STREAM_SAMPLES) {
+            const uint32_t n = buf.pop(gyro, BUFFER_SIZE);
+            if (n == 0) {
+                std::this_thread::yield();
+            }
+            received += n;
+        }
+        producer.join();
+    }
+    state.counters["dropped"] = float(dropped) / (STREAM_SAMPLES * state.iterations());
+}
+
+BENCHMARK(BM_ObjectBufferLockedStream)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ObjectBufferSPSCStream)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -461,6 +461,79 @@ private:
     HAL_Semaphore sem;
 };
 
+/*
+  lock-free ring buffer for objects of fixed size with exactly one
+  producer thread and one consumer thread. push() must only be called
+  by the producer and pop() / clear() only by the consumer. Neither
+  side ever blocks. SIZE must be a power of 2
+ */
+template <class T, uint32_t SIZE>
+class ObjectBuffer_SPSC {
+public:
+    static_assert(SIZE > 0 && (SIZE & (SIZE - 1)) == 0, "ObjectBuffer_SPSC size must be a power of 2");
+
+    // return size of ringbuffer
+    uint32_t get_size(void) const {
+        return SIZE;
+    }
+
+    // return number of objects available to be read
+    uint32_t available(void) const {
+        return _write_idx.load() - _read_idx.load();
+    }
+
+    // return number of objects that could be written
+    uint32_t space(void) const {
+        return SIZE - available();
+    }
+
+    // true is available() == 0
+    bool is_empty(void) const {
+        return available() == 0;
+    }
+
+    // push one object, returns false if the buffer is full
+    bool push(const T &object) {
+        const uint32_t write_idx = _write_idx.load(std::memory_order_relaxed);
+        if (write_idx - _read_idx.load(std::memory_order_acquire) >= SIZE) {
+            return false;
+        }
+        _buffer[write_idx & (SIZE - 1)] = object;
+        _write_idx.store(write_idx + 1);
+        return true;
+    }
+
+    // pop one object
+    bool pop(T &object) {
+        return pop(&object, 1) == 1;
+    }
+
+    // pop up to max_objects objects, returns the number of objects popped
+    uint32_t pop(T *object, uint32_t max_objects) {
+        const uint32_t read_idx = _read_idx.load(std::memory_order_relaxed);
+        uint32_t n = _write_idx.load(std::memory_order_acquire) - read_idx;
+        if (n > max_objects) {
+            n = max_objects;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            object[i] = _buffer[(read_idx + i) & (SIZE - 1)];
+        }
+        _read_idx.store(read_idx + n, std::memory_order_release);
+        return n;
+    }
+
+    // throw away all objects
+    void clear(void) {
+        _read_idx.store(_write_idx.load());
+    }
+
+private:
+    T _buffer[SIZE];
+    // free running indexes, masked when accessing _buffer
+    std::atomic<uint32_t> _write_idx{0};
+    std::atomic<uint32_t> _read_idx{0};
+};
+
 /*
   ring buffer class for objects of fixed size with pointer
   access. Note that this is not thread safe, buf offers efficient
@@ -131,7 +131,8 @@ bool BinarySemaphore::wait(uint32_t timeout_us)
 bool BinarySemaphore::wait_blocking(void)
 {
     WITH_SEMAPHORE(mtx);
-    if (!pending) {
+    // loop to handle spurious wakeups
+    while (!pending) {
         if (pthread_cond_wait(&cond, &mtx._lock) != 0) {
             return false;
         }
@@ -348,10 +348,17 @@ public:
         void periodic();
 
         bool doing_sensor_rate_logging() const { return _doing_sensor_rate_logging; }
+        bool doing_sensor_rate_logging(uint8_t _instance, IMU_SENSOR_TYPE _type) const;
         bool doing_post_filter_logging() const {
+            if (streaming) {
+                return has_option(BATCH_OPT_POST_FILTER);
+            }
             return (_doing_post_filter_logging && (post_filter || !_doing_sensor_rate_logging))
                 || (_doing_pre_post_filter_logging && post_filter);
         }
+        // continuous streaming has its own sensor mask, so it is fed
+        // alongside raw IMU logging rather than instead of it
+        bool doing_streaming() const { return streaming; }
 
         // Getters for arming check
         bool is_initialised() const { return initialised; }
@@ -386,6 +393,7 @@ public:
             BATCH_OPT_SENSOR_RATE = (1<<0),
             BATCH_OPT_POST_FILTER = (1<<1),
             BATCH_OPT_PRE_POST_FILTER = (1<<2),
+            BATCH_OPT_STREAMING = (1<<3),
         };
 
         void rotate_to_next_sensor();
@@ -421,6 +429,65 @@ public:
         // all samples are multiplied by this
         uint16_t multiplier; // initialised as part of init()
 
+        /*
+          continuous streaming of every sensor in the mask at full
+          rate. The sensor backend fills one of two fixed blocks per
+          stream; the stream thread delta/varint compresses completed
+          blocks into ISBS messages. A sample arriving while both
+          blocks are full is dropped rather than blocking the backend.
+         */
+        static constexpr uint8_t STREAM_BLOCK_SAMPLES = 128;
+        static constexpr uint8_t STREAM_PKT_DATA_LEN = 192;
+        static constexpr uint8_t STREAM_MAX_SAMPLE_BYTES = 9; // three 16 bit values, varint encoded
+        struct stream_block {
+            int16_t data[STREAM_BLOCK_SAMPLES][3];
+            uint64_t start_us;              // time of first sample
+            uint64_t end_us;                // time of last sample
+            std::atomic<bool> full{false};  // set by the backend, cleared by the stream thread
+        };
+        struct stream_state {
+            stream_block block[2];
+            IMU_SENSOR_TYPE type;
+            uint8_t instance;
+            uint16_t multiplier;
+            bool sensor_rate;               // true if fed from the sensor rate callbacks
+            float requested_rate_hz;
+
+            // backend side
+            uint8_t write_block;
+            uint8_t write_count;
+            uint32_t dropped;
+
+            // stream thread side
+            uint8_t read_block;
+            uint8_t read_count;
+            uint16_t seqnum;
+            int16_t last[3];                // last sample encoded into pkt_data
+            uint8_t pkt_data[STREAM_PKT_DATA_LEN];
+            uint8_t pkt_len;
+            uint8_t pkt_count;
+            uint64_t pkt_sample_us;
+            uint32_t pkt_started_ms;
+
+            // rate reporting, logged as ISBR
+            uint32_t logged_samples;
+            uint32_t logged_bytes;
+            uint32_t last_dropped;
+        };
+        stream_state *streams;
+        uint8_t num_streams;
+        bool streaming;
+        uint32_t stream_report_ms;
+
+        void init_streaming();
+        stream_state *find_stream(uint8_t _instance, IMU_SENSOR_TYPE _type) const __RAMFUNC__;
+        void stream_sample(stream_state &st, uint64_t sample_us, const Vector3f &sample) __RAMFUNC__;
+        void stream_thread();
+        void push_stream_data_to_log(stream_state &st, bool logging);
+        bool encode_stream_sample(stream_state &st, const int16_t v[3], uint64_t sample_us);
+        bool Write_ISBS(stream_state &st);
+        void Write_ISBR(uint32_t dt_ms);
+
         const AP_InertialSensor &_imu;
     };
     BatchSampler batchsampler{*this};
@@ -817,6 +884,10 @@ public:
     void disable_fast_rate_buffer();
     // get the next available gyro sample from the fast rate buffer
     bool get_next_gyro_sample(Vector3f& gyro);
+    // get up to max_samples gyro samples from the fast rate buffer, returns the number of samples
+    uint8_t get_next_gyro_samples(Vector3f *gyro, uint8_t max_samples);
+    // get the number of gyro samples dropped because the fast rate buffer was full
+    uint32_t get_fast_rate_buffer_overruns() const;
     // get the number of available gyro samples in the fast rate buffer
     uint32_t get_num_gyro_samples();
     // set the rate at which samples are collected, unused samples are dropped
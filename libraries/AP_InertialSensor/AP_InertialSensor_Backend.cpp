@@ -474,9 +474,10 @@ void AP_InertialSensor_Backend::log_gyro_raw(uint8_t instance, const uint64_t sa
     const bool log_because_primary_gyro = false;
 #endif
 
-    if (_imu.raw_logging_option_set(AP_InertialSensor::RAW_LOGGING_OPTION::ALL_GYROS) ||
+    const bool log_raw = _imu.raw_logging_option_set(AP_InertialSensor::RAW_LOGGING_OPTION::ALL_GYROS) ||
         log_because_primary_gyro ||
-        should_log_imu_raw()) {
+        should_log_imu_raw();
+    if (log_raw) {
 
         if (_imu.raw_logging_option_set(AP_InertialSensor::RAW_LOGGING_OPTION::PRE_AND_POST_FILTER)) {
             // Both pre and post, offset post instance as batch sampler does
@@ -492,15 +493,16 @@ void AP_InertialSensor_Backend::log_gyro_raw(uint8_t instance, const uint64_t sa
             Write_GYR(instance, sample_us, raw_gyro);
 
         }
-    } else {
+    }
 #if AP_INERTIALSENSOR_BATCHSAMPLER_ENABLED
-        if (!_imu.batchsampler.doing_sensor_rate_logging()) {
+    if (!log_raw || _imu.batchsampler.doing_streaming()) {
+        if (!_imu.batchsampler.doing_sensor_rate_logging(instance, AP_InertialSensor::IMU_SENSOR_TYPE_GYRO)) {
             _imu.batchsampler.sample(instance, AP_InertialSensor::IMU_SENSOR_TYPE_GYRO, sample_us,
                                      !_imu.batchsampler.doing_post_filter_logging() ? raw_gyro : filtered_gyro);
         }
-#endif
     }
 #endif
+#endif
 }
 
 /*
@@ -697,7 +699,7 @@ void AP_InertialSensor_Backend::_notify_new_delta_velocity(uint8_t instance, con
 void AP_InertialSensor_Backend::_notify_new_accel_sensor_rate_sample(uint8_t instance, const Vector3f &_accel)
 {
 #if AP_INERTIALSENSOR_BATCHSAMPLER_ENABLED
-    if (!_imu.batchsampler.doing_sensor_rate_logging()) {
+    if (!_imu.batchsampler.doing_sensor_rate_logging(instance, AP_InertialSensor::IMU_SENSOR_TYPE_ACCEL)) {
         return;
     }
 
@@ -712,7 +714,7 @@ void AP_InertialSensor_Backend::_notify_new_accel_sensor_rate_sample(uint8_t ins
 void AP_InertialSensor_Backend::_notify_new_gyro_sensor_rate_sample(uint8_t instance, const Vector3f &_gyro)
 {
 #if AP_INERTIALSENSOR_BATCHSAMPLER_ENABLED
-    if (!_imu.batchsampler.doing_sensor_rate_logging()) {
+    if (!_imu.batchsampler.doing_sensor_rate_logging(instance, AP_InertialSensor::IMU_SENSOR_TYPE_GYRO)) {
         return;
     }
 
@@ -732,16 +734,18 @@ void AP_InertialSensor_Backend::log_accel_raw(uint8_t instance, const uint64_t s
         // should not have been called
         return;
     }
-    if (should_log_imu_raw()) {
+    const bool log_raw = should_log_imu_raw();
+    if (log_raw) {
         Write_ACC(instance, sample_us, accel);
-    } else {
+    }
 #if AP_INERTIALSENSOR_BATCHSAMPLER_ENABLED
-        if (!_imu.batchsampler.doing_sensor_rate_logging()) {
+    if (!log_raw || _imu.batchsampler.doing_streaming()) {
+        if (!_imu.batchsampler.doing_sensor_rate_logging(instance, AP_InertialSensor::IMU_SENSOR_TYPE_ACCEL)) {
             _imu.batchsampler.sample(instance, AP_InertialSensor::IMU_SENSOR_TYPE_ACCEL, sample_us, accel);
         }
-#endif
     }
 #endif
+#endif
 }
 
 // increment accelerometer error_count
@@ -139,6 +139,59 @@ bool AP_InertialSensor::BatchSampler::Write_ISBD() const
 
     return AP::logger().WriteBlock_first_succeed(&pkt, sizeof(pkt));
 }
+
+// Write a stream's pending compressed samples to log:
+bool AP_InertialSensor::BatchSampler::Write_ISBS(stream_state &st)
+{
+    struct log_ISBS pkt {
+        LOG_PACKET_HEADER_INIT(LOG_ISBS_MSG),
+        time_us      : AP_HAL::micros64(),
+        sensor_type  : uint8_t(st.type),
+        instance     : st.instance,
+        seqno        : st.seqnum,
+        sample_us    : st.pkt_sample_us,
+        sample_count : st.pkt_count,
+        length       : st.pkt_len,
+        multiplier   : st.multiplier,
+    };
+    static_assert(sizeof(pkt.data) == STREAM_PKT_DATA_LEN, "ISBS data size mismatch");
+    memcpy(pkt.data, st.pkt_data, st.pkt_len);
+
+    if (!AP::logger().WriteBlock_first_succeed(&pkt, sizeof(pkt))) {
+        return false;
+    }
+    st.seqnum++;
+    st.logged_samples += st.pkt_count;
+    // every ISBS is written at full size however many samples it holds
+    st.logged_bytes += sizeof(pkt);
+    st.pkt_count = 0;
+    st.pkt_len = 0;
+    return true;
+}
+
+// Write requested and achieved rates of all streams to log:
+void AP_InertialSensor::BatchSampler::Write_ISBR(uint32_t dt_ms)
+{
+    const uint64_t now_us = AP_HAL::micros64();
+    for (uint8_t i=0; i<num_streams; i++) {
+        stream_state &st = streams[i];
+        const uint32_t dropped = st.dropped;
+        const struct log_ISBR pkt {
+            LOG_PACKET_HEADER_INIT(LOG_ISBR_MSG),
+            time_us           : now_us,
+            sensor_type       : uint8_t(st.type),
+            instance          : st.instance,
+            requested_rate    : st.requested_rate_hz,
+            achieved_rate     : st.logged_samples * 1000.0f / MAX(dt_ms, 1U),
+            dropped           : dropped - st.last_dropped,
+            compression_ratio : st.logged_bytes > 0 ? st.logged_samples * 3 * sizeof(int16_t) / float(st.logged_bytes) : 0,
+        };
+        AP::logger().WriteBlock(&pkt, sizeof(pkt));
+        st.last_dropped = dropped;
+        st.logged_samples = 0;
+        st.logged_bytes = 0;
+    }
+}
 #endif
 
 #if AP_INERTIALSENSOR_HARMONICNOTCH_ENABLED
@@ -210,7 +210,7 @@ void AP_InertialSensor_SITL::generate_accel()
 void AP_InertialSensor_SITL::generate_gyro()
 {
     Vector3f gyro_accum;
-    uint8_t nsamples = enable_fast_sampling(gyro_instance) ? 8 : 1;
+    const uint8_t nsamples = gyro_subsamples();
 
     const float _gyro_drift = gyro_drift();
     for (uint8_t j = 0; j < nsamples; j++) {
@@ -384,8 +384,24 @@ bool AP_InertialSensor_SITL::update(void)
 
 uint8_t AP_InertialSensor_SITL::bus_id = 0;
 
+/*
+  with fast sampling the simulated sensor produces 8kHz of data. As
+  on real sensors INS_GYRO_RATE selects how much of that is published
+  as separate samples rather than averaged together
+ */
+uint8_t AP_InertialSensor_SITL::gyro_subsamples() const
+{
+    if (!enable_fast_sampling(gyro_instance)) {
+        return 1;
+    }
+    return MAX(8 / get_fast_sampling_rate(), 1);
+}
+
 void AP_InertialSensor_SITL::start()
 {
+    if (enable_fast_sampling(gyro_instance)) {
+        gyro_sample_hz *= 8 / gyro_subsamples();
+    }
     if (!_imu.register_gyro(gyro_instance, gyro_sample_hz,
                             AP_HAL::Device::make_bus_id(AP_HAL::Device::BUS_TYPE_SITL, bus_id, 1, DEVTYPE_SITL)) ||
         !_imu.register_accel(accel_instance, accel_sample_hz,
@@ -424,7 +440,7 @@ void AP_InertialSensor_SITL::read_gyro_from_file()
 
     float buf[8 * 3 * sizeof(float)];
 
-    uint8_t nsamples = enable_fast_sampling(gyro_instance) ? 8 : 1;
+    const uint8_t nsamples = gyro_subsamples();
     ssize_t ret = ::read(gyro_fd, buf, nsamples * 3 * sizeof(float));
     if (ret == (ssize_t)(nsamples * 3 * sizeof(float))) {
         read_gyro(buf, nsamples);
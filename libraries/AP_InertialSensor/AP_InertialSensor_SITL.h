@@ -42,9 +42,12 @@ private:
 #endif
     SITL::SIM *sitl;
 
-    const uint16_t gyro_sample_hz;
+    uint16_t gyro_sample_hz;
     const uint16_t accel_sample_hz;
 
+    // number of simulated sub-samples averaged into each gyro sample
+    uint8_t gyro_subsamples() const;
+
     uint64_t next_gyro_sample;
     uint64_t next_accel_sample;
     float gyro_time;
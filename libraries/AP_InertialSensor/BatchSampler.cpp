@@ -4,6 +4,8 @@
 #include <GCS_MAVLink/GCS.h>
 #include <AP_Logger/AP_Logger.h>
 
+#define MASK_LOG_ANY                    0xFFFF
+
 // Class level parameters
 const AP_Param::GroupInfo AP_InertialSensor::BatchSampler::var_info[] = {
     // @Param: BAT_CNT
@@ -24,8 +26,8 @@ const AP_Param::GroupInfo AP_InertialSensor::BatchSampler::var_info[] = {
 
     // @Param: BAT_OPT
     // @DisplayName: Batch Logging Options Mask
-    // @Description: Options for the BatchSampler.
-    // @Bitmask: 0:Sensor-Rate Logging (sample at full sensor rate seen by AP), 1: Sample post-filtering, 2: Sample pre- and post-filter
+    // @Description: Options for the BatchSampler. Continuous streaming logs both the accel and gyro of every IMU in @PREFIX@BAT_MASK without gaps as compressed ISBS messages instead of ISBH/ISBD batches, with the achieved rate reported in ISBR; it takes effect on the next reboot, carries on alongside raw IMU logging, and needs a log backend fast enough for the sensor rates.
+    // @Bitmask: 0:Sensor-Rate Logging (sample at full sensor rate seen by AP), 1: Sample post-filtering, 2: Sample pre- and post-filter, 3: Continuous streaming
     // @User: Advanced
     AP_GROUPINFO("BAT_OPT",  3, AP_InertialSensor::BatchSampler, _batch_options_mask, 0),
 
@@ -56,6 +58,11 @@ void AP_InertialSensor::BatchSampler::init()
         return;
     }
 
+    if (has_option(BATCH_OPT_STREAMING)) {
+        init_streaming();
+        return;
+    }
+
     _required_count.set(_required_count - (_required_count % 32)); // round down to nearest multiple of 32
 
     _real_required_count = _required_count;
@@ -82,16 +89,216 @@ void AP_InertialSensor::BatchSampler::init()
     initialised = true;
 }
 
+/*
+  allocate a pair of blocks for the accel and gyro of each IMU in the
+  mask and start the thread which compresses them into the log
+ */
+void AP_InertialSensor::BatchSampler::init_streaming()
+{
+    const uint8_t _count = MIN(_imu._accel_count, _imu._gyro_count);
+    uint8_t n = 0;
+    for (uint8_t i=0; i<_count; i++) {
+        if (_sensor_mask & (1U<<i)) {
+            n += 2;
+        }
+    }
+    if (n == 0) {
+        return;
+    }
+
+    streams = NEW_NOTHROW stream_state[n];
+    if (streams == nullptr) {
+        GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "Failed to allocate %u bytes for IMU streaming", unsigned(n*sizeof(stream_state)));
+        return;
+    }
+    GCS_SEND_TEXT(MAV_SEVERITY_DEBUG, "INS: alloc %u bytes for ISB streaming (free=%u)", unsigned(n*sizeof(stream_state)), unsigned(hal.util->available_memory()));
+
+    for (uint8_t i=0; i<_count; i++) {
+        if (!(_sensor_mask & (1U<<i))) {
+            continue;
+        }
+        for (uint8_t t=0; t<2; t++) {
+            stream_state &st = streams[num_streams++];
+            st.type = (t == 0) ? IMU_SENSOR_TYPE_ACCEL : IMU_SENSOR_TYPE_GYRO;
+            st.instance = i;
+            if (st.type == IMU_SENSOR_TYPE_ACCEL) {
+                st.multiplier = _imu._accel_raw_sampling_multiplier[i];
+                st.sensor_rate = has_option(BATCH_OPT_SENSOR_RATE) && (_imu._accel_sensor_rate_sampling_enabled & (1U<<i));
+                st.requested_rate_hz = _imu._accel_raw_sample_rates[i] * (st.sensor_rate ? _imu._accel_over_sampling[i] : 1);
+            } else {
+                st.multiplier = _imu._gyro_raw_sampling_multiplier[i];
+                st.sensor_rate = has_option(BATCH_OPT_SENSOR_RATE) && (_imu._gyro_sensor_rate_sampling_enabled & (1U<<i));
+                st.requested_rate_hz = _imu._gyro_raw_sample_rates[i] * (st.sensor_rate ? _imu._gyro_over_sampling[i] : 1);
+            }
+        }
+    }
+
+    if (!hal.scheduler->thread_create(FUNCTOR_BIND_MEMBER(&AP_InertialSensor::BatchSampler::stream_thread, void),
+                                      "isb_stream", 2048, AP_HAL::Scheduler::PRIORITY_IO, 1)) {
+        GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "INS: failed to start IMU streaming");
+        return;
+    }
+
+    streaming = true;
+    initialised = true;
+}
+
 void AP_InertialSensor::BatchSampler::periodic()
 {
     if (_sensor_mask == 0) {
         return;
     }
+    if (streaming) {
+        // the stream thread does all logging
+        return;
+    }
 #if HAL_LOGGING_ENABLED
     push_data_to_log();
 #endif
 }
 
+/*
+  return true if samples for this sensor should come from the sensor
+  rate callbacks rather than the filtered sample path
+ */
+bool AP_InertialSensor::BatchSampler::doing_sensor_rate_logging(uint8_t _instance, IMU_SENSOR_TYPE _type) const
+{
+    if (!streaming) {
+        return _doing_sensor_rate_logging;
+    }
+    const stream_state *st = find_stream(_instance, _type);
+    return st != nullptr && st->sensor_rate;
+}
+
+AP_InertialSensor::BatchSampler::stream_state *AP_InertialSensor::BatchSampler::find_stream(uint8_t _instance, IMU_SENSOR_TYPE _type) const
+{
+    for (uint8_t i=0; i<num_streams; i++) {
+        if (streams[i].instance == _instance && streams[i].type == _type) {
+            return &streams[i];
+        }
+    }
+    return nullptr;
+}
+
+/*
+  add a sample to a stream's current block. Called from the sensor
+  backend, so this must never block; if the stream thread has not
+  yet emptied the other block the sample is dropped
+ */
+void AP_InertialSensor::BatchSampler::stream_sample(stream_state &st, uint64_t sample_us, const Vector3f &_sample)
+{
+    stream_block &b = st.block[st.write_block];
+    if (b.full) {
+        st.dropped++;
+        return;
+    }
+    if (st.write_count == 0) {
+        b.start_us = sample_us;
+    }
+    b.data[st.write_count][0] = st.multiplier*_sample.x;
+    b.data[st.write_count][1] = st.multiplier*_sample.y;
+    b.data[st.write_count][2] = st.multiplier*_sample.z;
+    if (++st.write_count == STREAM_BLOCK_SAMPLES) {
+        b.end_us = sample_us;
+        b.full = true;      // hands the block to the stream thread
+        st.write_block ^= 1;
+        st.write_count = 0;
+    }
+}
+
+// thread which compresses full blocks into the log
+void AP_InertialSensor::BatchSampler::stream_thread()
+{
+    stream_report_ms = AP_HAL::millis();
+    while (true) {
+        hal.scheduler->delay_microseconds(2000);
+
+        AP_Logger *logger = AP_Logger::get_singleton();
+        const bool logging = logger != nullptr && logger->should_log(MASK_LOG_ANY);
+        for (uint8_t i=0; i<num_streams; i++) {
+            push_stream_data_to_log(streams[i], logging);
+        }
+
+        const uint32_t now_ms = AP_HAL::millis();
+        if (now_ms - stream_report_ms >= 1000) {
+            if (logging) {
+                Write_ISBR(now_ms - stream_report_ms);
+            }
+            stream_report_ms = now_ms;
+        }
+    }
+}
+
+/*
+  append one sample to the stream's pending ISBS message. Returns false
+  if there is no room, in which case the message must be written first
+ */
+bool AP_InertialSensor::BatchSampler::encode_stream_sample(stream_state &st, const int16_t v[3], uint64_t sample_us)
+{
+    if (st.pkt_len + STREAM_MAX_SAMPLE_BYTES > STREAM_PKT_DATA_LEN || st.pkt_count == UINT8_MAX) {
+        return false;
+    }
+    if (st.pkt_count == 0) {
+        // each message is decodable on its own
+        memset(st.last, 0, sizeof(st.last));
+        st.pkt_sample_us = sample_us;
+        st.pkt_started_ms = AP_HAL::millis();
+    }
+    for (uint8_t axis=0; axis<3; axis++) {
+        const int32_t delta = int32_t(v[axis]) - st.last[axis];
+        // zigzag so small negative deltas are small too
+        uint32_t z = (uint32_t(delta) << 1) ^ uint32_t(delta >> 31);
+        while (z >= 0x80) {
+            st.pkt_data[st.pkt_len++] = uint8_t(z) | 0x80;
+            z >>= 7;
+        }
+        st.pkt_data[st.pkt_len++] = uint8_t(z);
+        st.last[axis] = v[axis];
+    }
+    st.pkt_count++;
+    return true;
+}
+
+/*
+  compress full blocks from one stream into ISBS messages. If the
+  logger is busy the pending message is kept and retried next time;
+  the backend drops samples if that makes both blocks stay full
+ */
+void AP_InertialSensor::BatchSampler::push_stream_data_to_log(stream_state &st, bool logging)
+{
+    while (true) {
+        stream_block &b = st.block[st.read_block];
+        if (!b.full) {
+            break;
+        }
+        if (!logging) {
+            // discard, we would only fall behind
+            st.pkt_len = 0;
+            st.pkt_count = 0;
+            st.read_count = 0;
+        }
+        while (logging && st.read_count < STREAM_BLOCK_SAMPLES) {
+            const uint64_t sample_us = b.start_us + (b.end_us - b.start_us) * st.read_count / (STREAM_BLOCK_SAMPLES-1);
+            if (encode_stream_sample(st, b.data[st.read_count], sample_us)) {
+                st.read_count++;
+                continue;
+            }
+            if (!Write_ISBS(st)) {
+                // logger buffer full, try again later
+                return;
+            }
+        }
+        st.read_count = 0;
+        st.read_block ^= 1;
+        b.full = false;     // hands the block back to the backend
+    }
+
+    // don't hold a partly filled message for long
+    if (st.pkt_count > 0 && AP_HAL::millis() - st.pkt_started_ms > 100) {
+        Write_ISBS(st);
+    }
+}
+
 void AP_InertialSensor::BatchSampler::update_doing_sensor_rate_logging()
 {
     if (has_option(BATCH_OPT_POST_FILTER)) {
@@ -263,7 +470,6 @@ bool AP_InertialSensor::BatchSampler::should_log(uint8_t _instance, IMU_SENSOR_T
     if (logger == nullptr) {
         return false;
     }
-#define MASK_LOG_ANY                    0xFFFF
     if (!logger->should_log(MASK_LOG_ANY)) {
         return false;
     }
@@ -274,6 +480,13 @@ bool AP_InertialSensor::BatchSampler::should_log(uint8_t _instance, IMU_SENSOR_T
 void AP_InertialSensor::BatchSampler::sample(uint8_t _instance, AP_InertialSensor::IMU_SENSOR_TYPE _type, uint64_t sample_us, const Vector3f &_sample)
 {
 #if HAL_LOGGING_ENABLED
+    if (streaming) {
+        stream_state *st = find_stream(_instance, _type);
+        if (st != nullptr) {
+            stream_sample(*st, sample_us, _sample);
+        }
+        return;
+    }
     if (!should_log(_instance, _type)) {
         return;
     }
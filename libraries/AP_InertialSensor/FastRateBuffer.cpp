@@ -100,19 +100,73 @@ bool AP_InertialSensor::get_next_gyro_sample(Vector3f& gyro)
 }
 
 
-bool FastRateBuffer::get_next_gyro_sample(Vector3f& gyro)
+// get up to max_samples gyro samples from the fast rate buffer, returns the number of samples
+uint8_t AP_InertialSensor::get_next_gyro_samples(Vector3f *gyro, uint8_t max_samples)
 {
-    if (!use_rate_loop_gyro_samples()) {
-        return false;
+    if (!fast_rate_buffer_enabled || fast_rate_buffer == nullptr) {
+        return 0;
     }
 
-    if (_rate_loop_gyro_window.available() == 0) {
+    return fast_rate_buffer->get_next_gyro_samples(gyro, max_samples);
+}
+
+// get the number of gyro samples dropped because the fast rate buffer was full
+uint32_t AP_InertialSensor::get_fast_rate_buffer_overruns() const
+{
+    if (fast_rate_buffer == nullptr) {
+        return 0;
+    }
+    return fast_rate_buffer->get_overruns();
+}
+
+/*
+  block until there is at least one sample in the buffer. The waiting
+  flag is set before re-checking the buffer so that a sample pushed
+  between the check and the wait always results in a signal
+ */
+bool FastRateBuffer::wait_for_samples()
+{
+    if (!_rate_loop_gyro_window.is_empty()) {
+        return true;
+    }
+    _consumer_waiting.store(true);
+    if (_rate_loop_gyro_window.is_empty()) {
         _notifier.wait_blocking();
     }
+    _consumer_waiting.store(false);
+    return !_rate_loop_gyro_window.is_empty();
+}
+
+bool FastRateBuffer::get_next_gyro_sample(Vector3f& gyro)
+{
+    return get_next_gyro_samples(&gyro, 1) == 1;
+}
+
+uint8_t FastRateBuffer::get_next_gyro_samples(Vector3f *gyro, uint8_t max_samples)
+{
+    if (!use_rate_loop_gyro_samples() || max_samples == 0) {
+        return 0;
+    }
 
-    WITH_SEMAPHORE(_mutex);
+    if (!wait_for_samples()) {
+        return 0;
+    }
 
-    return _rate_loop_gyro_window.pop(gyro);
+    return _rate_loop_gyro_window.pop(gyro, max_samples);
+}
+
+bool FastRateBuffer::push(const Vector3f& gyro)
+{
+    if (!_rate_loop_gyro_window.push(gyro)) {
+        _overruns.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // only wake the rate thread if it is waiting for us
+    if (_consumer_waiting.exchange(false)) {
+        _notifier.signal();
+    }
+    return true;
 }
 
 void FastRateBuffer::reset()
@@ -126,20 +180,31 @@ bool AP_InertialSensor::push_next_gyro_sample(const Vector3f& gyro)
         return false;
     }
 
-    if (++fast_rate_buffer->rate_decimation_count < fast_rate_buffer->rate_decimation) {
+    /*
+      the buffer only supports a single producer. Samples come from
+      the backend thread of the primary gyro, but while the primary
+      is changing the old and new backends can both get here, so only
+      one of them may push at a time. The other's sample is dropped
+     */
+    if (fast_rate_buffer->_producer_busy.exchange(true, std::memory_order_acquire)) {
+        fast_rate_buffer->_overruns.fetch_add(1, std::memory_order_relaxed);
         return false;
     }
-    /*
-        tell the rate thread we have a new sample
-    */
-    WITH_SEMAPHORE(fast_rate_buffer->_mutex);
 
-    if (!fast_rate_buffer->_rate_loop_gyro_window.push(gyro)) {
-        debug("dropped rate loop sample");
+    bool pushed = false;
+    if (++fast_rate_buffer->rate_decimation_count >= fast_rate_buffer->rate_decimation) {
+        /*
+            tell the rate thread we have a new sample
+        */
+        if (!fast_rate_buffer->push(gyro)) {
+            debug("dropped rate loop sample");
+        }
+        fast_rate_buffer->rate_decimation_count = 0;
+        pushed = true;
     }
-    fast_rate_buffer->rate_decimation_count = 0;
-    fast_rate_buffer->_notifier.signal();
-    return true;
+
+    fast_rate_buffer->_producer_busy.store(false, std::memory_order_release);
+    return pushed;
 }
 
 void AP_InertialSensor::update_backend_filters()
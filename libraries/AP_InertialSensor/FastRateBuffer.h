@@ -18,34 +18,56 @@
 
 #if AP_INERTIALSENSOR_FAST_SAMPLE_WINDOW_ENABLED
 
-#define AP_INERTIAL_SENSOR_RATE_LOOP_BUFFER_SIZE 8     // gyro buffer size for rate loop
+#define AP_INERTIAL_SENSOR_RATE_LOOP_BUFFER_SIZE 8     // gyro buffer size for rate loop, must be a power of 2
 
 #include <AP_HAL/AP_HAL_Boards.h>
 #include <AP_HAL/utility/RingBuffer.h>
 #include <AP_Math/AP_Math.h>
 #include <AP_HAL/Semaphores.h>
+#include <atomic>
 
 class FastRateBuffer
 {
     friend class AP_InertialSensor;
 public:
     bool get_next_gyro_sample(Vector3f& gyro);
-    uint32_t get_num_gyro_samples() { return _rate_loop_gyro_window.available(); }
+    // wait for at least one sample then pop up to max_samples, returns number of samples popped
+    uint8_t get_next_gyro_samples(Vector3f *gyro, uint8_t max_samples);
+    uint32_t get_num_gyro_samples() const { return _rate_loop_gyro_window.available(); }
     void set_rate_decimation(uint8_t rdec) { rate_decimation = rdec; }
     // whether or not to push the current gyro sample
     bool use_rate_loop_gyro_samples() const { return rate_decimation > 0; }
-    bool gyro_samples_available() { return  _rate_loop_gyro_window.available() > 0; }
+    bool gyro_samples_available() const { return _rate_loop_gyro_window.available() > 0; }
+    // number of samples dropped because the buffer was full
+    uint32_t get_overruns() const { return _overruns.load(std::memory_order_relaxed); }
+    // discard all samples, must only be called from the rate thread
     void reset();
 
 private:
+    // add a sample from the IMU backend and wake the rate thread if
+    // it is waiting. Only one thread may be in push() at a time, see
+    // AP_InertialSensor::push_next_gyro_sample()
+    bool push(const Vector3f& gyro);
+    bool wait_for_samples();
+
     /*
-      binary semaphore for rate loop to use to start a rate loop when
-      we hav finished filtering the primary IMU
+      samples are passed from the IMU backend to the rate thread
+      without taking a lock. When the buffer is full new samples are
+      dropped and counted as overruns
      */
-    ObjectBuffer<Vector3f> _rate_loop_gyro_window{AP_INERTIAL_SENSOR_RATE_LOOP_BUFFER_SIZE};
+    ObjectBuffer_SPSC<Vector3f, AP_INERTIAL_SENSOR_RATE_LOOP_BUFFER_SIZE> _rate_loop_gyro_window;
+    std::atomic<uint32_t> _overruns{0};
     uint8_t rate_decimation; // 0 means off
     uint8_t rate_decimation_count;
+    // set while a backend is pushing, to keep to a single producer
+    std::atomic<bool> _producer_busy{false};
+
+    /*
+      binary semaphore for rate loop to use to start a rate loop when
+      we hav finished filtering the primary IMU. Only signalled when
+      the rate thread has said it is about to wait
+     */
     HAL_BinarySemaphore _notifier;
-    HAL_Semaphore _mutex;
+    std::atomic<bool> _consumer_waiting{false};
 };
 #endif
@@ -8,6 +8,8 @@
     LOG_IMU_MSG, \
     LOG_ISBH_MSG, \
     LOG_ISBD_MSG, \
+    LOG_ISBS_MSG, \
+    LOG_ISBR_MSG, \
     LOG_VIBE_MSG
 
 // @LoggerMessage: ACC
@@ -113,6 +115,53 @@ struct PACKED log_ISBD {
 };
 static_assert(sizeof(log_ISBD) < 256, "log_ISBD is over-size");
 
+// @LoggerMessage: ISBS
+// @Description: InertialSensor Batch Logging Stream data, continuous full rate samples written when INS_LOG_BAT_OPT bit 3 is set
+// @Field: TimeUS: Time since system startup
+// @Field: type: indicates if this is accel or gyro data
+// @Field: instance: IMU sensor instance
+// @Field: N: message sequence number for this sensor, used to detect lost messages
+// @Field: SampleUS: timestamp of first sample
+// @Field: cnt: number of samples in this message
+// @Field: len: number of bytes of d0 to d2 used
+// @Field: mul: multiplier applied to the samples
+// @Field: d0: packed sample data, little-endian bytes. For each sample the x, y and z values are encoded as the difference from the previous sample in this message (the first from zero), zigzag encoded as unsigned varints
+// @Field: d1: packed sample data, continued
+// @Field: d2: packed sample data, continued
+struct PACKED log_ISBS {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t sensor_type;
+    uint8_t instance;
+    uint16_t seqno;
+    uint64_t sample_us;
+    uint8_t sample_count;
+    uint8_t length;
+    uint16_t multiplier;
+    uint8_t data[192];
+};
+static_assert(sizeof(log_ISBS) < 256, "log_ISBS is over-size");
+
+// @LoggerMessage: ISBR
+// @Description: InertialSensor Batch Logging Stream rates
+// @Field: TimeUS: Time since system startup
+// @Field: type: indicates if this is accel or gyro data
+// @Field: instance: IMU sensor instance
+// @Field: RReq: rate at which the sensor is producing samples
+// @Field: RAch: rate at which samples were written to the log
+// @Field: Drop: samples dropped since the last message because the log could not keep up
+// @Field: CR: compression ratio achieved, the size of the raw samples over the size of the ISBS messages written
+struct PACKED log_ISBR {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t sensor_type;
+    uint8_t instance;
+    float requested_rate;
+    float achieved_rate;
+    uint32_t dropped;
+    float compression_ratio;
+};
+
 // @LoggerMessage: VIBE
 // @Description: Processed (acceleration) vibration information
 // @Field: TimeUS: Time since system startup
@@ -141,4 +190,8 @@ struct PACKED log_Vibe {
     { LOG_ISBH_MSG, sizeof(log_ISBH), \
       "ISBH", "QHBBHHQf", "TimeUS,N,type,instance,mul,smp_cnt,SampleUS,smp_rate", "s-----sz", "F-----F-" },  \
     { LOG_ISBD_MSG, sizeof(log_ISBD), \
-      "ISBD", "QHHaaa", "TimeUS,N,seqno,x,y,z", "s--ooo", "F--???" },
+      "ISBD", "QHHaaa", "TimeUS,N,seqno,x,y,z", "s--ooo", "F--???" },  \
+    { LOG_ISBS_MSG, sizeof(log_ISBS), \
+      "ISBS", "QBBHQBBHaaa", "TimeUS,type,instance,N,SampleUS,cnt,len,mul,d0,d1,d2", "s---s------", "F---F------" },  \
+    { LOG_ISBR_MSG, sizeof(log_ISBR), \
+      "ISBR", "QBBffIf", "TimeUS,type,instance,RReq,RAch,Drop,CR", "s--zz--", "F------" },
@@ -202,6 +202,15 @@ const AP_Param::GroupInfo AP_Logger::var_info[] = {
     // @RebootRequired: True
     AP_GROUPINFO("_MAX_FILES", 12, AP_Logger, _params.max_log_files, MAX_LOG_FILES),
 
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    // @Param: _FILE_COMP
+    // @DisplayName: Log file compression
+    // @Description: Compress log files as they are written. This reduces the amount of data written to the SD card at the cost of some CPU time in the logging thread. Compressed logs must be decompressed before they can be read by tools other than Replay. Takes effect when the next log is started.
+    // @Values: 0:Disabled,1:LZ4 block compression
+    // @User: Advanced
+    AP_GROUPINFO("_FILE_COMP", 13, AP_Logger, _params.file_compress, 0),
+#endif
+
     AP_GROUPEND
 };
 
@@ -724,8 +733,8 @@ void AP_Logger::save_format_Replay(const void *pBuffer)
         f->name = strndup(fmt->name, sizeof(fmt->name));
         f->fmt = strndup(fmt->format, sizeof(fmt->format));
         f->labels = strndup(fmt->labels, sizeof(fmt->labels));
-        f->next = log_write_fmts;
-        log_write_fmts = f;
+        WITH_SEMAPHORE(log_write_fmts_sem);
+        add_log_write_fmt(f, true);
     }
 }
 #endif
@@ -1117,36 +1126,78 @@ bool AP_Logger::assert_same_fmt_for_name(const AP_Logger::log_write_fmt *f,
 }
 #endif
 
-AP_Logger::log_write_fmt *AP_Logger::msg_fmt_for_name(const char *name, const char *labels, const char *units, const char *mults, const char *fmt, const bool direct_comp, const bool copy_strings)
+/*
+  hash a format name into a log_write_fmt_hash bucket. Names longer
+  than LS_NAME_SIZE are truncated in the log, so only hash that much
+ */
+uint8_t AP_Logger::log_write_fmt_hash_bucket(const char *name)
 {
-    WITH_SEMAPHORE(log_write_fmts_sem);
-    struct log_write_fmt *f;
-    for (f = log_write_fmts; f; f=f->next) {
+    uint32_t hash = 0;
+    for (uint8_t i=0; i<LS_NAME_SIZE && name[i] != '\0'; i++) {
+        hash = hash * 31 + uint8_t(name[i]);
+    }
+    return hash % LOG_WRITE_FMT_HASH_SIZE;
+}
+
+AP_Logger::log_write_fmt *AP_Logger::find_msg_fmt_for_name(const char *name, const bool direct_comp) const
+{
+    const uint8_t bucket = log_write_fmt_hash_bucket(name);
+    for (struct log_write_fmt *f = log_write_fmt_hash[bucket].load(std::memory_order_acquire); f; f=f->hash_next) {
         if (!direct_comp) {
             if (f->name == name) { // ptr comparison
-                // already have an ID for this name:
-#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
-                if (!assert_same_fmt_for_name(f, name, labels, units, mults, fmt)) {
-                    return nullptr;
-                }
-#endif
                 return f;
             }
-        } else {
+        } else if (strcmp(f->name, name) == 0) {
             // direct comparison used from scripting where pointer is not maintained
-            if (strcmp(f->name,name) == 0) {
-                // already have an ID for this name:
-#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
-                if (!assert_same_fmt_for_name(f, name, labels, units, mults, fmt)) {
-                    return nullptr;
-                }
-#endif
-                return f;
-            }
+            return f;
         }
     }
+    return nullptr;
+}
 
-    f = (struct log_write_fmt *)calloc(1, sizeof(*f));
+void AP_Logger::add_log_write_fmt(struct log_write_fmt *f, const bool at_front)
+{
+    if (at_front || (log_write_fmts == nullptr)) {
+        f->next = log_write_fmts;
+        log_write_fmts = f;
+    } else {
+        struct log_write_fmt *list_end = log_write_fmts;
+        while (list_end->next) {
+            list_end=list_end->next;
+        }
+        list_end->next = f;
+    }
+
+    // publish into the name index last so that lock-free readers
+    // only ever see a fully populated entry
+    std::atomic<log_write_fmt*> &head = log_write_fmt_hash[log_write_fmt_hash_bucket(f->name)];
+    f->hash_next = head.load(std::memory_order_relaxed);
+    head.store(f, std::memory_order_release);
+}
+
+AP_Logger::log_write_fmt *AP_Logger::msg_fmt_for_name(const char *name, const char *labels, const char *units, const char *mults, const char *fmt, const bool direct_comp, const bool copy_strings)
+{
+    struct log_write_fmt *f = find_msg_fmt_for_name(name, direct_comp);
+    if (f == nullptr) {
+        WITH_SEMAPHORE(log_write_fmts_sem);
+        // another thread may have allocated this name while we waited
+        f = find_msg_fmt_for_name(name, direct_comp);
+        if (f == nullptr) {
+            return new_msg_fmt_for_name(name, labels, units, mults, fmt, direct_comp, copy_strings);
+        }
+    }
+    // already have an ID for this name:
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+    if (!assert_same_fmt_for_name(f, name, labels, units, mults, fmt)) {
+        return nullptr;
+    }
+#endif
+    return f;
+}
+
+AP_Logger::log_write_fmt *AP_Logger::new_msg_fmt_for_name(const char *name, const char *labels, const char *units, const char *mults, const char *fmt, const bool direct_comp, const bool copy_strings)
+{
+    struct log_write_fmt *f = (struct log_write_fmt *)calloc(1, sizeof(*f));
     if (f == nullptr) {
         // out of memory
         return nullptr;
@@ -1201,17 +1252,8 @@ AP_Logger::log_write_fmt *AP_Logger::msg_fmt_for_name(const char *name, const ch
 
     f->msg_len = tmp;
 
-    // add direct_comp formats to start of list, otherwise add to the end, this minimises the number of string comparisons when walking the list in future calls
-    if (direct_comp || (log_write_fmts == nullptr)) {
-        f->next = log_write_fmts;
-        log_write_fmts = f;
-    } else {
-        struct log_write_fmt *list_end = log_write_fmts;
-        while (list_end->next) {
-            list_end=list_end->next;
-        }
-        list_end->next = f;
-    }
+    // direct_comp formats go to the start of the list, others to the end
+    add_log_write_fmt(f, direct_comp);
 
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
     struct log_write_fmt_strings ls_strings = {};
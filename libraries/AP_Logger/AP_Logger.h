@@ -15,6 +15,7 @@
 #include <AP_Vehicle/ModeReason.h>
 
 #include <stdint.h>
+#include <atomic>
 
 #include "LoggerMessageWriter.h"
 
@@ -349,6 +350,9 @@ public:
         AP_Float blk_ratemax;
         AP_Float disarm_ratemax;
         AP_Int16 max_log_files;
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+        AP_Int8 file_compress;
+#endif
     } _params;
 
     const struct LogStructure *structure(uint16_t num) const;
@@ -392,6 +396,7 @@ public:
     // efficiency of finding message types
     struct log_write_fmt {
         struct log_write_fmt *next;
+        struct log_write_fmt *hash_next; // next format in the same name hash bucket
         uint8_t msg_type;
         uint8_t msg_len;
         const char *name;
@@ -455,6 +460,24 @@ private:
      */
     HAL_Semaphore log_write_fmts_sem;
 
+    /*
+      index of log_write_fmts by name. Formats are only ever added,
+      never removed, so the buckets can be walked without taking
+      log_write_fmts_sem; additions are made with the semaphore held
+     */
+    static const uint8_t LOG_WRITE_FMT_HASH_SIZE = 32;
+    std::atomic<log_write_fmt*> log_write_fmt_hash[LOG_WRITE_FMT_HASH_SIZE] {};
+    static uint8_t log_write_fmt_hash_bucket(const char *name);
+
+    // find an existing log_write_fmt for a name, nullptr if none
+    struct log_write_fmt *find_msg_fmt_for_name(const char *name, bool direct_comp) const;
+
+    // allocate a new log_write_fmt for a name; log_write_fmts_sem must be held
+    struct log_write_fmt *new_msg_fmt_for_name(const char *name, const char *labels, const char *units, const char *mults, const char *fmt, bool direct_comp, bool copy_strings);
+
+    // add a log_write_fmt to the list and name index
+    void add_log_write_fmt(struct log_write_fmt *f, bool at_front);
+
     // return (possibly allocating) a log_write_fmt for a name
     const struct log_write_fmt *log_write_fmt_for_msg_type(uint8_t msg_type) const;
 
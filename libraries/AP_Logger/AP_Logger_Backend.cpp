@@ -468,6 +468,22 @@ bool AP_Logger_Backend::WritePrioritisedBlock(const void *pBuffer, uint16_t size
     return _WritePrioritisedBlock(pBuffer, size, is_critical);
 }
 
+#if AP_LOGGER_STARTUP_CACHE_ENABLED
+bool AP_Logger_Backend::WriteStartupBlock(const void *pBuffer, uint16_t size)
+{
+    if (!ShouldLog(true)) {
+        return false;
+    }
+    if (StartNewLogOK()) {
+        start_new_log();
+    }
+    if (!WritesOK()) {
+        return false;
+    }
+    return _WritePrioritisedBlock(pBuffer, size, true);
+}
+#endif
+
 bool AP_Logger_Backend::ShouldLog(bool is_critical)
 {
     if (!_front.WritesEnabled()) {
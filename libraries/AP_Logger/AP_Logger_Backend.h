@@ -71,6 +71,12 @@ public:
 
     bool WritePrioritisedBlock(const void *pBuffer, uint16_t size, bool is_critical, bool writev_streaming=false);
 
+#if AP_LOGGER_STARTUP_CACHE_ENABLED
+    // write a block holding several complete startup messages whose
+    // formats are included in the block
+    bool WriteStartupBlock(const void *pBuffer, uint16_t size);
+#endif
+
     // high level interface, indexed by the position in the list of logs
     virtual uint16_t find_last_log() = 0;
     virtual void get_log_boundaries(uint16_t list_entry, uint32_t & start_page, uint32_t & end_page) = 0;
@@ -137,6 +143,8 @@ public:
     bool have_emitted_format_for_type(LogMessages a_type) const {
         return _formats_written.get(uint8_t(a_type));
     }
+    // note that FMT messages for every LogStructure have been written
+    void set_emitted_all_formats();
     bool Write_Message(const char *message);
     bool Write_MessageF(const char *fmt, ...);
     bool Write_Mission_Cmd(const AP_Mission &mission,
@@ -36,6 +36,16 @@ void AP_Logger_Block::Init(void)
         AP_HAL::panic("Out of DMA memory for logging");
     }
 
+    // read several pages at a time when downloading logs
+    readahead_pages = AP_LOGGER_BLOCK_READ_AHEAD / df_PageSize;
+    if (readahead_pages > 1) {
+        readahead_buf = (uint8_t *)hal.util->malloc_type(readahead_pages * df_PageSize, AP_HAL::Util::MEM_DMA_SAFE);
+    }
+    if (readahead_buf == nullptr) {
+        readahead_pages = 0;
+    }
+    write_batch_pages = MAX(AP_LOGGER_BLOCK_WRITE_BATCH / df_PageSize, 1U);
+
     //flash_test();
 
     if (CardInserted()) {
@@ -84,12 +94,29 @@ uint32_t AP_Logger_Block::bufferspace_available()
 void AP_Logger_Block::StartWrite(uint32_t PageAdr)
 {
     df_PageAdr    = PageAdr;
+    // a block erased ahead of an earlier write point may be written
+    // before we get to it
+    if (erased_ahead_block != get_block(PageAdr) + 1) {
+        erased_ahead_block = UINT32_MAX;
+    }
 }
 
 void AP_Logger_Block::FinishWrite(void)
 {
     // Write Buffer to flash
     BufferToPage(df_PageAdr);
+
+    // remember the headers we have just written
+    struct PageHeader ph;
+    memcpy(&ph, buffer, sizeof(ph));
+    PageHeaderCacheEntry &e = header_cache[df_PageAdr % ARRAY_SIZE(header_cache)];
+    e.page = df_PageAdr;
+    e.file_page = ph.FilePage;
+    e.file_number = ph.FileNumber;
+    if (df_PageAdr >= readahead_first && df_PageAdr < readahead_first + readahead_count) {
+        readahead_count = 0;
+    }
+
     df_PageAdr++;
 
     // If we reach the end of the memory, start from the beginning
@@ -101,7 +128,7 @@ void AP_Logger_Block::FinishWrite(void)
     if ((df_PageAdr-1) % df_PagePerBlock == 0) {
         // if we have wrapped over an existing log, force the oldest to be recalculated
         if (_cached_oldest_log > 0) {
-            uint16_t log_num = StartRead(df_PageAdr);
+            uint16_t log_num = ReadPageHeader(df_PageAdr);
             if (log_num != 0xFFFF && log_num >= _cached_oldest_log) {
                 _cached_oldest_log = 0;
             }
@@ -109,12 +136,57 @@ void AP_Logger_Block::FinishWrite(void)
         // are we about to erase a sector with our own headers in it?
         if (df_Write_FilePage > df_NumPages - df_PagePerBlock) {
             chip_full = true;
+            erased_ahead_block = UINT32_MAX;
+            return;
+        }
+        if (get_block(df_PageAdr) == erased_ahead_block) {
+            // already erased by erase_next_block()
+            erased_ahead_block = UINT32_MAX;
             return;
         }
         SectorErase(get_block(df_PageAdr));
+        invalidate_read_cache();
+        block_erase_pending = true;
+        io_stats.erases++;
     }
 }
 
+/*
+  erase the block after the one being written while there is nothing
+  waiting to be written, so that the write point does not have to stop
+  for the erase when it gets there
+ */
+void AP_Logger_Block::erase_next_block()
+{
+    // wait until the write point is half way through its block
+    if ((df_PageAdr - 1) % df_PagePerBlock < df_PagePerBlock / 2U) {
+        return;
+    }
+    // never erase the first block early, if logging stopped before
+    // the write point wrapped the logs would appear to have gone
+    const uint32_t next_block = get_block(df_PageAdr) + 1;
+    if (next_block >= df_NumPages / df_PagePerBlock || next_block == erased_ahead_block) {
+        return;
+    }
+    // leave it to FinishWrite() to stop a log which would erase its own start
+    if (df_Write_FilePage + 2U * df_PagePerBlock > df_NumPages) {
+        return;
+    }
+    // if we are about to wrap over an existing log, force the oldest to be recalculated
+    if (_cached_oldest_log > 0) {
+        const uint16_t log_num = ReadPageHeader(next_block * df_PagePerBlock + 1);
+        if (log_num != 0xFFFF && log_num >= _cached_oldest_log) {
+            _cached_oldest_log = 0;
+        }
+    }
+    SectorErase(next_block);
+    invalidate_read_cache();
+    erased_ahead_block = next_block;
+    block_erase_pending = true;
+    io_stats.erases++;
+    io_stats.erases_ahead++;
+}
+
 bool AP_Logger_Block::WritesOK() const
 {
     if (!CardInserted() || erase_started) {
@@ -178,11 +250,82 @@ uint16_t AP_Logger_Block::StartRead(uint32_t PageAdr)
         df_Read_PageAdr = PageAdr;
         memset(buffer, 0xff, df_PageSize);
     } else {
-        PageToBuffer(PageAdr);
+        ReadPage(PageAdr);
     }
     return ReadHeaders();
 }
 
+uint16_t AP_Logger_Block::ReadPageHeader(uint32_t PageAdr)
+{
+    if (PageAdr == 0 || erase_started) {
+        return StartRead(PageAdr);
+    }
+    PageHeaderCacheEntry &e = header_cache[PageAdr % ARRAY_SIZE(header_cache)];
+    if (e.page == PageAdr) {
+        df_FileNumber = e.file_number;
+        df_FilePage = e.file_page;
+        return df_FileNumber;
+    }
+    StartRead(PageAdr);
+    e.page = PageAdr;
+    e.file_number = df_FileNumber;
+    e.file_page = df_FilePage;
+    return df_FileNumber;
+}
+
+/*
+  read a page into buffer.  When pages are read in sequence, as they
+  are when a log is downloaded, several are read at once
+ */
+void AP_Logger_Block::ReadPage(uint32_t PageAdr)
+{
+    if (readahead_buf != nullptr) {
+        if (PageAdr >= readahead_first && PageAdr < readahead_first + readahead_count) {
+            memcpy(buffer, &readahead_buf[(PageAdr - readahead_first) * df_PageSize], df_PageSize);
+            df_Read_PageAdr = PageAdr;
+            last_read_page = PageAdr;
+            return;
+        }
+        if (PageAdr == last_read_page + 1 &&
+            PageAdr + readahead_pages - 1 <= df_NumPages) {
+            PagesToBuffer(PageAdr, readahead_buf, readahead_pages);
+            readahead_first = PageAdr;
+            readahead_count = readahead_pages;
+            memcpy(buffer, readahead_buf, df_PageSize);
+            df_Read_PageAdr = PageAdr;
+            last_read_page = PageAdr;
+            return;
+        }
+    }
+    PageToBuffer(PageAdr);
+    last_read_page = PageAdr;
+}
+
+// read npages consecutive pages one at a time
+void AP_Logger_Block::PagesToBuffer(uint32_t PageAdr, uint8_t *buf, uint16_t npages)
+{
+    for (uint16_t i=0; i<npages; i++) {
+        PageToBuffer(PageAdr + i);
+        memcpy(&buf[i * df_PageSize], buffer, df_PageSize);
+    }
+}
+
+void AP_Logger_Block::invalidate_read_cache()
+{
+    memset(header_cache, 0, sizeof(header_cache));
+    readahead_count = 0;
+}
+
+uint32_t AP_Logger_Block::first_page_after_block(uint32_t page)
+{
+    const uint32_t num_blocks = df_NumPages / df_PagePerBlock;
+    uint32_t next_page = ((get_block(page) + 1) % num_blocks) * df_PagePerBlock + 1;
+    if (ReadPageHeader(next_page) == 0xFFFF) {
+        next_page = ((get_block(next_page) + 1) % num_blocks) * df_PagePerBlock + 1;
+    }
+    return next_page;
+}
+
 // read the headers at the current read point returning the file number
 uint16_t AP_Logger_Block::ReadHeaders()
 {
@@ -236,7 +379,7 @@ bool AP_Logger_Block::ReadBlock(void *pBuffer, uint16_t size)
                 memset(buffer, 0xff, df_PageSize);
                 df_Read_PageAdr = new_page_addr;
             } else {
-                PageToBuffer(new_page_addr);
+                ReadPage(new_page_addr);
             }
 
             // We are starting a new page - read FileNumber and FilePage
@@ -286,6 +429,8 @@ void AP_Logger_Block::EraseAll()
     // throw away everything
     log_write_started = false;
     writebuf.clear();
+    invalidate_read_cache();
+    erased_ahead_block = UINT32_MAX;
 
     // reset the format version and wrapped status so that any incomplete erase will be caught
     Sector4kErase(get_sector(df_NumPages));
@@ -305,6 +450,10 @@ void AP_Logger_Block::periodic_1Hz()
         rate_limiter = NEW_NOTHROW AP_Logger_RateLimiter(_front, _front._params.blk_ratemax, _front._params.disarm_ratemax);
     }
     
+    if (logging_started()) {
+        Write_Block_Stats();
+    }
+
     if (!io_thread_alive()) {
         if (warning_decimation_counter == 0 && _initialised) {
             // we don't print this error unless we did initialise. When _initialised is set to true
@@ -380,7 +529,7 @@ void AP_Logger_Block::validate_log_structure()
     uint32_t page = 1;
     uint32_t page_start = 1;
 
-    uint16_t file = StartRead(page);
+    uint16_t file = ReadPageHeader(page);
     uint16_t first_file = file;
     uint16_t next_file = file;
     uint16_t last_file = 0;
@@ -391,11 +540,11 @@ void AP_Logger_Block::validate_log_structure()
             break;
         }
         page = end_page + 1;
-        file = StartRead(page);
+        file = ReadPageHeader(page);
         next_file++;
         // skip over the rest of an erased block
         if (wrapped && file == 0xFFFF) {
-            file = StartRead((get_block(page) + 1) * df_PagePerBlock + 1);
+            file = ReadPageHeader(first_page_after_block(page));
         }
         if (wrapped && file < next_file) {
             page_start = page;
@@ -468,16 +617,37 @@ int16_t AP_Logger_Block::get_log_data(uint16_t list_entry, uint16_t page, uint32
 
     uint16_t ret = 0;
     if (len > 0) {
+        const uint32_t start_us = AP_HAL::micros();
         const int16_t bytes = get_log_data_raw(log_num, page, offset, len, data);
         if (bytes == -1) {
             return -1;
         }
         ret += bytes;
+
+        const uint32_t dt_us = AP_HAL::micros() - start_us;
+        io_stats.read_bytes += bytes;
+        io_stats.read_us += dt_us;
+        download_bytes += bytes;
+        download_us += dt_us;
     }
 
     return ret;
 }
 
+// report how fast the log was read from flash
+void AP_Logger_Block::end_log_transfer()
+{
+    if (download_bytes == 0) {
+        return;
+    }
+    GCS_SEND_TEXT(MAV_SEVERITY_INFO, "Log read %ukB in %ums (%ukB/s)",
+                  unsigned(download_bytes / 1024U),
+                  unsigned(download_us / 1000U),
+                  unsigned(uint64_t(download_bytes) * 1000000U / 1024U / MAX(download_us, 1U)));
+    download_bytes = 0;
+    download_us = 0;
+}
+
 
 // This function determines the number of whole log files in the AP_Logger
 // partial logs are rejected as without the headers they are relatively useless
@@ -491,20 +661,20 @@ uint16_t AP_Logger_Block::get_num_logs(void)
         return 0;
     }
 
-    uint32_t first = StartRead(1);
+    uint32_t first = ReadPageHeader(1);
     
     if (first == 0xFFFF) {
         return 0;
     }
 
     lastpage = find_last_page();
-    last = StartRead(lastpage);
+    last = ReadPageHeader(lastpage);
 
     if (is_wrapped()) {
         // if we wrapped then the rest of the block will be filled with 0xFFFF because we always erase
         // a block before writing to it, in order to find the first page we therefore have to read after the
         // next block boundary
-        first = StartRead((get_block(lastpage) + 1) * df_PagePerBlock + 1);
+        first = ReadPageHeader(first_page_after_block(lastpage));
         // unless we happen to land on the first page of the file that is being overwritten we skip to the next file
         if (df_FilePage > 1) {
             first++;
@@ -556,7 +726,7 @@ void AP_Logger_Block::start_new_log(void)
 
     uint32_t last_page = find_last_page();
 
-    StartRead(last_page);
+    ReadPageHeader(last_page);
 
     log_write_started = true;
     uint16_t new_log_num = 1;
@@ -615,13 +785,13 @@ void AP_Logger_Block::get_log_boundaries(uint16_t list_entry, uint32_t & start_p
         if (!is_wrapped()) {
             start_page = 1;
         } else {
-            StartRead(end_page);
+            ReadPageHeader(end_page);
             start_page = (end_page + df_NumPages - df_FilePage) % df_NumPages + 1;
         }
     } else {
         // looking for the first log which might have a gap in front of it
         if (list_entry == 1) {
-            StartRead(end_page);
+            ReadPageHeader(end_page);
             if (end_page > df_FilePage) { // log is not wrapped
                 start_page = end_page - df_FilePage + 1;
             } else { // log is wrapped
@@ -649,7 +819,7 @@ void AP_Logger_Block::get_log_boundaries(uint16_t list_entry, uint32_t & start_p
 // return true if logging has wrapped around to the beginning of the chip
 bool AP_Logger_Block::is_wrapped(void)
 {
-    return StartRead(df_NumPages) != 0xFFFF;
+    return ReadPageHeader(df_NumPages) != 0xFFFF;
 }
 
 
@@ -658,7 +828,7 @@ uint16_t AP_Logger_Block::find_last_log(void)
 {
     WITH_SEMAPHORE(sem);
     uint32_t last_page = find_last_page();
-    return StartRead(last_page);
+    return ReadPageHeader(last_page);
 }
 
 // This function finds the last page of the last file
@@ -673,12 +843,12 @@ uint32_t AP_Logger_Block::find_last_page(void)
 
     WITH_SEMAPHORE(sem);
 
-    StartRead(bottom);
+    ReadPageHeader(bottom);
     bottom_hash = ((int64_t)GetFileNumber()<<32) | df_FilePage;
 
     while (top-bottom > 1) {
         look = (top+bottom)/2;
-        StartRead(look);
+        ReadPageHeader(look);
         look_hash = (int64_t)GetFileNumber()<<32 | df_FilePage;
         // erased sector so can discount everything above
         if (look_hash >= 0xFFFF00000000) {
@@ -695,7 +865,7 @@ uint32_t AP_Logger_Block::find_last_page(void)
         }
     }
 
-    StartRead(top);
+    ReadPageHeader(top);
     top_hash = ((int64_t)GetFileNumber()<<32) | df_FilePage;
     if (top_hash >= 0xFFFF00000000) {
         top_hash = 0;
@@ -719,7 +889,7 @@ uint32_t AP_Logger_Block::find_last_page_of_log(uint16_t log_number)
     WITH_SEMAPHORE(sem);
 
     if (is_wrapped()) {
-        bottom = StartRead(1);
+        bottom = ReadPageHeader(1);
         if (bottom > log_number) {
             bottom = find_last_page();
             top = df_NumPages;
@@ -736,7 +906,7 @@ uint32_t AP_Logger_Block::find_last_page_of_log(uint16_t log_number)
 
     while (top-bottom > 1) {
         look = (top+bottom)/2;
-        StartRead(look);
+        ReadPageHeader(look);
         look_hash = (int64_t)GetFileNumber()<<32 | df_FilePage;
         if (look_hash >= 0xFFFF00000000) {
             look_hash = 0;
@@ -751,11 +921,11 @@ uint32_t AP_Logger_Block::find_last_page_of_log(uint16_t log_number)
         }
     }
 
-    if (StartRead(top) == log_number) {
+    if (ReadPageHeader(top) == log_number) {
         return top;
     }
 
-    if (StartRead(bottom) == log_number) {
+    if (ReadPageHeader(bottom) == log_number) {
         return bottom;
     }
 
@@ -875,6 +1045,7 @@ void AP_Logger_Block::io_timer(void)
             io_timer_heartbeat = AP_HAL::millis();
             next_sector += sectors_in_block;
         }
+        invalidate_read_cache();
         status_msg = StatusMessage::RECOVERY_COMPLETE;
         df_EraseFrom = 0;
     }
@@ -883,6 +1054,17 @@ void AP_Logger_Block::io_timer(void)
         return;
     }
 
+    // rather than wait for a block erase in WriteEnable() come back
+    // when it has finished
+    if (block_erase_pending) {
+        WITH_SEMAPHORE(sem);
+        if (Busy()) {
+            io_stats.busy_skips++;
+            return;
+        }
+        block_erase_pending = false;
+    }
+
     // we have been asked to stop logging, flush everything
     if (stop_log_pending) {
         WITH_SEMAPHORE(sem);
@@ -897,11 +1079,23 @@ void AP_Logger_Block::io_timer(void)
             stop_log_pending = false;
         }
 
-    // write at most one page
+    // write as many whole pages as are ready, up to a batch
     } else if (writebuf.available() >= df_PageSize - sizeof(struct PageHeader)) {
         WITH_SEMAPHORE(sem);
 
-        write_log_page();
+        for (uint16_t i=0; i<write_batch_pages; i++) {
+            write_log_page();
+            if (block_erase_pending || chip_full ||
+                writebuf.available() < df_PageSize - sizeof(struct PageHeader)) {
+                break;
+            }
+        }
+
+    // nothing to write, get the next block ready
+    } else if (log_write_started) {
+        WITH_SEMAPHORE(sem);
+
+        erase_next_block();
     }
 }
 
@@ -920,10 +1114,38 @@ void AP_Logger_Block::write_log_page()
     if (nbytes <  pagesize) {
         memset(&buffer[sizeof(ph) + nbytes], 0, pagesize - nbytes);
     }
+    const uint32_t start_us = AP_HAL::micros();
     FinishWrite();
+    io_stats.write_bytes += df_PageSize;
+    io_stats.write_us += AP_HAL::micros() - start_us;
     df_Write_FilePage++;
 }
 
+// log flash throughput over the last second
+void AP_Logger_Block::Write_Block_Stats()
+{
+    // the IO thread updates the counters with sem held
+    if (!sem.take_nonblocking()) {
+        return;
+    }
+    const auto stats = io_stats;
+    memset(&io_stats, 0, sizeof(io_stats));
+    sem.give();
+
+    const struct log_Block_Stats pkt {
+        LOG_PACKET_HEADER_INIT(LOG_BLOCK_STATS_MSG),
+        time_us      : AP_HAL::micros64(),
+        write_bytes  : stats.write_bytes,
+        write_us     : stats.write_us,
+        read_bytes   : stats.read_bytes,
+        read_us      : stats.read_us,
+        erases       : stats.erases,
+        erases_ahead : stats.erases_ahead,
+        busy_skips   : stats.busy_skips,
+    };
+    WriteBlock(&pkt, sizeof(pkt));
+}
+
 void AP_Logger_Block::flash_test()
 {
     uint32_t pages_to_check = 128;
@@ -24,7 +24,7 @@ public:
     void get_log_boundaries(uint16_t list_entry, uint32_t & start_page, uint32_t & end_page) override;
     void get_log_info(uint16_t list_entry, uint32_t &size, uint32_t &time_utc) override;
     int16_t get_log_data(uint16_t list_entry, uint16_t page, uint32_t offset, uint16_t len, uint8_t *data) override WARN_IF_UNUSED;
-    void end_log_transfer() override { }
+    void end_log_transfer() override;
     uint16_t get_num_logs() override;
     void start_new_log(void) override;
     uint32_t bufferspace_available() override;
@@ -65,6 +65,10 @@ protected:
     uint32_t last_messagewrite_message_sent;
     uint32_t df_Read_PageAdr;
 
+    // read npages consecutive pages starting at PageAdr into buf.  By
+    // default they are read one at a time through buffer
+    virtual void PagesToBuffer(uint32_t PageAdr, uint8_t *buf, uint16_t npages);
+
 private:
     /*
       functions implemented by the board specific backends
@@ -75,6 +79,7 @@ private:
     virtual void Sector4kErase(uint32_t SectorAdr) = 0;
     virtual void StartErase() = 0;
     virtual bool InErase() = 0;
+    virtual bool Busy() = 0;
     void         flash_test(void);
 
     struct PACKED PageHeader {
@@ -111,6 +116,42 @@ private:
     // offset from adding FMT messages to log data
     bool adding_fmt_headers;
 
+    // number of pages written in one IO pass when data is backed up
+    uint16_t write_batch_pages;
+
+    // pages read ahead of the read point when reading sequentially
+    uint8_t *readahead_buf;
+    uint16_t readahead_pages;       // number of pages readahead_buf holds
+    uint32_t readahead_first;       // first page held in readahead_buf
+    uint16_t readahead_count;       // number of valid pages in readahead_buf
+    uint32_t last_read_page;
+
+    // headers of recently read pages, indexed by page number modulo the cache size
+    struct PageHeaderCacheEntry {
+        uint32_t page;              // zero if unused
+        uint32_t file_page;
+        uint16_t file_number;
+    } header_cache[AP_LOGGER_BLOCK_HEADER_CACHE_SIZE];
+
+    // block erased before the write point reached it, or UINT32_MAX
+    uint32_t erased_ahead_block = UINT32_MAX;
+    // has a block erase been started that may not have finished?
+    volatile bool block_erase_pending;
+
+    // flash throughput, logged in BKS and cleared each second
+    struct {
+        uint32_t write_bytes;
+        uint32_t write_us;
+        uint32_t read_bytes;
+        uint32_t read_us;
+        uint16_t erases;
+        uint16_t erases_ahead;
+        uint16_t busy_skips;
+    } io_stats;
+    // totals for the current log download
+    uint32_t download_bytes;
+    uint32_t download_us;
+
     // are we waiting on an erase to finish?
     volatile bool erase_started;
     // were we logging before the erase started?
@@ -144,6 +185,18 @@ private:
     uint16_t StartRead(uint32_t PageAdr);
     // read the headers at the current read point returning the file number
     uint16_t ReadHeaders();
+    // read just the headers of a page returning the file number, using
+    // the header cache where possible
+    uint16_t ReadPageHeader(uint32_t PageAdr);
+    // read a page into buffer, reading ahead if reads are sequential
+    void ReadPage(uint32_t PageAdr);
+    // forget cached headers and read-ahead data after an erase
+    void invalidate_read_cache();
+    // first page of the block after the one holding page, skipping a
+    // block that has been erased ahead of the write point
+    uint32_t first_page_after_block(uint32_t page);
+    // erase the block after the write point while logging is idle
+    void erase_next_block();
     uint32_t find_last_page(void);
     uint32_t find_last_page_of_log(uint16_t log_number);
     bool is_wrapped(void);
@@ -162,6 +215,7 @@ private:
     // callback on IO thread
     bool io_thread_alive() const;
     void write_log_page();
+    void Write_Block_Stats();
 };
 
 #endif  // HAL_LOGGING_BLOCK_ENABLED
@@ -846,6 +846,9 @@ void AP_Logger_File::start_new_log(void)
     _open_error_ms = 0;
     _write_offset = 0;
     _writebuf.clear();
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    compress_start();
+#endif
     write_fd_semaphore.give();
 
     // now update lastlog.txt with the new log number
@@ -883,7 +886,11 @@ void AP_Logger_File::flush(void)
 #if APM_BUILD_TYPE(APM_BUILD_Replay) || APM_BUILD_TYPE(APM_BUILD_UNKNOWN)
 {
     uint32_t tnow = AP_HAL::millis();
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    while (_write_fd != -1 && _initialised && !recent_open_error() && (_writebuf.available() || compress_pending())) {
+#else
     while (_write_fd != -1 && _initialised && !recent_open_error() && _writebuf.available()) {
+#endif
         // convince the IO timer that it really is OK to write out
         // less than _writebuf_chunk bytes:
         if (tnow > 2001) { // avoid resetting _last_write_time to 0
@@ -935,10 +942,16 @@ void AP_Logger_File::io_timer(void)
     }
 
     uint32_t nbytes = _writebuf.available();
-    if (nbytes == 0) {
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    // compressed data already taken from _writebuf is written straight away
+    const bool have_pending = compress_pending() > 0;
+#else
+    const bool have_pending = false;
+#endif
+    if (nbytes == 0 && !have_pending) {
         return;
     }
-    if (nbytes < _writebuf_chunk && 
+    if (!have_pending && nbytes < _writebuf_chunk &&
         tnow - _last_write_time < 2000UL) {
         // write in _writebuf_chunk-sized chunks, but always write at
         // least once per 2 seconds if data is available
@@ -965,9 +978,36 @@ void AP_Logger_File::io_timer(void)
         nbytes = _writebuf_chunk;
     }
 
-    uint32_t size;
-    const uint8_t *head = _writebuf.readptr(size);
-    nbytes = MIN(nbytes, size);
+    last_io_operation = "write";
+    if (!write_fd_semaphore.take(1)) {
+        return;
+    }
+    if (_write_fd == -1) {
+        write_fd_semaphore.give();
+        return;
+    }
+
+    // a new log may have been started since we looked, so find the
+    // data to write while holding the semaphore
+    const uint8_t *head;
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    if (_compress.active) {
+        if (compress_pending() == 0) {
+            compress_block(nbytes);
+        }
+        head = &_compress.out_buf[_compress.out_ofs];
+        nbytes = compress_pending();
+    } else
+#endif
+    {
+        uint32_t size;
+        head = _writebuf.readptr(size);
+        nbytes = MIN(nbytes, size);
+    }
+    if (nbytes == 0) {
+        write_fd_semaphore.give();
+        return;
+    }
 
 #if !AP_FILESYSTEM_LITTLEFS_ENABLED
     // try to align writes on a 512 byte boundary to avoid filesystem reads
@@ -978,14 +1018,6 @@ void AP_Logger_File::io_timer(void)
         }
     }
 #endif
-    last_io_operation = "write";
-    if (!write_fd_semaphore.take(1)) {
-        return;
-    }
-    if (_write_fd == -1) {
-        write_fd_semaphore.give();
-        return;
-    }
 
     uint32_t bytes_until_fsync = AP::FS().bytes_until_fsync(_write_fd);
     if (bytes_until_fsync > 0 && nbytes > bytes_until_fsync) {
@@ -1015,7 +1047,14 @@ void AP_Logger_File::io_timer(void)
         _last_write_failed = false;
         _last_write_ms = tnow;
         _write_offset += nwritten;
-        _writebuf.advance(nwritten);
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+        if (_compress.active) {
+            _compress.out_ofs += nwritten;
+        } else
+#endif
+        {
+            _writebuf.advance(nwritten);
+        }
 
         // we know nwritten > 0 so we won't sync if bytes_until_fsync == 0
         if ((uint32_t)nwritten == bytes_until_fsync) {
@@ -1040,6 +1079,102 @@ void AP_Logger_File::io_timer(void)
     write_fd_semaphore.give();
 }
 
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+// size of the compressed block buffer
+#define LOGGER_COMP_BUF_SIZE AP_LOGGER_LZ_COMPRESSED_MAX(AP_LOGGER_LZ_BLOCK_MAX)
+// LZB messages needed for the largest compressed block, plus the LZB FMT message
+#define LOGGER_COMP_OUT_SIZE ((LOGGER_COMP_BUF_SIZE / sizeof(log_Compressed_Block::data) + 1) * sizeof(log_Compressed_Block) + sizeof(log_Format))
+
+/*
+  decide whether to compress a newly opened log file, queueing the LZB
+  FMT message to be written uncompressed at the start of the file
+ */
+void AP_Logger_File::compress_start(void)
+{
+    _compress.active = false;
+    _compress.out_len = 0;
+    _compress.out_ofs = 0;
+    _compress.seq = 0;
+
+    if (_front._params.file_compress == 0) {
+        return;
+    }
+    if (_compress.lz == nullptr) {
+        _compress.lz = NEW_NOTHROW AP_Logger_LZ;
+        _compress.comp_buf = NEW_NOTHROW uint8_t[LOGGER_COMP_BUF_SIZE];
+        _compress.out_buf = NEW_NOTHROW uint8_t[LOGGER_COMP_OUT_SIZE];
+    }
+    if (_compress.lz == nullptr || _compress.comp_buf == nullptr || _compress.out_buf == nullptr) {
+        DEV_PRINTF("Log compression disabled: out of memory\n");
+        return;
+    }
+
+    for (uint8_t i = 0; i < num_types(); i++) {
+        const struct LogStructure *s = structure(i);
+        if (s->msg_type != LOG_COMPRESSED_BLOCK_MSG) {
+            continue;
+        }
+        struct log_Format pkt;
+        Fill_Format(s, pkt);
+        memcpy(_compress.out_buf, &pkt, sizeof(pkt));
+        _compress.out_len = sizeof(pkt);
+        _compress.active = true;
+        return;
+    }
+}
+
+/*
+  compress up to nbytes from the front of _writebuf and turn the
+  result into LZB messages ready to be written to the file. Blocks
+  which do not compress are stored as they are
+ */
+void AP_Logger_File::compress_block(uint32_t nbytes)
+{
+    uint32_t size;
+    const uint8_t *head = _writebuf.readptr(size);
+    const uint16_t raw_len = MIN(MIN(nbytes, size), uint32_t(AP_LOGGER_LZ_BLOCK_MAX));
+    if (raw_len == 0) {
+        return;
+    }
+
+    const uint32_t start_us = AP_HAL::micros();
+    uint16_t comp_len = _compress.lz->compress(head, raw_len, _compress.comp_buf, LOGGER_COMP_BUF_SIZE);
+    const uint32_t cpu_us = AP_HAL::micros() - start_us;
+
+    uint8_t method = 1;
+    const uint8_t *data = _compress.comp_buf;
+    if (comp_len == 0 || comp_len >= raw_len) {
+        method = 0;
+        data = head;
+        comp_len = raw_len;
+    }
+
+    _compress.out_len = 0;
+    _compress.out_ofs = 0;
+    const uint64_t now_us = AP_HAL::micros64();
+    for (uint16_t ofs = 0; ofs < comp_len; ) {
+        struct log_Compressed_Block pkt {
+            LOG_PACKET_HEADER_INIT(LOG_COMPRESSED_BLOCK_MSG),
+            time_us  : now_us,
+            seq      : _compress.seq,
+            method   : method,
+            raw_len  : raw_len,
+            comp_len : comp_len,
+            offset   : ofs,
+            cpu_us   : uint16_t(MIN(cpu_us, UINT16_MAX)),
+            length   : uint8_t(MIN(comp_len - ofs, sizeof(pkt.data))),
+        };
+        memcpy(pkt.data, &data[ofs], pkt.length);
+        memcpy(&_compress.out_buf[_compress.out_len], &pkt, sizeof(pkt));
+        _compress.out_len += sizeof(pkt);
+        ofs += pkt.length;
+    }
+    _compress.seq++;
+
+    _writebuf.advance(raw_len);
+}
+#endif // AP_LOGGER_FILE_COMPRESSION_ENABLED
+
 bool AP_Logger_File::io_thread_alive() const
 {
     if (!hal.scheduler->is_system_initialized()) {
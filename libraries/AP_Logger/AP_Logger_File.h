@@ -10,6 +10,7 @@
 
 #include <AP_HAL/utility/RingBuffer.h>
 #include "AP_Logger_Backend.h"
+#include "AP_Logger_LZ.h"
 
 #if HAL_LOGGING_FILESYSTEM_ENABLED
 
@@ -156,6 +157,34 @@ private:
     const char *last_io_operation = "";
 
     bool start_new_log_pending;
+
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    /*
+      compressed log file support. When compressing, the io thread
+      takes data from _writebuf a block at a time, compresses it and
+      writes it out as LZB messages. The LZB FMT message is written
+      uncompressed at the start of the file so readers know how to
+      find the compressed blocks
+     */
+    struct {
+        bool active;            // compressing the current log file
+        AP_Logger_LZ *lz;
+        uint8_t *comp_buf;      // compressed block
+        uint8_t *out_buf;       // messages waiting to be written to the file
+        uint16_t out_len;
+        uint16_t out_ofs;
+        uint16_t seq;
+    } _compress;
+
+    // decide whether to compress a newly opened log file
+    void compress_start(void);
+    // compress up to nbytes of _writebuf into LZB messages
+    void compress_block(uint32_t nbytes);
+    // number of compressed bytes waiting to be written to the file
+    uint16_t compress_pending(void) const {
+        return (_compress.active && _compress.out_ofs < _compress.out_len) ? _compress.out_len - _compress.out_ofs : 0;
+    }
+#endif
 };
 
 #endif // HAL_LOGGING_FILESYSTEM_ENABLED
@@ -246,6 +246,28 @@ void AP_Logger_Flash_JEDEC::PageToBuffer(uint32_t pageNum)
     read_cache_valid = true;
 }
 
+/*
+  read consecutive pages with a single read command, the chip
+  continues to the next page as long as the clock runs
+ */
+void AP_Logger_Flash_JEDEC::PagesToBuffer(uint32_t pageNum, uint8_t *buf, uint16_t npages)
+{
+    if (pageNum == 0 || pageNum + npages - 1 > df_NumPages+1) {
+        AP_Logger_Block::PagesToBuffer(pageNum, buf, npages);
+        return;
+    }
+
+    WaitReady();
+
+    uint32_t PageAdr = (pageNum-1) * df_PageSize;
+
+    WITH_SEMAPHORE(dev_sem);
+    dev->set_chip_select(true);
+    send_command_addr(JEDEC_READ_DATA, PageAdr);
+    dev->transfer(nullptr, 0, buf, npages * df_PageSize);
+    dev->set_chip_select(false);
+}
+
 void AP_Logger_Flash_JEDEC::BufferToPage(uint32_t pageNum)
 {
     if (pageNum == 0 || pageNum > df_NumPages+1) {
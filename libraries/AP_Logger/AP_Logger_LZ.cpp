@@ -0,0 +1,197 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_Logger_LZ.h"
+
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+
+#include <string.h>
+#include <AP_Math/AP_Math.h>
+
+#pragma GCC optimize("O2")
+
+// matches are at least this long
+#define LZ_MIN_MATCH 4
+// the last match must start at least this far from the end of the block
+#define LZ_MATCH_LIMIT 12
+// the block always ends with at least this many literals
+#define LZ_LAST_LITERALS 5
+
+static inline uint32_t read32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// write a length of 15 or more as a run of extra bytes after the token
+static inline uint8_t *write_length(uint8_t *op, uint32_t len)
+{
+    len -= 15;
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = len;
+    return op;
+}
+
+/*
+  compress src_len bytes from src into dst. Returns the compressed
+  length, or zero if the compressed data would not fit in dst_max
+  bytes
+ */
+uint16_t AP_Logger_LZ::compress(const uint8_t *src, uint16_t src_len, uint8_t *dst, uint16_t dst_max)
+{
+    const uint8_t *ip = src;
+    const uint8_t *anchor = src;
+    const uint8_t *const iend = src + src_len;
+    uint8_t *op = dst;
+    uint8_t *const oend = dst + dst_max;
+
+    if (src_len > LZ_MATCH_LIMIT) {
+        memset(hash_table, 0, sizeof(hash_table));
+        const uint8_t *const match_limit = iend - LZ_MATCH_LIMIT;
+        const uint8_t *const match_end_limit = iend - LZ_LAST_LITERALS;
+
+        while (ip < match_limit) {
+            const uint32_t seq = read32(ip);
+            const uint32_t h = (seq * 2654435761U) >> (32 - HASH_BITS);
+            const uint8_t *ref = src + hash_table[h];
+            hash_table[h] = ip - src;
+            if (ref >= ip || read32(ref) != seq) {
+                ip++;
+                continue;
+            }
+
+            // extend the match as far as we can
+            uint32_t match_len = LZ_MIN_MATCH;
+            while (ip + match_len < match_end_limit && ref[match_len] == ip[match_len]) {
+                match_len++;
+            }
+
+            // token, literal run, offset and match length
+            const uint32_t lit_len = ip - anchor;
+            if (op + 1 + lit_len + lit_len/255 + 1 + 2 + (match_len/255 + 1) > oend) {
+                return 0;
+            }
+            const uint32_t ml = match_len - LZ_MIN_MATCH;
+            uint8_t *token = op++;
+            *token = (MIN(lit_len, 15U) << 4) | MIN(ml, 15U);
+            if (lit_len >= 15) {
+                op = write_length(op, lit_len);
+            }
+            memcpy(op, anchor, lit_len);
+            op += lit_len;
+            const uint16_t offset = ip - ref;
+            *op++ = offset & 0xFF;
+            *op++ = offset >> 8;
+            if (ml >= 15) {
+                op = write_length(op, ml);
+            }
+
+            ip += match_len;
+            anchor = ip;
+        }
+    }
+
+    // the remaining bytes go out as literals
+    const uint32_t lit_len = iend - anchor;
+    if (op + 1 + lit_len + lit_len/255 + 1 > oend) {
+        return 0;
+    }
+    *op++ = MIN(lit_len, 15U) << 4;
+    if (lit_len >= 15) {
+        op = write_length(op, lit_len);
+    }
+    memcpy(op, anchor, lit_len);
+    op += lit_len;
+
+    return op - dst;
+}
+
+/*
+  decompress a block into dst. Returns the decompressed length, or
+  -1 if the block is corrupt or would not fit in dst_max bytes
+ */
+int32_t AP_Logger_LZ::decompress(const uint8_t *src, uint16_t src_len, uint8_t *dst, uint16_t dst_max)
+{
+    const uint8_t *ip = src;
+    const uint8_t *const iend = src + src_len;
+    uint8_t *op = dst;
+    uint8_t *const oend = dst + dst_max;
+
+    while (ip < iend) {
+        const uint8_t token = *ip++;
+
+        uint32_t lit_len = token >> 4;
+        if (lit_len == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) {
+                    return -1;
+                }
+                b = *ip++;
+                lit_len += b;
+            } while (b == 255);
+        }
+        if (lit_len > uint32_t(iend - ip) || lit_len > uint32_t(oend - op)) {
+            return -1;
+        }
+        memcpy(op, ip, lit_len);
+        ip += lit_len;
+        op += lit_len;
+
+        if (ip == iend) {
+            // last sequence has no match
+            break;
+        }
+
+        if (iend - ip < 2) {
+            return -1;
+        }
+        const uint16_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op - dst) {
+            return -1;
+        }
+
+        uint32_t match_len = token & 0x0F;
+        if (match_len == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) {
+                    return -1;
+                }
+                b = *ip++;
+                match_len += b;
+            } while (b == 255);
+        }
+        match_len += LZ_MIN_MATCH;
+        if (match_len > uint32_t(oend - op)) {
+            return -1;
+        }
+        // matches may overlap the bytes being written so copy forwards
+        const uint8_t *ref = op - offset;
+        for (uint32_t i = 0; i < match_len; i++) {
+            op[i] = ref[i];
+        }
+        op += match_len;
+    }
+
+    return op - dst;
+}
+
+#endif // AP_LOGGER_FILE_COMPRESSION_ENABLED
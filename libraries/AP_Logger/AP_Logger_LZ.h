@@ -0,0 +1,60 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  LZ77 block compression for log files, using the LZ4 block format.
+
+  Each block is compressed independently. A compressed block is a
+  sequence of tokens, each giving a run of literal bytes followed by a
+  match copying bytes from earlier in the block. The block always ends
+  with a run of literals.
+ */
+#pragma once
+
+#include "AP_Logger_config.h"
+
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+
+#include <stdint.h>
+
+// largest block that may be compressed
+#define AP_LOGGER_LZ_BLOCK_MAX 4096
+
+// largest compressed size of a block of n bytes
+#define AP_LOGGER_LZ_COMPRESSED_MAX(n) ((n) + (n)/255 + 16)
+
+class AP_Logger_LZ
+{
+public:
+    /*
+      compress src_len bytes from src into dst. Returns the compressed
+      length, or zero if the compressed data would not fit in dst_max
+      bytes
+     */
+    uint16_t compress(const uint8_t *src, uint16_t src_len, uint8_t *dst, uint16_t dst_max);
+
+    /*
+      decompress a block into dst. Returns the decompressed length, or
+      -1 if the block is corrupt or would not fit in dst_max bytes
+     */
+    static int32_t decompress(const uint8_t *src, uint16_t src_len, uint8_t *dst, uint16_t dst_max);
+
+private:
+    static const uint8_t HASH_BITS = 12;
+
+    // position in the current block of the last 4 bytes seen with each hash
+    uint16_t hash_table[1U<<HASH_BITS];
+};
+
+#endif // AP_LOGGER_FILE_COMPRESSION_ENABLED
@@ -247,6 +247,45 @@ void AP_Logger_W25NXX::PageToBuffer(uint32_t pageNum)
     }
 }
 
+/*
+  read consecutive pages with the chip in continuous read mode, where
+  a read runs on from the end of one page's main array into the next
+  page. The chip is put back in buffer read mode afterwards as page
+  programming uses the data buffer
+ */
+void AP_Logger_W25NXX::PagesToBuffer(uint32_t pageNum, uint8_t *buf, uint16_t npages)
+{
+    if (pageNum == 0 || pageNum + npages - 1 > df_NumPages+1) {
+        AP_Logger_Block::PagesToBuffer(pageNum, buf, npages);
+        return;
+    }
+
+    WriteStatusReg(W25NXX_CONF_REG, W25NXX_CONFIG_ECC_ENABLE);
+
+    WaitReady();
+    {
+        WITH_SEMAPHORE(dev_sem);
+        // read first page into internal buffer
+        send_command_addr(JEDEC_PAGE_DATA_READ, pageNum-1);
+    }
+
+    WaitReady();
+    {
+        WITH_SEMAPHORE(dev_sem);
+        dev->set_chip_select(true);
+        uint8_t cmd[4];
+        cmd[0] = JEDEC_READ_DATA;
+        cmd[1] = 0; // dummy
+        cmd[2] = 0; // dummy
+        cmd[3] = 0; // dummy
+        dev->transfer(cmd, 4, nullptr, 0);
+        dev->transfer(nullptr, 0, buf, npages * df_PageSize);
+        dev->set_chip_select(false);
+    }
+
+    WriteStatusReg(W25NXX_CONF_REG, W25NXX_CONFIG_ECC_ENABLE|W25NXX_CONFIG_BUFFER_READ_MODE);
+}
+
 //#define AP_W25NXX_DEBUG
 #ifdef AP_W25NXX_DEBUG
 static uint32_t block_writes;
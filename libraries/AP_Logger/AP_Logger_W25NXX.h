@@ -25,13 +25,14 @@ public:
 private:
     void              BufferToPage(uint32_t PageAdr) override;
     void              PageToBuffer(uint32_t PageAdr) override;
+    void              PagesToBuffer(uint32_t PageAdr, uint8_t *buf, uint16_t npages) override;
     void              SectorErase(uint32_t SectorAdr) override;
     void              Sector4kErase(uint32_t SectorAdr) override;
     void              StartErase() override;
     bool              InErase() override;
+    bool              Busy() override;
     void              send_command_addr(uint8_t cmd, uint32_t address);
     void              WaitReady();
-    bool              Busy();
     uint8_t           ReadStatusRegBits(uint8_t bits);
     void              WriteStatusReg(uint8_t reg, uint8_t bits);
 
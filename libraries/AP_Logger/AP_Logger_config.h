@@ -51,6 +51,34 @@
 #define HAL_LOGGER_FILE_CONTENTS_ENABLED HAL_LOGGING_FILESYSTEM_ENABLED && !AP_FILESYSTEM_LITTLEFS_ENABLED
 #endif
 
+#ifndef AP_LOGGER_FILE_COMPRESSION_ENABLED
+#define AP_LOGGER_FILE_COMPRESSION_ENABLED HAL_LOGGING_FILESYSTEM_ENABLED && HAL_PROGRAM_SIZE_LIMIT_KB > 1024
+#endif
+
+// keep the format and parameter messages written at the start of
+// each log prebuilt in memory so they can be copied in as a block.
+// The cache holds the whole log header, about 70kB on Copter
+#ifndef AP_LOGGER_STARTUP_CACHE_ENABLED
+#define AP_LOGGER_STARTUP_CACHE_ENABLED (HAL_LOGGING_ENABLED && HAL_MEM_CLASS >= HAL_MEM_CLASS_1000)
+#endif
+
+// block based storage: bytes written per IO pass when data is backed
+// up, bytes read at once when a log is read sequentially, and number
+// of page headers kept for finding log boundaries
+#ifndef AP_LOGGER_BLOCK_WRITE_BATCH
+#define AP_LOGGER_BLOCK_WRITE_BATCH 4096
+#endif
+
+// the read ahead buffer is DMA safe memory, so it is left out on
+// boards short of it
+#ifndef AP_LOGGER_BLOCK_READ_AHEAD
+#define AP_LOGGER_BLOCK_READ_AHEAD ((HAL_MEM_CLASS >= HAL_MEM_CLASS_1000) ? 4096 : (HAL_MEM_CLASS >= HAL_MEM_CLASS_500) ? 1024 : 0)
+#endif
+
+#ifndef AP_LOGGER_BLOCK_HEADER_CACHE_SIZE
+#define AP_LOGGER_BLOCK_HEADER_CACHE_SIZE 64
+#endif
+
 // range of IDs to allow for new messages during replay. It is very
 // useful to be able to add new messages during a replay, but we need
 // to avoid colliding with existing messages
@@ -67,6 +67,13 @@ bool AP_Logger_Backend::Write_Format(const struct LogStructure *s)
     return true;
 }
 
+void AP_Logger_Backend::set_emitted_all_formats()
+{
+    for (uint8_t i=0; i<num_types(); i++) {
+        _formats_written.set(structure(i)->msg_type);
+    }
+}
+
 /*
   write a unit definition
  */
@@ -230,6 +230,18 @@ struct PACKED log_DSF {
     uint32_t buf_space_avg;
 };
 
+struct PACKED log_Block_Stats {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint32_t write_bytes;
+    uint32_t write_us;
+    uint32_t read_bytes;
+    uint32_t read_us;
+    uint16_t erases;
+    uint16_t erases_ahead;
+    uint16_t busy_skips;
+};
+
 struct PACKED log_Event {
     LOG_PACKET_HEADER;
     uint64_t time_us;
@@ -318,6 +330,27 @@ struct PACKED log_MAV {
     uint16_t times_full;
 };
 
+struct PACKED log_MAVR {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t chan;
+    uint8_t id;
+    float requested_hz;
+    float achieved_hz;
+    uint16_t skipped;
+    uint16_t link_bw;
+};
+
+struct PACKED log_MAVT {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t sysid;
+    uint8_t compid;
+    uint8_t chan;
+    uint32_t age_ms;
+    uint32_t forward_count;
+};
+
 struct PACKED log_RSSI {
     LOG_PACKET_HEADER;
     uint64_t time_us;
@@ -477,6 +510,8 @@ struct PACKED log_TERRAIN {
     uint16_t pending;
     uint16_t loaded;
     float reference_offset;
+    uint32_t cache_hits;
+    uint32_t cache_misses;
 };
 
 struct PACKED log_ARSP {
@@ -546,6 +581,20 @@ struct PACKED log_Performance {
     uint64_t rtc;
 };
 
+// task number used in log_PerfHistogram for the main loop
+#define LOG_PERF_HISTOGRAM_LOOP 255
+
+struct PACKED log_PerfHistogram {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t task;
+    uint16_t count;
+    uint16_t p50;
+    uint16_t p95;
+    uint16_t p99;
+    uint16_t max;
+};
+
 struct PACKED log_SRTL {
     LOG_PACKET_HEADER;
     uint64_t time_us;
@@ -602,6 +651,20 @@ struct PACKED log_File {
     char data[64];
 };
 
+// a chunk of a compressed block of log data, see AP_Logger_File
+struct PACKED log_Compressed_Block {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint16_t seq;
+    uint8_t method;
+    uint16_t raw_len;
+    uint16_t comp_len;
+    uint16_t offset;
+    uint16_t cpu_us;
+    uint8_t length;
+    uint8_t data[192];
+};
+
 struct PACKED log_Scripting {
     LOG_PACKET_HEADER;
     uint64_t time_us;
@@ -714,6 +777,17 @@ struct PACKED log_VER {
 // @Field: FMx: Maximum free space in write buffer in last time period
 // @Field: FAv: Average free space in write buffer in last time period
 
+// @LoggerMessage: BKS
+// @Description: Block based onboard logging throughput
+// @Field: TimeUS: Time since system startup
+// @Field: WB: bytes written to flash in last time period
+// @Field: WT: time spent writing to flash in last time period
+// @Field: RB: bytes read from flash in last time period
+// @Field: RT: time spent reading from flash in last time period
+// @Field: Er: number of blocks erased in last time period
+// @Field: ErA: number of those blocks erased ahead of the write point
+// @Field: Bsy: number of IO passes skipped while waiting for an erase to finish
+
 // @LoggerMessage: ERR
 // @Description: Specifically coded error messages
 // @Field: TimeUS: Time since system startup
@@ -779,6 +853,25 @@ struct PACKED log_VER {
 // @Field: ss: stream slowdown is the number of ms being added to each message to fit within bandwidth
 // @Field: tf: times buffer was full when a message was going to be sent
 
+// @LoggerMessage: MAVR
+// @Description: GCS MAVLink per-message stream rates
+// @Field: TimeUS: Time since system startup
+// @Field: chan: mavlink channel number
+// @Field: id: ap_message id of the stream message
+// @Field: RReq: rate requested for this message
+// @Field: RAch: rate this message was actually sent at
+// @Field: Skp: number of times this message was skipped to save bandwidth
+// @Field: BW: estimated link throughput
+
+// @LoggerMessage: MAVT
+// @Description: MAVLink routing table entries
+// @Field: TimeUS: Time since system startup
+// @Field: SysID: system ID of the route
+// @Field: CompID: component ID of the route
+// @Field: chan: mavlink channel the route was learned on
+// @Field: Age: time since a message was last received from this route
+// @Field: Fwd: number of messages forwarded to this route
+
 // @LoggerMessage: MAVC
 // @Description: MAVLink command we have just executed
 // @Field: TimeUS: Time since system startup
@@ -880,6 +973,16 @@ struct PACKED log_VER {
 // @Field: Ex: number of microseconds being added to each loop to address scheduler overruns
 // @Field: R: RTC time, time since Unix epoch
 
+// @LoggerMessage: PMH
+// @Description: Main loop and scheduler task time percentiles, from a histogram of times since the last PMH message
+// @Field: TimeUS: Time since system startup
+// @Field: Task: Scheduler task index, 255 for the main loop
+// @Field: N: Number of times measured
+// @Field: P50: Median time
+// @Field: P95: 95th percentile time
+// @Field: P99: 99th percentile time
+// @Field: Max: Maximum time
+
 // @LoggerMessage: POWR
 // @Description: System power information
 // @Field: TimeUS: Time since system startup
@@ -1047,6 +1150,8 @@ struct PACKED log_VER {
 // @Field: Pending: Number of tile requests outstanding
 // @Field: Loaded: Number of tiles in memory
 // @Field: ROfs: terrain reference offset for arming altitude
+// @Field: Hit: Number of terrain lookups which found the tile in memory
+// @Field: Miss: Number of terrain lookups which had to load the tile
 
 // @LoggerMessage: TSYN
 // @Description: Time synchronisation response information
@@ -1099,6 +1204,20 @@ struct PACKED log_VER {
 // @Field: Length: Length of this data block
 // @Field: Data: File data of this block
 
+// @LoggerMessage: LZB
+// @Description: Compressed log data. When LOG_FILE_COMP is set all log messages after this message's FMT are written as a sequence of compressed blocks, each split over as many LZB messages as needed
+// @Field: TimeUS: Time since system startup
+// @Field: Seq: block sequence number
+// @Field: Meth: compression method, 0 for uncompressed and 1 for LZ4 block format
+// @Field: RLen: uncompressed length of the block
+// @Field: CLen: compressed length of the block
+// @Field: Ofs: offset into the compressed block of this chunk
+// @Field: CPU: time taken to compress the block
+// @Field: Len: number of bytes of Data used in this chunk
+// @Field: D0: compressed data
+// @Field: D1: compressed data
+// @Field: D2: compressed data
+
 // @LoggerMessage: SCR
 // @Description: Scripting runtime stats
 // @Field: TimeUS: Time since system startup
@@ -1192,13 +1311,15 @@ LOG_STRUCTURE_FROM_MOUNT \
     LOG_STRUCTURE_FROM_PROXIMITY                                    \
     { LOG_PERFORMANCE_MSG, sizeof(log_Performance),                     \
       "PM",  "QHHHIIHHIIIIIIQ", "TimeUS,LR,NLon,NL,MaxT,Mem,Load,ErrL,InE,ErC,SPIC,I2CC,I2CI,Ex,R", "sz---b%------ss", "F----0A------FF" }, \
+    { LOG_PERF_HISTOGRAM_MSG, sizeof(log_PerfHistogram),               \
+      "PMH", "QBHHHHH", "TimeUS,Task,N,P50,P95,P99,Max", "s#-ssss", "F--FFFF" }, \
     { LOG_SRTL_MSG, sizeof(log_SRTL), \
       "SRTL", "QBHHBfff", "TimeUS,Active,NumPts,MaxPts,Action,N,E,D", "s----mmm", "F----000" }, \
 LOG_STRUCTURE_FROM_AVOIDANCE \
     { LOG_SIMSTATE_MSG, sizeof(log_AHRS), \
       "SIM","QccCfLLffff","TimeUS,Roll,Pitch,Yaw,Alt,Lat,Lng,Q1,Q2,Q3,Q4", "sddhmDU----", "FBBB0GG0000", true }, \
     { LOG_TERRAIN_MSG, sizeof(log_TERRAIN), \
-      "TERR","QBLLHffHHf","TimeUS,Status,Lat,Lng,Spacing,TerrH,CHeight,Pending,Loaded,ROfs", "s-DU-mm--m", "F-GG-00--0", true }, \
+      "TERR","QBLLHffHHfII","TimeUS,Status,Lat,Lng,Spacing,TerrH,CHeight,Pending,Loaded,ROfs,Hit,Miss", "s-DU-mm--m--", "F-GG-00--0--", true }, \
 LOG_STRUCTURE_FROM_ESC_TELEM \
 LOG_STRUCTURE_FROM_SERVO_TELEM \
     { LOG_PIDR_MSG, sizeof(log_PID), \
@@ -1228,10 +1349,16 @@ LOG_STRUCTURE_FROM_RPM \
 LOG_STRUCTURE_FROM_FENCE \
     { LOG_DF_FILE_STATS, sizeof(log_DSF), \
       "DSF", "QIHIIII", "TimeUS,Dp,Blk,Bytes,FMn,FMx,FAv", "s--b---", "F--0---" }, \
+    { LOG_BLOCK_STATS_MSG, sizeof(log_Block_Stats), \
+      "BKS", "QIIIIHHH", "TimeUS,WB,WT,RB,RT,Er,ErA,Bsy", "sbsbs---", "F0F0F---" }, \
     { LOG_RALLY_MSG, sizeof(log_Rally), \
       "RALY", "QBBLLhB", "TimeUS,Tot,Seq,Lat,Lng,Alt,Flags", "s--DUm-", "F--GGB-" },  \
     { LOG_MAV_MSG, sizeof(log_MAV),   \
       "MAV", "QBHHHBHH",   "TimeUS,chan,txp,rxp,rxdp,flags,ss,tf", "s#----s-", "F-000-C-" },   \
+    { LOG_MAVR_MSG, sizeof(log_MAVR),   \
+      "MAVR", "QBBffHH",   "TimeUS,chan,id,RReq,RAch,Skp,BW", "s#-zz--", "F------" },   \
+    { LOG_MAVT_MSG, sizeof(log_MAVT),   \
+      "MAVT", "QBBBII",   "TimeUS,SysID,CompID,chan,Age,Fwd", "s---s-", "F---C-" },   \
 LOG_STRUCTURE_FROM_VISUALODOM \
     { LOG_OPTFLOW_MSG, sizeof(log_Optflow), \
       "OF",   "QBffff",   "TimeUS,Qual,flowX,flowY,bodyX,bodyY", "s-EEEE", "F-0000" , true }, \
@@ -1252,6 +1379,8 @@ LOG_STRUCTURE_FROM_VISUALODOM \
       "STAK", "QBBHHN", "TimeUS,Id,Pri,Total,Free,Name", "s#----", "F-----", true }, \
     { LOG_FILE_MSG, sizeof(log_File), \
       "FILE",   "NIBZ",       "FileName,Offset,Length,Data", "----", "----" }, \
+    { LOG_COMPRESSED_BLOCK_MSG, sizeof(log_Compressed_Block), \
+      "LZB",   "QHBHHHHBaaa", "TimeUS,Seq,Meth,RLen,CLen,Ofs,CPU,Len,D0,D1,D2", "s--bbbsb---", "F--000F0---" }, \
 LOG_STRUCTURE_FROM_AIS \
     { LOG_SCRIPTING_MSG, sizeof(log_Scripting), \
       "SCR",   "QNIii", "TimeUS,Name,Runtime,Total_mem,Run_mem", "s#sbb", "F-F--", true }, \
@@ -1346,6 +1475,12 @@ enum LogMessages : uint8_t {
     LOG_RCOUT3_MSG,
     LOG_IDS_FROM_FENCE,
     LOG_IDS_FROM_HAL,
+    LOG_PERF_HISTOGRAM_MSG,
+    LOG_MAVR_MSG,
+    LOG_XKTC_MSG,
+    LOG_COMPRESSED_BLOCK_MSG,
+    LOG_BLOCK_STATS_MSG,
+    LOG_MAVT_MSG,
 
     _LOG_LAST_MSG_
 };
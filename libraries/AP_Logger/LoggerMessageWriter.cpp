@@ -70,11 +70,55 @@ void LoggerMessageWriter_DFLogStart::reset()
     _next_format_unit_to_send = 0;
     param_default = AP::logger().quiet_nanf();
     ap = AP_Param::first(&token, &type, &param_default);
+
+    _header_start_us = AP_HAL::micros();
+    _header_source = HeaderSource::MESSAGES;
+
+#if AP_LOGGER_STARTUP_CACHE_ENABLED
+    if (_cache.failed) {
+        return;
+    }
+    stage = Stage::CACHED_HEADER;
+    _cache_ofs = 0;
+    _cache_generation = _cache.generation;
+    _header_source = HeaderSource::CACHE;
+#if AP_PARAM_CHANGE_JOURNAL_SET_ENABLED
+    // every change, including those made with set() alone, moves the
+    // change sequence on
+    const uint32_t seq = AP_Param::change_seq();
+    const bool params_changed = (seq != _cache.param_seq) ||
+        !AP_Param::change_journal_covers(_cache.param_seq);
+#else
+    // this build doesn't journal changes made with set(), so we
+    // can't tell if any parameter has changed
+    const uint32_t seq = 0;
+    const bool params_changed = true;
+#endif
+    // another backend may have started a capture for its own log
+    // which we can share unless a parameter has changed since
+    const bool restart = _cache.params_valid ? params_changed : (seq != _cache.param_seq);
+    if (restart) {
+        if (_cache.buf != nullptr) {
+            // keep the formats, capture the parameters again
+            start_param_capture(seq);
+        } else {
+            // capture starts once the buffer is allocated
+            _cache.param_seq = seq;
+        }
+    }
+    if (!_cache.params_valid) {
+        _header_source = HeaderSource::CACHE_REBUILT;
+    }
+#endif
 }
 
 bool LoggerMessageWriter_DFLogStart::out_of_time_for_writing_messages_df() const
 {
-    if (stage == Stage::FORMATS) {
+    if (stage == Stage::FORMATS
+#if AP_LOGGER_STARTUP_CACHE_ENABLED
+        || stage == Stage::CACHED_HEADER
+#endif
+        ) {
         // write out the FMT messages as fast as we can
 #if AP_SCHEDULER_ENABLED
         return AP::scheduler().time_available_usec() == 0;
@@ -107,6 +151,29 @@ void LoggerMessageWriter_DFLogStart::process()
     const uint32_t start_us = AP_HAL::micros();
 
     switch(stage) {
+#if AP_LOGGER_STARTUP_CACHE_ENABLED
+    case Stage::CACHED_HEADER:
+        switch (update_cache(start_us)) {
+        case CacheState::BUILDING:
+            return; // call me again!
+        case CacheState::VALID:
+            if (!write_cache(start_us)) {
+                return; // call me again!
+            }
+            _logger_backend->set_emitted_all_formats();
+            _fmt_done = true;
+            _params_done = true;
+            stage = Stage::HEADER_STATS;
+            return;
+        case CacheState::FAILED:
+            break;
+        }
+        // fall back to writing the messages one at a time
+        _header_source = HeaderSource::MESSAGES;
+        stage = Stage::FORMATS;
+        FALLTHROUGH;
+#endif
+
     case Stage::FORMATS:
         // write log formats so the log is self-describing
         while (next_format_to_send < _logger_backend->num_types()) {
@@ -180,7 +247,30 @@ void LoggerMessageWriter_DFLogStart::process()
                 return; // call me again!
             }
         }
+        stage = Stage::HEADER_STATS;
+        FALLTHROUGH;
+
+    case Stage::HEADER_STATS: {
+        // record how long the formats and parameters took to go out
+        // so that log start latency can be seen in the log
+        const char *source = "";
+        switch (_header_source) {
+        case HeaderSource::MESSAGES:
+            break;
+        case HeaderSource::CACHE:
+            source = " (cached)";
+            break;
+        case HeaderSource::CACHE_REBUILT:
+            source = " (cache rebuilt)";
+            break;
+        }
+        if (!_logger_backend->Write_MessageF("Log header %ums%s",
+                                             unsigned((AP_HAL::micros() - _header_start_us) / 1000U),
+                                             source)) {
+            return; // call me again!
+        }
         stage = Stage::RUNNING_SUBWRITERS;
+        }
         FALLTHROUGH;
 
     case Stage::RUNNING_SUBWRITERS: {
@@ -227,6 +317,180 @@ void LoggerMessageWriter_DFLogStart::process()
     _finished = true;
 }
 
+#if AP_LOGGER_STARTUP_CACHE_ENABLED
+LoggerMessageWriter_DFLogStart::StartupCache LoggerMessageWriter_DFLogStart::_cache;
+
+// the time_us field is at the same place in every cached message but FMT
+static_assert(offsetof(log_Unit, time_us) == offsetof(log_Parameter, time_us), "time_us offset must match");
+static_assert(offsetof(log_Format_Multiplier, time_us) == offsetof(log_Parameter, time_us), "time_us offset must match");
+static_assert(offsetof(log_Format_Units, time_us) == offsetof(log_Parameter, time_us), "time_us offset must match");
+
+// length of a message held in the startup cache
+uint16_t LoggerMessageWriter_DFLogStart::cached_msg_len(uint8_t msg_type)
+{
+    switch (msg_type) {
+    case LOG_FORMAT_MSG:
+        return sizeof(log_Format);
+    case LOG_UNIT_MSG:
+        return sizeof(log_Unit);
+    case LOG_MULT_MSG:
+        return sizeof(log_Format_Multiplier);
+    case LOG_FORMAT_UNITS_MSG:
+        return sizeof(log_Format_Units);
+    }
+    return sizeof(log_Parameter);
+}
+
+// discard the parameters held in the cache and start capturing them again
+void LoggerMessageWriter_DFLogStart::start_param_capture(uint32_t seq)
+{
+    _cache.params_valid = false;
+    _cache.len = _cache.fmt_len;
+    _cache.param_seq = seq;
+    _cache.generation++;
+    _cache.param_default = AP::logger().quiet_nanf();
+    _cache.ap = AP_Param::first(&_cache.token, &_cache.type, &_cache.param_default);
+}
+
+/*
+  allocate the startup cache and fill in any part of it which is not
+  valid, spending at most 1ms per call
+ */
+LoggerMessageWriter_DFLogStart::CacheState LoggerMessageWriter_DFLogStart::update_cache(uint32_t start_us)
+{
+    if (_cache.failed) {
+        return CacheState::FAILED;
+    }
+
+    if (_cache.buf == nullptr) {
+        const uint32_t fmt_bytes =
+            _logger_backend->num_types() * (sizeof(log_Format) + sizeof(log_Format_Units)) +
+            _logger_backend->num_units() * sizeof(log_Unit) +
+            _logger_backend->num_multipliers() * sizeof(log_Format_Multiplier);
+        // allow for a few parameters to appear before we need to reallocate
+        const uint32_t size = fmt_bytes + (AP_Param::count_parameters() + 16U) * sizeof(log_Parameter);
+        _cache.buf = NEW_NOTHROW uint8_t[size];
+        if (_cache.buf == nullptr) {
+            _cache.failed = true;
+            return CacheState::FAILED;
+        }
+        _cache.size = size;
+
+        // formats, units and multipliers are fixed so are only built once
+        _cache.len = 0;
+        for (uint8_t i=0; i<_logger_backend->num_types(); i++) {
+            struct log_Format pkt;
+            _logger_backend->Fill_Format(_logger_backend->structure(i), pkt);
+            memcpy(&_cache.buf[_cache.len], &pkt, sizeof(pkt));
+            _cache.len += sizeof(pkt);
+        }
+        for (uint8_t i=0; i<_logger_backend->num_units(); i++) {
+            const struct UnitStructure *u = _logger_backend->unit(i);
+            struct log_Unit pkt{
+                LOG_PACKET_HEADER_INIT(LOG_UNIT_MSG),
+                time_us : 0,
+                type    : u->ID,
+                unit    : { }
+            };
+            strncpy_noterm(pkt.unit, u->unit, sizeof(pkt.unit));
+            memcpy(&_cache.buf[_cache.len], &pkt, sizeof(pkt));
+            _cache.len += sizeof(pkt);
+        }
+        for (uint8_t i=0; i<_logger_backend->num_multipliers(); i++) {
+            const struct MultiplierStructure *m = _logger_backend->multiplier(i);
+            const struct log_Format_Multiplier pkt{
+                LOG_PACKET_HEADER_INIT(LOG_MULT_MSG),
+                time_us      : 0,
+                type         : m->ID,
+                multiplier   : m->multiplier,
+            };
+            memcpy(&_cache.buf[_cache.len], &pkt, sizeof(pkt));
+            _cache.len += sizeof(pkt);
+        }
+        for (uint8_t i=0; i<_logger_backend->num_types(); i++) {
+            struct log_Format_Units pkt;
+            _logger_backend->Fill_Format_Units(_logger_backend->structure(i), pkt);
+            memcpy(&_cache.buf[_cache.len], &pkt, sizeof(pkt));
+            _cache.len += sizeof(pkt);
+        }
+        _cache.fmt_len = _cache.len;
+        start_param_capture(_cache.param_seq);
+    }
+
+    while (!_cache.params_valid && _cache.ap != nullptr) {
+        if (_cache.len + sizeof(log_Parameter) > _cache.size) {
+            // parameters have appeared since we allocated; start
+            // again with a larger buffer
+            delete[] _cache.buf;
+            _cache.buf = nullptr;
+            return CacheState::BUILDING;
+        }
+        struct log_Parameter pkt{
+            LOG_PACKET_HEADER_INIT(LOG_PARAMETER_MSG),
+            time_us : 0,
+            name  : {},
+            value : _cache.ap->cast_to_float(_cache.type),
+            default_value : _cache.param_default
+        };
+        _cache.ap->copy_name_token(_cache.token, pkt.name, sizeof(pkt.name), true);
+        memcpy(&_cache.buf[_cache.len], &pkt, sizeof(pkt));
+        _cache.len += sizeof(pkt);
+
+        _cache.param_default = AP::logger().quiet_nanf();
+        _cache.ap = AP_Param::next_scalar(&_cache.token, &_cache.type, &_cache.param_default);
+        if (check_process_limit(start_us)) {
+            return CacheState::BUILDING;
+        }
+    }
+    _cache.params_valid = true;
+
+    return CacheState::VALID;
+}
+
+/*
+  copy the startup cache into the log as a few large blocks, each
+  using at most half of the space free in the backend's buffer.  The
+  timestamps are filled in just before each block is copied so the
+  shared buffer can be used by each backend in turn.
+  Returns true once the whole cache has been written
+ */
+bool LoggerMessageWriter_DFLogStart::write_cache(uint32_t start_us)
+{
+    if (_cache_generation != _cache.generation) {
+        // another backend recaptured the parameters while we were
+        // part way through them; write them all again.  A repeated
+        // PARM message simply replaces the earlier value
+        _cache_ofs = MIN(_cache_ofs, _cache.fmt_len);
+        _cache_generation = _cache.generation;
+    }
+    while (_cache_ofs < _cache.len) {
+        const uint32_t allowed = MIN(_logger_backend->bufferspace_available() / 2, uint32_t(UINT16_MAX));
+        const uint64_t now_us = AP_HAL::micros64();
+        uint32_t n = 0;
+        while (_cache_ofs + n < _cache.len) {
+            uint8_t *msg = &_cache.buf[_cache_ofs + n];
+            const uint16_t msg_len = cached_msg_len(msg[2]);
+            if (n + msg_len > allowed) {
+                break;
+            }
+            if (msg[2] != LOG_FORMAT_MSG) {
+                memcpy(&msg[offsetof(log_Parameter, time_us)], &now_us, sizeof(now_us));
+            }
+            n += msg_len;
+        }
+        if (n == 0 ||
+            !_logger_backend->WriteStartupBlock(&_cache.buf[_cache_ofs], n)) {
+            return false;
+        }
+        _cache_ofs += n;
+        if (check_process_limit(start_us)) {
+            break;
+        }
+    }
+    return _cache_ofs >= _cache.len;
+}
+#endif  // AP_LOGGER_STARTUP_CACHE_ENABLED
+
 #if AP_MISSION_ENABLED
 bool LoggerMessageWriter_DFLogStart::writeentiremission()
 {
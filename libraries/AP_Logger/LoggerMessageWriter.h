@@ -149,11 +149,15 @@ private:
     static bool check_process_limit(uint32_t start_us);
 
     enum class Stage {
-        FORMATS = 0,
+#if AP_LOGGER_STARTUP_CACHE_ENABLED
+        CACHED_HEADER,
+#endif
+        FORMATS,
         UNITS,
         MULTIPLIERS,
         FORMAT_UNITS,
         PARMS,
+        HEADER_STATS,
         VEHICLE_MESSAGES,
         RUNNING_SUBWRITERS, // must be last thing to run as we can redo bits of these
         DONE,
@@ -175,6 +179,55 @@ private:
     float param_default;
     enum ap_var_type type;
 
+    // time the header of this log was started, and how it was written
+    uint32_t _header_start_us;
+    enum class HeaderSource : uint8_t {
+        MESSAGES,
+        CACHE,
+        CACHE_REBUILT,
+    } _header_source;
+
+#if AP_LOGGER_STARTUP_CACHE_ENABLED
+    /*
+      the FMT, UNIT, MULT and FMTU messages followed by a PARM message
+      for every parameter, prebuilt in memory so that they can be
+      copied into a new log a buffer-full at a time.  The formats
+      never change; the parameters are rebuilt when the parameter
+      change journal shows a change since they were captured.
+
+      The messages are the same for every backend so one cache is
+      shared between all of the backends' writers.  All writers run
+      from the logger's periodic tasks, so no locking is needed
+     */
+    static struct StartupCache {
+        uint8_t *buf;
+        uint32_t size;          // bytes allocated for buf
+        uint32_t fmt_len;       // bytes of format messages at the start of buf
+        uint32_t len;           // bytes of messages held in buf
+        uint32_t param_seq;     // AP_Param::change_seq() when the parameters were captured
+        uint32_t generation;    // incremented each time the parameters are recaptured
+        bool params_valid;
+        bool failed;            // could not allocate, write messages one at a time instead
+        // parameter iteration state while the parameters are captured
+        AP_Param *ap;
+        AP_Param::ParamToken token;
+        enum ap_var_type type;
+        float param_default;
+    } _cache;
+    uint32_t _cache_ofs;        // bytes of _cache.buf written to this log so far
+    uint32_t _cache_generation; // _cache.generation when _cache_ofs was last valid
+
+    enum class CacheState : uint8_t {
+        BUILDING,
+        VALID,
+        FAILED,
+    };
+    CacheState update_cache(uint32_t start_us);
+    static void start_param_capture(uint32_t seq);
+    bool write_cache(uint32_t start_us);
+    static uint16_t cached_msg_len(uint8_t msg_type);
+#endif
+
 
     LoggerMessageWriter_WriteSysInfo _writesysinfo;
 #if AP_MISSION_ENABLED
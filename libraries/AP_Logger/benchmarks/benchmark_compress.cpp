@@ -0,0 +1,96 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  measure the cost of compressing and decompressing a block of log
+  data made up of IMU messages, as written with LOG_FILE_COMP set
+ */
+#include <AP_gbenchmark.h>
+
+#include <AP_Logger/AP_Logger.h>
+#include <AP_Logger/AP_Logger_LZ.h>
+#include <AP_InertialSensor/LogStructure.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+
+static uint8_t block[AP_LOGGER_LZ_BLOCK_MAX];
+static uint8_t comp[AP_LOGGER_LZ_COMPRESSED_MAX(AP_LOGGER_LZ_BLOCK_MAX)];
+static uint8_t decomp[AP_LOGGER_LZ_BLOCK_MAX];
+static AP_Logger_LZ lz;
+
+// fill the block with IMU messages from two sensors sampled at 400Hz with noise
+static void fill_block(void)
+{
+    uint32_t seed = 1;
+    uint16_t ofs = 0;
+    for (uint32_t i = 0; ofs + sizeof(log_IMU) <= sizeof(block); i++) {
+        seed = seed * 1103515245U + 12345U;
+        const float noise = int32_t(seed >> 16) * 1.0e-7f;
+        const struct log_IMU pkt {
+            LOG_PACKET_HEADER_INIT(LOG_IMU_MSG),
+            time_us      : 60000000ULL + (i / 2) * 2500,
+            instance     : uint8_t(i % 2),
+            gyro_x       : 0.01f + noise,
+            gyro_y       : -0.02f + noise,
+            gyro_z       : 0.003f - noise,
+            accel_x      : 0.1f + noise,
+            accel_y      : -0.05f - noise,
+            accel_z      : -9.8f + noise,
+            gyro_error   : 0,
+            accel_error  : 0,
+            temperature  : 45.0f,
+            gyro_health  : 1,
+            accel_health : 1,
+            gyro_rate    : 1000,
+            accel_rate   : 1000,
+        };
+        memcpy(&block[ofs], &pkt, sizeof(pkt));
+        ofs += sizeof(pkt);
+    }
+}
+
+static void BM_LogCompressBlock(benchmark::State& state)
+{
+    fill_block();
+    uint16_t comp_len = 0;
+    while (state.KeepRunning()) {
+        comp_len = lz.compress(block, sizeof(block), comp, sizeof(comp));
+        gbenchmark_escape(comp);
+    }
+    state.counters["ratio"] = comp_len > 0 ? float(sizeof(block)) / comp_len : 0;
+    state.SetBytesProcessed(state.iterations() * sizeof(block));
+}
+
+static void BM_LogDecompressBlock(benchmark::State& state)
+{
+    fill_block();
+    const uint16_t comp_len = lz.compress(block, sizeof(block), comp, sizeof(comp));
+    while (state.KeepRunning()) {
+        if (AP_Logger_LZ::decompress(comp, comp_len, decomp, sizeof(decomp)) != sizeof(block)) {
+            state.SkipWithError("decompress failed");
+            break;
+        }
+        gbenchmark_escape(decomp);
+    }
+    state.SetBytesProcessed(state.iterations() * sizeof(block));
+}
+
+BENCHMARK(BM_LogCompressBlock);
+BENCHMARK(BM_LogDecompressBlock);
+
+#endif // AP_LOGGER_FILE_COMPRESSION_ENABLED
+
+BENCHMARK_MAIN();
@@ -0,0 +1,67 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  measure the per-call cost of looking up the format of an ad-hoc
+  AP_Logger::Write() message with a varying number of registered formats
+ */
+#include <AP_gbenchmark.h>
+
+#include <AP_Logger/AP_Logger.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static AP_Logger logger;
+
+#define MAX_FORMATS 200
+
+// names must stay valid as the logger keeps a pointer to them
+static char names[MAX_FORMATS][LS_NAME_SIZE+1];
+static uint16_t num_formats;
+
+static void register_formats(uint16_t count)
+{
+    while (num_formats < count) {
+        char *name = names[num_formats];
+        snprintf(name, sizeof(names[0]), "B%03u", unsigned(num_formats));
+        logger.msg_fmt_for_name(name, "TimeUS,V", nullptr, nullptr, "Qf");
+        num_formats++;
+    }
+}
+
+/*
+  formats are never removed, so the cases must run in order of
+  increasing format count. The second argument selects lookup by name
+  string, as done by Write() from scripting, rather than by pointer
+ */
+static void BM_MsgFmtForName(benchmark::State& state)
+{
+    register_formats(state.range(0));
+    // the most recently registered name was the worst case for a list walk
+    char name_copy[LS_NAME_SIZE+1];
+    strncpy(name_copy, names[state.range(0)-1], sizeof(name_copy));
+    const bool direct_comp = state.range(1);
+    const char *name = direct_comp ? name_copy : names[state.range(0)-1];
+    while (state.KeepRunning()) {
+        AP_Logger::log_write_fmt *f = logger.msg_fmt_for_name(name, "TimeUS,V", nullptr, nullptr, "Qf", direct_comp);
+        gbenchmark_escape(f);
+    }
+}
+
+BENCHMARK(BM_MsgFmtForName)
+    ->Args({50, 0})->Args({50, 1})
+    ->Args({100, 0})->Args({100, 1})
+    ->Args({MAX_FORMATS, 0})->Args({MAX_FORMATS, 1});
+
+BENCHMARK_MAIN();
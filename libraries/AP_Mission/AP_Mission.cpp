@@ -87,6 +87,18 @@ void AP_Mission::init()
         _cmd_total.set(0);
     }
 
+#if AP_MISSION_CMD_CACHE_ENABLED
+    for (auto &c : _cmd_cache) {
+        c.index = AP_MISSION_CMD_INDEX_NONE;
+    }
+    if (_commands_max > 0 && _cmd_index.nav_stops == nullptr) {
+        // without this the command index is not used and commands are
+        // found by reading storage
+        _cmd_index.nav_stops_words = (_commands_max + 31U) / 32U;
+        _cmd_index.nav_stops = NEW_NOTHROW uint32_t[_cmd_index.nav_stops_words];
+    }
+#endif
+
 
     // check_eeprom_version - checks version of missions stored in eeprom matches this library
     // command list will be cleared if they do not match
@@ -302,6 +314,9 @@ void AP_Mission::truncate(uint16_t index)
     if ((unsigned)_cmd_total > index) {
         _cmd_total.set_and_save(index);
         _last_change_time_ms = AP_HAL::millis();
+#if AP_MISSION_CMD_CACHE_ENABLED
+        truncate_cmd_index(index);
+#endif
     }
 }
 
@@ -538,12 +553,17 @@ bool AP_Mission::replace_cmd(uint16_t index, const Mission_Command& cmd)
 
 /// is_nav_cmd - returns true if the command's id is a "navigation" command, false if "do" or "conditional" command
 bool AP_Mission::is_nav_cmd(const Mission_Command& cmd)
+{
+    return is_nav_cmd_id(cmd.id);
+}
+
+bool AP_Mission::is_nav_cmd_id(uint16_t id)
 {
     // NAV commands all have ids below MAV_CMD_NAV_LAST, plus some exceptions
-    return (cmd.id <= MAV_CMD_NAV_LAST ||
-            cmd.id == MAV_CMD_NAV_SET_YAW_SPEED ||
-            cmd.id == MAV_CMD_NAV_SCRIPT_TIME ||
-            cmd.id == MAV_CMD_NAV_ATTITUDE_TIME);
+    return (id <= MAV_CMD_NAV_LAST ||
+            id == MAV_CMD_NAV_SET_YAW_SPEED ||
+            id == MAV_CMD_NAV_SCRIPT_TIME ||
+            id == MAV_CMD_NAV_ATTITUDE_TIME);
 }
 
 /// get_next_nav_cmd - gets next "navigation" command found at or after start_index
@@ -551,8 +571,23 @@ bool AP_Mission::is_nav_cmd(const Mission_Command& cmd)
 ///     accounts for do_jump commands but never increments the jump's num_times_run (advance_current_nav_cmd is responsible for this)
 bool AP_Mission::get_next_nav_cmd(uint16_t start_index, Mission_Command& cmd)
 {
+#if AP_MISSION_CMD_CACHE_ENABLED
+    WITH_SEMAPHORE(_rsem);
+    const bool use_index = update_cmd_index();
+#endif
+
     // search until the end of the mission command list
     for (uint16_t cmd_index = start_index; cmd_index < (unsigned)_cmd_total; cmd_index++) {
+#if AP_MISSION_CMD_CACHE_ENABLED
+        if (use_index) {
+            // any other command would be returned by get_next_cmd()
+            // and skipped, so go straight to the next nav or jump
+            cmd_index = next_nav_stop(cmd_index);
+            if (cmd_index >= (unsigned)_cmd_total) {
+                break;
+            }
+        }
+#endif
         // get next command
         if (!get_next_cmd(cmd_index, cmd, false)) {
             // no more commands so return failure
@@ -832,6 +867,14 @@ bool AP_Mission::read_cmd_from_storage(uint16_t index, Mission_Command& cmd) con
         return false;
     }
 
+#if AP_MISSION_CMD_CACHE_ENABLED
+    Mission_Command &cached = _cmd_cache[index % AP_MISSION_CMD_CACHE_SIZE];
+    if (cached.index == index) {
+        cmd = cached;
+        return true;
+    }
+#endif
+
     // ensure all bytes of cmd are zeroed
     cmd = {};
 
@@ -890,6 +933,10 @@ bool AP_Mission::read_cmd_from_storage(uint16_t index, Mission_Command& cmd) con
     // set command's index to it's position in eeprom
     cmd.index = index;
 
+#if AP_MISSION_CMD_CACHE_ENABLED
+    cached = cmd;
+#endif
+
     // return success
     return true;
 }
@@ -984,6 +1031,11 @@ bool AP_Mission::write_cmd_to_storage(uint16_t index, const Mission_Command& cmd
         _storage.write_block(pos_in_storage+5, packed.bytes, 10);
     }
 
+#if AP_MISSION_CMD_CACHE_ENABLED
+    _cmd_cache[index % AP_MISSION_CMD_CACHE_SIZE].index = AP_MISSION_CMD_INDEX_NONE;
+    update_cmd_index_entry(index, cmd);
+#endif
+
     // remember when the mission last changed
     if (index != 0) {
         // Update of home location is not a true change
@@ -2299,6 +2351,13 @@ bool AP_Mission::jump_to_tag(const uint16_t tag)
 // Returns 0 if no appropriate JUMP_TAG match can be found.
 uint16_t AP_Mission::get_index_of_jump_tag(const uint16_t tag) const
 {
+#if AP_MISSION_CMD_CACHE_ENABLED
+    WITH_SEMAPHORE(_rsem);
+    if (update_cmd_index()) {
+        uint16_t index;
+        return find_indexed_cmd(MAV_CMD_JUMP_TAG, tag, 1, index) ? index : 0;
+    }
+#endif
     const auto count = num_commands();
     for (uint16_t i = 1; i < count; i++) {
         if (get_command_id(i) != uint16_t(MAV_CMD_JUMP_TAG)) {
@@ -2420,10 +2479,7 @@ uint16_t AP_Mission::get_landing_sequence_start(const Location &current_loc)
 
     // Go through mission looking for nearest landing start command
     const auto count = num_commands();
-    for (uint16_t i = 1; i < count; i++) {
-        if (get_command_id(i) != uint16_t(MAV_CMD_DO_LAND_START)) {
-            continue;
-        }
+    for (uint16_t i = next_cmd_with_id(MAV_CMD_DO_LAND_START, 1); i < count; i = next_cmd_with_id(MAV_CMD_DO_LAND_START, i+1)) {
         Mission_Command tmp;
         if (!read_cmd_from_storage(i, tmp)) {
             continue;
@@ -2492,18 +2548,16 @@ bool AP_Mission::jump_to_closest_mission_leg(const Location &current_loc)
     uint16_t search_remaining = 1000;
 
     // Go through mission and check each DO_RETURN_PATH_START
-    for (uint16_t i = 1; i < num_commands(); i++) {
-        if (get_command_id(i) == uint16_t(MAV_CMD_DO_RETURN_PATH_START)) {
-            uint16_t tmp_index;
-            float tmp_distance;
-            if (distance_to_mission_leg(i, search_remaining, tmp_distance, tmp_index, current_loc) && (min_distance < 0 || tmp_distance <= min_distance)){
-                min_distance = tmp_distance;
-                landing_start_index = tmp_index;
-            }
-            if (search_remaining == 0) {
-                // Run out of time to search, stop and return the best so far
-                break;
-            }
+    for (uint16_t i = next_cmd_with_id(MAV_CMD_DO_RETURN_PATH_START, 1); i < num_commands(); i = next_cmd_with_id(MAV_CMD_DO_RETURN_PATH_START, i+1)) {
+        uint16_t tmp_index;
+        float tmp_distance;
+        if (distance_to_mission_leg(i, search_remaining, tmp_distance, tmp_index, current_loc) && (min_distance < 0 || tmp_distance <= min_distance)){
+            min_distance = tmp_distance;
+            landing_start_index = tmp_index;
+        }
+        if (search_remaining == 0) {
+            // Run out of time to search, stop and return the best so far
+            break;
         }
     }
 
@@ -2530,10 +2584,7 @@ bool AP_Mission::jump_to_abort_landing_sequence(const Location &current_loc)
     float min_distance = FLT_MAX;
 
     const auto count = num_commands();
-    for (uint16_t i = 1; i < count; i++) {
-        if (get_command_id(i) != uint16_t(MAV_CMD_DO_GO_AROUND)) {
-            continue;
-        }
+    for (uint16_t i = next_cmd_with_id(MAV_CMD_DO_GO_AROUND, 1); i < count; i = next_cmd_with_id(MAV_CMD_DO_GO_AROUND, i+1)) {
         Mission_Command tmp;
         if (!read_cmd_from_storage(i, tmp)) {
             continue;
@@ -2951,10 +3002,7 @@ uint16_t AP_Mission::get_command_id(uint16_t index) const
 bool AP_Mission::contains_item(MAV_CMD command) const
 {
     const auto count = num_commands();
-    for (uint16_t i = 1; i < count; i++) {
-        if (get_command_id(i) != uint16_t(command)) {
-            continue;
-        }
+    for (uint16_t i = next_cmd_with_id(command, 1); i < count; i = next_cmd_with_id(command, i+1)) {
         // confirm with full read
         Mission_Command tmp;
         if (!read_cmd_from_storage(i, tmp)) {
@@ -2967,6 +3015,302 @@ bool AP_Mission::contains_item(MAV_CMD command) const
     return false;
 }
 
+/*
+  return the index of the first command at or after index with the
+  given id, or num_commands() if there is none
+ */
+uint16_t AP_Mission::next_cmd_with_id(uint16_t id, uint16_t index) const
+{
+    const uint16_t count = num_commands();
+#if AP_MISSION_CMD_CACHE_ENABLED
+    WITH_SEMAPHORE(_rsem);
+    // jump tags are found by tag, see get_index_of_jump_tag()
+    if (id != MAV_CMD_JUMP_TAG && cmd_index_group(id) >= 0 && update_cmd_index()) {
+        uint16_t found;
+        return find_indexed_cmd(id, 0, index, found) ? found : count;
+    }
+#endif
+    while (index < count && get_command_id(index) != id) {
+        index++;
+    }
+    return index;
+}
+
+#if AP_MISSION_CMD_CACHE_ENABLED
+/*
+  return the group a command is held in by the command index, or -1
+  if it is not indexed
+ */
+int8_t AP_Mission::cmd_index_group(uint16_t id)
+{
+    switch (id) {
+    case MAV_CMD_DO_LAND_START:
+        return 0;
+    case MAV_CMD_DO_GO_AROUND:
+        return 1;
+    case MAV_CMD_DO_RETURN_PATH_START:
+        return 2;
+    case MAV_CMD_JUMP_TAG:
+        return 3;
+    default:
+        return -1;
+    }
+}
+
+/*
+  rebuild the command index if the mission has changed since it was
+  built. Returns false if the index can't be used
+ */
+bool AP_Mission::update_cmd_index() const
+{
+    WITH_SEMAPHORE(_rsem);
+
+    if (_cmd_index.nav_stops == nullptr) {
+        return false;
+    }
+    const uint16_t total = MIN(num_commands(), _commands_max);
+    if (_cmd_index.valid && _cmd_index.total == total) {
+        return true;
+    }
+
+    _cmd_index.valid = false;
+    delete[] _cmd_index.entries;
+    _cmd_index.entries = nullptr;
+    _cmd_index.entries_size = 0;
+    memset(_cmd_index.nav_stops, 0, _cmd_index.nav_stops_words * sizeof(uint32_t));
+
+    // command 0 is home, which is always a waypoint
+    _cmd_index.nav_stops[0] = 1U;
+
+    // mark nav and jump commands and count the size of each group
+    uint16_t group_count[CMD_INDEX_NUM_GROUPS] {};
+    uint16_t num_entries = 0;
+    for (uint16_t i = 1; i < total; i++) {
+        const uint16_t id = get_command_id(i);
+        if (is_nav_cmd_id(id) || id == MAV_CMD_DO_JUMP || id == MAV_CMD_DO_JUMP_TAG) {
+            _cmd_index.nav_stops[i/32U] |= 1U << (i%32U);
+        }
+        const int8_t group = cmd_index_group(id);
+        if (group >= 0) {
+            group_count[group]++;
+            num_entries++;
+        }
+    }
+
+    _cmd_index.group_start[0] = 0;
+    for (uint8_t g = 0; g < CMD_INDEX_NUM_GROUPS; g++) {
+        _cmd_index.group_start[g+1] = _cmd_index.group_start[g] + group_count[g];
+    }
+
+    if (num_entries > 0) {
+        _cmd_index.entries = NEW_NOTHROW cmd_index_entry[num_entries];
+        if (_cmd_index.entries == nullptr) {
+            return false;
+        }
+        _cmd_index.entries_size = num_entries;
+        // fill each group in index order
+        uint16_t next[CMD_INDEX_NUM_GROUPS];
+        memcpy(next, _cmd_index.group_start, sizeof(next));
+        for (uint16_t i = 1; i < total; i++) {
+            const int8_t group = cmd_index_group(get_command_id(i));
+            if (group < 0) {
+                continue;
+            }
+            cmd_index_entry &e = _cmd_index.entries[next[group]++];
+            e.index = i;
+            e.tag = 0;
+            Mission_Command tmp;
+            if (group == cmd_index_group(MAV_CMD_JUMP_TAG) && read_cmd_from_storage(i, tmp)) {
+                e.tag = tmp.content.jump.target;
+            }
+        }
+        // sort jump tags by tag, keeping index order for equal tags
+        const int8_t g = cmd_index_group(MAV_CMD_JUMP_TAG);
+        cmd_index_entry *tags = &_cmd_index.entries[_cmd_index.group_start[g]];
+        const uint16_t num_tags = group_count[g];
+        for (uint16_t i = 1; i < num_tags; i++) {
+            const cmd_index_entry e = tags[i];
+            uint16_t j = i;
+            for (; j > 0 && tags[j-1].tag > e.tag; j--) {
+                tags[j] = tags[j-1];
+            }
+            tags[j] = e;
+        }
+    }
+
+    _cmd_index.total = total;
+    _cmd_index.valid = true;
+    return true;
+}
+
+/*
+  update the command index for a command written to storage, rather
+  than rebuilding it. Uploads and edits write commands within the
+  mission or one past its end, anything else leaves the index to be
+  rebuilt on the next query
+ */
+void AP_Mission::update_cmd_index_entry(uint16_t index, const Mission_Command &cmd)
+{
+    WITH_SEMAPHORE(_rsem);
+
+    if (!_cmd_index.valid) {
+        return;
+    }
+    if (index > _cmd_index.total || index >= _commands_max) {
+        _cmd_index.valid = false;
+        return;
+    }
+    if (index == 0) {
+        // home is always a waypoint and never in a group
+        _cmd_index.total = MAX(_cmd_index.total, 1U);
+        return;
+    }
+
+    // remove the command this replaces
+    if (index < _cmd_index.total) {
+        for (uint8_t g = 0; g < CMD_INDEX_NUM_GROUPS; g++) {
+            for (uint16_t i = _cmd_index.group_start[g]; i < _cmd_index.group_start[g+1]; i++) {
+                if (_cmd_index.entries[i].index == index) {
+                    remove_cmd_index_entries(g, i, 1);
+                    break;
+                }
+            }
+        }
+    }
+
+    if (is_nav_cmd_id(cmd.id) || cmd.id == MAV_CMD_DO_JUMP || cmd.id == MAV_CMD_DO_JUMP_TAG) {
+        _cmd_index.nav_stops[index/32U] |= 1U << (index%32U);
+    } else {
+        _cmd_index.nav_stops[index/32U] &= ~(1U << (index%32U));
+    }
+
+    const int8_t group = cmd_index_group(cmd.id);
+    if (group >= 0) {
+        const uint16_t num_entries = _cmd_index.group_start[CMD_INDEX_NUM_GROUPS];
+        if (num_entries == _cmd_index.entries_size) {
+            // grow a few entries at a time as uploads add commands one by one
+            const uint16_t new_size = num_entries + 8;
+            cmd_index_entry *entries = NEW_NOTHROW cmd_index_entry[new_size];
+            if (entries == nullptr) {
+                _cmd_index.valid = false;
+                return;
+            }
+            if (num_entries > 0) {
+                memcpy(entries, _cmd_index.entries, num_entries * sizeof(cmd_index_entry));
+            }
+            delete[] _cmd_index.entries;
+            _cmd_index.entries = entries;
+            _cmd_index.entries_size = new_size;
+        }
+        cmd_index_entry e {};
+        e.index = index;
+        e.tag = cmd.id == MAV_CMD_JUMP_TAG ? cmd.content.jump.target : 0;
+        // keep the group sorted by tag then index
+        uint16_t pos = _cmd_index.group_start[group];
+        while (pos < _cmd_index.group_start[group+1] &&
+               (_cmd_index.entries[pos].tag < e.tag ||
+                (_cmd_index.entries[pos].tag == e.tag && _cmd_index.entries[pos].index < e.index))) {
+            pos++;
+        }
+        memmove(&_cmd_index.entries[pos+1], &_cmd_index.entries[pos], (num_entries - pos) * sizeof(cmd_index_entry));
+        _cmd_index.entries[pos] = e;
+        for (uint8_t g = group+1; g <= CMD_INDEX_NUM_GROUPS; g++) {
+            _cmd_index.group_start[g]++;
+        }
+    }
+
+    if (index == _cmd_index.total) {
+        _cmd_index.total++;
+    }
+}
+
+/*
+  remove the commands at and after index from the command index
+ */
+void AP_Mission::truncate_cmd_index(uint16_t index)
+{
+    WITH_SEMAPHORE(_rsem);
+
+    if (!_cmd_index.valid || index >= _cmd_index.total) {
+        return;
+    }
+    for (uint8_t g = 0; g < CMD_INDEX_NUM_GROUPS; g++) {
+        uint16_t i = _cmd_index.group_start[g];
+        while (i < _cmd_index.group_start[g+1]) {
+            if (_cmd_index.entries[i].index >= index) {
+                remove_cmd_index_entries(g, i, 1);
+            } else {
+                i++;
+            }
+        }
+    }
+    // home is never removed from the nav stops
+    for (uint16_t i = MAX(index, 1U); i < _cmd_index.total; i++) {
+        _cmd_index.nav_stops[i/32U] &= ~(1U << (i%32U));
+    }
+    _cmd_index.total = index;
+}
+
+/*
+  remove count entries from group starting at entry pos
+ */
+void AP_Mission::remove_cmd_index_entries(uint8_t group, uint16_t pos, uint16_t count)
+{
+    const uint16_t num_entries = _cmd_index.group_start[CMD_INDEX_NUM_GROUPS];
+    memmove(&_cmd_index.entries[pos], &_cmd_index.entries[pos+count], (num_entries - pos - count) * sizeof(cmd_index_entry));
+    for (uint8_t g = group+1; g <= CMD_INDEX_NUM_GROUPS; g++) {
+        _cmd_index.group_start[g] -= count;
+    }
+}
+
+/*
+  find the first indexed command with the given id and tag at or
+  after index. The index must be up to date
+ */
+bool AP_Mission::find_indexed_cmd(uint16_t id, uint16_t tag, uint16_t index, uint16_t &found) const
+{
+    const int8_t group = cmd_index_group(id);
+    if (group < 0) {
+        return false;
+    }
+    // bisection search on tag then index
+    uint16_t lo = _cmd_index.group_start[group];
+    uint16_t hi = _cmd_index.group_start[group+1];
+    while (lo < hi) {
+        const uint16_t mid = (lo + hi) / 2;
+        const cmd_index_entry &e = _cmd_index.entries[mid];
+        if (e.tag < tag || (e.tag == tag && e.index < index)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == _cmd_index.group_start[group+1] || _cmd_index.entries[lo].tag != tag) {
+        return false;
+    }
+    found = _cmd_index.entries[lo].index;
+    return true;
+}
+
+/*
+  return the first nav or jump command at or after index, or the
+  number of indexed commands if there is none. The index must be up
+  to date
+ */
+uint16_t AP_Mission::next_nav_stop(uint16_t index) const
+{
+    const uint16_t total = _cmd_index.total;
+    while (index < total) {
+        const uint32_t bits = _cmd_index.nav_stops[index/32U] >> (index%32U);
+        if (bits != 0) {
+            return MIN(uint16_t(index + __builtin_ctz(bits)), total);
+        }
+        index = (index/32U + 1U) * 32U;
+    }
+    return total;
+}
+#endif // AP_MISSION_CMD_CACHE_ENABLED
+
 /*
   return true if the mission item has a location
 */
@@ -61,6 +61,7 @@ union PackedContent;
 /// @brief    Object managing Mission
 class AP_Mission
 {
+    friend class AP_Mission_Test;
 
 public:
     // jump command structure
@@ -939,6 +940,46 @@ private:
     // const functions
     static HAL_Semaphore _rsem;
 
+    // return true if id is a "navigation" command
+    static bool is_nav_cmd_id(uint16_t id);
+
+    // return index of the first command at or after index with the
+    // given id, or num_commands() if there is none
+    uint16_t next_cmd_with_id(uint16_t id, uint16_t index) const;
+
+#if AP_MISSION_CMD_CACHE_ENABLED
+    // recently read commands, held in slot index % AP_MISSION_CMD_CACHE_SIZE.
+    // a slot is empty if its index doesn't match
+    mutable Mission_Command _cmd_cache[AP_MISSION_CMD_CACHE_SIZE];
+
+    // index of commands by type. It is updated as commands are written
+    // and the mission is truncated, and rebuilt from storage if the
+    // mission changes any other way. Landing sequence, go around,
+    // return path and jump tag commands are held in one group each
+    static constexpr uint8_t CMD_INDEX_NUM_GROUPS = 4;
+    struct cmd_index_entry {
+        uint16_t tag;   // tag of a MAV_CMD_JUMP_TAG, zero otherwise
+        uint16_t index;
+    };
+    mutable struct {
+        uint32_t *nav_stops;        // bit per command, set for nav and jump commands
+        uint16_t nav_stops_words;
+        cmd_index_entry *entries;   // grouped by command, each group sorted by tag then index
+        uint16_t entries_size;
+        uint16_t group_start[CMD_INDEX_NUM_GROUPS+1];
+        uint16_t total;             // number of commands in the index
+        bool valid;
+    } _cmd_index;
+
+    bool update_cmd_index() const;
+    void update_cmd_index_entry(uint16_t index, const Mission_Command &cmd);
+    void truncate_cmd_index(uint16_t index);
+    void remove_cmd_index_entries(uint8_t group, uint16_t pos, uint16_t count);
+    static int8_t cmd_index_group(uint16_t id);
+    bool find_indexed_cmd(uint16_t id, uint16_t tag, uint16_t index, uint16_t &found) const;
+    uint16_t next_nav_stop(uint16_t index) const;
+#endif
+
     // mission items common to all vehicles:
     bool start_command_do_aux_function(const AP_Mission::Mission_Command& cmd);
     bool start_command_do_gripper(const AP_Mission::Mission_Command& cmd);
@@ -7,3 +7,13 @@
 #ifndef AP_MISSION_NAV_PAYLOAD_PLACE_ENABLED
 #define AP_MISSION_NAV_PAYLOAD_PLACE_ENABLED 1
 #endif
+
+// cache decoded commands and index command types to avoid rescanning
+// storage for landing sequences, jump tags and the next nav command
+#ifndef AP_MISSION_CMD_CACHE_ENABLED
+#define AP_MISSION_CMD_CACHE_ENABLED (HAL_MEM_CLASS >= HAL_MEM_CLASS_300)
+#endif
+
+#ifndef AP_MISSION_CMD_CACHE_SIZE
+#define AP_MISSION_CMD_CACHE_SIZE 16
+#endif
@@ -0,0 +1,342 @@
+#include <AP_gtest.h>
+
+/*
+  check the AP_Mission command index and command cache give the same
+  answers as reading storage, for random missions and after they are
+  edited and truncated
+ */
+
+#include <AP_Mission/AP_Mission.h>
+#include <AP_AHRS/AP_AHRS.h>
+#include <GCS_MAVLink/GCS_Dummy.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+AP_AHRS ahrs{AP_AHRS::FLAG_ALWAYS_USE_EKF};
+GCS_Dummy _gcs;
+
+#if AP_MISSION_CMD_CACHE_ENABLED
+
+// tags are drawn from a small range so many are duplicated
+#define MAX_TAG 8
+#define MAX_TEST_COMMANDS 300
+
+static uint32_t test_rand_state = 1;
+
+// simple repeatable pseudo random number
+static uint32_t test_rand(uint32_t range)
+{
+    test_rand_state = test_rand_state * 1103515245U + 12345U;
+    return ((test_rand_state >> 8) & 0xFFFF) % range;
+}
+
+class AP_Mission_Test
+{
+public:
+    AP_Mission_Test()
+    {
+        mission.init();
+        mission.clear();
+        mission.init_jump_tracking();
+        nav_stops = mission._cmd_index.nav_stops;
+    }
+
+    // a random command, mostly nav and do commands with a mix of
+    // the commands the index holds
+    AP_Mission::Mission_Command random_cmd(uint16_t num_cmds)
+    {
+        static const uint16_t ids[] {
+            MAV_CMD_NAV_WAYPOINT, MAV_CMD_NAV_WAYPOINT, MAV_CMD_NAV_WAYPOINT,
+            MAV_CMD_NAV_LAND,
+            MAV_CMD_NAV_SCRIPT_TIME,
+            MAV_CMD_NAV_ATTITUDE_TIME,
+            MAV_CMD_DO_CHANGE_SPEED, MAV_CMD_DO_CHANGE_SPEED,
+            MAV_CMD_CONDITION_DELAY,
+            MAV_CMD_DO_JUMP,
+            MAV_CMD_DO_JUMP_TAG,
+            MAV_CMD_JUMP_TAG, MAV_CMD_JUMP_TAG,
+            MAV_CMD_DO_LAND_START, MAV_CMD_DO_LAND_START,
+            MAV_CMD_DO_GO_AROUND,
+            MAV_CMD_DO_RETURN_PATH_START,
+        };
+        AP_Mission::Mission_Command cmd {};
+        cmd.id = ids[test_rand(ARRAY_SIZE(ids))];
+        cmd.p1 = test_rand(100);
+        switch (cmd.id) {
+        case MAV_CMD_DO_JUMP:
+            // targets include home and past the end of the mission
+            cmd.content.jump.target = test_rand(num_cmds + 2);
+            cmd.content.jump.num_times = int16_t(test_rand(5)) - 1;
+            break;
+        case MAV_CMD_DO_JUMP_TAG:
+            cmd.content.jump.target = test_rand(MAX_TAG + 2);
+            cmd.content.jump.num_times = int16_t(test_rand(5)) - 1;
+            break;
+        case MAV_CMD_JUMP_TAG:
+            cmd.content.jump.target = test_rand(MAX_TAG);
+            break;
+        case MAV_CMD_NAV_SCRIPT_TIME:
+        case MAV_CMD_NAV_ATTITUDE_TIME:
+        case MAV_CMD_DO_CHANGE_SPEED:
+        case MAV_CMD_CONDITION_DELAY:
+            break;
+        default:
+            // landing starts without a location use the next nav command's
+            if (cmd.id != MAV_CMD_DO_LAND_START || test_rand(3) != 0) {
+                cmd.content.location.lat = -353632640 + int32_t(test_rand(20000));
+                cmd.content.location.lng = 1491652352 + int32_t(test_rand(20000));
+                cmd.content.location.alt = test_rand(10000);
+            }
+            break;
+        }
+        return cmd;
+    }
+
+    // replace the mission with num_cmds random commands after home
+    void make_random_mission(uint16_t num_cmds)
+    {
+        mission.clear();
+        num_shadow = 0;
+        has_home = false;
+        for (uint16_t i = 0; i < num_cmds; i++) {
+            add(random_cmd(num_cmds));
+        }
+    }
+
+    void add(AP_Mission::Mission_Command cmd)
+    {
+        ASSERT_TRUE(mission.add_cmd(cmd));
+        ASSERT_LT(num_shadow, ARRAY_SIZE(shadow));
+        shadow[num_shadow++] = cmd;
+        has_home = true;
+        EXPECT_EQ(cmd.index, num_shadow);
+    }
+
+    void replace(uint16_t index, const AP_Mission::Mission_Command &cmd)
+    {
+        ASSERT_GE(index, 1U);
+        ASSERT_LE(index, num_shadow);
+        ASSERT_TRUE(mission.replace_cmd(index, cmd));
+        shadow[index-1] = cmd;
+    }
+
+    void truncate(uint16_t index)
+    {
+        mission.truncate(index);
+        num_shadow = MIN(num_shadow, MAX(index, 1U) - 1U);
+        if (index == 0) {
+            has_home = false;
+        }
+    }
+
+    uint16_t num_cmds() const
+    {
+        return num_shadow;
+    }
+
+    // check every command reads back as written, through the cache
+    void check_reads()
+    {
+        // truncating to zero removes home as well
+        ASSERT_EQ(mission.num_commands(), has_home ? num_shadow + 1U : 0U);
+        for (uint16_t i = 1; i <= num_shadow; i++) {
+            const AP_Mission::Mission_Command &expected = shadow[i-1];
+            AP_Mission::Mission_Command cmd;
+            ASSERT_TRUE(mission.read_cmd_from_storage(i, cmd));
+            EXPECT_EQ(cmd.index, i);
+            EXPECT_EQ(cmd.id, expected.id) << "index " << i;
+            EXPECT_EQ(cmd.p1, expected.p1) << "index " << i;
+            switch (cmd.id) {
+            case MAV_CMD_DO_JUMP:
+            case MAV_CMD_DO_JUMP_TAG:
+            case MAV_CMD_JUMP_TAG:
+                EXPECT_EQ(cmd.content.jump.target, expected.content.jump.target) << "index " << i;
+                break;
+            case MAV_CMD_NAV_WAYPOINT:
+            case MAV_CMD_NAV_LAND:
+            case MAV_CMD_DO_LAND_START:
+            case MAV_CMD_DO_GO_AROUND:
+            case MAV_CMD_DO_RETURN_PATH_START:
+                EXPECT_EQ(cmd.content.location.lat, expected.content.location.lat) << "index " << i;
+                EXPECT_EQ(cmd.content.location.lng, expected.content.location.lng) << "index " << i;
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    /*
+      check the index kept up to date by writes and truncates is the
+      same as one built from storage
+     */
+    void check_index_matches_rebuild()
+    {
+        auto &index = mission._cmd_index;
+        ASSERT_TRUE(index.valid);
+        ASSERT_EQ(index.total, mission.num_commands());
+        const uint16_t num_entries = index.group_start[AP_Mission::CMD_INDEX_NUM_GROUPS];
+        AP_Mission::cmd_index_entry entries[MAX_TEST_COMMANDS];
+        ASSERT_LE(num_entries, ARRAY_SIZE(entries));
+        memcpy(entries, index.entries, num_entries * sizeof(entries[0]));
+        uint16_t group_start[AP_Mission::CMD_INDEX_NUM_GROUPS+1];
+        memcpy(group_start, index.group_start, sizeof(group_start));
+        uint32_t nav_stops[(MAX_TEST_COMMANDS + 32) / 32];
+        const uint16_t nav_words = (index.total + 31U) / 32U;
+        ASSERT_LE(nav_words, ARRAY_SIZE(nav_stops));
+        memcpy(nav_stops, index.nav_stops, nav_words * sizeof(uint32_t));
+
+        index.valid = false;
+        ASSERT_TRUE(mission.update_cmd_index());
+        EXPECT_EQ(memcmp(group_start, index.group_start, sizeof(group_start)), 0);
+        for (uint16_t i = 0; i < num_entries; i++) {
+            EXPECT_EQ(entries[i].index, index.entries[i].index) << "entry " << i;
+            EXPECT_EQ(entries[i].tag, index.entries[i].tag) << "entry " << i;
+        }
+        for (uint16_t i = 0; i < index.total; i++) {
+            const uint32_t bit = 1U << (i%32U);
+            EXPECT_EQ(nav_stops[i/32U] & bit, index.nav_stops[i/32U] & bit) << "nav stop " << i;
+        }
+    }
+
+    // check every query the index is used for against the same query
+    // reading storage
+    void check_queries()
+    {
+        const uint16_t count = mission.num_commands();
+        ASSERT_TRUE(mission.update_cmd_index());
+
+        for (uint16_t start = 0; start <= count; start++) {
+            check("get_next_nav_cmd", start, [&]() {
+                AP_Mission::Mission_Command cmd;
+                if (!mission.get_next_nav_cmd(start, cmd)) {
+                    return UINT32_MAX;
+                }
+                return (uint32_t(cmd.index) << 16) | cmd.id;
+            });
+        }
+
+        for (uint16_t tag = 0; tag <= MAX_TAG; tag++) {
+            check("get_index_of_jump_tag", tag, [&]() {
+                return uint32_t(mission.get_index_of_jump_tag(tag));
+            });
+        }
+
+        static const MAV_CMD ids[] {
+            MAV_CMD_DO_LAND_START,
+            MAV_CMD_DO_GO_AROUND,
+            MAV_CMD_DO_RETURN_PATH_START,
+            MAV_CMD_JUMP_TAG,
+            MAV_CMD_DO_JUMP,
+            MAV_CMD_NAV_LAND,
+        };
+        for (const MAV_CMD id : ids) {
+            check("contains_item", id, [&]() {
+                return uint32_t(mission.contains_item(id));
+            });
+            for (uint16_t start = 1; start <= count; start++) {
+                check("next_cmd_with_id", (uint32_t(id) << 16) | start, [&]() {
+                    return uint32_t(mission.next_cmd_with_id(id, start));
+                });
+            }
+        }
+
+        for (uint8_t i = 0; i < 10; i++) {
+            const Location loc {
+                -353632640 + int32_t(test_rand(20000)),
+                1491652352 + int32_t(test_rand(20000)),
+                int32_t(test_rand(10000)),
+                Location::AltFrame::ABSOLUTE
+            };
+            check("get_landing_sequence_start", i, [&]() {
+                return uint32_t(mission.get_landing_sequence_start(loc));
+            });
+        }
+    }
+
+private:
+    // run query with the command index, then with it disabled so the
+    // commands are found by reading storage, and compare the results
+    template <typename Query>
+    void check(const char *name, uint32_t arg, Query query)
+    {
+        mission._cmd_index.nav_stops = nav_stops;
+        const uint32_t indexed = query();
+        mission._cmd_index.nav_stops = nullptr;
+        const uint32_t unindexed = query();
+        mission._cmd_index.nav_stops = nav_stops;
+        EXPECT_EQ(indexed, unindexed) << name << "(" << arg << ")";
+    }
+
+    bool start_cmd(const AP_Mission::Mission_Command& cmd) { return true; }
+    bool verify_cmd(const AP_Mission::Mission_Command& cmd) { return true; }
+    void mission_complete(void) {}
+
+    AP_Mission mission{
+        FUNCTOR_BIND_MEMBER(&AP_Mission_Test::start_cmd, bool, const AP_Mission::Mission_Command &),
+        FUNCTOR_BIND_MEMBER(&AP_Mission_Test::verify_cmd, bool, const AP_Mission::Mission_Command &),
+        FUNCTOR_BIND_MEMBER(&AP_Mission_Test::mission_complete, void)};
+
+    uint32_t *nav_stops;
+
+    // the commands after home as written
+    AP_Mission::Mission_Command shadow[MAX_TEST_COMMANDS];
+    uint16_t num_shadow;
+    bool has_home;
+};
+
+// AP_Mission is a singleton, so the tests share one, created once the
+// HAL is running
+static AP_Mission_Test &mission_test()
+{
+    static AP_Mission_Test t;
+    return t;
+}
+
+TEST(AP_Mission, IndexRandomMissions)
+{
+    AP_Mission_Test &t = mission_test();
+    test_rand_state = 1;
+    for (uint8_t n = 0; n < 20; n++) {
+        t.make_random_mission(1 + test_rand(MAX_TEST_COMMANDS - 1));
+        t.check_reads();
+        t.check_queries();
+        t.check_index_matches_rebuild();
+    }
+}
+
+// single writes and truncates update the index in place
+TEST(AP_Mission, IndexEdits)
+{
+    AP_Mission_Test &t = mission_test();
+    test_rand_state = 2;
+    t.make_random_mission(100);
+    t.check_queries();
+    for (uint8_t n = 0; n < 100; n++) {
+        switch (test_rand(4)) {
+        case 0:
+            if (t.num_cmds() + 1 < MAX_TEST_COMMANDS) {
+                t.add(t.random_cmd(t.num_cmds()));
+            }
+            break;
+        case 1:
+            // drop up to 10 commands, sometimes the whole mission
+            t.truncate(test_rand(8) == 0 ? 0 : 1 + t.num_cmds() - MIN(t.num_cmds(), test_rand(10)));
+            break;
+        default:
+            if (t.num_cmds() > 0) {
+                t.replace(1 + test_rand(t.num_cmds()), t.random_cmd(t.num_cmds()));
+            }
+            break;
+        }
+        t.check_reads();
+        if (t.num_cmds() > 0) {
+            t.check_index_matches_rebuild();
+            t.check_queries();
+        }
+    }
+}
+
+#endif // AP_MISSION_CMD_CACHE_ENABLED
+
+AP_GTEST_MAIN()
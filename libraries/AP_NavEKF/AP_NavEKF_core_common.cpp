@@ -16,10 +16,17 @@
  */
 #include "AP_NavEKF_core_common.h"
 
+#if AP_NAVEKF_THREAD_LOCAL_SCRATCH
+thread_local NavEKF_core_common::Matrix24 NavEKF_core_common::KH;
+thread_local NavEKF_core_common::Matrix24 NavEKF_core_common::KHP;
+thread_local NavEKF_core_common::Matrix24 NavEKF_core_common::nextP;
+thread_local NavEKF_core_common::Vector28 NavEKF_core_common::Kfusion;
+#else
 NavEKF_core_common::Matrix24 NavEKF_core_common::KH;
 NavEKF_core_common::Matrix24 NavEKF_core_common::KHP;
 NavEKF_core_common::Matrix24 NavEKF_core_common::nextP;
 NavEKF_core_common::Vector28 NavEKF_core_common::Kfusion;
+#endif
 
 /*
   fill common scratch variables, for detecting re-use of variables between loops in SITL
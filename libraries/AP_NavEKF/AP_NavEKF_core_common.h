@@ -21,6 +21,18 @@
 #include <AP_Math/vectorN.h>
 #include "AP_Nav_Common.h"
 
+// EKF3 can run its cores on worker threads on Linux and SITL, so
+// there each thread gets its own copy of the scratch space
+#ifndef AP_NAVEKF_THREAD_LOCAL_SCRATCH
+#define AP_NAVEKF_THREAD_LOCAL_SCRATCH (CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_SITL)
+#endif
+
+#if AP_NAVEKF_THREAD_LOCAL_SCRATCH
+#define NAVEKF_SCRATCH static thread_local
+#else
+#define NAVEKF_SCRATCH static
+#endif
+
 /*
   this declares a common parent class for AP_NavEKF2 and
   AP_NavEKF3. The purpose of this class is to hold common static
@@ -29,7 +41,8 @@
   placing these in a common parent class we save a lot of memory, but
   we also save a lot of CPU (approx 10% on STM32F427) as the compiler
   is able to resolve the address of these variables at compile time,
-  which means significantly faster code
+  which means significantly faster code. Where cores may be updated
+  on several threads at once the scratch space is per thread
  */
 class NavEKF_core_common {
 public:
@@ -42,12 +55,12 @@ public:
 #endif
 
 protected:
-    static Matrix24 KH;                   // intermediate result used for covariance updates
-    static Matrix24 KHP;                  // intermediate result used for covariance updates
-    static Matrix24 nextP;                // Predicted covariance matrix before addition of process noise to diagonals
-    static Vector28 Kfusion;              // intermediate fusion vector
+    NAVEKF_SCRATCH Matrix24 KH;           // intermediate result used for covariance updates
+    NAVEKF_SCRATCH Matrix24 KHP;          // intermediate result used for covariance updates
+    NAVEKF_SCRATCH Matrix24 nextP;        // Predicted covariance matrix before addition of process noise to diagonals
+    NAVEKF_SCRATCH Vector28 Kfusion;      // intermediate fusion vector
 
-    // fill all the common scratch variables with NaN on SITL
+    // fill the calling thread's scratch variables with NaN on SITL
     void fill_scratch_variables(void);
 
     // zero part of an array for index range [n1,n2]
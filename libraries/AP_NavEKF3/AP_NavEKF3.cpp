@@ -739,8 +739,8 @@ const AP_Param::GroupInfo NavEKF3::var_info2[] = {
 
     // @Param: OPTIONS
     // @DisplayName: Optional EKF behaviour
-    // @Description: EKF optional behaviour. Bit 0 (JammingExpected): Setting JammingExpected will change the EKF behaviour such that if dead reckoning navigation is possible it will require the preflight alignment GPS quality checks controlled by EK3_GPS_CHECK and EK3_CHECK_SCALE to pass before resuming GPS use if GPS lock is lost for more than 2 seconds to prevent bad position estimate. Bit 1 (Manual lane switching): DANGEROUS – If enabled, this disables automatic lane switching. If the active lane becomes unhealthy, no automatic switching will occur. Users must manually set EK3_PRIMARY to change lanes. No health checks will be performed on the selected lane. Use with extreme caution.
-    // @Bitmask: 0:JammingExpected, 1: ManualLaneSwitching
+    // @Description: EKF optional behaviour. Bit 0 (JammingExpected): Setting JammingExpected will change the EKF behaviour such that if dead reckoning navigation is possible it will require the preflight alignment GPS quality checks controlled by EK3_GPS_CHECK and EK3_CHECK_SCALE to pass before resuming GPS use if GPS lock is lost for more than 2 seconds to prevent bad position estimate. Bit 1 (Manual lane switching): DANGEROUS – If enabled, this disables automatic lane switching. If the active lane becomes unhealthy, no automatic switching will occur. Users must manually set EK3_PRIMARY to change lanes. No health checks will be performed on the selected lane. Use with extreme caution. Bit 2 (ParallelCores): On multi-core Linux boards and SITL, run each EKF core's update on its own thread once the EKF origin is set. Outputs are identical to running the cores in series. Core update timing is logged in XKTC.
+    // @Bitmask: 0:JammingExpected, 1: ManualLaneSwitching, 2:ParallelCores
     // @User: Advanced
     AP_GROUPINFO("OPTIONS",  11, NavEKF3, _options, 0),
 
@@ -917,17 +917,13 @@ void NavEKF3::UpdateFilter(void)
 
     imuSampleTime_us = dal.micros64();
 
-    for (uint8_t i=0; i<num_cores; i++) {
-        // if we have not overrun by more than 3 IMU frames, and we
-        // have already used more than 1/3 of the CPU budget for this
-        // loop then suppress the prediction step. This allows
-        // multiple EKF instances to cooperate on scheduling
-        bool allow_state_prediction = true;
-        if (core[i].getFramesSincePredict() < (_framesPerPrediction+3) &&
-            dal.ekf_low_time_remaining(AP_DAL::EKFType::EKF3, i)) {
-            allow_state_prediction = false;
+#if EK3_FEATURE_PARALLEL_CORES
+    if (!runCoresParallel())
+#endif
+    {
+        for (uint8_t i=0; i<num_cores; i++) {
+            updateCore(i, corePredictionAllowed(i), false);
         }
-        core[i].UpdateFilter(allow_state_prediction);
     }
 
     // If the current core selected has a bad error score or is unhealthy, switch to a healthy core with the lowest fault score
@@ -1020,6 +1016,137 @@ void NavEKF3::UpdateFilter(void)
     sources.align_inactive_sources();
 }
 
+/*
+  return true if a core may run its state prediction step on this update
+ */
+bool NavEKF3::corePredictionAllowed(uint8_t i)
+{
+    // if we have not overrun by more than 3 IMU frames, and we
+    // have already used more than 1/3 of the CPU budget for this
+    // loop then suppress the prediction step. This allows
+    // multiple EKF instances to cooperate on scheduling
+    return !(core[i].getFramesSincePredict() < (_framesPerPrediction+3) &&
+             dal.ekf_low_time_remaining(AP_DAL::EKFType::EKF3, i));
+}
+
+/*
+  run UpdateFilter() on one core, recording how long it took
+ */
+void NavEKF3::updateCore(uint8_t i, bool predict, bool parallel)
+{
+    const uint32_t start_us = AP_HAL::micros();
+    core[i].UpdateFilter(predict);
+    const uint32_t dt_us = AP_HAL::micros() - start_us;
+
+    auto &t = coreUpdateTiming[i];
+    t.count++;
+    t.total_us += dt_us;
+    t.max_us = MAX(t.max_us, dt_us);
+    t.parallel = parallel;
+}
+
+#if EK3_FEATURE_PARALLEL_CORES
+#if !AP_NAVEKF_THREAD_LOCAL_SCRATCH
+#error "EK3_FEATURE_PARALLEL_CORES needs AP_NAVEKF_THREAD_LOCAL_SCRATCH"
+#endif
+
+extern const AP_HAL::HAL& hal;
+
+/*
+  a thread which runs UpdateFilter() for one core each time it is
+  started, used when EK3_OPTIONS has ParallelCores set
+ */
+class NavEKF3::CoreWorker {
+public:
+    NavEKF3 *frontend;
+    uint8_t core_index;
+    bool predict;
+    HAL_BinarySemaphore start_sem;
+    HAL_BinarySemaphore done_sem;
+
+    void thread(void) {
+        while (true) {
+            start_sem.wait_blocking();
+            frontend->updateCore(core_index, predict, true);
+            done_sem.signal();
+        }
+    }
+};
+
+/*
+  start a worker thread for each core other than the first, which
+  is run on the main thread
+ */
+bool NavEKF3::startCoreWorkers(void)
+{
+    if (coreWorkers != nullptr) {
+        return !coreWorkersFailed;
+    }
+    if (coreWorkersFailed) {
+        return false;
+    }
+    coreWorkers = NEW_NOTHROW CoreWorker[num_cores-1];
+    if (coreWorkers == nullptr) {
+        coreWorkersFailed = true;
+        GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "EKF3 parallel cores: allocation failed");
+        return false;
+    }
+    for (uint8_t i=1; i<num_cores; i++) {
+        CoreWorker &w = coreWorkers[i-1];
+        w.frontend = this;
+        w.core_index = i;
+        // workers that did start are left waiting on start_sem
+        if (!hal.scheduler->thread_create(FUNCTOR_BIND(&w, &CoreWorker::thread, void),
+                                          "ekf3_core", 16384, AP_HAL::Scheduler::PRIORITY_MAIN, 0)) {
+            coreWorkersFailed = true;
+            GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "EKF3 parallel cores: thread create failed");
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+  run core 0 on the main thread and the other cores on worker threads,
+  waiting for all of them to finish before returning. Returns false if
+  the cores should be run in series instead.
+
+  Each thread has its own copy of the scratch matrices in
+  NavEKF_core_common, and otherwise cores only share read-only data
+  (the DAL frame and frontend parameters) while updating, so the
+  results are identical to running them in series. The exceptions are
+  the prediction scheduling decision, which is made for all cores
+  before any of them start, and the shared origin which is set by the
+  first core to set its own origin. We run in series until the shared
+  origin is valid so it is always set by the same core as in serial
+  execution.
+ */
+bool NavEKF3::runCoresParallel(void)
+{
+    if (!option_is_enabled(Option::ParallelCores) ||
+        num_cores < 2 ||
+        !common_origin_valid ||
+        !startCoreWorkers()) {
+        return false;
+    }
+
+    const bool predict0 = corePredictionAllowed(0);
+    for (uint8_t i=1; i<num_cores; i++) {
+        CoreWorker &w = coreWorkers[i-1];
+        w.predict = corePredictionAllowed(i);
+        w.start_sem.signal();
+    }
+
+    updateCore(0, predict0, true);
+
+    // barrier; lane switching looks at the outputs of all cores
+    for (uint8_t i=1; i<num_cores; i++) {
+        coreWorkers[i-1].done_sem.wait_blocking();
+    }
+    return true;
+}
+#endif  // EK3_FEATURE_PARALLEL_CORES
+
 /*
   check if switching lanes will reduce the normalised
   innovations. This is called when the vehicle code is about to
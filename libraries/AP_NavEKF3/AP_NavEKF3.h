@@ -24,12 +24,14 @@
 #include <AP_Param/AP_Param.h>
 #include <AP_NavEKF/AP_Nav_Common.h>
 #include <AP_NavEKF/AP_NavEKF_Source.h>
+#include "AP_NavEKF3_feature.h"
 
 class NavEKF3_core;
 class EKFGSF_yaw;
 
 class NavEKF3 {
     friend class NavEKF3_core;
+    friend class NavEKF3_core_Test;
 
 public:
     NavEKF3();
@@ -459,6 +461,7 @@ private:
     enum class Option {
         JammingExpected     = (1<<0),
         ManualLaneSwitch   = (1<<1),
+        ParallelCores      = (1<<2),
     };
     bool option_is_enabled(Option option) const {
         return (_options & (uint32_t)option) != 0;
@@ -513,6 +516,15 @@ private:
     // last time of Log_Write
     uint64_t lastLogWrite_us;
 
+    // time taken by each core's UpdateFilter(), logged as XKTC
+    struct {
+        uint32_t count;               // number of updates since last logged
+        uint64_t total_us;            // total time taken by those updates
+        uint32_t max_us;              // longest update
+        bool parallel;                // true if the last update ran in parallel with the other cores
+    } coreUpdateTiming[MAX_EKF_CORES];
+    uint32_t lastCoreTimingLogTime_ms;
+
     struct {
         uint32_t last_function_call;  // last time getLastYawResetAngle was called
         bool core_changed;            // true when a core change happened and hasn't been consumed, false otherwise
@@ -576,6 +588,28 @@ private:
     // checks for alignment
     bool coreBetterScore(uint8_t new_core, uint8_t current_core) const;
 
+    // return true if core may run its state prediction step on this update
+    bool corePredictionAllowed(uint8_t core_index);
+
+    // run and time UpdateFilter() on one core
+    void updateCore(uint8_t core_index, bool predict, bool parallel);
+
+    // log XKTC core update timing
+    void Log_Write_Core_Timing(uint64_t time_us);
+
+#if EK3_FEATURE_PARALLEL_CORES
+    // thread running UpdateFilter() for one of cores 1 to num_cores-1
+    class CoreWorker;
+    CoreWorker *coreWorkers = nullptr;
+    bool coreWorkersFailed;
+
+    // start worker threads, returns true if they are running
+    bool startCoreWorkers(void);
+
+    // run cores in parallel if enabled, returns false if they should be run in series
+    bool runCoresParallel(void);
+#endif
+
     // position, velocity and yaw source control
     AP_NavEKF_Source sources;
 };
@@ -374,9 +374,35 @@ void NavEKF3::Log_Write()
         core[i].Log_Write(time_us);
     }
 
+    Log_Write_Core_Timing(time_us);
+
     AP::dal().start_frame(AP_DAL::FrameType::LogWriteEKF3);
 }
 
+void NavEKF3::Log_Write_Core_Timing(uint64_t time_us)
+{
+    // log core update timing every 5s
+    if (AP::dal().millis() - lastCoreTimingLogTime_ms <= 5000) {
+        return;
+    }
+    lastCoreTimingLogTime_ms = AP::dal().millis();
+
+    for (uint8_t i=0; i<activeCores(); i++) {
+        auto &t = coreUpdateTiming[i];
+        const struct log_XKTC xktc{
+            LOG_PACKET_HEADER_INIT(LOG_XKTC_MSG),
+            time_us  : time_us,
+            core     : DAL_CORE(i),
+            count    : t.count,
+            avg_us   : t.count > 0 ? uint32_t(t.total_us / t.count) : 0,
+            max_us   : t.max_us,
+            parallel : t.parallel,
+        };
+        memset(&t, 0, sizeof(t));
+        AP::logger().WriteBlock(&xktc, sizeof(xktc));
+    }
+}
+
 void NavEKF3_core::Log_Write(uint64_t time_us)
 {
     const auto level = frontend->_log_level;
@@ -126,6 +126,8 @@
 
 class NavEKF3_core : public NavEKF_core_common
 {
+    friend class NavEKF3_core_Test;
+
 public:
     // Constructor
     NavEKF3_core(class NavEKF3 *_frontend, class AP_DAL &dal);
@@ -377,6 +377,24 @@ struct PACKED log_XKTV {
     float tvd;
 };
 
+// @LoggerMessage: XKTC
+// @Description: EKF3 core update timing
+// @Field: TimeUS: Time since system startup
+// @Field: C: EKF3 core this data is for
+// @Field: Cnt: number of updates since the last message
+// @Field: Avg: average time taken by an update
+// @Field: Max: longest time taken by an update
+// @Field: Par: 1 if the core is being updated in parallel with the other cores
+struct PACKED log_XKTC {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t core;
+    uint32_t count;
+    uint32_t avg_us;
+    uint32_t max_us;
+    uint8_t parallel;
+};
+
 // @LoggerMessage: XKV1
 // @Description: EKF3 State variances (primary core)
 // @Field: TimeUS: Time since system startup
@@ -453,6 +471,8 @@ struct PACKED log_XKV {
       "XKT", "QBIffffffff", "TimeUS,C,Cnt,IMUMin,IMUMax,EKFMin,EKFMax,AngMin,AngMax,VMin,VMax", "s#sssssssss", "F-000000000", true }, \
     { LOG_XKTV_MSG, sizeof(log_XKTV),                         \
       "XKTV", "QBff", "TimeUS,C,TVS,TVD", "s#rr", "F-00", true }, \
+    { LOG_XKTC_MSG, sizeof(log_XKTC),                         \
+      "XKTC", "QBIIIB", "TimeUS,C,Cnt,Avg,Max,Par", "s#-ss-", "F--FF-", true }, \
     { LOG_XKV1_MSG, sizeof(log_XKV), \
       "XKV1","QBffffffffffff","TimeUS,C,V00,V01,V02,V03,V04,V05,V06,V07,V08,V09,V10,V11", "s#------------", "F-------------" , true }, \
     { LOG_XKV2_MSG, sizeof(log_XKV), \
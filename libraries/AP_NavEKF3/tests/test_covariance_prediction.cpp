@@ -0,0 +1,444 @@
+// the covariance symmetry and unchanged block tests compare floats directly
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wfloat-equal"
+
+#include <AP_gtest.h>
+
+/*
+  tests for NavEKF3_core::CovariancePrediction()
+ */
+
+#include <AP_NavEKF3/AP_NavEKF3.h>
+#include <AP_NavEKF3/AP_NavEKF3_core.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <atomic>
+
+#include <AP_HAL/AP_HAL.h>
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+
+class NavEKF3_core_Test
+{
+public:
+    NavEKF3_core_Test() :
+        core(&ekf, AP::dal())
+    {}
+
+    // setup a core with states up to state_limit active, random IMU
+    // data and a random symmetric covariance matrix
+    void setup(unsigned seed, uint8_t state_limit=23)
+    {
+        srand(seed);
+        core.stateIndexLim = state_limit;
+        core.dtEkfAvg = EKF_TARGET_DT;
+        core.imuDataDelayed.delAngDT = EKF_TARGET_DT;
+        core.imuDataDelayed.delVelDT = EKF_TARGET_DT;
+        core.imuDataDelayed.delAng = Vector3F(rnd(-0.01), rnd(-0.01), rnd(-0.01));
+        core.imuDataDelayed.delVel = Vector3F(rnd(-0.1), rnd(-0.1), rnd(-0.1));
+        core.stateStruct.quat = QuaternionF(rnd(-1), rnd(-1), rnd(-1), rnd(-1));
+        core.stateStruct.quat.normalize();
+        core.stateStruct.velocity = Vector3F(rnd(-5), rnd(-5), rnd(-5));
+        core.stateStruct.gyro_bias = Vector3F(rnd(-1e-4), rnd(-1e-4), rnd(-1e-4));
+        core.stateStruct.accel_bias = Vector3F(rnd(-1e-3), rnd(-1e-3), rnd(-1e-3));
+        core.hgtRate = 0;
+        core.onGround = false;
+        core.badIMUdata = false;
+        core.inhibitDelAngBiasStates = state_limit < 12;
+        core.inhibitDelVelBiasStates = state_limit < 15;
+        core.inhibitMagStates = state_limit < 21;
+        core.lastInhibitMagStates = core.inhibitMagStates;
+        core.inhibitWindStates = state_limit < 23;
+        core.needMagBodyVarReset = false;
+        core.needEarthBodyVarReset = false;
+        core.windStateIsObservable = true;
+        core.treatWindStatesAsTruth = false;
+        core.filterStatus.value = 0;
+        core.tasDataDelayed.allowFusion = true;
+        core.vertVelVarClipCounter = 0;
+        core.imuSampleTime_ms = core.lastLogTime_ms;
+        for (uint8_t i=0; i<3; i++) {
+            core.dvelBiasAxisInhibit[i] = false;
+        }
+
+        for (uint8_t i=0; i<24; i++) {
+            for (uint8_t j=0; j<i; j++) {
+                core.P[i][j] = core.P[j][i] = rnd(1e-6);
+            }
+            core.P[i][i] = 1e-4 + fabsF(rnd(1e-3));
+        }
+        // keep the delta velocity bias variances within their limits
+        for (uint8_t i=13; i<=15; i++) {
+            core.P[i][i] = sq(0.1 * EKF_TARGET_DT);
+        }
+    }
+
+    void predict(Vector3F *rotVarVecPtr=nullptr)
+    {
+        core.CovariancePrediction(rotVarVecPtr);
+    }
+
+    // the prediction calculated from its derivation
+    void reference_prediction(Vector3F *rotVarVecPtr);
+
+    ftype &P(uint8_t i, uint8_t j) { return core.P[i][j]; }
+
+    // as done by UpdateFilter() for every core update
+    void fill_scratch() { core.fill_scratch_variables(); }
+
+private:
+    static ftype rnd(ftype limit)
+    {
+        return limit * (2 * (rand() / ftype(RAND_MAX)) - 1);
+    }
+
+    NavEKF3 ekf;
+    NavEKF3_core core;
+};
+
+/*
+  the state propagation of derivation/generate_2.py, from which the
+  covariance prediction equations are generated. x is the 24 element
+  state vector and u the delta angle and delta velocity inputs
+ */
+static void state_transition(const ftype x[24], const ftype u[6], ftype dt, ftype x_new[24])
+{
+    const ftype q0 = x[0], q1 = x[1], q2 = x[2], q3 = x[3];
+
+    // q_new = quat_mult(q, [1, 0.5*d_ang_true])
+    const ftype r1 = 0.5 * (u[0] - x[10]);
+    const ftype r2 = 0.5 * (u[1] - x[11]);
+    const ftype r3 = 0.5 * (u[2] - x[12]);
+    x_new[0] = q0 - q1*r1 - q2*r2 - q3*r3;
+    x_new[1] = q0*r1 + q1 + q2*r3 - q3*r2;
+    x_new[2] = q0*r2 - q1*r3 + q2 + q3*r1;
+    x_new[3] = q0*r3 + q1*r2 - q2*r1 + q3;
+
+    // v_new = v + R_to_earth * d_vel_true + [0,0,g] * dt, using the
+    // rotation matrix form of quat2Rot()
+    const ftype R[3][3] {
+        { 1 - 2*(sq(q2) + sq(q3)), 2*(q1*q2 - q0*q3),       2*(q1*q3 + q0*q2) },
+        { 2*(q1*q2 + q0*q3),       1 - 2*(sq(q1) + sq(q3)), 2*(q2*q3 - q0*q1) },
+        { 2*(q1*q3 - q0*q2),       2*(q2*q3 + q0*q1),       1 - 2*(sq(q1) + sq(q2)) },
+    };
+    for (uint8_t i=0; i<3; i++) {
+        x_new[4+i] = x[4+i] + (i == 2 ? GRAVITY_MSS * dt : 0);
+        for (uint8_t j=0; j<3; j++) {
+            x_new[4+i] += R[i][j] * (u[3+j] - x[13+j]);
+        }
+    }
+
+    // p_new = p + v * dt
+    for (uint8_t i=0; i<3; i++) {
+        x_new[7+i] = x[7+i] + x[4+i] * dt;
+    }
+
+    // the bias, magnetic field and wind states are constant
+    for (uint8_t i=10; i<24; i++) {
+        x_new[i] = x[i];
+    }
+}
+
+/*
+  d(x_new)/d(v) for element n of the state (v == x) or input (v == u)
+  vector. Each element of x_new is at most quadratic in any one state
+  or input, so a central difference gives the exact partial derivative
+  whatever the step size
+ */
+static void jacobian_column(const ftype x[24], const ftype u[6], ftype dt, ftype *v, uint8_t n, ftype col[24])
+{
+    const ftype v0 = v[n];
+    ftype hi[24], lo[24];
+    v[n] = v0 + 1;
+    state_transition(x, u, dt, hi);
+    v[n] = v0 - 1;
+    state_transition(x, u, dt, lo);
+    v[n] = v0;
+    for (uint8_t i=0; i<24; i++) {
+        col[i] = 0.5 * (hi[i] - lo[i]);
+    }
+}
+
+/*
+  the covariance prediction as derived in derivation/generate_2.py,
+  P_new = A * P * A.T + G * var_u * G.T with A and G the jacobians of
+  the state propagation, followed by the process noise on the
+  diagonals of the constant states. This is calculated directly
+  rather than through the generated equations
+ */
+void NavEKF3_core_Test::reference_prediction(Vector3F *rotVarVecPtr)
+{
+    const ftype dt = EKF_TARGET_DT;
+    const uint8_t lim = core.stateIndexLim;
+    auto &P = core.P;
+
+    // input noise variances
+    ftype var_u[6];
+    if (rotVarVecPtr != nullptr) {
+        // the earth frame quaternion variances are rotated into the
+        // body frame and propagated as gyro noise
+        const Matrix3F R_ef {
+            rotVarVecPtr->x, 0, 0,
+            0, rotVarVecPtr->y, 0,
+            0, 0, rotVarVecPtr->z };
+        Matrix3F Tnb;
+        core.stateStruct.quat.inverse().rotation_matrix(Tnb);
+        const Matrix3F R_bf = Tnb * R_ef * Tnb.transposed();
+        var_u[0] = R_bf.a.x;
+        var_u[1] = R_bf.b.y;
+        var_u[2] = R_bf.c.z;
+        for (uint8_t i=0; i<=3; i++) {
+            for (uint8_t j=0; j<24; j++) {
+                P[i][j] = P[j][i] = 0;
+            }
+        }
+    } else {
+        var_u[0] = var_u[1] = var_u[2] = sq(dt * constrain_ftype(ekf._gyrNoise, 0, 1));
+    }
+    var_u[3] = var_u[4] = var_u[5] = sq(dt * constrain_ftype(ekf._accNoise, 0, BAD_IMU_DATA_ACC_P_NSE));
+
+    // process noise of the constant states
+    ftype noise[24] {};
+    if (!core.inhibitDelAngBiasStates) {
+        noise[10] = noise[11] = noise[12] = sq(sq(dt) * constrain_ftype(ekf._gyroBiasProcessNoise, 0, 1));
+    }
+    if (!core.inhibitDelVelBiasStates) {
+        noise[13] = noise[14] = noise[15] = sq(sq(dt) * constrain_ftype(ekf._accelBiasProcessNoise, 0, 1));
+    }
+    if (!core.inhibitMagStates) {
+        noise[16] = noise[17] = noise[18] = sq(dt * constrain_ftype(ekf._magEarthProcessNoise, 0, 1));
+        noise[19] = noise[20] = noise[21] = sq(dt * constrain_ftype(ekf._magBodyProcessNoise, 0, 1));
+    }
+    if (!core.inhibitWindStates) {
+        // the height rate filter starts from zero in setup()
+        const ftype hgtRate = -core.stateStruct.velocity.z * 0.1 * dt;
+        noise[22] = noise[23] = sq(dt * constrain_ftype(ekf._windVelProcessNoise, 0, 1) *
+                                   (1 + constrain_ftype(ekf._wndVarHgtRateScale, 0, 1) * fabsF(hgtRate)));
+    }
+
+    const auto &s = core.stateStruct;
+    ftype x[24] {
+        s.quat[0], s.quat[1], s.quat[2], s.quat[3],
+        s.velocity.x, s.velocity.y, s.velocity.z,
+        s.position.x, s.position.y, s.position.z,
+        s.gyro_bias.x, s.gyro_bias.y, s.gyro_bias.z,
+        s.accel_bias.x, s.accel_bias.y, s.accel_bias.z,
+        s.earth_magfield.x, s.earth_magfield.y, s.earth_magfield.z,
+        s.body_magfield.x, s.body_magfield.y, s.body_magfield.z,
+        s.wind_vel.x, s.wind_vel.y,
+    };
+    const auto &imu = core.imuDataDelayed;
+    ftype u[6] { imu.delAng.x, imu.delAng.y, imu.delAng.z, imu.delVel.x, imu.delVel.y, imu.delVel.z };
+
+    // columns of A = d(x_new)/dx and G = d(x_new)/du
+    ftype A_T[24][24], G_T[6][24];
+    for (uint8_t n=0; n<24; n++) {
+        jacobian_column(x, u, dt, x, n, A_T[n]);
+    }
+    for (uint8_t n=0; n<6; n++) {
+        jacobian_column(x, u, dt, u, n, G_T[n]);
+    }
+
+    // P * A.T
+    ftype PA_T[24][24];
+    for (uint8_t i=0; i<24; i++) {
+        for (uint8_t j=0; j<24; j++) {
+            ftype sum = 0;
+            for (uint8_t k=0; k<24; k++) {
+                sum += P[i][k] * A_T[k][j];
+            }
+            PA_T[i][j] = sum;
+        }
+    }
+
+    // only the active states are predicted
+    ftype P_new[24][24];
+    for (uint8_t i=0; i<=lim; i++) {
+        for (uint8_t j=0; j<=lim; j++) {
+            ftype sum = (i == j) ? noise[i] : 0;
+            for (uint8_t k=0; k<24; k++) {
+                sum += A_T[k][i] * PA_T[k][j];
+            }
+            for (uint8_t k=0; k<6; k++) {
+                sum += G_T[k][i] * var_u[k] * G_T[k][j];
+            }
+            P_new[i][j] = sum;
+        }
+    }
+    if (rotVarVecPtr != nullptr) {
+        // only the quaternion covariances are reset
+        for (uint8_t i=0; i<=3; i++) {
+            for (uint8_t j=0; j<=3; j++) {
+                P[i][j] = (i == j) ? constrain_ftype(P_new[i][j], 0, 1) : P_new[i][j];
+            }
+        }
+        return;
+    }
+    for (uint8_t i=0; i<=lim; i++) {
+        for (uint8_t j=0; j<=lim; j++) {
+            P[i][j] = P_new[i][j];
+        }
+    }
+
+    core.ConstrainVariances();
+}
+
+static NavEKF3_core_Test test;
+
+/*
+  the prediction gives the same covariance matrix as its derivation,
+  for each number of active states and when initialising the
+  quaternion covariances
+ */
+TEST(NavEKF3_core, CovariancePredictionMatchesReference)
+{
+    const uint8_t state_limits[] { 9, 12, 15, 21, 23 };
+    for (unsigned seed=0; seed<200; seed++) {
+        const uint8_t state_limit = state_limits[seed % ARRAY_SIZE(state_limits)];
+        Vector3F rotVarVec { 1e-3, 2e-3, 3e-3 };
+        Vector3F *rotVarVecPtr = (seed % 10 < 5) ? nullptr : &rotVarVec;
+
+        test.setup(seed, state_limit);
+        test.reference_prediction(rotVarVecPtr);
+        ftype expected[24][24];
+        for (uint8_t i=0; i<24; i++) {
+            for (uint8_t j=0; j<24; j++) {
+                expected[i][j] = test.P(i, j);
+            }
+        }
+
+        test.setup(seed, state_limit);
+        test.predict(rotVarVecPtr);
+        for (uint8_t i=0; i<24; i++) {
+            for (uint8_t j=0; j<24; j++) {
+                EXPECT_NEAR(test.P(i, j), expected[i][j], 1e-5 * fabsF(expected[i][j]) + 1e-15);
+            }
+        }
+    }
+}
+
+/*
+  the earth field, body field and wind states are constant in the
+  process model, as are the IMU bias states. The predicted covariance
+  between a kinematic state and any constant state is the same linear
+  function of that constant state's column of P. So columns 16 and
+  above, which are calculated in a loop, must match the generated
+  equations for the bias columns when given the same input
+ */
+TEST(NavEKF3_core, CovariancePredictionConstantColumns)
+{
+    for (unsigned seed=0; seed<100; seed++) {
+        test.setup(seed);
+        for (uint8_t col=16; col<=23; col++) {
+            const uint8_t bias_col = 10 + (col - 16) % 6;
+            for (uint8_t row=0; row<=15; row++) {
+                const ftype v = (row == bias_col) ? test.P(bias_col, bias_col) : test.P(row, bias_col);
+                test.P(row, col) = test.P(col, row) = v;
+            }
+        }
+        test.predict();
+        for (uint8_t col=16; col<=23; col++) {
+            const uint8_t bias_col = 10 + (col - 16) % 6;
+            for (uint8_t row=0; row<=9; row++) {
+                const ftype expected = test.P(row, bias_col);
+                EXPECT_NEAR(test.P(row, col), expected, 1e-5 * fabsF(expected) + 1e-15);
+            }
+        }
+    }
+}
+
+/*
+  covariances between the constant states are unchanged by the
+  prediction, and the predicted matrix is symmetric
+ */
+TEST(NavEKF3_core, CovariancePredictionConstantBlock)
+{
+    for (unsigned seed=0; seed<100; seed++) {
+        test.setup(seed);
+        ftype before[24][24];
+        for (uint8_t i=0; i<24; i++) {
+            for (uint8_t j=0; j<24; j++) {
+                before[i][j] = test.P(i, j);
+            }
+        }
+        test.predict();
+        for (uint8_t i=0; i<24; i++) {
+            for (uint8_t j=0; j<24; j++) {
+                EXPECT_EQ(test.P(i, j), test.P(j, i));
+                if (i >= 10 && j >= 10 && i != j) {
+                    EXPECT_EQ(test.P(i, j), before[i][j]);
+                }
+            }
+        }
+    }
+}
+
+#if AP_NAVEKF_THREAD_LOCAL_SCRATCH
+static const uint16_t thread_predictions = 2000;
+static std::atomic<uint8_t> threads_waiting;
+
+static void *predict_thread(void *arg)
+{
+    NavEKF3_core_Test &t = *(NavEKF3_core_Test *)arg;
+    // start both threads together
+    threads_waiting--;
+    while (threads_waiting > 0) {
+    }
+    for (uint16_t i=0; i<thread_predictions; i++) {
+        t.fill_scratch();
+        t.predict();
+    }
+    return nullptr;
+}
+
+/*
+  with EK3_OPTIONS ParallelCores set the cores are updated on their
+  own threads. Each thread has its own scratch matrices, so two cores
+  predicting at the same time get the same result as when run in
+  series
+ */
+TEST(NavEKF3_core, CovariancePredictionOnThreads)
+{
+    static NavEKF3_core_Test tests[2];
+    ftype expected[2][24][24];
+    for (uint8_t n=0; n<2; n++) {
+        tests[n].setup(n);
+        for (uint16_t i=0; i<thread_predictions; i++) {
+            tests[n].fill_scratch();
+            tests[n].predict();
+        }
+        for (uint8_t i=0; i<24; i++) {
+            for (uint8_t j=0; j<24; j++) {
+                expected[n][i][j] = tests[n].P(i, j);
+            }
+        }
+    }
+
+    for (uint8_t n=0; n<2; n++) {
+        tests[n].setup(n);
+    }
+    threads_waiting = 2;
+    pthread_t threads[2];
+    for (uint8_t n=0; n<2; n++) {
+        ASSERT_EQ(pthread_create(&threads[n], nullptr, predict_thread, &tests[n]), 0);
+    }
+    for (uint8_t n=0; n<2; n++) {
+        pthread_join(threads[n], nullptr);
+    }
+
+    for (uint8_t n=0; n<2; n++) {
+        for (uint8_t i=0; i<24; i++) {
+            for (uint8_t j=0; j<24; j++) {
+                EXPECT_EQ(tests[n].P(i, j), expected[n][i][j]);
+            }
+        }
+    }
+}
+#endif  // AP_NAVEKF_THREAD_LOCAL_SCRATCH
+
+AP_GTEST_MAIN()
+
+#endif // HAL_SITL or HAL_LINUX
+
+#pragma GCC diagnostic pop
@@ -25,6 +25,7 @@
 
 #include <cmath>
 #include <string.h>
+#include <ctype.h>
 
 #include <AP_Common/AP_Common.h>
 #include <AP_HAL/AP_HAL.h>
@@ -104,6 +105,44 @@ uint16_t AP_Param::_count_marker;
 uint16_t AP_Param::_count_marker_done;
 HAL_Semaphore AP_Param::_count_sem;
 
+#if AP_PARAM_CHANGE_JOURNAL_ENABLED
+// journal of changed parameters
+AP_Param::change_entry AP_Param::_change_journal[AP_PARAM_CHANGE_JOURNAL_SIZE];
+uint8_t AP_Param::_change_journal_next;
+uint8_t AP_Param::_change_journal_hash[CHANGE_HASH_SIZE];
+uint32_t AP_Param::_change_seq;
+uint32_t AP_Param::_change_floor_seq;
+std::atomic<bool> AP_Param::_change_count_invalidated;
+#if AP_PARAM_CHANGE_JOURNAL_SET_ENABLED
+std::atomic<const AP_Param *> AP_Param::_set_pending[AP_PARAM_CHANGE_SET_PENDING_SIZE];
+std::atomic<uint8_t> AP_Param::_set_pending_size[AP_PARAM_CHANGE_SET_PENDING_SIZE];
+std::atomic<bool> AP_Param::_change_missed;
+bool AP_Param::_change_journal_active;
+#endif
+HAL_Semaphore AP_Param::_change_sem;
+#endif
+
+#if AP_PARAM_NAME_INDEX_ENABLED
+// index of parameter names
+AP_Param::name_index_entry *AP_Param::_name_index_entries;
+uint32_t *AP_Param::_name_index_slots;
+uint16_t AP_Param::_name_index_size;
+uint16_t AP_Param::_name_index_count;
+uint16_t AP_Param::_name_index_marker;
+bool AP_Param::_name_index_valid;
+bool AP_Param::_name_index_built;
+HAL_Semaphore AP_Param::_name_index_sem;
+#endif
+
+#if AP_PARAM_OFFSET_INDEX_ENABLED
+// index of storage offsets
+uint16_t *AP_Param::_offset_index;
+uint16_t AP_Param::_offset_index_size;
+uint16_t AP_Param::_offset_index_count;
+bool AP_Param::_offset_index_valid;
+HAL_Semaphore AP_Param::_offset_index_sem;
+#endif
+
 // storage and naming information about all types that can be saved
 const AP_Param::Info *AP_Param::_var_info;
 
@@ -187,6 +226,11 @@ void AP_Param::erase_all(void)
 
     // add a sentinal directly after the header
     write_sentinal(sizeof(struct EEPROM_header));
+
+#if AP_PARAM_OFFSET_INDEX_ENABLED
+    // storage is now empty, so an empty index is correct
+    offset_index_clear(true);
+#endif
 }
 
 /* the 'group_id' of a element of a group is the 18 bit identifier
@@ -361,6 +405,11 @@ bool AP_Param::setup(void)
 {
     struct EEPROM_header hdr {};
 
+#if AP_PARAM_CHANGE_JOURNAL_SET_ENABLED
+    // static constructors have run, so set() can use the journal
+    _change_journal_active = true;
+#endif
+
     // check the header
     _storage.read_block(&hdr, 0, sizeof(hdr));
 
@@ -377,6 +426,9 @@ bool AP_Param::setup(void)
             hdr2.magic[1] == k_EEPROM_magic1 &&
             hdr2.revision == k_EEPROM_revision &&
             _storage.copy_area(_storage_bak)) {
+#if AP_PARAM_OFFSET_INDEX_ENABLED
+            offset_index_clear(false);
+#endif
             // restored from backup
             INTERNAL_ERROR(AP_InternalError::error_t::params_restored);
             return true;
@@ -762,6 +814,19 @@ bool AP_Param::is_sentinal(const Param_header &phdr)
 // if the sentinal isn't found either, the offset is set to 0xFFFF
 bool AP_Param::scan(const AP_Param::Param_header *target, uint16_t *pofs)
 {
+#if AP_PARAM_OFFSET_INDEX_ENABLED
+    {
+        WITH_SEMAPHORE(_offset_index_sem);
+        if (_offset_index_valid) {
+            if (offset_index_find(*target, *pofs)) {
+                return true;
+            }
+            *pofs = sentinal_offset;
+            return false;
+        }
+    }
+#endif
+
     struct Param_header phdr;
     uint16_t ofs = sizeof(AP_Param::EEPROM_header);
     while (ofs < _storage.size()) {
@@ -786,6 +851,108 @@ bool AP_Param::scan(const AP_Param::Param_header *target, uint16_t *pofs)
     return false;
 }
 
+#if AP_PARAM_OFFSET_INDEX_ENABLED
+/*
+  first slot to probe for a header in the offset index
+ */
+uint16_t AP_Param::offset_index_slot(const Param_header &phdr)
+{
+    uint32_t v;
+    memcpy(&v, &phdr, sizeof(v));
+    // multiplicative hash, taking the top bits
+    v *= 2654435761U;
+    return (v >> 16) & (_offset_index_size - 1);
+}
+
+/*
+  find the storage offset of a header in the offset index
+ */
+bool AP_Param::offset_index_find(const Param_header &phdr, uint16_t &ofs)
+{
+    if (_offset_index_size == 0) {
+        return false;
+    }
+    const uint16_t mask = _offset_index_size - 1;
+    for (uint16_t slot = offset_index_slot(phdr); _offset_index[slot] != 0; slot = (slot + 1) & mask) {
+        struct Param_header phdr2;
+        _storage.read_block(&phdr2, _offset_index[slot], sizeof(phdr2));
+        if (memcmp(&phdr, &phdr2, sizeof(phdr)) == 0) {
+            ofs = _offset_index[slot];
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+  add the header stored at ofs to the offset index, growing it as
+  needed. The first copy of a header in storage is the one used, so a
+  header already in the index is left alone. If memory runs out the
+  index is marked invalid, so scan() walks storage, and false is
+  returned
+ */
+bool AP_Param::offset_index_add(const Param_header &phdr, uint16_t ofs)
+{
+    WITH_SEMAPHORE(_offset_index_sem);
+
+    // keep the table at most 3/4 full
+    if ((_offset_index_count + 1) * 4 > _offset_index_size * 3) {
+        const uint32_t new_size = MAX(_offset_index_size * 2U, 64U);
+        uint16_t *new_index = new_size <= UINT16_MAX ? NEW_NOTHROW uint16_t[new_size] : nullptr;
+        if (new_index == nullptr) {
+            offset_index_clear(false);
+            return false;
+        }
+        memset(new_index, 0, new_size * sizeof(uint16_t));
+        uint16_t *old_index = _offset_index;
+        const uint16_t old_size = _offset_index_size;
+        _offset_index = new_index;
+        _offset_index_size = new_size;
+        const uint16_t mask = _offset_index_size - 1;
+        for (uint16_t i=0; i<old_size; i++) {
+            if (old_index[i] == 0) {
+                continue;
+            }
+            struct Param_header phdr2;
+            _storage.read_block(&phdr2, old_index[i], sizeof(phdr2));
+            uint16_t slot = offset_index_slot(phdr2);
+            while (_offset_index[slot] != 0) {
+                slot = (slot + 1) & mask;
+            }
+            _offset_index[slot] = old_index[i];
+        }
+        delete[] old_index;
+    }
+
+    uint16_t ofs2;
+    if (offset_index_find(phdr, ofs2)) {
+        return true;
+    }
+    const uint16_t mask = _offset_index_size - 1;
+    uint16_t slot = offset_index_slot(phdr);
+    while (_offset_index[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    _offset_index[slot] = ofs;
+    _offset_index_count++;
+    return true;
+}
+
+/*
+  empty the offset index, marking whether an empty index correctly
+  describes storage
+ */
+void AP_Param::offset_index_clear(bool valid)
+{
+    WITH_SEMAPHORE(_offset_index_sem);
+    if (_offset_index != nullptr) {
+        memset(_offset_index, 0, _offset_index_size * sizeof(uint16_t));
+    }
+    _offset_index_count = 0;
+    _offset_index_valid = valid;
+}
+#endif // AP_PARAM_OFFSET_INDEX_ENABLED
+
 /**
  * add a _X, _Y, _Z suffix to the name of a Vector3f element
  * @param buffer
@@ -973,9 +1140,137 @@ AP_Param::find_by_index(uint16_t idx, enum ap_var_type *ptype, ParamToken *token
     return ap;    
 }
 
+#if AP_PARAM_NAME_INDEX_ENABLED
+/*
+  case insensitive FNV-1a hash of the first AP_MAX_NAME_SIZE
+  characters of a parameter name
+ */
+uint32_t AP_Param::name_index_hash(const char *name)
+{
+    uint32_t h = 2166136261U;
+    for (uint8_t i=0; i<AP_MAX_NAME_SIZE && name[i] != 0; i++) {
+        h ^= (uint8_t)toupper(name[i]);
+        h *= 16777619U;
+    }
+    return h;
+}
+
+/*
+  build the name index by walking the parameter tree in the same
+  order as find_by_name(), so the first of any duplicate names
+  wins. Returns false if there are too many parameters or the index
+  can't be allocated
+ */
+bool AP_Param::name_index_build(void)
+{
+    // a failed build is not retried until the parameter count is
+    // invalidated again
+    _name_index_valid = false;
+    _name_index_built = true;
+    const uint16_t marker = _count_marker;
+    _name_index_marker = marker;
+    const uint16_t count = count_parameters();
+    if (count >= AP_PARAM_NAME_INDEX_MAX) {
+        return false;
+    }
+
+    if (count != _name_index_count) {
+        delete[] _name_index_entries;
+        _name_index_entries = NEW_NOTHROW name_index_entry[count];
+        if (_name_index_entries == nullptr) {
+            _name_index_count = 0;
+            return false;
+        }
+        _name_index_count = count;
+    }
+
+    // keep the table at most 3/4 full
+    uint16_t size = 64;
+    while (uint32_t(size) * 3 < uint32_t(count) * 4) {
+        size *= 2;
+    }
+    if (size != _name_index_size) {
+        delete[] _name_index_slots;
+        _name_index_slots = NEW_NOTHROW uint32_t[size];
+        if (_name_index_slots == nullptr) {
+            _name_index_size = 0;
+            return false;
+        }
+        _name_index_size = size;
+    }
+    memset(_name_index_slots, 0, size * sizeof(uint32_t));
+
+    const uint16_t mask = size - 1;
+    uint16_t n = 0;
+    ParamToken token {};
+    enum ap_var_type type;
+    for (AP_Param *ap = first(&token, &type);
+         ap && type != AP_PARAM_GROUP && type != AP_PARAM_NONE;
+         ap = next_scalar(&token, &type)) {
+        if (n == count) {
+            // parameters were added while counting
+            return false;
+        }
+        char name[AP_MAX_NAME_SIZE+1] {};
+        ap->copy_name_token(token, name, AP_MAX_NAME_SIZE);
+        const uint32_t h = name_index_hash(name);
+        bool duplicate = false;
+        uint16_t slot = h & mask;
+        for (; _name_index_slots[slot] != 0; slot = (slot + 1) & mask) {
+            if ((_name_index_slots[slot] >> 16) != (h >> 16)) {
+                continue;
+            }
+            const name_index_entry &e = _name_index_entries[(_name_index_slots[slot] & 0xFFFF) - 1];
+            char name2[AP_MAX_NAME_SIZE+1] {};
+            e.ap->copy_name_token(e.token, name2, AP_MAX_NAME_SIZE);
+            if (strncasecmp(name, name2, AP_MAX_NAME_SIZE) == 0) {
+                duplicate = true;
+                break;
+            }
+        }
+        if (duplicate) {
+            continue;
+        }
+        _name_index_entries[n] = { ap, token, (uint8_t)type };
+        _name_index_slots[slot] = (h & 0xFFFF0000U) | (n + 1U);
+        n++;
+    }
+
+    _name_index_valid = true;
+    return true;
+}
+#endif // AP_PARAM_NAME_INDEX_ENABLED
+
 // by-name equivalent of find_by_index()
 AP_Param* AP_Param::find_by_name(const char* name, enum ap_var_type *ptype, ParamToken *token)
 {
+#if AP_PARAM_NAME_INDEX_ENABLED
+    {
+        WITH_SEMAPHORE(_name_index_sem);
+        if (!_name_index_built || _name_index_marker != _count_marker) {
+            name_index_build();
+        }
+        if (_name_index_valid) {
+            const uint32_t h = name_index_hash(name);
+            const uint16_t mask = _name_index_size - 1;
+            for (uint16_t slot = h & mask; _name_index_slots[slot] != 0; slot = (slot + 1) & mask) {
+                if ((_name_index_slots[slot] >> 16) != (h >> 16)) {
+                    continue;
+                }
+                const name_index_entry &e = _name_index_entries[(_name_index_slots[slot] & 0xFFFF) - 1];
+                char buf[AP_MAX_NAME_SIZE];
+                e.ap->copy_name_token(e.token, buf, AP_MAX_NAME_SIZE);
+                if (strncasecmp(name, buf, AP_MAX_NAME_SIZE) == 0) {
+                    *ptype = (enum ap_var_type)e.type;
+                    *token = e.token;
+                    return e.ap;
+                }
+            }
+            return nullptr;
+        }
+    }
+#endif
+
     AP_Param *ap;
     for (ap = AP_Param::first(token, ptype);
          ap && *ptype != AP_PARAM_GROUP && *ptype != AP_PARAM_NONE;
@@ -1134,14 +1429,180 @@ void AP_Param::notify() const {
         param_header_type = info->type;
     }
 
+#if AP_PARAM_CHANGE_JOURNAL_ENABLED
+    record_change(this, type_size((enum ap_var_type)param_header_type));
+#endif
+
     send_parameter(name, (enum ap_var_type)param_header_type, idx);
 }
 
+#if AP_PARAM_CHANGE_JOURNAL_ENABLED
+/*
+  note that the variable at ap has changed. This is O(1) as set() may
+  call it from fast loops. If the hash slot has been taken by another
+  variable a second entry for ap may be added, changed_between()
+  merges these
+ */
+void AP_Param::record_change(const AP_Param *ap, uint8_t size)
+{
+    WITH_SEMAPHORE(_change_sem);
+    update_change_floor();
+    journal_change(ap, size);
+}
+
+/*
+  add a change to the journal with the next sequence number. Must be
+  called with _change_sem held
+ */
+void AP_Param::journal_change(const AP_Param *ap, uint8_t size)
+{
+    _change_seq++;
+    uint8_t &slot = _change_journal_hash[change_hash(ap)];
+    if (slot < AP_PARAM_CHANGE_JOURNAL_SIZE && _change_journal[slot].ap == ap) {
+        change_entry &e = _change_journal[slot];
+        e.seq = _change_seq;
+        e.size = MAX(e.size, size);
+        return;
+    }
+    change_entry &e = _change_journal[_change_journal_next];
+    if (e.ap != nullptr) {
+        // dropping the oldest change
+        _change_floor_seq = MAX(_change_floor_seq, e.seq);
+    }
+    e.ap = ap;
+    e.seq = _change_seq;
+    e.size = size;
+    slot = _change_journal_next;
+    _change_journal_next = (_change_journal_next + 1) % AP_PARAM_CHANGE_JOURNAL_SIZE;
+}
+
+/*
+  note a change made with set(). This can be called from fast loops on
+  any thread, so it only marks the variable as changed, and
+  update_change_floor() journals it later. If its slot is held by
+  another variable we try the journal lock instead. If the lock is
+  busy the change is lost, and earlier sequence numbers stop being
+  covered by the journal
+ */
+#if AP_PARAM_CHANGE_JOURNAL_SET_ENABLED
+void AP_Param::record_set(const AP_Param *ap, uint8_t size)
+{
+    const uintptr_t v = uintptr_t(ap);
+    const uint8_t i = ((v >> 2) ^ (v >> 7)) & (AP_PARAM_CHANGE_SET_PENDING_SIZE - 1);
+    const AP_Param *pending = _set_pending[i].load();
+    if (pending == ap) {
+        // already waiting to be journalled
+        return;
+    }
+    if (pending == nullptr) {
+        // the size is set first as the slot may be read once it is filled
+        uint8_t pending_size = _set_pending_size[i].load();
+        while (pending_size < size &&
+               !_set_pending_size[i].compare_exchange_weak(pending_size, size)) {
+        }
+        if (_set_pending[i].compare_exchange_strong(pending, ap) || pending == ap) {
+            return;
+        }
+    }
+    if (!_change_journal_active) {
+        // variables may be set from constructors before the lock exists
+        return;
+    }
+    if (!_change_sem.take_nonblocking()) {
+        _change_missed = true;
+        return;
+    }
+    record_change(ap, size);
+    _change_sem.give();
+}
+#endif
 
 /*
-  Save the variable to HAL storage, synchronous version
+  after the parameter count has been invalidated parameters may have
+  appeared or disappeared, so earlier sequence numbers can't be
+  covered by the journal. The same applies when a change could not be
+  recorded. invalidate_count() only sets a flag as it must not block.
+  Then journal the variables set() has marked as changed. Must be
+  called with _change_sem held
+ */
+void AP_Param::update_change_floor(void)
+{
+    bool lost = _change_count_invalidated.exchange(false);
+#if AP_PARAM_CHANGE_JOURNAL_SET_ENABLED
+    lost |= _change_missed.exchange(false);
+#endif
+    if (lost) {
+        _change_floor_seq = ++_change_seq;
+    }
+#if AP_PARAM_CHANGE_JOURNAL_SET_ENABLED
+    for (uint8_t i=0; i<AP_PARAM_CHANGE_SET_PENDING_SIZE; i++) {
+        const AP_Param *ap = _set_pending[i].load();
+        if (ap == nullptr) {
+            continue;
+        }
+        // only we empty slots, so the size covers ap. The slot is
+        // emptied before the change gets its sequence number, so a
+        // later set() is journalled again
+        const uint8_t size = _set_pending_size[i].exchange(0);
+        _set_pending[i].store(nullptr);
+        journal_change(ap, size);
+    }
+#endif
+}
+
+uint32_t AP_Param::change_seq(void)
+{
+    WITH_SEMAPHORE(_change_sem);
+    update_change_floor();
+    return _change_seq;
+}
+
+bool AP_Param::change_journal_covers(uint32_t seq)
+{
+    WITH_SEMAPHORE(_change_sem);
+    update_change_floor();
+    return seq >= _change_floor_seq && seq <= _change_seq;
+}
+
+uint8_t AP_Param::changed_between(uint32_t since, uint32_t until, ChangedVar *vars)
+{
+    WITH_SEMAPHORE(_change_sem);
+    uint8_t n = 0;
+    for (const auto &e : _change_journal) {
+        if (e.ap == nullptr || e.seq <= since || e.seq > until) {
+            continue;
+        }
+        // a variable may have more than one entry after a hash collision
+        uint8_t i;
+        for (i=0; i<n && vars[i].ap != e.ap; i++) {
+        }
+        if (i == n) {
+            vars[n].ap = e.ap;
+            vars[n].size = 0;
+            n++;
+        }
+        vars[i].size = MAX(vars[i].size, e.size);
+    }
+    return n;
+}
+#endif  // AP_PARAM_CHANGE_JOURNAL_ENABLED
+
+
+/*
+  Save the variable to HAL storage, synchronous version. The write is
+  passed on to hal.storage before returning
 */
 void AP_Param::save_sync(bool force_save, bool send_to_gcs)
+{
+    save_sync_unflushed(force_save, send_to_gcs);
+    StorageManager::flush();
+}
+
+/*
+  Save the variable to HAL storage, leaving the write in the
+  StorageManager write-back buffer
+*/
+void AP_Param::save_sync_unflushed(bool force_save, bool send_to_gcs)
 {
     uint32_t group_element = 0;
     const struct GroupInfo *ginfo;
@@ -1194,6 +1655,9 @@ void AP_Param::save_sync(bool force_save, bool send_to_gcs)
     if (scan(&phdr, &ofs)) {
         // found an existing copy of the variable
         eeprom_write_check(ap, ofs+sizeof(phdr), type_size((enum ap_var_type)phdr.type));
+#if AP_PARAM_CHANGE_JOURNAL_ENABLED
+        record_change(ap, type_size((enum ap_var_type)phdr.type));
+#endif
         if (send_to_gcs) {
             send_parameter(name, (enum ap_var_type)phdr.type, idx);
         }
@@ -1243,6 +1707,12 @@ void AP_Param::save_sync(bool force_save, bool send_to_gcs)
     write_sentinal(ofs + sizeof(phdr) + type_size((enum ap_var_type)phdr.type));
     eeprom_write_check(ap, ofs+sizeof(phdr), type_size((enum ap_var_type)phdr.type));
     eeprom_write_check(&phdr, ofs, sizeof(phdr));
+#if AP_PARAM_OFFSET_INDEX_ENABLED
+    offset_index_add(phdr, ofs);
+#endif
+#if AP_PARAM_CHANGE_JOURNAL_ENABLED
+    record_change(ap, type_size((enum ap_var_type)phdr.type));
+#endif
 
     if (send_to_gcs) {
         send_parameter(name, (enum ap_var_type)phdr.type, idx);
@@ -1289,8 +1759,14 @@ void AP_Param::save(bool force_save)
 void AP_Param::save_io_handler(void)
 {
     struct param_save p;
+    bool saved = false;
     while (save_queue.pop(p)) {
-        p.param->save_sync(p.force_save, true);
+        p.param->save_sync_unflushed(p.force_save, true);
+        saved = true;
+    }
+    if (saved) {
+        // the queue is empty, so a burst of saves is written together
+        StorageManager::flush();
     }
     if (hal.scheduler->is_system_initialized()) {
         // pay the cost of parameter counting in the IO thread
@@ -1309,6 +1785,8 @@ void AP_Param::flush(void)
         hal.scheduler->delay(10);
         hal.scheduler->expect_delay_ms(0);
     }
+    // the IO thread may still hold the last saves in the write-back buffer
+    StorageManager::flush();
 }
 
 // Load the variable from EEPROM, if supported
@@ -1573,12 +2051,23 @@ bool AP_Param::load_all()
         registered_save_handler = true;
         hal.scheduler->register_io_process(FUNCTOR_BIND((&save_dummy), &AP_Param::save_io_handler, void));
     }
-    
+
+#if AP_PARAM_OFFSET_INDEX_ENABLED
+    // rebuild the offset index as we go, it becomes valid if we reach
+    // the sentinal
+    offset_index_clear(false);
+    bool offset_index_ok = true;
+#endif
+
     while (ofs < _storage.size()) {
         _storage.read_block(&phdr, ofs, sizeof(phdr));
         if (is_sentinal(phdr)) {
             // we've reached the sentinal
             sentinal_offset = ofs;
+#if AP_PARAM_OFFSET_INDEX_ENABLED
+            WITH_SEMAPHORE(_offset_index_sem);
+            _offset_index_valid = offset_index_ok;
+#endif
             return true;
         }
 
@@ -1590,6 +2079,12 @@ bool AP_Param::load_all()
             _storage.read_block(ptr, ofs+sizeof(phdr), type_size((enum ap_var_type)phdr.type));
         }
 
+#if AP_PARAM_OFFSET_INDEX_ENABLED
+        if (!offset_index_add(phdr, ofs)) {
+            offset_index_ok = false;
+        }
+#endif
+
         ofs += type_size((enum ap_var_type)phdr.type) + sizeof(phdr);
     }
 
@@ -2715,6 +3210,9 @@ void AP_Param::invalidate_count(void)
     // not-equal test is strong enough to ensure we get the right
     // answer
     _count_marker++;
+#if AP_PARAM_CHANGE_JOURNAL_ENABLED
+    _change_count_invalidated = true;
+#endif
 }
 
 /*
@@ -23,6 +23,7 @@
 #include <string.h>
 #include <stdint.h>
 #include <cmath>
+#include <atomic>
 
 #include <AP_HAL/AP_HAL.h>
 #include <AP_HAL/utility/RingBuffer.h>
@@ -192,6 +193,8 @@ enum ap_var_type {
 ///
 class AP_Param
 {
+    friend class AP_Param_Test;
+
 public:
     // the Info and GroupInfo structures are passed by the main
     // program in setup() to give information on how variables are
@@ -579,6 +582,33 @@ public:
     // invalidate parameter count
     static void invalidate_count(void);
 
+#if AP_PARAM_CHANGE_JOURNAL_ENABLED
+    // sequence number of the latest parameter change
+    static uint32_t change_seq(void);
+
+    // true if every parameter change after sequence number seq is
+    // still in the change journal and no parameters have appeared or
+    // disappeared since then
+    static bool change_journal_covers(uint32_t seq);
+
+    // a variable recorded in the change journal
+    struct ChangedVar {
+        const AP_Param *ap;
+        uint8_t size;
+        // true if p is this variable or an element of it
+        bool contains(const AP_Param *p) const {
+            return (const uint8_t *)p >= (const uint8_t *)ap &&
+                (const uint8_t *)p < (const uint8_t *)ap + size;
+        }
+    };
+
+    // copy the variables changed after sequence number since, up to
+    // and including sequence number until, into vars returning the
+    // number copied. vars must have room for
+    // AP_PARAM_CHANGE_JOURNAL_SIZE entries
+    static uint8_t changed_between(uint32_t since, uint32_t until, ChangedVar *vars);
+#endif
+
     static void set_hide_disabled_groups(bool value) { _hide_disabled_groups = value; }
 
     // set frame type flags. Used to unhide frame specific parameters
@@ -623,6 +653,11 @@ protected:
     // store default value in linked list
     static void add_default(AP_Param *ap, float v);
 
+#if AP_PARAM_CHANGE_JOURNAL_SET_ENABLED
+    // note a change made with set()
+    static void record_set(const AP_Param *ap, uint8_t size);
+#endif
+
 private:
     static AP_Param *_singleton;
 
@@ -751,6 +786,21 @@ private:
     static bool                 scan(
                                     const struct Param_header *phdr,
                                     uint16_t *pofs);
+#if AP_PARAM_CHANGE_JOURNAL_ENABLED
+    static void                 record_change(const AP_Param *ap, uint8_t size);
+    static void                 journal_change(const AP_Param *ap, uint8_t size);
+    static void                 update_change_floor(void);
+#endif
+#if AP_PARAM_NAME_INDEX_ENABLED
+    static uint32_t             name_index_hash(const char *name);
+    static bool                 name_index_build(void);
+#endif
+#if AP_PARAM_OFFSET_INDEX_ENABLED
+    static uint16_t             offset_index_slot(const Param_header &phdr);
+    static bool                 offset_index_find(const Param_header &phdr, uint16_t &ofs);
+    static bool                 offset_index_add(const Param_header &phdr, uint16_t ofs);
+    static void                 offset_index_clear(bool valid);
+#endif
     static void                 eeprom_write_check(
                                     const void *ptr,
                                     uint16_t ofs,
@@ -866,6 +916,9 @@ private:
     // background function for saving parameters
     void save_io_handler(void);
 
+    // save_sync() without flushing the StorageManager write-back buffer
+    void save_sync_unflushed(bool force_save, bool send_to_gcs);
+
     // Store default values from add_default() calls in linked list
     struct defaults_list {
         AP_Param *ap;
@@ -876,6 +929,90 @@ private:
     static void check_default(AP_Param *ap, float *default_value);
 
     static bool eeprom_full;
+
+#if AP_PARAM_CHANGE_JOURNAL_ENABLED
+    /*
+      ring of the most recently changed variables, each with the
+      sequence number of its latest change. Changes at or before
+      _change_floor_seq may have been dropped from the ring
+     */
+    struct change_entry {
+        const AP_Param *ap;
+        uint32_t seq;
+        uint8_t size;
+    };
+    static change_entry _change_journal[AP_PARAM_CHANGE_JOURNAL_SIZE];
+    static uint8_t _change_journal_next;
+    // journal index of the latest entry for a variable, by a hash of
+    // its address, so a change needn't search the journal. An entry
+    // is only used if the journal slot still holds that variable
+    static const uint8_t CHANGE_HASH_SIZE = 128;
+    static_assert(AP_PARAM_CHANGE_JOURNAL_SIZE <= 255, "AP_PARAM_CHANGE_JOURNAL_SIZE too large");
+    static uint8_t _change_journal_hash[CHANGE_HASH_SIZE];
+    static uint8_t change_hash(const AP_Param *ap) {
+        const uintptr_t v = uintptr_t(ap);
+        return ((v >> 2) ^ (v >> 9)) & (CHANGE_HASH_SIZE - 1);
+    }
+    static uint32_t _change_seq;
+    static uint32_t _change_floor_seq;
+    // set without the lock, from any thread
+    static std::atomic<bool> _change_count_invalidated;
+#if AP_PARAM_CHANGE_JOURNAL_SET_ENABLED
+    /*
+      variables changed with set() and not yet in the journal, by a
+      hash of their address. Slots are only filled by set() and only
+      emptied under _change_sem. A slot's size only grows while it is
+      in use, so a size left by a set() which lost the race for the
+      slot can only widen the entry, sending extra parameters rather
+      than missing any
+     */
+    static_assert((AP_PARAM_CHANGE_SET_PENDING_SIZE & (AP_PARAM_CHANGE_SET_PENDING_SIZE-1)) == 0,
+                  "AP_PARAM_CHANGE_SET_PENDING_SIZE must be a power of 2");
+    static std::atomic<const AP_Param *> _set_pending[AP_PARAM_CHANGE_SET_PENDING_SIZE];
+    static std::atomic<uint8_t> _set_pending_size[AP_PARAM_CHANGE_SET_PENDING_SIZE];
+    static std::atomic<bool> _change_missed;
+    static bool _change_journal_active;
+#endif
+    static HAL_Semaphore _change_sem;
+#endif
+
+#if AP_PARAM_NAME_INDEX_ENABLED
+    /*
+      hash index of the names of all scalars visible to
+      first()/next_scalar(), built on demand by find_by_name() and
+      rebuilt when the parameter count is invalidated. Each slot holds
+      the top 16 bits of the name hash and 1 + the index of an entry
+      (0 for empty)
+     */
+    struct name_index_entry {
+        AP_Param *ap;
+        ParamToken token;
+        uint8_t type;
+    };
+    static name_index_entry *_name_index_entries;
+    static uint32_t *_name_index_slots;
+    static uint16_t _name_index_size;       // number of slots, a power of 2
+    static uint16_t _name_index_count;      // number of entries allocated
+    static uint16_t _name_index_marker;     // _count_marker when last built
+    static bool _name_index_valid;
+    static bool _name_index_built;          // a build has been attempted
+    static HAL_Semaphore _name_index_sem;
+#endif
+
+#if AP_PARAM_OFFSET_INDEX_ENABLED
+    /*
+      open addressed hash table giving the storage offset of each
+      saved variable, built by load_all() and updated as variables are
+      added. Slots hold an offset (0 for empty) and are matched against
+      the header in storage, so a slot is only 2 bytes. While not valid
+      scan() walks storage instead
+     */
+    static uint16_t *_offset_index;
+    static uint16_t _offset_index_size;     // number of slots, a power of 2
+    static uint16_t _offset_index_count;    // number of slots in use
+    static bool _offset_index_valid;
+    static HAL_Semaphore _offset_index_sem;
+#endif
 };
 
 namespace AP {
@@ -905,7 +1042,14 @@ public:
     /// Value setter
     ///
     void set(const T &v) {
+#if AP_PARAM_CHANGE_JOURNAL_SET_ENABLED
+        if (memcmp(&_value, &v, sizeof(T)) != 0) {
+            _value = v;
+            record_set(this, sizeof(T));
+        }
+#else
         _value = v;
+#endif
     }
 
     // set a parameter that is an ENABLE param
@@ -1047,7 +1191,14 @@ public:
     /// Value setter
     ///
     void set(const T &v) {
+#if AP_PARAM_CHANGE_JOURNAL_SET_ENABLED
+        if (memcmp(&_value, &v, sizeof(T)) != 0) {
+            _value = v;
+            record_set(this, sizeof(T));
+        }
+#else
         _value = v;
+#endif
     }
 
     /// Value setter - set value, tell GCS
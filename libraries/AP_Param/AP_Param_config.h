@@ -11,3 +11,49 @@
 #ifndef FORCE_APJ_DEFAULT_PARAMETERS
 #define FORCE_APJ_DEFAULT_PARAMETERS 0
 #endif
+
+// keep an in-RAM index of parameter storage offsets so lookups don't
+// need to walk storage
+#ifndef AP_PARAM_OFFSET_INDEX_ENABLED
+#define AP_PARAM_OFFSET_INDEX_ENABLED (HAL_MEM_CLASS >= HAL_MEM_CLASS_300)
+#endif
+
+// keep a hash index of parameter names for find_by_name()
+#ifndef AP_PARAM_NAME_INDEX_ENABLED
+#define AP_PARAM_NAME_INDEX_ENABLED (HAL_MEM_CLASS >= HAL_MEM_CLASS_1000)
+#endif
+
+// maximum number of parameters in the name index. Above this
+// find_by_name() walks the parameter tree
+#ifndef AP_PARAM_NAME_INDEX_MAX
+#define AP_PARAM_NAME_INDEX_MAX 4096
+#endif
+
+// keep a short journal of changed parameters so that a GCS can
+// download only the parameters changed since an earlier download
+#ifndef AP_PARAM_CHANGE_JOURNAL_ENABLED
+#define AP_PARAM_CHANGE_JOURNAL_ENABLED AP_FILESYSTEM_PARAM_ENABLED
+#endif
+
+#ifndef AP_PARAM_CHANGE_JOURNAL_SIZE
+#define AP_PARAM_CHANGE_JOURNAL_SIZE 64
+#endif
+
+// also journal changes made with set(), not only those notified or
+// saved. A set() which changes the value marks the variable in a
+// small lock-free table, which costs a memcmp and an atomic load once
+// the variable is marked, so it is cheap enough for the loop rate
+// changes made by hover throttle learning and autotune. The marks are
+// moved into the journal when a download or log asks for the change
+// sequence. Without it delta downloads can't be trusted and are
+// refused, so a GCS always gets every parameter
+#ifndef AP_PARAM_CHANGE_JOURNAL_SET_ENABLED
+#define AP_PARAM_CHANGE_JOURNAL_SET_ENABLED AP_PARAM_CHANGE_JOURNAL_ENABLED
+#endif
+
+// number of variables changed with set() which can be waiting to be
+// moved into the journal. Once it is full set() takes the journal
+// lock instead
+#ifndef AP_PARAM_CHANGE_SET_PENDING_SIZE
+#define AP_PARAM_CHANGE_SET_PENDING_SIZE 32
+#endif
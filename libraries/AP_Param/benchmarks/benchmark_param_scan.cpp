@@ -0,0 +1,130 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  measure the boot time cost of AP_Param::load_all(), the cost of
+  saving and loading single parameters and of finding parameters by
+  name with a few hundred parameters in storage
+ */
+#include <AP_gbenchmark.h>
+
+#include <AP_Param/AP_Param.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#define PARAMS_PER_GROUP 60
+#define NUM_GROUPS 8
+
+class BenchGroup {
+public:
+    BenchGroup() {
+        AP_Param::setup_object_defaults(this, var_info);
+    }
+    static const struct AP_Param::GroupInfo var_info[];
+    AP_Float p[PARAMS_PER_GROUP];
+};
+
+#define BENCH_PARAM(n) AP_GROUPINFO("P" #n, n+1, BenchGroup, p[n], 0)
+#define BENCH_PARAM10(n) BENCH_PARAM(n##0), BENCH_PARAM(n##1), BENCH_PARAM(n##2), BENCH_PARAM(n##3), BENCH_PARAM(n##4), \
+                         BENCH_PARAM(n##5), BENCH_PARAM(n##6), BENCH_PARAM(n##7), BENCH_PARAM(n##8), BENCH_PARAM(n##9)
+
+const AP_Param::GroupInfo BenchGroup::var_info[] = {
+    BENCH_PARAM(0), BENCH_PARAM(1), BENCH_PARAM(2), BENCH_PARAM(3), BENCH_PARAM(4),
+    BENCH_PARAM(5), BENCH_PARAM(6), BENCH_PARAM(7), BENCH_PARAM(8), BENCH_PARAM(9),
+    BENCH_PARAM10(1), BENCH_PARAM10(2), BENCH_PARAM10(3), BENCH_PARAM10(4), BENCH_PARAM10(5),
+    AP_GROUPEND
+};
+
+static BenchGroup groups[NUM_GROUPS];
+
+#define BENCH_GROUP(n) { "G" #n "_", (const void *)&groups[n], { group_info : BenchGroup::var_info }, 0, n+1, AP_PARAM_GROUP }
+
+static const AP_Param::Info var_info[] = {
+    BENCH_GROUP(0), BENCH_GROUP(1), BENCH_GROUP(2), BENCH_GROUP(3),
+    BENCH_GROUP(4), BENCH_GROUP(5), BENCH_GROUP(6), BENCH_GROUP(7),
+    AP_VAREND
+};
+
+static AP_Param param_loader(var_info);
+
+// fill storage with a non-default value for every parameter
+static void setup_storage()
+{
+    static bool done;
+    if (done) {
+        return;
+    }
+    done = true;
+    AP_Param::setup();
+    AP_Param::erase_all();
+    for (uint8_t g = 0; g < NUM_GROUPS; g++) {
+        for (uint8_t i = 0; i < PARAMS_PER_GROUP; i++) {
+            groups[g].p[i].set(g * PARAMS_PER_GROUP + i + 1);
+            groups[g].p[i].save_sync(true, false);
+        }
+    }
+    AP_Param::load_all();
+}
+
+static void BM_ParamLoadAll(benchmark::State& state)
+{
+    setup_storage();
+    while (state.KeepRunning()) {
+        bool ret = AP_Param::load_all();
+        gbenchmark_escape(&ret);
+    }
+}
+
+// save every parameter, as in a bulk upload from a GCS
+static void BM_ParamSaveSyncAll(benchmark::State& state)
+{
+    setup_storage();
+    while (state.KeepRunning()) {
+        for (uint8_t g = 0; g < NUM_GROUPS; g++) {
+            for (uint8_t i = 0; i < PARAMS_PER_GROUP; i++) {
+                groups[g].p[i].save_sync(false, false);
+            }
+        }
+    }
+}
+
+// load a parameter near the end of storage
+static void BM_ParamLoadLast(benchmark::State& state)
+{
+    setup_storage();
+    AP_Float &p = groups[NUM_GROUPS-1].p[PARAMS_PER_GROUP-1];
+    while (state.KeepRunning()) {
+        bool ret = p.load();
+        gbenchmark_escape(&ret);
+    }
+}
+
+// find the last parameter by name, as for a PARAM_SET or a script
+static void BM_ParamFindByName(benchmark::State& state)
+{
+    setup_storage();
+    while (state.KeepRunning()) {
+        enum ap_var_type type;
+        AP_Param::ParamToken token;
+        AP_Param *ap = AP_Param::find_by_name("G7_P59", &type, &token);
+        gbenchmark_escape(ap);
+    }
+}
+
+BENCHMARK(BM_ParamLoadAll);
+BENCHMARK(BM_ParamSaveSyncAll);
+BENCHMARK(BM_ParamLoadLast);
+BENCHMARK(BM_ParamFindByName);
+
+BENCHMARK_MAIN();
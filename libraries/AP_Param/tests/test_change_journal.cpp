@@ -0,0 +1,147 @@
+#include <AP_gtest.h>
+
+/*
+  check changes made with set() alone, as tuning knobs, autotune and
+  scripting make them, reach the parameter change journal which
+  param.pck deltas and the log header cache rely on
+ */
+
+#include <AP_Param/AP_Param.h>
+#include <AP_Math/AP_Math.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_PARAM_CHANGE_JOURNAL_SET_ENABLED
+
+class AP_Param_Test
+{
+public:
+    // as AP_Param::setup() does once static constructors have run
+    static void activate()
+    {
+        AP_Param::_change_journal_active = true;
+    }
+
+    // true if var is in the changes after since, up to now
+    static bool changed_since(uint32_t since, const AP_Param &var)
+    {
+        AP_Param::ChangedVar vars[AP_PARAM_CHANGE_JOURNAL_SIZE];
+        const uint8_t n = AP_Param::changed_between(since, AP_Param::change_seq(), vars);
+        for (uint8_t i = 0; i < n; i++) {
+            if (vars[i].contains(&var)) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+static AP_Float f1;
+static AP_Float f2;
+static AP_Int8 i1;
+static AP_Vector3f v1;
+static AP_Float many[AP_PARAM_CHANGE_JOURNAL_SIZE + 10];
+
+TEST(AP_Param, SetReachesJournal)
+{
+    AP_Param_Test::activate();
+    const uint32_t seq0 = AP_Param::change_seq();
+
+    f1.set(1.5);
+    const uint32_t seq1 = AP_Param::change_seq();
+    EXPECT_GT(seq1, seq0);
+    EXPECT_TRUE(AP_Param::change_journal_covers(seq0));
+    EXPECT_TRUE(AP_Param_Test::changed_since(seq0, f1));
+    EXPECT_FALSE(AP_Param_Test::changed_since(seq0, f2));
+
+    // setting the same value is not a change
+    f1.set(1.5);
+    EXPECT_EQ(AP_Param::change_seq(), seq1);
+
+    // many changes of one variable between downloads, as hover
+    // throttle learning makes, are one change
+    for (uint16_t i = 0; i < 1000; i++) {
+        f1.set(i * 0.1);
+    }
+    const uint32_t seq2 = AP_Param::change_seq();
+    EXPECT_EQ(seq2, seq1 + 1);
+    EXPECT_TRUE(AP_Param_Test::changed_since(seq1, f1));
+
+    // a change after a download is in the next delta, but not in
+    // the one before it
+    f2.set(2);
+    i1.set(3);
+    const uint32_t seq3 = AP_Param::change_seq();
+    EXPECT_TRUE(AP_Param_Test::changed_since(seq2, f2));
+    EXPECT_TRUE(AP_Param_Test::changed_since(seq2, i1));
+    EXPECT_FALSE(AP_Param_Test::changed_since(seq2, f1));
+    f1.set(7);
+    EXPECT_TRUE(AP_Param_Test::changed_since(seq3, f1));
+    EXPECT_FALSE(AP_Param_Test::changed_since(seq3, f2));
+}
+
+// a vector covers all of its elements
+TEST(AP_Param, SetVector)
+{
+    AP_Param_Test::activate();
+    const uint32_t seq0 = AP_Param::change_seq();
+    v1.set(Vector3f{1, 2, 3});
+    AP_Param::ChangedVar vars[AP_PARAM_CHANGE_JOURNAL_SIZE];
+    const uint8_t n = AP_Param::changed_between(seq0, AP_Param::change_seq(), vars);
+    ASSERT_EQ(n, 1U);
+    for (uint8_t i = 0; i < 3; i++) {
+        EXPECT_TRUE(vars[0].contains((const AP_Param *)&v1.get()[i]));
+    }
+}
+
+// more changes than the journal holds, including more than fit in
+// the set() pending table, are either all in the journal or the
+// journal no longer covers the earlier sequence number
+TEST(AP_Param, SetOverflow)
+{
+    AP_Param_Test::activate();
+    uint32_t seq0 = AP_Param::change_seq();
+    const uint8_t few = AP_PARAM_CHANGE_JOURNAL_SIZE / 2;
+    for (uint8_t i = 0; i < few; i++) {
+        many[i].set(i + 1);
+    }
+    ASSERT_TRUE(AP_Param::change_journal_covers(seq0));
+    for (uint8_t i = 0; i < few; i++) {
+        EXPECT_TRUE(AP_Param_Test::changed_since(seq0, many[i])) << "var " << i;
+    }
+
+    seq0 = AP_Param::change_seq();
+    for (uint8_t i = 0; i < ARRAY_SIZE(many); i++) {
+        many[i].set(-(i + 1));
+    }
+    EXPECT_FALSE(AP_Param::change_journal_covers(seq0));
+}
+
+/*
+  the log header cache keeps its PARM messages while the change
+  sequence hasn't moved and the journal still covers it, so the
+  sequence must only move on a change, and must move on any change
+ */
+TEST(AP_Param, ChangeSeqForLogCache)
+{
+    AP_Param_Test::activate();
+    const uint32_t seq0 = AP_Param::change_seq();
+    EXPECT_EQ(AP_Param::change_seq(), seq0);
+    f2.set(f2.get());
+    EXPECT_EQ(AP_Param::change_seq(), seq0);
+    EXPECT_TRUE(AP_Param::change_journal_covers(seq0));
+
+    f2.set(f2.get() + 1);
+    const uint32_t seq1 = AP_Param::change_seq();
+    EXPECT_NE(seq1, seq0);
+    EXPECT_TRUE(AP_Param::change_journal_covers(seq0));
+
+    // parameters appearing or disappearing invalidate everything
+    AP_Param::invalidate_count();
+    EXPECT_NE(AP_Param::change_seq(), seq1);
+    EXPECT_FALSE(AP_Param::change_journal_covers(seq1));
+}
+
+#endif  // AP_PARAM_CHANGE_JOURNAL_SET_ENABLED
+
+AP_GTEST_MAIN()
@@ -438,6 +438,9 @@ void AP_Scheduler::update_logging()
     if (_log_performance_bit != (uint32_t)-1 &&
         AP::logger().should_log(_log_performance_bit)) {
         Log_Write_Performance();
+#if AP_SCHEDULER_LATENCY_HISTOGRAM_ENABLED
+        Log_Write_Latency_Histograms();
+#endif
     }
     perf_info.set_loop_rate(get_loop_rate_hz());
     perf_info.reset();
@@ -478,13 +481,68 @@ void AP_Scheduler::Log_Write_Performance()
     };
     AP::logger().WriteCriticalBlock(&pkt, sizeof(pkt));
 }
+
+#if AP_SCHEDULER_LATENCY_HISTOGRAM_ENABLED
+// write latency percentiles for the main loop and each task that has run
+void AP_Scheduler::Log_Write_Latency_Histograms()
+{
+    const uint64_t now_us = AP_HAL::micros64();
+
+    const AP::PerfInfo::LatencyHistogram &lh = perf_info.get_loop_histogram();
+    const uint32_t max_loop_us = perf_info.get_max_time();
+    const struct log_PerfHistogram loop_pkt {
+        LOG_PACKET_HEADER_INIT(LOG_PERF_HISTOGRAM_MSG),
+        time_us : now_us,
+        task    : LOG_PERF_HISTOGRAM_LOOP,
+        count   : uint16_t(MIN(lh.total_count(), uint32_t(UINT16_MAX))),
+        p50     : uint16_t(MIN(lh.percentile(50, max_loop_us), uint32_t(UINT16_MAX))),
+        p95     : uint16_t(MIN(lh.percentile(95, max_loop_us), uint32_t(UINT16_MAX))),
+        p99     : uint16_t(MIN(lh.percentile(99, max_loop_us), uint32_t(UINT16_MAX))),
+        max     : uint16_t(MIN(max_loop_us, uint32_t(UINT16_MAX))),
+    };
+    AP::logger().WriteBlock(&loop_pkt, sizeof(loop_pkt));
+
+    for (uint8_t i = 0; i < _num_tasks; i++) {
+        const AP::PerfInfo::TaskInfo *ti = perf_info.get_task_info(i);
+        if (ti == nullptr) {
+            // task info is not being recorded
+            return;
+        }
+        if (ti->tick_count == 0) {
+            continue;
+        }
+        const struct log_PerfHistogram pkt {
+            LOG_PACKET_HEADER_INIT(LOG_PERF_HISTOGRAM_MSG),
+            time_us : now_us,
+            task    : i,
+            count   : uint16_t(MIN(ti->tick_count, uint32_t(UINT16_MAX))),
+            p50     : uint16_t(ti->histogram.percentile(50, ti->max_time_us)),
+            p95     : uint16_t(ti->histogram.percentile(95, ti->max_time_us)),
+            p99     : uint16_t(ti->histogram.percentile(99, ti->max_time_us)),
+            max     : ti->max_time_us,
+        };
+        AP::logger().WriteBlock(&pkt, sizeof(pkt));
+    }
+}
+#endif  // AP_SCHEDULER_LATENCY_HISTOGRAM_ENABLED
 #endif  // HAL_LOGGING_ENABLED
 
 // display task statistics as text buffer for @SYS/tasks.txt
 void AP_Scheduler::task_info(ExpandingString &str)
 {
     // a header to allow for machine parsers to determine format
+#if AP_SCHEDULER_LATENCY_HISTOGRAM_ENABLED
+    str.printf("TasksV3\n");
+    const AP::PerfInfo::LatencyHistogram &lh = perf_info.get_loop_histogram();
+    const uint32_t max_loop_us = perf_info.get_max_time();
+    str.printf("%-32.32s MAX=%5u P50=%5u P95=%5u P99=%5u\n", "loop",
+               unsigned(MIN(max_loop_us, 99999U)),
+               unsigned(MIN(lh.percentile(50, max_loop_us), 99999U)),
+               unsigned(MIN(lh.percentile(95, max_loop_us), 99999U)),
+               unsigned(MIN(lh.percentile(99, max_loop_us), 99999U)));
+#else
     str.printf("TasksV2\n");
+#endif
 
     // dynamically enable statistics collection
     if (!(_options & uint8_t(Options::RECORD_TASK_INFO))) {
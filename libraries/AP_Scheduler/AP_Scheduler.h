@@ -115,6 +115,10 @@ public:
 
     // write out PERF message to logger
     void Log_Write_Performance();
+#if AP_SCHEDULER_LATENCY_HISTOGRAM_ENABLED
+    // write out PMH latency percentile messages to logger
+    void Log_Write_Latency_Histograms();
+#endif
 
     // call when one tick has passed
     void tick(void);
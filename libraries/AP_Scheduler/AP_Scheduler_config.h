@@ -9,3 +9,7 @@
 #ifndef AP_SCHEDULER_EXTENDED_TASKINFO_ENABLED
 #define AP_SCHEDULER_EXTENDED_TASKINFO_ENABLED 1
 #endif
+
+#ifndef AP_SCHEDULER_LATENCY_HISTOGRAM_ENABLED
+#define AP_SCHEDULER_LATENCY_HISTOGRAM_ENABLED AP_SCHEDULER_EXTENDED_TASKINFO_ENABLED
+#endif
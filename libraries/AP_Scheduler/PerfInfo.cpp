@@ -31,6 +31,9 @@ void AP::PerfInfo::reset()
     long_running = 0;
     sigma_time = 0;
     sigmasquared_time = 0;
+#if AP_SCHEDULER_LATENCY_HISTOGRAM_ENABLED
+    memset(&loop_histogram, 0, sizeof(loop_histogram));
+#endif
     if (_task_info != nullptr) {
         memset(_task_info, 0, (_num_tasks) * sizeof(TaskInfo));
     }
@@ -89,6 +92,9 @@ void AP::PerfInfo::TaskInfo::update(uint16_t task_time_us, bool overrun)
     if (overrun) {
         overrun_count++;
     }
+#if AP_SCHEDULER_LATENCY_HISTOGRAM_ENABLED
+    histogram.record(task_time_us);
+#endif
 }
 
 void AP::PerfInfo::TaskInfo::print(const char* task_name, uint32_t total_time, ExpandingString& str) const
@@ -99,6 +105,15 @@ void AP::PerfInfo::TaskInfo::print(const char* task_name, uint32_t total_time, E
         pct = elapsed_time_us * 100.0f / total_time;
         avg = MIN(uint16_t(elapsed_time_us / tick_count), 9999);
     }
+#if AP_SCHEDULER_LATENCY_HISTOGRAM_ENABLED
+    const char* fmt = "%-32.32s MIN=%4u MAX=%4u AVG=%4u P50=%4u P95=%4u P99=%4u OVR=%3u SLP=%3u, TOT=%4.1f%%\n";
+    str.printf(fmt, task_name,
+                unsigned(MIN(min_time_us, 9999)), unsigned(MIN(max_time_us, 9999)), unsigned(avg),
+                unsigned(MIN(histogram.percentile(50, max_time_us), 9999)),
+                unsigned(MIN(histogram.percentile(95, max_time_us), 9999)),
+                unsigned(MIN(histogram.percentile(99, max_time_us), 9999)),
+                unsigned(MIN(overrun_count, 999)), unsigned(MIN(slip_count, 999)), pct);
+#else
 #if AP_SCHEDULER_EXTENDED_TASKINFO_ENABLED
     const char* fmt = "%-32.32s MIN=%4u MAX=%4u AVG=%4u OVR=%3u SLP=%3u, TOT=%4.1f%%\n";
 #else
@@ -107,8 +122,62 @@ void AP::PerfInfo::TaskInfo::print(const char* task_name, uint32_t total_time, E
     str.printf(fmt, task_name,
                 unsigned(MIN(min_time_us, 9999)), unsigned(MIN(max_time_us, 9999)), unsigned(avg),
                 unsigned(MIN(overrun_count, 999)), unsigned(MIN(slip_count, 999)), pct);
+#endif
 }
 
+#if AP_SCHEDULER_LATENCY_HISTOGRAM_ENABLED
+/*
+  buckets 0 and 1 hold times of 0us and 1us. Above that each octave
+  [2^n, 2^(n+1)) is split into two buckets on the bit below the most
+  significant bit
+ */
+void AP::PerfInfo::LatencyHistogram::record(uint32_t time_us)
+{
+    uint8_t bucket;
+    if (time_us < 2) {
+        bucket = time_us;
+    } else {
+        const uint8_t msb = 31 - __builtin_clz(time_us);
+        bucket = MIN(uint8_t(2 * msb + ((time_us >> (msb - 1)) & 1U)), uint8_t(NUM_BUCKETS - 1));
+    }
+    if (counts[bucket] < UINT16_MAX) {
+        counts[bucket]++;
+    }
+}
+
+uint32_t AP::PerfInfo::LatencyHistogram::total_count() const
+{
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < NUM_BUCKETS; i++) {
+        total += counts[i];
+    }
+    return total;
+}
+
+uint32_t AP::PerfInfo::LatencyHistogram::percentile(uint8_t pct, uint32_t max_us) const
+{
+    const uint32_t total = total_count();
+    if (total == 0) {
+        return 0;
+    }
+    // rank of the sample we want, rounded up
+    const uint32_t rank = (total * pct + 99) / 100;
+    uint32_t count = 0;
+    for (uint8_t i = 0; i < NUM_BUCKETS - 1; i++) {
+        count += counts[i];
+        if (count >= rank) {
+            if (i < 2) {
+                return i;
+            }
+            const uint8_t msb = i / 2;
+            const uint32_t lower = (1U << msb) + (i & 1U) * (1U << (msb - 1));
+            return MIN(lower + (1U << (msb - 1)) - 1, max_us);
+        }
+    }
+    return max_us;
+}
+#endif  // AP_SCHEDULER_LATENCY_HISTOGRAM_ENABLED
+
 // check_loop_time - check latest loop time vs min, max and overtime threshold
 void AP::PerfInfo::check_loop_time(uint32_t time_in_micros)
 {
@@ -131,6 +200,9 @@ void AP::PerfInfo::check_loop_time(uint32_t time_in_micros)
     }
     sigma_time += time_in_micros;
     sigmasquared_time += time_in_micros * time_in_micros;
+#if AP_SCHEDULER_LATENCY_HISTOGRAM_ENABLED
+    loop_histogram.record(time_in_micros);
+#endif
 
     /* we keep a filtered loop time for use as G_Dt which is the
        predicted time for the next loop. We remove really excessive
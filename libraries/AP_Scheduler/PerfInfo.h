@@ -13,6 +13,25 @@ class PerfInfo {
 public:
     PerfInfo() {}
 
+#if AP_SCHEDULER_LATENCY_HISTOGRAM_ENABLED
+    /*
+      histogram of times in microseconds with buckets half an octave
+      wide, so recording a time is a count-leading-zeros and an
+      increment. Times of 49152us and above go in the last bucket
+     */
+    struct LatencyHistogram {
+        static const uint8_t NUM_BUCKETS = 32;
+        uint16_t counts[NUM_BUCKETS];
+
+        void record(uint32_t time_us);
+        // return the time in microseconds below which pct percent of
+        // the recorded times fall, reported as the upper bound of the
+        // bucket and limited to max_us
+        uint32_t percentile(uint8_t pct, uint32_t max_us) const;
+        uint32_t total_count() const;
+    };
+#endif
+
     // per-task timing information
     struct TaskInfo {
         uint16_t min_time_us;
@@ -21,6 +40,9 @@ public:
         uint32_t tick_count;
         uint16_t slip_count;
         uint16_t overrun_count;
+#if AP_SCHEDULER_LATENCY_HISTOGRAM_ENABLED
+        LatencyHistogram histogram;
+#endif
 
         void update(uint16_t task_time_us, bool overrun);
         void print(const char* task_name, uint32_t total_time, ExpandingString& str) const;
@@ -41,6 +63,10 @@ public:
     float    get_filtered_time() const;
     float get_filtered_loop_rate_hz() const;
     void set_loop_rate(uint16_t rate_hz);
+#if AP_SCHEDULER_LATENCY_HISTOGRAM_ENABLED
+    // histogram of main loop times since the last reset
+    const LatencyHistogram &get_loop_histogram() const { return loop_histogram; }
+#endif
 
     void update_logging() const;
 
@@ -74,6 +100,9 @@ private:
     uint32_t last_check_us;
     float filtered_loop_time;
     bool ignore_loop;
+#if AP_SCHEDULER_LATENCY_HISTOGRAM_ENABLED
+    LatencyHistogram loop_histogram;
+#endif
     // performance monitoring
     uint8_t _num_tasks;
     TaskInfo* _task_info;
@@ -80,7 +80,7 @@ const AP_Param::GroupInfo AP_Terrain::var_info[] = {
 
     // @Param: CACHE_SZ
     // @DisplayName: Terrain cache size
-    // @Description: The number of 32x28 cache blocks to keep in memory. Each block uses about 1800 bytes of memory
+    // @Description: The number of 32x28 cache blocks to keep in memory. Each block uses about 1800 bytes of memory. Blocks beyond the first 12 are used to load terrain data along the upcoming mission legs ahead of time
     // @Range: 0 128
     // @User: Advanced
     AP_GROUPINFO("CACHE_SZ",  5, AP_Terrain, config_cache_size, TERRAIN_GRID_BLOCK_CACHE_SIZE),
@@ -135,7 +135,23 @@ bool AP_Terrain::height_amsl(const Location &loc, float &height, bool corrected)
     calculate_grid_info(loc, info);
 
     // find the grid
+#if AP_TERRAIN_MMAP_ENABLED
+    // held until we are done with the block as it may be in a mapped file
+    WITH_SEMAPHORE(mmap_sem);
+    const struct grid_block *mapped_grid = mmap_find_block(info);
+    if (mapped_grid != nullptr &&
+        (!check_bitmap(*mapped_grid, info.idx_x,   info.idx_y) ||
+         !check_bitmap(*mapped_grid, info.idx_x,   info.idx_y+1) ||
+         !check_bitmap(*mapped_grid, info.idx_x+1, info.idx_y) ||
+         !check_bitmap(*mapped_grid, info.idx_x+1, info.idx_y+1))) {
+        // not all on disk yet, use the cache which will request the
+        // missing data
+        mapped_grid = nullptr;
+    }
+    const struct grid_block &grid = mapped_grid != nullptr ? *mapped_grid : find_grid_cache(info).grid;
+#else
     const struct grid_block &grid = find_grid_cache(info).grid;
+#endif
 
     /*
       note that we rely on the one square overlap to ensure these
@@ -387,6 +403,11 @@ void AP_Terrain::update(void)
     update_rally_data();
 #endif
 
+    // load blocks along the mission path before we need them
+    if (pos_valid) {
+        update_mission_prefetch(loc);
+    }
+
     // update tiles surrounding our current location:
     if (pos_valid) {
         have_surrounding_tiles = update_surrounding_tiles(loc);
@@ -463,10 +484,11 @@ void AP_Terrain::log_terrain_data()
     float terrain_height = 0;
     float current_height = 0;
     uint16_t pending, loaded;
+    uint32_t hits, misses;
 
     height_amsl(loc, terrain_height);
     height_above_terrain(current_height, true);
-    get_statistics(pending, loaded);
+    get_statistics(pending, loaded, hits, misses);
 
     struct log_TERRAIN pkt = {
         LOG_PACKET_HEADER_INIT(LOG_TERRAIN_MSG),
@@ -480,6 +502,8 @@ void AP_Terrain::log_terrain_data()
         pending        : pending,
         loaded         : loaded,
         reference_offset : have_reference_offset?reference_offset:0,
+        cache_hits     : hits,
+        cache_misses   : misses,
     };
     AP::logger().WriteBlock(&pkt, sizeof(pkt));
 }
@@ -497,13 +521,38 @@ bool AP_Terrain::allocate(void)
     if (cache != nullptr) {
         return true;
     }
+    // use at least twice as many hash buckets as blocks to keep chains short
+    cache_hash_size = 1;
+    while (cache_hash_size < 2*config_cache_size) {
+        cache_hash_size <<= 1;
+    }
     cache = (struct grid_cache *)calloc(config_cache_size, sizeof(cache[0]));
-    if (cache == nullptr) {
+    cache_hash = (uint16_t *)calloc(cache_hash_size, sizeof(cache_hash[0]));
+    if (cache == nullptr || cache_hash == nullptr) {
+        free(cache);
+        free(cache_hash);
+        cache = nullptr;
+        cache_hash = nullptr;
         GCS_SEND_TEXT(MAV_SEVERITY_CRITICAL, "Terrain: Allocation failed");
         memory_alloc_failed = true;
         return false;
     }
     cache_size = config_cache_size;
+
+    // hash table starts empty. The LRU list is ordered so that blocks
+    // are first used in index order
+    for (uint16_t i=0; i<cache_hash_size; i++) {
+        cache_hash[i] = TERRAIN_CACHE_IDX_NONE;
+    }
+    for (uint16_t i=0; i<cache_size; i++) {
+        cache[i].hash_bucket = TERRAIN_CACHE_IDX_NONE;
+        cache[i].hash_next = TERRAIN_CACHE_IDX_NONE;
+        cache[i].lru_prev = (i+1 < cache_size) ? i+1 : TERRAIN_CACHE_IDX_NONE;
+        cache[i].lru_next = (i > 0) ? i-1 : TERRAIN_CACHE_IDX_NONE;
+    }
+    lru_head = cache_size - 1;
+    lru_tail = 0;
+    prefetch_count = 0;
     return true;
 }
 
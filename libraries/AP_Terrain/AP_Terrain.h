@@ -50,6 +50,23 @@
 #define TERRAIN_GRID_BLOCK_CACHE_SIZE 12
 #endif
 
+// number of cache blocks kept for the area around the vehicle and
+// home. Only cache blocks beyond this are used to prefetch blocks
+// along the mission path
+#define TERRAIN_PREFETCH_RESERVED_BLOCKS 12
+
+// marks the end of a cache hash chain or LRU list
+#define TERRAIN_CACHE_IDX_NONE UINT16_MAX
+
+#if AP_TERRAIN_MMAP_ENABLED
+// number of degree files kept memory mapped
+#define TERRAIN_MMAP_NUM_FILES 4
+
+// number of blocks per mapped file remembered as having passed the
+// crc check
+#define TERRAIN_MMAP_NUM_VALIDATED 8
+#endif
+
 // format of grid on disk
 #define TERRAIN_GRID_FORMAT_VERSION 1
 
@@ -76,6 +93,8 @@
  */
 
 class AP_Terrain {
+    friend class AP_Terrain_Test;
+
 public:
     AP_Terrain();
 
@@ -186,6 +205,9 @@ public:
       get some statistics for TERRAIN_REPORT
      */
     void get_statistics(uint16_t &pending, uint16_t &loaded) const;
+    // as above, also returning the number of cache lookups which
+    // found (hits) or did not find (misses) the grid block in memory
+    void get_statistics(uint16_t &pending, uint16_t &loaded, uint32_t &hits, uint32_t &misses) const;
 
     /*
       get grid spacing in meters
@@ -265,8 +287,17 @@ private:
 
         volatile enum GridCacheState state;
 
-        // the last time access was requested to this block, used for LRU
-        uint32_t last_access_ms;
+        // hash bucket holding this block and the next block in the
+        // same bucket, TERRAIN_CACHE_IDX_NONE if not in the hash table
+        uint16_t hash_bucket;
+        uint16_t hash_next;
+
+        // neighbours in the LRU list, prev is more recently used
+        uint16_t lru_prev;
+        uint16_t lru_next;
+
+        // loaded ahead of the vehicle and not looked up since
+        bool prefetched;
     };
 
     /*
@@ -304,7 +335,16 @@ private:
     /*
       find a grid structure given a grid_info
     */
-    struct grid_cache &find_grid_cache(const struct grid_info &info);
+    struct grid_cache &find_grid_cache(const struct grid_info &info, bool prefetch=false);
+
+    // hash bucket for the grid block described by a grid_info
+    uint16_t grid_cache_bucket(const struct grid_info &info) const;
+
+    // mark a cache block as the most recently used
+    void cache_touch(uint16_t idx);
+
+    // remove a cache block from the hash table
+    void cache_hash_remove(uint16_t idx);
 
     /*
       calculate bit number in grid_block bitmap. This corresponds to a
@@ -340,13 +380,13 @@ private:
       disk IO functions
      */
     int16_t find_io_idx(enum GridCacheState state);
-    uint16_t get_block_crc(struct grid_block &block);
+    uint16_t get_block_crc(const struct grid_block &block) const;
     void check_disk_read(void);
     void check_disk_write(void);
     void io_timer(void);
     void open_file(void);
     void seek_offset(void);
-    uint32_t east_blocks(struct grid_block &block) const;
+    uint32_t east_blocks(int8_t lat_degrees, int16_t lon_degrees) const;
     void write_block(void);
     void read_block(void);
 
@@ -358,6 +398,68 @@ private:
      */
     void update_mission_data(void);
 
+#if AP_TERRAIN_MMAP_ENABLED
+    /*
+      memory mapped degree files, giving lookups direct access to
+      blocks on disk without a copy or a trip through io_timer(). Files
+      are only opened and mapped by mmap_update() on the IO thread,
+      lookups use whatever is already mapped
+     */
+    struct mmap_region {
+        const uint8_t *base;    // nullptr if not mapped
+        uint32_t length;        // bytes mapped, a whole number of blocks
+        int fd;
+    };
+    struct mmap_file {
+        bool in_use;
+        bool want_map;          // lookup wants the file (re)mapped
+        struct mmap_region region;
+        int8_t lat_degrees;
+        int16_t lon_degrees;
+        uint16_t spacing;       // grid_spacing that east_blocks was calculated for
+        uint32_t east_blocks;
+        uint32_t last_check_ms; // last time the file was (re)opened or checked for growth
+        uint32_t last_used_ms;
+        // blocks which have passed the crc check with a given bitmap and crc
+        struct {
+            uint32_t blocknum;
+            uint64_t bitmap;
+            uint16_t crc;
+        } validated[TERRAIN_MMAP_NUM_VALIDATED];
+        uint8_t validated_next;
+    };
+    struct mmap_file mmap_files[TERRAIN_MMAP_NUM_FILES] {};
+
+    // degree square a lookup found no mapping for, handled by mmap_update()
+    struct {
+        bool pending;
+        int8_t lat_degrees;
+        int16_t lon_degrees;
+    } mmap_request {};
+
+    // protects mmap_files and mmap_request, taken for the whole of a
+    // lookup so a mapping can't be removed while in use. Never held
+    // during file IO
+    HAL_Semaphore mmap_sem;
+
+    /*
+      find the block described by a grid_info in a mapped file. Returns
+      nullptr if the block is not mapped or fails validation. Must be
+      called with mmap_sem held
+     */
+    const struct grid_block *mmap_find_block(const struct grid_info &info);
+    void mmap_update(void);
+    bool mmap_map(int8_t lat_degrees, int16_t lon_degrees, const struct mmap_region &old, struct mmap_region &region) const;
+    void mmap_release(const struct mmap_region &region, int keep_fd) const;
+    bool mmap_validate(struct mmap_file &mf, uint32_t blocknum, const struct grid_block &block);
+#endif
+
+    /*
+      load grid blocks along the upcoming mission legs into the cache
+     */
+    void update_mission_prefetch(const Location &loc);
+    uint16_t prefetch_leg(const Location &start, const Location &end, uint16_t max_blocks);
+
     /*
       check for missing rally data
      */
@@ -385,6 +487,28 @@ private:
     uint8_t cache_size = 0;
     struct grid_cache *cache = nullptr;
 
+    // hash table of cache indexes, chained through grid_cache::hash_next
+    uint16_t *cache_hash = nullptr;
+    uint16_t cache_hash_size;   // number of buckets, a power of 2
+
+    // most and least recently used cache blocks
+    uint16_t lru_head;
+    uint16_t lru_tail;
+
+    // protects the hash table and LRU list, find_grid_cache() may be
+    // called from scripting as well as the main thread
+    HAL_Semaphore cache_sem;
+
+    // cache lookup statistics
+    uint32_t cache_hits;
+    uint32_t cache_misses;
+
+    // number of cache blocks with prefetched set
+    uint16_t prefetch_count;
+
+    // last time blocks along the mission were prefetched
+    uint32_t last_prefetch_ms;
+
     // a grid_cache block waiting for disk IO
     enum DiskIoState {
         DiskIoIdle      = 0,
@@ -189,6 +189,16 @@ void AP_Terrain::get_statistics(uint16_t &pending, uint16_t &loaded) const
     }
 }
 
+/*
+  get some statistics for TERRAIN_REPORT plus cache hit/miss counts
+*/
+void AP_Terrain::get_statistics(uint16_t &pending, uint16_t &loaded, uint32_t &hits, uint32_t &misses) const
+{
+    get_statistics(pending, loaded);
+    hits = cache_hits;
+    misses = cache_misses;
+}
+
 #if HAL_GCS_ENABLED
 /*
    handle terrain messages from GCS
@@ -114,6 +114,83 @@ void AP_Terrain::update_mission_data(void)
 #endif  // AP_MISSION_ENABLED
 }
 
+/*
+  touch each grid block along a line from start to end so it is
+  loaded into the cache, stopping after max_blocks blocks.  Returns
+  the number of blocks touched
+ */
+uint16_t AP_Terrain::prefetch_leg(const Location &start, const Location &end, uint16_t max_blocks)
+{
+    // step less than a block so that no block on the line is missed
+    const float step_m = MIN(TERRAIN_GRID_BLOCK_SPACING_X, TERRAIN_GRID_BLOCK_SPACING_Y) * 0.7f * grid_spacing;
+    const float distance_m = start.get_distance(end);
+    const float bearing_deg = start.get_bearing_to(end) * 0.01f;
+
+    uint16_t count = 0;
+    int32_t last_grid_lat = 0;
+    int32_t last_grid_lon = 0;
+    for (float d=0; count < max_blocks; d += step_m) {
+        Location loc = start;
+        loc.offset_bearing(bearing_deg, MIN(d, distance_m));
+        struct grid_info info;
+        calculate_grid_info(loc, info);
+        if (count == 0 || info.grid_lat != last_grid_lat || info.grid_lon != last_grid_lon) {
+            find_grid_cache(info, true);
+            last_grid_lat = info.grid_lat;
+            last_grid_lon = info.grid_lon;
+            count++;
+        }
+        if (d >= distance_m) {
+            break;
+        }
+    }
+    return count;
+}
+
+/*
+  load the grid blocks along the current mission leg and the leg
+  after it into the cache ahead of the vehicle. Only the part of the
+  cache beyond TERRAIN_PREFETCH_RESERVED_BLOCKS is used so that blocks
+  around the vehicle are not evicted
+ */
+void AP_Terrain::update_mission_prefetch(const Location &loc)
+{
+#if AP_MISSION_ENABLED
+    if (cache_size <= TERRAIN_PREFETCH_RESERVED_BLOCKS) {
+        return;
+    }
+
+    const uint32_t now_ms = AP_HAL::millis();
+    if (now_ms - last_prefetch_ms < 1000) {
+        return;
+    }
+    last_prefetch_ms = now_ms;
+
+    AP_Mission *mission = AP::mission();
+    if (mission == nullptr || mission->state() != AP_Mission::MISSION_RUNNING) {
+        return;
+    }
+
+    uint16_t max_blocks = cache_size - TERRAIN_PREFETCH_RESERVED_BLOCKS;
+
+    // current leg
+    const AP_Mission::Mission_Command &nav_cmd = mission->get_current_nav_cmd();
+    if (nav_cmd.content.location.lat == 0 && nav_cmd.content.location.lng == 0) {
+        return;
+    }
+    max_blocks -= prefetch_leg(loc, nav_cmd.content.location, max_blocks);
+
+    // leg after it
+    AP_Mission::Mission_Command next_cmd;
+    if (max_blocks == 0 ||
+        !mission->get_next_nav_cmd(nav_cmd.index+1, next_cmd) ||
+        (next_cmd.content.location.lat == 0 && next_cmd.content.location.lng == 0)) {
+        return;
+    }
+    prefetch_leg(nav_cmd.content.location, next_cmd.content.location, max_blocks);
+#endif  // AP_MISSION_ENABLED
+}
+
 #if HAL_RALLY_ENABLED
 /*
   check that we have fetched all rally terrain data
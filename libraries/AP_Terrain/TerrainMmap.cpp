@@ -0,0 +1,304 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  memory mapped access to terrain degree files
+
+  On boards with a POSIX filesystem the degree files written by the IO
+  thread are mapped read-only so that height lookups can use blocks
+  on disk directly, without copying them into the block cache and
+  waiting for io_timer(). The mapping is shared, so blocks written by
+  write_block() become visible without remapping. Anything which
+  can't be found or fails validation falls back to the block cache,
+  which also takes care of requesting missing data from the GCS.
+
+  Lookups never open, stat or map a file. A lookup which finds no
+  mapping, or a block past the end of a mapping, asks for it and
+  falls back to the block cache. mmap_update(), called from
+  io_timer(), then opens and maps the file, or remaps it once it has
+  grown.
+ */
+
+#include "AP_Terrain.h"
+
+#if AP_TERRAIN_MMAP_ENABLED
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdio.h>
+
+extern const AP_HAL::HAL& hal;
+
+// how often to retry a missing file or check a mapped file for growth
+#define TERRAIN_MMAP_CHECK_MS 1000
+
+/*
+  find the block described by a grid_info in a mapped file
+ */
+const struct AP_Terrain::grid_block *AP_Terrain::mmap_find_block(const struct grid_info &info)
+{
+    struct mmap_file *mf = nullptr;
+    for (auto &f : mmap_files) {
+        if (f.in_use &&
+            f.lat_degrees == info.lat_degrees &&
+            f.lon_degrees == info.lon_degrees) {
+            mf = &f;
+            break;
+        }
+    }
+    if (mf == nullptr) {
+        // ask the IO thread to map the file
+        mmap_request.pending = true;
+        mmap_request.lat_degrees = info.lat_degrees;
+        mmap_request.lon_degrees = info.lon_degrees;
+        return nullptr;
+    }
+    mf->last_used_ms = AP_HAL::millis();
+
+    if (mf->spacing != grid_spacing) {
+        // offsets of blocks within the file depend on the grid spacing
+        mf->east_blocks = east_blocks(mf->lat_degrees, mf->lon_degrees);
+        mf->spacing = grid_spacing;
+        mf->validated_next = 0;
+        memset(mf->validated, 0, sizeof(mf->validated));
+    }
+
+    const uint32_t blocknum = mf->east_blocks * info.grid_idx_x + info.grid_idx_y;
+    const uint32_t file_offset = blocknum * sizeof(union grid_io_block);
+    if (mf->region.base == nullptr ||
+        file_offset + sizeof(union grid_io_block) > mf->region.length) {
+        // the file may have been created or grown since it was mapped
+        mf->want_map = true;
+        return nullptr;
+    }
+
+    const struct grid_block &block = *(const struct grid_block *)&mf->region.base[file_offset];
+    if (!TERRAIN_LATLON_EQUAL(block.lat, info.grid_lat) ||
+        !TERRAIN_LATLON_EQUAL(block.lon, info.grid_lon) ||
+        block.bitmap == 0 ||
+        block.spacing != grid_spacing ||
+        block.version != TERRAIN_GRID_FORMAT_VERSION ||
+        !mmap_validate(*mf, blocknum, block)) {
+        return nullptr;
+    }
+    return &block;
+}
+
+/*
+  check the crc of a mapped block. The result is remembered until the
+  bitmap or stored crc changes, so the crc of a block in use is not
+  recalculated on every lookup
+ */
+bool AP_Terrain::mmap_validate(struct mmap_file &mf, uint32_t blocknum, const struct grid_block &block)
+{
+    const uint64_t bitmap = block.bitmap;
+    const uint16_t crc = block.crc;
+    for (const auto &v : mf.validated) {
+        if (v.blocknum == blocknum && v.bitmap == bitmap && v.crc == crc) {
+            return true;
+        }
+    }
+    if (crc != get_block_crc(block)) {
+        // possibly a block part way through being written
+        return false;
+    }
+    mf.validated[mf.validated_next].blocknum = blocknum;
+    mf.validated[mf.validated_next].bitmap = bitmap;
+    mf.validated[mf.validated_next].crc = crc;
+    mf.validated_next = (mf.validated_next + 1) % TERRAIN_MMAP_NUM_VALIDATED;
+    return true;
+}
+
+/*
+  map files requested by lookups and remap files which have grown.
+  Called from io_timer(). mmap_sem is only held while looking at or
+  changing mmap_files, never while opening or mapping a file, so
+  lookups are not held up by file IO
+ */
+void AP_Terrain::mmap_update(void)
+{
+    const uint32_t now = AP_HAL::millis();
+    struct mmap_region replaced {nullptr, 0, -1};
+    struct mmap_file *mf = nullptr;
+    struct mmap_region old;
+    int8_t lat_degrees = 0;
+    int16_t lon_degrees = 0;
+
+    {
+        WITH_SEMAPHORE(mmap_sem);
+
+        if (mmap_request.pending) {
+            mmap_request.pending = false;
+            struct mmap_file *oldest = &mmap_files[0];
+            bool found = false;
+            for (auto &f : mmap_files) {
+                if (f.in_use &&
+                    f.lat_degrees == mmap_request.lat_degrees &&
+                    f.lon_degrees == mmap_request.lon_degrees) {
+                    found = true;
+                    break;
+                }
+                if (!f.in_use) {
+                    oldest = &f;
+                } else if (oldest->in_use && now - f.last_used_ms > now - oldest->last_used_ms) {
+                    oldest = &f;
+                }
+            }
+            if (!found) {
+                // replace the least recently used mapping, which is
+                // removed once we no longer hold mmap_sem
+                struct mmap_file &f = *oldest;
+                if (f.in_use) {
+                    replaced = f.region;
+                }
+                memset(&f, 0, sizeof(f));
+                f.in_use = true;
+                f.want_map = true;
+                f.region.fd = -1;
+                f.lat_degrees = mmap_request.lat_degrees;
+                f.lon_degrees = mmap_request.lon_degrees;
+                f.spacing = grid_spacing;
+                f.east_blocks = east_blocks(f.lat_degrees, f.lon_degrees);
+                f.last_used_ms = now;
+                // map straight away
+                f.last_check_ms = now - TERRAIN_MMAP_CHECK_MS;
+            }
+        }
+
+        // one file at a time, missing files and files which may have
+        // grown are rechecked at most once every TERRAIN_MMAP_CHECK_MS
+        for (auto &f : mmap_files) {
+            if (f.in_use && f.want_map &&
+                now - f.last_check_ms >= TERRAIN_MMAP_CHECK_MS) {
+                f.want_map = false;
+                f.last_check_ms = now;
+                mf = &f;
+                old = f.region;
+                lat_degrees = f.lat_degrees;
+                lon_degrees = f.lon_degrees;
+                break;
+            }
+        }
+    }
+
+    mmap_release(replaced, -1);
+
+    // only the IO thread changes which square a mmap_file is for, so
+    // mf still describes the same file when we install the new mapping
+    struct mmap_region region;
+    if (mf == nullptr || !mmap_map(lat_degrees, lon_degrees, old, region)) {
+        return;
+    }
+    {
+        WITH_SEMAPHORE(mmap_sem);
+        mf->region = region;
+    }
+    mmap_release(old, region.fd);
+}
+
+/*
+  map the degree file for a square, or remap it if it has grown. old
+  is the current mapping, which is left alone so lookups can keep
+  using it until the new one is installed. Returns true if region
+  should replace old, which includes an empty region if the file has
+  shrunk
+ */
+bool AP_Terrain::mmap_map(int8_t lat_degrees, int16_t lon_degrees, const struct mmap_region &old, struct mmap_region &region) const
+{
+    const bool mapped = old.base != nullptr;
+    int fd = old.fd;
+    if (!mapped) {
+        const char* terrain_dir = hal.util->get_custom_terrain_directory();
+        if (terrain_dir == nullptr) {
+            terrain_dir = HAL_BOARD_TERRAIN_DIRECTORY;
+        }
+        uint32_t lat_tmp = abs((int32_t)lat_degrees);
+        if (lat_tmp > 99U) {
+            lat_tmp = 99U;
+        }
+        uint32_t lon_tmp = abs((int32_t)lon_degrees);
+        if (lon_tmp > 999U) {
+            lon_tmp = 999;
+        }
+        char path[128];
+        if (hal.util->snprintf(path, sizeof(path), "%s/%c%02u%c%03u.DAT",
+                               terrain_dir,
+                               lat_degrees<0?'S':'N',
+                               (unsigned)lat_tmp,
+                               lon_degrees<0?'W':'E',
+                               (unsigned)lon_tmp) >= (int)sizeof(path)) {
+            return false;
+        }
+        fd = ::open(path, O_RDONLY|O_CLOEXEC);
+        if (fd == -1) {
+            return false;
+        }
+    }
+
+    // only map whole blocks, a partly written last block can't be used
+    struct stat st;
+    uint32_t length = 0;
+    if (::fstat(fd, &st) == 0) {
+        length = (st.st_size / sizeof(union grid_io_block)) * sizeof(union grid_io_block);
+    }
+    if (mapped && length < old.length) {
+        // reading a mapping beyond the end of a file faults, so drop it
+        region = {nullptr, 0, -1};
+        return true;
+    }
+    if (length == 0 || length <= old.length) {
+        // empty or not grown
+        if (!mapped) {
+            ::close(fd);
+        }
+        return false;
+    }
+
+    void *base = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        if (!mapped) {
+            ::close(fd);
+        }
+        return false;
+    }
+    region.base = (const uint8_t *)base;
+    region.length = length;
+    region.fd = fd;
+#if TERRAIN_DEBUG
+    hal.console->printf("Terrain: mapped %u blocks for %d %d\n",
+                        (unsigned)(length / sizeof(union grid_io_block)),
+                        (int)lat_degrees, (int)lon_degrees);
+#endif
+    return true;
+}
+
+/*
+  remove a mapping which lookups can no longer see, closing its file
+  unless it is keep_fd
+ */
+void AP_Terrain::mmap_release(const struct mmap_region &region, int keep_fd) const
+{
+    if (region.base != nullptr) {
+        ::munmap(const_cast<uint8_t *>(region.base), region.length);
+    }
+    if (region.fd != -1 && region.fd != keep_fd) {
+        ::close(region.fd);
+    }
+}
+
+#endif // AP_TERRAIN_MMAP_ENABLED
@@ -102,29 +102,123 @@ void AP_Terrain::calculate_grid_info(const Location &loc, struct grid_info &info
 
 
 /*
-  find a grid structure given a grid_info
+  hash bucket for the grid block described by a grid_info. Blocks are
+  identified by their degree square and index within it, which unlike
+  the corner lat/lon are exact
  */
-AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info)
+uint16_t AP_Terrain::grid_cache_bucket(const struct grid_info &info) const
 {
-    uint16_t oldest_i = 0;
+    const uint32_t h = (uint32_t(info.grid_idx_x) * 73856093U) ^
+                       (uint32_t(info.grid_idx_y) * 19349663U) ^
+                       (uint32_t(info.lat_degrees + 90) * 83492791U) ^
+                       (uint32_t(info.lon_degrees + 180) * 2654435761U);
+    return (h ^ (h >> 16)) & (cache_hash_size - 1);
+}
+
+/*
+  mark a cache block as the most recently used
+ */
+void AP_Terrain::cache_touch(uint16_t idx)
+{
+    if (idx == lru_head) {
+        return;
+    }
+    struct grid_cache &gcache = cache[idx];
+
+    // unlink
+    cache[gcache.lru_prev].lru_next = gcache.lru_next;
+    if (gcache.lru_next != TERRAIN_CACHE_IDX_NONE) {
+        cache[gcache.lru_next].lru_prev = gcache.lru_prev;
+    } else {
+        lru_tail = gcache.lru_prev;
+    }
+
+    // insert at head
+    gcache.lru_prev = TERRAIN_CACHE_IDX_NONE;
+    gcache.lru_next = lru_head;
+    cache[lru_head].lru_prev = idx;
+    lru_head = idx;
+}
+
+/*
+  remove a cache block from the hash table
+ */
+void AP_Terrain::cache_hash_remove(uint16_t idx)
+{
+    struct grid_cache &gcache = cache[idx];
+    if (gcache.hash_bucket == TERRAIN_CACHE_IDX_NONE) {
+        return;
+    }
+    uint16_t *link = &cache_hash[gcache.hash_bucket];
+    while (*link != TERRAIN_CACHE_IDX_NONE) {
+        if (*link == idx) {
+            *link = gcache.hash_next;
+            break;
+        }
+        link = &cache[*link].hash_next;
+    }
+    gcache.hash_bucket = TERRAIN_CACHE_IDX_NONE;
+    gcache.hash_next = TERRAIN_CACHE_IDX_NONE;
+}
+
+/*
+  find a grid structure given a grid_info. Prefetch lookups may only
+  take the cache blocks beyond TERRAIN_PREFETCH_RESERVED_BLOCKS, once
+  they are all in use the least recently used prefetched block is
+  replaced instead
+ */
+AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info, bool prefetch)
+{
+    WITH_SEMAPHORE(cache_sem);
+
+    const uint16_t bucket = grid_cache_bucket(info);
 
     // see if we have that grid
-    for (uint16_t i=0; i<cache_size; i++) {
+    for (uint16_t i=cache_hash[bucket]; i != TERRAIN_CACHE_IDX_NONE; i=cache[i].hash_next) {
         if (TERRAIN_LATLON_EQUAL(cache[i].grid.lat,info.grid_lat) &&
             TERRAIN_LATLON_EQUAL(cache[i].grid.lon,info.grid_lon) &&
             cache[i].grid.spacing == grid_spacing) {
-            cache[i].last_access_ms = AP_HAL::millis();
+            if (!prefetch) {
+                if (cache[i].prefetched) {
+                    // the vehicle has reached it
+                    cache[i].prefetched = false;
+                    prefetch_count--;
+                }
+                cache_hits++;
+            }
+            cache_touch(i);
             return cache[i];
         }
-        if (cache[i].last_access_ms < cache[oldest_i].last_access_ms) {
-            oldest_i = i;
-        }
+    }
+    if (!prefetch) {
+        cache_misses++;
     }
 
-    // Not found. Use the oldest grid and make it this grid,
-    // initially unpopulated
-    struct grid_cache &grid = cache[oldest_i];
-    memset(&grid, 0, sizeof(grid));
+    // Not found. Use the least recently used grid and make it this
+    // grid, initially unpopulated
+    uint16_t idx = lru_tail;
+    if (prefetch && prefetch_count + TERRAIN_PREFETCH_RESERVED_BLOCKS >= cache_size) {
+        // prefetching is limited to once a second so a walk of the
+        // list is fine. As the cache is larger than the reserved
+        // blocks there is at least one prefetched block
+        while (idx != TERRAIN_CACHE_IDX_NONE && !cache[idx].prefetched) {
+            idx = cache[idx].lru_prev;
+        }
+        if (idx == TERRAIN_CACHE_IDX_NONE) {
+            idx = lru_tail;
+        }
+    }
+    struct grid_cache &grid = cache[idx];
+    cache_hash_remove(idx);
+    if (grid.prefetched != prefetch) {
+        grid.prefetched = prefetch;
+        if (prefetch) {
+            prefetch_count++;
+        } else {
+            prefetch_count--;
+        }
+    }
+    memset(&grid.grid, 0, sizeof(grid.grid));
 
     grid.grid.lat = info.grid_lat;
     grid.grid.lon = info.grid_lon;
@@ -134,7 +228,11 @@ AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info
     grid.grid.lat_degrees = info.lat_degrees;
     grid.grid.lon_degrees = info.lon_degrees;
     grid.grid.version = TERRAIN_GRID_FORMAT_VERSION;
-    grid.last_access_ms = AP_HAL::millis();
+
+    grid.hash_bucket = bucket;
+    grid.hash_next = cache_hash[bucket];
+    cache_hash[bucket] = idx;
+    cache_touch(idx);
 
     // mark as waiting for disk read
     grid.state = GRID_CACHE_DISKWAIT;
@@ -168,12 +266,17 @@ int16_t AP_Terrain::find_io_idx(enum GridCacheState state)
 /*
   get CRC for a block
  */
-uint16_t AP_Terrain::get_block_crc(struct grid_block &block)
+uint16_t AP_Terrain::get_block_crc(const struct grid_block &block) const
 {
-    uint16_t saved_crc = block.crc;
-    block.crc = 0;
-    uint16_t ret = crc16_ccitt((const uint8_t *)&block, sizeof(block), 0);
-    block.crc = saved_crc;
+    // the crc is taken with the crc field as zero. Calculate it in
+    // pieces rather than clearing the field so that blocks in read-only
+    // memory can be checked
+    const uint8_t zero[sizeof(block.crc)] {};
+    const uint8_t *b = (const uint8_t *)&block;
+    const uint16_t crc_ofs = offsetof(struct grid_block, crc);
+    uint16_t ret = crc16_ccitt(b, crc_ofs, 0);
+    ret = crc16_ccitt(zero, sizeof(zero), ret);
+    ret = crc16_ccitt(&b[crc_ofs + sizeof(block.crc)], sizeof(block) - (crc_ofs + sizeof(block.crc)), ret);
     return ret;
 }
 
@@ -0,0 +1,216 @@
+#include <AP_gtest.h>
+
+/*
+  tests for the memory mapped terrain lookup path, checking mapped
+  blocks against the same blocks read with read_block()
+ */
+
+#include <AP_Terrain/AP_Terrain.h>
+#include <AP_HAL/AP_HAL.h>
+#include <unistd.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_TERRAIN_MMAP_ENABLED
+
+// a degree square no real terrain data is likely to be in
+#define TEST_LAT_DEGREES -80
+#define TEST_LON_DEGREES -170
+#define TEST_FILE HAL_BOARD_TERRAIN_DIRECTORY "/S80W170.DAT"
+
+// AP_Terrain is a singleton, so the tests share one
+static AP_Terrain terrain;
+
+class AP_Terrain_Test
+{
+public:
+    AP_Terrain_Test()
+    {
+        terrain.grid_spacing.set(100);
+        reset();
+    }
+
+    ~AP_Terrain_Test()
+    {
+        reset();
+    }
+
+    // grid_info for a point north_deg and east_deg into the test square
+    AP_Terrain::grid_info info_for(float north_deg, float east_deg) const
+    {
+        Location loc;
+        loc.lat = (TEST_LAT_DEGREES + north_deg) * 1.0e7;
+        loc.lng = (TEST_LON_DEGREES + east_deg) * 1.0e7;
+        AP_Terrain::grid_info info;
+        terrain.calculate_grid_info(loc, info);
+        return info;
+    }
+
+    // write a block the way io_timer() does
+    void write(const AP_Terrain::grid_info &info, uint64_t bitmap, int16_t height_base)
+    {
+        setup_disk_block(info);
+        AP_Terrain::grid_block &block = terrain.disk_block.block;
+        block.bitmap = bitmap;
+        for (uint8_t x=0; x<TERRAIN_GRID_BLOCK_SIZE_X; x++) {
+            for (uint8_t y=0; y<TERRAIN_GRID_BLOCK_SIZE_Y; y++) {
+                block.height[x][y] = height_base + x * TERRAIN_GRID_BLOCK_SIZE_Y + y;
+            }
+        }
+        terrain.open_file();
+        ASSERT_NE(terrain.fd, -1);
+        terrain.write_block();
+        ASSERT_FALSE(terrain.io_failure);
+    }
+
+    // read a block the way io_timer() does, leaving it in disk_block
+    const AP_Terrain::grid_block &read(const AP_Terrain::grid_info &info)
+    {
+        setup_disk_block(info);
+        terrain.open_file();
+        EXPECT_NE(terrain.fd, -1);
+        terrain.read_block();
+        return terrain.disk_block.block;
+    }
+
+    const AP_Terrain::grid_block *find_mapped(const AP_Terrain::grid_info &info)
+    {
+        WITH_SEMAPHORE(terrain.mmap_sem);
+        return terrain.mmap_find_block(info);
+    }
+
+    // check the mapped block matches the one read with read_block()
+    void check_mapped(const AP_Terrain::grid_info &info)
+    {
+        const AP_Terrain::grid_block *mapped = find_mapped(info);
+        ASSERT_NE(mapped, nullptr);
+        const AP_Terrain::grid_block &block = read(info);
+        // copies, as the fields of the packed blocks can't be bound to references
+        ASSERT_NE(uint64_t(block.bitmap), 0U);
+        EXPECT_EQ(uint64_t(mapped->bitmap), uint64_t(block.bitmap));
+        EXPECT_EQ(int32_t(mapped->lat), int32_t(block.lat));
+        EXPECT_EQ(int32_t(mapped->lon), int32_t(block.lon));
+        EXPECT_EQ(memcmp(mapped->height, block.height, sizeof(block.height)), 0);
+    }
+
+    // run the IO thread's part of the mapping
+    void io_update()
+    {
+        terrain.mmap_update();
+    }
+
+    bool request_pending() const
+    {
+        return terrain.mmap_request.pending;
+    }
+
+    // let mmap_update() recheck files without waiting
+    void expire_checks()
+    {
+        for (auto &mf : terrain.mmap_files) {
+            mf.last_check_ms -= 2000;
+        }
+    }
+
+private:
+    // remove all mappings, the open degree file and the test file
+    void reset()
+    {
+        for (auto &mf : terrain.mmap_files) {
+            if (mf.in_use) {
+                terrain.mmap_release(mf.region, -1);
+            }
+        }
+        memset(terrain.mmap_files, 0, sizeof(terrain.mmap_files));
+        terrain.mmap_request.pending = false;
+        if (terrain.fd != -1) {
+            ::close(terrain.fd);
+            terrain.fd = -1;
+        }
+        unlink(TEST_FILE);
+    }
+
+    void setup_disk_block(const AP_Terrain::grid_info &info)
+    {
+        memset(&terrain.disk_block, 0, sizeof(terrain.disk_block));
+        AP_Terrain::grid_block &block = terrain.disk_block.block;
+        block.lat = info.grid_lat;
+        block.lon = info.grid_lon;
+        block.spacing = terrain.grid_spacing;
+        block.grid_idx_x = info.grid_idx_x;
+        block.grid_idx_y = info.grid_idx_y;
+        block.lat_degrees = info.lat_degrees;
+        block.lon_degrees = info.lon_degrees;
+        block.version = TERRAIN_GRID_FORMAT_VERSION;
+    }
+};
+
+TEST(AP_Terrain, MmapMatchesReadBlock)
+{
+    AP_Terrain_Test t;
+    const auto info = t.info_for(0.1, 0.1);
+    ASSERT_EQ(info.lat_degrees, TEST_LAT_DEGREES);
+    ASSERT_EQ(info.lon_degrees, TEST_LON_DEGREES);
+
+    // nothing is mapped until the IO thread has seen a request
+    t.write(info, 0x0F, 100);
+    EXPECT_EQ(t.find_mapped(info), nullptr);
+    EXPECT_TRUE(t.request_pending());
+    t.io_update();
+    EXPECT_FALSE(t.request_pending());
+    t.check_mapped(info);
+
+    // rewritten blocks are seen through the existing mapping, both
+    // with more grids and with the same grids changed
+    t.write(info, 0xFF, 200);
+    t.check_mapped(info);
+    EXPECT_EQ(int16_t(t.find_mapped(info)->height[0][0]), 200);
+    t.write(info, 0xFF, 300);
+    t.check_mapped(info);
+    EXPECT_EQ(int16_t(t.find_mapped(info)->height[0][0]), 300);
+}
+
+TEST(AP_Terrain, MmapFileGrows)
+{
+    AP_Terrain_Test t;
+    const auto info = t.info_for(0.1, 0.1);
+    t.write(info, 0x0F, 100);
+    EXPECT_EQ(t.find_mapped(info), nullptr);
+    t.io_update();
+    t.check_mapped(info);
+
+    // a block further north is past the end of the mapping until the
+    // IO thread next checks the file
+    const auto info_north = t.info_for(0.5, 0.1);
+    ASSERT_GT(info_north.grid_idx_x, info.grid_idx_x);
+    t.write(info_north, 0x3F, 500);
+    EXPECT_EQ(t.find_mapped(info_north), nullptr);
+    t.io_update();
+    EXPECT_EQ(t.find_mapped(info_north), nullptr);
+    t.expire_checks();
+    t.io_update();
+    t.check_mapped(info_north);
+    t.check_mapped(info);
+}
+
+TEST(AP_Terrain, MmapMissingFile)
+{
+    AP_Terrain_Test t;
+    const auto info = t.info_for(0.1, 0.1);
+
+    // no file, the lookup keeps asking and the IO thread retries
+    EXPECT_EQ(t.find_mapped(info), nullptr);
+    t.io_update();
+    EXPECT_EQ(t.find_mapped(info), nullptr);
+
+    t.write(info, 0x0F, 100);
+    t.io_update();
+    EXPECT_EQ(t.find_mapped(info), nullptr);
+    t.expire_checks();
+    t.io_update();
+    t.check_mapped(info);
+}
+
+#endif // AP_TERRAIN_MMAP_ENABLED
+
+AP_GTEST_MAIN()
@@ -942,6 +942,7 @@ void AP_Vehicle::reboot(bool hold_in_bootloader)
 
     // flush pending parameter writes
     AP_Param::flush();
+    StorageManager::flush();
 
     // do not process incoming mavlink messages while we delay:
     hal.scheduler->register_delay_callback(nullptr, 5);
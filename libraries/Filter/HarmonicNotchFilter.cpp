@@ -219,8 +219,10 @@ void HarmonicNotchFilter<T>::allocate_filters(uint8_t num_notches, uint32_t harm
 
     if (_num_filters > 0) {
         _filters = NEW_NOTHROW NotchFilter<T>[_num_filters];
-        if (_filters == nullptr) {
+        if (_filters == nullptr || !_bank.resize(_num_filters)) {
             GCS_SEND_TEXT(MAV_SEVERITY_ERROR, "Failed to allocate %u bytes for notch filter", (unsigned int)(_num_filters * sizeof(NotchFilter<T>)));
+            delete[] _filters;
+            _filters = nullptr;
             _num_filters = 0;
         }
     }
@@ -245,7 +247,8 @@ void HarmonicNotchFilter<T>::expand_filter_count(uint16_t total_notches)
       AP_InertialSensor_Backend.cpp to make this thread safe
      */
     auto filters = NEW_NOTHROW NotchFilter<T>[total_notches];
-    if (filters == nullptr) {
+    if (filters == nullptr || !_bank.resize(total_notches)) {
+        delete[] filters;
         _alloc_has_failed = true;
         return;
     }
@@ -365,6 +368,12 @@ void HarmonicNotchFilter<T>::update(uint8_t num_centers, const float center_freq
         expand_filter_count(total_notches);
     }
 
+    // a reset is only complete once a sample has been applied, which
+    // the bank tracks for us
+    for (uint16_t i = 0; i < _num_filters; i++) {
+        _filters[i].need_reset = _bank.reset_pending(i);
+    }
+
     _num_enabled_filters = 0;
 
     // update all of the filters using the new center frequencies and existing A & Q
@@ -387,6 +396,10 @@ void HarmonicNotchFilter<T>::update(uint8_t num_centers, const float center_freq
             set_center_frequency(_num_enabled_filters++, notch_center, 1.0 + _notch_spread, harmonic_mul);
         }
     }
+
+    for (uint16_t i = 0; i < _num_enabled_filters; i++) {
+        _bank.set_coefficients(i, _filters[i]);
+    }
 }
 
 /*
@@ -404,25 +417,19 @@ T HarmonicNotchFilter<T>::apply(const T &sample)
     if (dfd == -1) {
         dfd = ::open("notch.txt", O_WRONLY|O_CREAT|O_TRUNC, 0644);
     }
-#endif
-
-    T output = sample;
     for (uint16_t i = 0; i < _num_enabled_filters; i++) {
-#if NOTCH_DEBUG_LOGGING
         if (!_filters[i].initialised) {
             ::dprintf(dfd, "------- ");
         } else {
             ::dprintf(dfd, "%.4f ", _filters[i]._center_freq_hz);
         }
-#endif
-        output = _filters[i].apply(output);
     }
-#if NOTCH_DEBUG_LOGGING
     if (_num_enabled_filters > 0) {
         ::dprintf(dfd, "\n");
     }
 #endif
-    return output;
+
+    return _bank.apply(sample, _num_enabled_filters);
 }
 
 /*
@@ -438,6 +445,7 @@ void HarmonicNotchFilter<T>::reset()
     for (uint16_t i = 0; i < _num_filters; i++) {
         _filters[i].reset();
     }
+    _bank.reset();
 }
 
 #if HAL_LOGGING_ENABLED
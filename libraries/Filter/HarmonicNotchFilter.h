@@ -18,6 +18,7 @@
 #include <cmath>
 #include <AP_Param/AP_Param.h>
 #include "NotchFilter.h"
+#include "NotchFilterBank.h"
 
 #define HNF_MAX_HARMONICS 16
 
@@ -62,6 +63,8 @@ public:
 private:
     // underlying bank of notch filters
     NotchFilter<T>*  _filters;
+    // coefficients and state of _filters laid out for apply()
+    NotchFilterBank<T> _bank;
     // sample frequency for each filter
     float _sample_freq_hz;
     // base double notch bandwidth for each filter
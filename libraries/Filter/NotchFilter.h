@@ -29,10 +29,14 @@
 template <class T>
 class HarmonicNotchFilter;
 
+template <class T>
+class NotchFilterBank;
+
 template <class T>
 class NotchFilter {
 public:
     friend class HarmonicNotchFilter<T>;
+    friend class NotchFilterBank<T>;
     // set parameters
     void init(float sample_freq_hz, float center_freq_hz, float bandwidth_hz, float attenuation_dB);
     void init_with_A_and_Q(float sample_freq_hz, float center_freq_hz, float A, float Q);
@@ -0,0 +1,184 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HAL_DEBUG_BUILD
+#define AP_INLINE_VECTOR_OPS
+#pragma GCC optimize("O2")
+#endif
+
+#include "NotchFilterBank.h"
+
+/*
+  allocate a new array of n elements, copying the first old_n from old
+  and freeing old. Returns nullptr on allocation failure, leaving old
+  untouched
+ */
+template <class E>
+static E *realloc_array(E *old, uint16_t old_n, uint16_t n)
+{
+    E *ret = NEW_NOTHROW E[n];
+    if (ret == nullptr) {
+        return nullptr;
+    }
+    if (old != nullptr) {
+        memcpy(ret, old, sizeof(E)*old_n);
+    }
+    return ret;
+}
+
+template <class T>
+NotchFilterBank<T>::~NotchFilterBank()
+{
+    free_arrays();
+}
+
+template <class T>
+void NotchFilterBank<T>::free_arrays()
+{
+    delete[] _b0;
+    delete[] _b1;
+    delete[] _b2;
+    delete[] _a1;
+    delete[] _a2;
+    delete[] _ntchsig1;
+    delete[] _ntchsig2;
+    delete[] _signal1;
+    delete[] _signal2;
+    delete[] _flags;
+}
+
+/*
+  resize the bank. All arrays are allocated before any are replaced so
+  that a failure leaves the bank as it was
+ */
+template <class T>
+bool NotchFilterBank<T>::resize(uint16_t count)
+{
+    if (count <= _size) {
+        return true;
+    }
+
+    float *b0 = realloc_array(_b0, _size, count);
+    float *b1 = realloc_array(_b1, _size, count);
+    float *b2 = realloc_array(_b2, _size, count);
+    float *a1 = realloc_array(_a1, _size, count);
+    float *a2 = realloc_array(_a2, _size, count);
+    T *ntchsig1 = realloc_array(_ntchsig1, _size, count);
+    T *ntchsig2 = realloc_array(_ntchsig2, _size, count);
+    T *signal1 = realloc_array(_signal1, _size, count);
+    T *signal2 = realloc_array(_signal2, _size, count);
+    uint8_t *flags = realloc_array(_flags, _size, count);
+
+    if (b0 == nullptr || b1 == nullptr || b2 == nullptr || a1 == nullptr || a2 == nullptr ||
+        ntchsig1 == nullptr || ntchsig2 == nullptr || signal1 == nullptr || signal2 == nullptr ||
+        flags == nullptr) {
+        delete[] b0;
+        delete[] b1;
+        delete[] b2;
+        delete[] a1;
+        delete[] a2;
+        delete[] ntchsig1;
+        delete[] ntchsig2;
+        delete[] signal1;
+        delete[] signal2;
+        delete[] flags;
+        return false;
+    }
+
+    // new slots start disabled and must be reset before use
+    for (uint16_t i = _size; i < count; i++) {
+        flags[i] = FLAG_NEED_RESET;
+    }
+
+    free_arrays();
+
+    _b0 = b0;
+    _b1 = b1;
+    _b2 = b2;
+    _a1 = a1;
+    _a2 = a2;
+    _ntchsig1 = ntchsig1;
+    _ntchsig2 = ntchsig2;
+    _signal1 = signal1;
+    _signal2 = signal2;
+    _flags = flags;
+    _size = count;
+
+    return true;
+}
+
+template <class T>
+void NotchFilterBank<T>::set_coefficients(uint16_t idx, const NotchFilter<T> &filter)
+{
+    if (idx >= _size) {
+        return;
+    }
+    if (!filter.initialised) {
+        _flags[idx] &= ~FLAG_ENABLED;
+        return;
+    }
+    _b0[idx] = filter.b0;
+    _b1[idx] = filter.b1;
+    _b2[idx] = filter.b2;
+    _a1[idx] = filter.a1;
+    _a2[idx] = filter.a2;
+    _flags[idx] |= FLAG_ENABLED;
+}
+
+/*
+  apply a sample to each slot in turn. This is the same calculation
+  as NotchFilter::apply(), including passing the sample through
+  unchanged for disabled slots and slots with a reset pending
+ */
+template <class T>
+T NotchFilterBank<T>::apply(const T &sample, uint16_t count)
+{
+    T output = sample;
+    count = MIN(count, _size);
+    for (uint16_t i = 0; i < count; i++) {
+        if (_flags[i] != FLAG_ENABLED) {
+            _signal1[i] = output;
+            _signal2[i] = output;
+            _ntchsig1[i] = output;
+            _ntchsig2[i] = output;
+            _flags[i] &= ~FLAG_NEED_RESET;
+            continue;
+        }
+
+        const T input = output;
+        output = input*_b0[i] + _ntchsig1[i]*_b1[i] + _ntchsig2[i]*_b2[i] - _signal1[i]*_a1[i] - _signal2[i]*_a2[i];
+
+        _ntchsig2[i] = _ntchsig1[i];
+        _ntchsig1[i] = input;
+
+        _signal2[i] = _signal1[i];
+        _signal1[i] = output;
+    }
+    return output;
+}
+
+template <class T>
+void NotchFilterBank<T>::reset()
+{
+    for (uint16_t i = 0; i < _size; i++) {
+        _flags[i] |= FLAG_NEED_RESET;
+    }
+}
+
+/*
+   instantiate template classes
+ */
+template class NotchFilterBank<float>;
+template class NotchFilterBank<Vector3f>;
@@ -0,0 +1,69 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*
+  a bank of notch filters applied in series, stored as a structure of
+  arrays so that the per-sample loop walks contiguous coefficient and
+  state arrays rather than a set of NotchFilter objects
+
+  Coefficients are calculated by NotchFilter and copied in with
+  set_coefficients(), so the output is identical to applying the same
+  NotchFilter objects one after another
+ */
+
+#include "NotchFilter.h"
+
+template <class T>
+class NotchFilterBank {
+public:
+    NotchFilterBank() = default;
+    CLASS_NO_COPY(NotchFilterBank);
+
+    ~NotchFilterBank();
+
+    // resize the bank, keeping the coefficients and state of existing slots
+    bool resize(uint16_t count) WARN_IF_UNUSED;
+
+    // copy the coefficients and enable state of a notch filter into a slot
+    void set_coefficients(uint16_t idx, const NotchFilter<T> &filter);
+
+    // apply a sample through the first count slots in turn
+    T apply(const T &sample, uint16_t count);
+
+    // reset the state of all slots on their next sample
+    void reset();
+
+    // true if a slot has a reset pending
+    bool reset_pending(uint16_t idx) const { return _flags[idx] & FLAG_NEED_RESET; }
+
+private:
+    enum {
+        FLAG_ENABLED    = 1U<<0,
+        FLAG_NEED_RESET = 1U<<1,
+    };
+
+    uint16_t _size;
+
+    // coefficients, one array per coefficient
+    float *_b0, *_b1, *_b2, *_a1, *_a2;
+
+    // filter state, one array per delay element
+    T *_ntchsig1, *_ntchsig2, *_signal1, *_signal2;
+
+    uint8_t *_flags;
+
+    void free_arrays();
+};
@@ -0,0 +1,89 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  compare the harmonic notch filter bank with applying each notch
+  filter in turn, for a double notch on three IMUs. The argument is the
+  number of harmonics
+ */
+#include <AP_gbenchmark.h>
+
+#include <Filter/HarmonicNotchFilter.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#define NUM_IMUS 3
+#define MAX_NOTCHES (HNF_MAX_HARMONICS*2)
+
+static const float rate_hz = 8000;
+static const float base_freq = 80;
+static const float bandwidth = 40;
+static const float attenuation_dB = 40;
+
+static Vector3f test_sample(uint32_t i)
+{
+    return Vector3f(sinf(i*0.1f), cosf(i*0.07f), sinf(i*0.03f));
+}
+
+static void BM_NotchFilterChain(benchmark::State& state)
+{
+    const uint8_t num_notches = state.range(0) * 2;
+    NotchFilter<Vector3f> filters[NUM_IMUS][MAX_NOTCHES] {};
+    for (uint8_t imu = 0; imu < NUM_IMUS; imu++) {
+        for (uint8_t n = 0; n < num_notches; n++) {
+            const float center = base_freq * (n/2 + 1) * (n % 2 ? 1.02 : 0.98);
+            filters[imu][n].init(rate_hz, center, bandwidth/2, attenuation_dB);
+        }
+    }
+    uint32_t i = 0;
+    while (state.KeepRunning()) {
+        const Vector3f sample = test_sample(i++);
+        for (uint8_t imu = 0; imu < NUM_IMUS; imu++) {
+            Vector3f v = sample;
+            for (uint8_t n = 0; n < num_notches; n++) {
+                v = filters[imu][n].apply(v);
+            }
+            gbenchmark_escape(&v);
+        }
+    }
+}
+
+static void BM_HarmonicNotchFilterBank(benchmark::State& state)
+{
+    const uint32_t harmonics = (1U << state.range(0)) - 1;
+    HarmonicNotchFilterParams params {};
+    params.set_options(uint16_t(HarmonicNotchFilterParams::Options::DoubleNotch));
+    params.set_attenuation(attenuation_dB);
+    params.set_bandwidth_hz(bandwidth);
+    params.set_center_freq_hz(base_freq);
+    params.set_freq_min_ratio(1.0);
+    HarmonicNotchFilter<Vector3f> filters[NUM_IMUS] {};
+    for (auto &f : filters) {
+        f.allocate_filters(1, harmonics, params.num_composite_notches());
+        f.init(rate_hz, params);
+    }
+    uint32_t i = 0;
+    while (state.KeepRunning()) {
+        const Vector3f sample = test_sample(i++);
+        for (auto &f : filters) {
+            Vector3f v = f.apply(sample);
+            gbenchmark_escape(&v);
+        }
+    }
+}
+
+BENCHMARK(BM_NotchFilterChain)->Arg(1)->Arg(2)->Arg(4)->Arg(8);
+BENCHMARK(BM_HarmonicNotchFilterBank)->Arg(1)->Arg(2)->Arg(4)->Arg(8);
+
+BENCHMARK_MAIN();
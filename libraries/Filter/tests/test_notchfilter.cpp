@@ -363,4 +363,73 @@ TEST(NotchFilterTest, HarmonicNotchTest5)
     fclose(f);
 }
 
+/*
+  check that the harmonic notch gives the same output as the
+  equivalent notch filters applied one after another
+ */
+TEST(NotchFilterTest, HarmonicNotchBankTest)
+{
+    const float base_freq = 80;
+    const float bandwidth = 40;
+    const float attenuation_dB = 40;
+    const uint16_t rate_hz = 2000;
+    const uint32_t samples = 20000;
+    const double dt = 1.0 / rate_hz;
+
+    HarmonicNotchFilter<Vector3f> filter {};
+    HarmonicNotchFilterParams notch_params {};
+    notch_params.set_options(uint16_t(HarmonicNotchFilterParams::Options::DoubleNotch));
+    notch_params.set_attenuation(attenuation_dB);
+    notch_params.set_bandwidth_hz(bandwidth);
+    notch_params.set_center_freq_hz(base_freq);
+    notch_params.set_freq_min_ratio(1.0);
+    filter.allocate_filters(1, 3, notch_params.num_composite_notches());
+    filter.init(rate_hz, notch_params);
+
+    // reference double notch on the first and second harmonic
+    float A, Q;
+    NotchFilter<Vector3f>::calculate_A_and_Q(base_freq, bandwidth/2, attenuation_dB, A, Q);
+    const float spread = bandwidth / (32 * base_freq);
+    const float spread_mul[2] { float(1.0 - spread), float(1.0 + spread) };
+    NotchFilter<Vector3f> reference[4] {};
+    auto update_reference = [&](float source_freq) {
+        for (uint8_t h=0; h<2; h++) {
+            const float notch_center = MAX(source_freq * (h+1), base_freq);
+            for (uint8_t n=0; n<2; n++) {
+                reference[h*2+n].init_with_A_and_Q(rate_hz, notch_center * spread_mul[n], A, Q);
+            }
+        }
+    };
+    update_reference(base_freq);
+
+    for (uint32_t s=0; s<samples; s++) {
+        const double t = s * dt;
+        // sweep the source frequency either side of the base frequency
+        const float source_freq = base_freq + 40 * sin(t * 2 * M_PI / 5);
+        filter.update(source_freq);
+        update_reference(source_freq);
+
+        if (s == samples/2) {
+            filter.reset();
+            for (auto &r : reference) {
+                r.reset();
+            }
+        }
+
+        const Vector3f sample {
+            float(sin(90 * t * 2 * M_PI)),
+            float(sin(160 * t * 2 * M_PI) * 0.5),
+            float(sin(40 * t * 2 * M_PI) + sin(200 * t * 2 * M_PI)),
+        };
+        const Vector3f v = filter.apply(sample);
+        Vector3f expected = sample;
+        for (auto &r : reference) {
+            expected = r.apply(expected);
+        }
+        EXPECT_NEAR(v.x, expected.x, 1.0e-5);
+        EXPECT_NEAR(v.y, expected.y, 1.0e-5);
+        EXPECT_NEAR(v.z, expected.z, 1.0e-5);
+    }
+}
+
 AP_GTEST_MAIN()
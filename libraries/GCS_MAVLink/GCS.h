@@ -214,6 +214,28 @@ public:
     // this is called when we discover we'd like to send something but can't:
     void out_of_space_to_send() { out_of_space_to_send_count++; }
 
+#if AP_MAVLINK_FTP_ENABLED
+    // MAVLink FTP throughput counters, shared by all links
+    struct FTPStats {
+        uint32_t bytes_sent;        // file data sent in read replies
+        uint32_t packets_sent;      // FILE_TRANSFER_PROTOCOL replies sent
+        uint32_t burst_packets;     // replies sent as part of burst reads
+        uint32_t rerequests;        // reads of data already sent in a burst
+        uint32_t bytes_per_second;  // file data sent over the last second
+    };
+    static void get_ftp_stats(FTPStats &stats) { stats = ftp.stats; }
+#endif
+
+#if AP_MAVLINK_STREAM_SCHEDULER_ENABLED
+    // rate requested for a message on this link and the rate it has
+    // recently been sent at.  Returns false if the message is not
+    // being streamed
+    bool get_stream_rates(ap_message id, float &requested_hz, float &achieved_hz) const;
+
+    // estimated throughput of this link in bytes per second
+    uint32_t link_bandwidth_estimate() const { return link_model.bytes_per_second; }
+#endif
+
     void send_mission_ack(const mavlink_message_t &msg,
                           MAV_MISSION_TYPE mission_type,
                           MAV_MISSION_RESULT result) const {
@@ -302,6 +324,8 @@ public:
     }
     static float telemetry_radio_rssi(); // 0==no signal, 1==full signal
     static bool last_txbuf_is_greater(uint8_t txbuf_limit);
+    // as last_txbuf_is_greater() for RADIO_STATUS received on this link
+    bool txbuf_is_greater(uint8_t txbuf_limit) const;
 
     // mission item index to be sent on queued msg, delayed or not
     uint16_t mission_item_reached_index = AP_MISSION_CMD_INDEX_NONE;
@@ -801,6 +825,9 @@ private:
         LOCKED = (1<<4),
     };
     void log_mavlink_stats();
+#if AP_MAVLINK_STREAM_SCHEDULER_ENABLED
+    void log_stream_rates();
+#endif
 
     MAV_RESULT _set_mode_common(const uint8_t base_mode, const uint32_t custom_mode);
 
@@ -877,6 +904,46 @@ private:
     void find_next_bucket_to_send(uint16_t now16_ms);
     void remove_message_from_bucket(int8_t bucket, ap_message id);
 
+#if AP_MAVLINK_STREAM_SCHEDULER_ENABLED
+    /*
+      streamed messages are sent against a token bucket filled at the
+      estimated throughput of the link.  High priority messages are
+      sent whenever there is space in the port; normal and low
+      priority messages need spare tokens, so they are the first to
+      be skipped when the link can't keep up
+     */
+    enum class MessagePriority : uint8_t {
+        LOW,
+        NORMAL,
+        HIGH,
+    };
+    MessagePriority ap_message_priority(ap_message id) const;
+
+    struct {
+        uint32_t last_update_ms;
+        uint16_t txspace_at_last_update; // txspace() at the end of the last update_send()
+        uint16_t txspace_max;       // largest txspace() seen, taken to mean the port buffer is empty
+        float bytes_per_second;     // estimated throughput of the link
+        float tokens;               // bytes which may be sent before exceeding the estimate
+        uint8_t radio_txbuf = 100;  // txbuf from the last RADIO_STATUS received on this link
+        uint32_t radio_txbuf_ms;
+    } link_model;
+    void update_link_model(uint32_t now_ms);
+    float link_model_burst_bytes() const;
+    bool stream_message_allowed(ap_message id) const;
+
+    // number of times each message was sent and skipped since
+    // start_ms.  Counts are halved every STREAM_STATS_PERIOD_MS so
+    // rates follow recent behaviour
+    static constexpr uint16_t STREAM_STATS_PERIOD_MS = 10000;
+    struct {
+        uint16_t sent[MSG_LAST];
+        uint16_t skipped[MSG_LAST];
+        uint32_t start_ms;
+    } stream_stats;
+    void update_stream_stats(uint32_t now_ms);
+#endif
+
     // bitmask of IDs the code has spontaneously decided it wants to
     // send out.  Examples include HEARTBEAT (gcs_send_heartbeat)
     Bitmask<MSG_LAST> pushed_ap_message_ids;
@@ -940,13 +1007,11 @@ private:
     static MAVLink_routing routing;
 
     struct pending_param_request {
-        mavlink_channel_t chan;
         int16_t param_index;
         char param_name[AP_MAX_NAME_SIZE+1];
     };
 
     struct pending_param_reply {
-        mavlink_channel_t chan;        
         float value;
         enum ap_var_type p_type;
         int16_t param_index;
@@ -954,9 +1019,11 @@ private:
         char param_name[AP_MAX_NAME_SIZE+1];
     };
 
-    // queue of pending parameter requests and replies
-    static ObjectBuffer<pending_param_request> param_requests;
-    static ObjectBuffer<pending_param_reply> param_replies;
+    // queue of pending parameter requests and replies for this
+    // link. Requests are pushed by the main thread and popped by the
+    // IO thread, replies the other way around, so neither needs a lock
+    ObjectBuffer<pending_param_request> param_requests{10};
+    ObjectBuffer<pending_param_reply> param_replies{5};
 
     // have we registered the IO timer callback?
     static bool param_timer_registered;
@@ -964,8 +1031,23 @@ private:
     // IO timer callback for parameters
     void param_io_timer(void);
 
+    // answer queued parameter requests for this link
+    void process_param_requests(void);
+
     uint8_t send_parameter_async_replies();
 
+    /*
+      number of PARAM_VALUE messages sent per call when streaming
+      parameters on a link without flow control. This grows while the
+      link drains each batch before the next one and shrinks when it
+      doesn't
+     */
+    static constexpr uint8_t PARAM_BATCH_MIN = 2;
+    static constexpr uint8_t PARAM_BATCH_MAX = 40;
+    uint8_t param_batch_limit = 5;
+    uint16_t param_txspace_after_send;
+    uint16_t param_last_batch_bytes;
+
 #if AP_MAVLINK_FTP_ENABLED
     enum class FTP_OP : uint8_t {
         None = 0,
@@ -1021,27 +1103,77 @@ private:
         Write,
     };
 
+    // an open file.  Sessions are identified by the session number
+    // chosen by the GCS along with the GCS's sysid and compid, so
+    // several GCSs may each have a file open
+    struct ftp_session {
+        int fd = -1;
+        int16_t id = -1;        // session number, -1 if this slot is free
+        uint8_t sysid;
+        uint8_t compid;
+        FTP_FILE_MODE mode;     // work around AP_Filesystem not supporting file modes
+        uint32_t last_send_ms;
+        uint32_t file_pos;      // position of fd
+
+        // file data read ahead of a read or burst read
+        uint8_t *readahead;
+        uint32_t readahead_offset;
+        uint16_t readahead_len;
+
+        // burst read in progress.  Packets are sent from ftp_worker
+        // between handling other requests
+        struct {
+            uint16_t remaining; // packets left to send, 0 if no burst is active
+            uint16_t seq_number;
+            uint32_t offset;    // file offset of the next packet
+            uint32_t end_offset; // offset just past the data sent by the last burst
+            uint8_t max_read;
+            mavlink_channel_t chan;
+            uint32_t interval_us; // gap between packets on links without flow control
+            uint32_t last_send_us;
+            uint8_t bw_percent; // share of the link used on links without flow control
+        } burst;
+    };
+
     struct ftp_state {
         ObjectBuffer<pending_ftp> *requests;
 
-        // session specific info, currently only support a single session over all links
-        int fd = -1;
-        FTP_FILE_MODE mode; // work around AP_Filesystem not supporting file modes
-        int16_t current_session;
+        ftp_session sessions[AP_MAVLINK_FTP_MAX_SESSIONS];
         uint32_t last_send_ms;
         uint8_t need_banner_send_mask;
+
+        FTPStats stats;
+        uint32_t stats_window_start_ms;
+        uint32_t stats_window_bytes;
     };
     static struct ftp_state ftp;
 
     static void ftp_error(struct pending_ftp &response, FTP_ERROR error); // FTP helper method for packing a NAK
+    static void ftp_error_data(uint8_t *data, uint8_t &size, FTP_ERROR error);
     static int gen_dir_entry(char *dest, size_t space, const char * path, const struct dirent * entry); // FTP helper for emitting a dir response
     static void ftp_list_dir(struct pending_ftp &request, struct pending_ftp &response);
 
     bool ftp_init(void);
     void handle_file_transfer_protocol(const mavlink_message_t &msg);
+    static bool ftp_link_txbuf_ok(mavlink_channel_t reply_chan);
     bool send_ftp_reply(const pending_ftp &reply);
     void ftp_worker(void);
     void ftp_push_replies(pending_ftp &reply);
+
+    // session management
+    static ftp_session *ftp_find_session(const pending_ftp &request);
+    static ftp_session *ftp_open_session(const pending_ftp &request, uint32_t now_ms);
+    static void ftp_close_session(ftp_session &session);
+
+    // read file data at offset, through the session's read-ahead buffer
+    static ssize_t ftp_read(ftp_session &session, uint32_t offset, uint8_t *data, uint8_t len);
+
+    // burst reads
+    void ftp_start_burst(ftp_session &session, const pending_ftp &request);
+    uint32_t ftp_service_bursts(void);
+    bool ftp_send_burst_packet(ftp_session &session);
+
+    static void ftp_count_sent(uint8_t data_bytes);
 #endif  // AP_MAVLINK_FTP_ENABLED
 
     void send_distance_sensor(const class AP_RangeFinder_Backend *sensor, const uint8_t instance) const;
@@ -1244,6 +1376,11 @@ public:
     void update_send();
     void update_receive();
 
+#if HAL_LOGGING_ENABLED
+    // record the learned MAVLink routes to the logger
+    void log_routes();
+#endif
+
     // minimum amount of time (in microseconds) that must remain in
     // the main scheduler loop before we are allowed to send any
     // mavlink messages.  We want to prioritise the main flight
@@ -1377,6 +1514,11 @@ private:
     // time we last saw traffic from our GCS
     uint32_t _sysid_gcs_last_seen_time_ms;
 
+#if HAL_LOGGING_ENABLED
+    // time we last logged the MAVLink routes
+    uint32_t last_routes_logged_ms;
+#endif
+
     void service_statustext(void);
 #if HAL_MEM_CLASS <= HAL_MEM_CLASS_192 || CONFIG_HAL_BOARD == HAL_BOARD_SITL
     static const uint8_t _status_capacity = 7;
@@ -891,6 +891,20 @@ bool GCS_MAVLINK::last_txbuf_is_greater(uint8_t txbuf_limit)
     return last_radio_status.txbuf > txbuf_limit;
 }
 
+bool GCS_MAVLINK::txbuf_is_greater(uint8_t txbuf_limit) const
+{
+#if AP_MAVLINK_STREAM_SCHEDULER_ENABLED
+    if (AP_HAL::millis() - link_model.radio_txbuf_ms > 5000) {
+        // stale report
+        return true;
+    }
+    return link_model.radio_txbuf > txbuf_limit;
+#else
+    // no per-link record of RADIO_STATUS is kept
+    return last_txbuf_is_greater(txbuf_limit);
+#endif
+}
+
 void GCS_MAVLINK::handle_radio_status(const mavlink_message_t &msg)
 {
     mavlink_radio_t packet;
@@ -908,6 +922,10 @@ void GCS_MAVLINK::handle_radio_status(const mavlink_message_t &msg)
     }
 
     last_radio_status.txbuf = packet.txbuf;
+#if AP_MAVLINK_STREAM_SCHEDULER_ENABLED
+    link_model.radio_txbuf = packet.txbuf;
+    link_model.radio_txbuf_ms = now;
+#endif
 
     // use the state of the transmit buffer in the radio to
     // control the stream rate, giving us adaptive software
@@ -1265,6 +1283,184 @@ uint16_t GCS_MAVLINK::get_reschedule_interval_ms(const deferred_message_bucket_t
     return interval_ms;
 }
 
+#if AP_MAVLINK_STREAM_SCHEDULER_ENABLED
+/*
+  priority of a streamed message when the link is short of bandwidth.
+  Messages a GCS needs to fly the vehicle are high priority;
+  messages mostly of interest when tuning or debugging are low
+ */
+GCS_MAVLINK::MessagePriority GCS_MAVLINK::ap_message_priority(ap_message id) const
+{
+    switch (id) {
+    case MSG_HEARTBEAT:
+#if AP_AHRS_ENABLED
+    case MSG_ATTITUDE:
+    case MSG_ATTITUDE_QUATERNION:
+    case MSG_LOCATION:
+    case MSG_VFR_HUD:
+#endif
+    case MSG_SYS_STATUS:
+    case MSG_EXTENDED_SYS_STATE:
+    case MSG_GPS_RAW:
+    case MSG_BATTERY_STATUS:
+    case MSG_CURRENT_WAYPOINT:
+    case MSG_MISSION_ITEM_REACHED:
+    case MSG_NAV_CONTROLLER_OUTPUT:
+    case MSG_HOME:
+    case MSG_ORIGIN:
+    case MSG_FENCE_STATUS:
+    case MSG_ADSB_VEHICLE:
+    case MSG_NEXT_PARAM:
+    case MSG_HIGH_LATENCY2:
+        return MessagePriority::HIGH;
+
+#if AP_AHRS_ENABLED
+    case MSG_AHRS:
+    case MSG_AHRS2:
+#endif
+    case MSG_MEMINFO:
+    case MSG_SERVO_OUTPUT_RAW:
+    case MSG_RC_CHANNELS_RAW:
+    case MSG_RAW_IMU:
+    case MSG_SCALED_IMU:
+    case MSG_SCALED_IMU2:
+    case MSG_SCALED_IMU3:
+    case MSG_SCALED_PRESSURE2:
+    case MSG_SCALED_PRESSURE3:
+    case MSG_SIMSTATE:
+    case MSG_SIM_STATE:
+    case MSG_HWSTATUS:
+    case MSG_PID_TUNING:
+    case MSG_VIBRATION:
+    case MSG_RPM:
+    case MSG_ESC_TELEMETRY:
+    case MSG_MCU_STATUS:
+    case MSG_NAMED_FLOAT:
+#if AP_MAVLINK_MSG_HIGHRES_IMU_ENABLED
+    case MSG_HIGHRES_IMU:
+#endif
+        return MessagePriority::LOW;
+
+    default:
+        return MessagePriority::NORMAL;
+    }
+}
+
+/*
+  a burst of this many bytes may be sent without waiting for tokens
+ */
+float GCS_MAVLINK::link_model_burst_bytes() const
+{
+    return MAX(link_model.bytes_per_second * 0.2f, 2.0f * MAVLINK_MAX_PACKET_LEN);
+}
+
+/*
+  update the estimate of the link throughput from the space freed in
+  the port's transmit buffer since the last update, then add tokens
+  for the time elapsed
+ */
+void GCS_MAVLINK::update_link_model(uint32_t now_ms)
+{
+    const uint16_t space = txspace();
+    if (space > link_model.txspace_max) {
+        link_model.txspace_max = space;
+    }
+    const float nominal_bps = MAX(_port->bw_in_bytes_per_second(), 1U);
+
+    const uint32_t dt_ms = now_ms - link_model.last_update_ms;
+    if (link_model.last_update_ms == 0 || dt_ms > 1000) {
+        // first call or we haven't been called for a while; start
+        // again from the nominal rate of the port
+        if (link_model.last_update_ms == 0) {
+            link_model.bytes_per_second = nominal_bps;
+        }
+        link_model.last_update_ms = now_ms;
+        link_model.tokens = link_model_burst_bytes();
+        return;
+    }
+    if (dt_ms == 0) {
+        return;
+    }
+    link_model.last_update_ms = now_ms;
+
+    const uint16_t drained = space > link_model.txspace_at_last_update ? space - link_model.txspace_at_last_update : 0;
+    const float sample_bps = drained * 1000.0f / dt_ms;
+    if (space < link_model.txspace_max) {
+        // data is still queued so the port has been sending as fast
+        // as the link allows
+        link_model.bytes_per_second += (sample_bps - link_model.bytes_per_second) * 0.1f;
+    } else {
+        // the buffer emptied so the link can do at least this much;
+        // drift back towards the nominal rate
+        link_model.bytes_per_second = MAX(link_model.bytes_per_second, sample_bps);
+        link_model.bytes_per_second += (nominal_bps - link_model.bytes_per_second) * 0.02f;
+    }
+    link_model.bytes_per_second = constrain_float(link_model.bytes_per_second, nominal_bps * 0.05f, nominal_bps);
+
+    // a radio which reports its buffer filling is sending slower
+    // than we are feeding it
+    float fill_bps = link_model.bytes_per_second;
+    if (now_ms - link_model.radio_txbuf_ms < 5000 && link_model.radio_txbuf < 50) {
+        fill_bps *= link_model.radio_txbuf * 0.02f;
+    }
+    link_model.tokens = MIN(link_model.tokens + fill_bps * dt_ms * 0.001f, link_model_burst_bytes());
+}
+
+/*
+  return true if there is enough bandwidth to send a streamed message
+  given its priority
+ */
+bool GCS_MAVLINK::stream_message_allowed(ap_message id) const
+{
+    switch (ap_message_priority(id)) {
+    case MessagePriority::HIGH:
+        return true;
+    case MessagePriority::NORMAL:
+        return link_model.tokens > 0;
+    case MessagePriority::LOW:
+        return link_model.tokens > link_model_burst_bytes() * 0.5f;
+    }
+    return true;
+}
+
+/*
+  age the per-message send counts so rates reflect recent behaviour
+ */
+void GCS_MAVLINK::update_stream_stats(uint32_t now_ms)
+{
+    if (stream_stats.start_ms == 0) {
+        stream_stats.start_ms = now_ms;
+        return;
+    }
+    const uint32_t elapsed_ms = now_ms - stream_stats.start_ms;
+    if (elapsed_ms < STREAM_STATS_PERIOD_MS) {
+        return;
+    }
+#if HAL_LOGGING_ENABLED
+    if (is_active() || is_streaming()) {
+        log_stream_rates();
+    }
+#endif
+    for (uint8_t i=0; i<MSG_LAST; i++) {
+        stream_stats.sent[i] /= 2;
+        stream_stats.skipped[i] /= 2;
+    }
+    stream_stats.start_ms = now_ms - elapsed_ms / 2;
+}
+
+bool GCS_MAVLINK::get_stream_rates(ap_message id, float &requested_hz, float &achieved_hz) const
+{
+    uint16_t interval_ms;
+    if (id >= MSG_LAST || !get_ap_message_interval(id, interval_ms) || interval_ms == 0) {
+        return false;
+    }
+    requested_hz = 1000.0f / interval_ms;
+    const uint32_t elapsed_ms = AP_HAL::millis() - stream_stats.start_ms;
+    achieved_hz = (stream_stats.start_ms == 0 || elapsed_ms == 0) ? 0 : stream_stats.sent[id] * 1000.0f / elapsed_ms;
+    return true;
+}
+#endif  // AP_MAVLINK_STREAM_SCHEDULER_ENABLED
+
 // typical runtime on fmuv3: 5 microseconds for 3 buckets
 void GCS_MAVLINK::find_next_bucket_to_send(uint16_t now16_ms)
 {
@@ -1348,6 +1544,9 @@ bool GCS_MAVLINK::do_try_send_message(const ap_message id)
         return false;
     }
     WITH_SEMAPHORE(comm_chan_lock(chan));
+#if AP_MAVLINK_STREAM_SCHEDULER_ENABLED
+    const uint16_t space_before_send = txspace();
+#endif
 #if GCS_DEBUG_SEND_MESSAGE_TIMINGS
     void *data = hal.scheduler->disable_interrupts_save();
     uint32_t start_send_message_us = AP_HAL::micros();
@@ -1367,6 +1566,16 @@ bool GCS_MAVLINK::do_try_send_message(const ap_message id)
         try_send_message_stats.longest_time_us = delta_us;
         try_send_message_stats.longest_id = id;
     }
+#endif
+#if AP_MAVLINK_STREAM_SCHEDULER_ENABLED
+    // everything we send uses the link, whatever its priority
+    const uint16_t space_after_send = txspace();
+    if (space_after_send < space_before_send) {
+        link_model.tokens = MAX(link_model.tokens - (space_before_send - space_after_send), -link_model_burst_bytes());
+    }
+    if (stream_stats.sent[id] < UINT16_MAX) {
+        stream_stats.sent[id]++;
+    }
 #endif
     return true;
 }
@@ -1574,6 +1783,10 @@ void GCS_MAVLINK::update_send()
 
     const uint32_t start = AP_HAL::millis();
     const uint16_t start16 = start & 0xFFFF;
+#if AP_MAVLINK_STREAM_SCHEDULER_ENABLED
+    update_link_model(start);
+    update_stream_stats(start);
+#endif
     while (AP_HAL::millis() - start < 5) { // spend a max of 5ms sending messages.  This should never trigger - out_of_time() should become true
         if (gcs().out_of_time()) {
 #if GCS_DEBUG_SEND_MESSAGE_TIMINGS
@@ -1636,7 +1849,17 @@ void GCS_MAVLINK::update_send()
 
         ap_message next = next_deferred_bucket_message_to_send(start16);
         if (next != no_message_to_send) {
-            if (!do_try_send_message(next)) {
+            bool skip = false;
+#if AP_MAVLINK_STREAM_SCHEDULER_ENABLED
+            // not enough bandwidth for a message of this priority;
+            // skip it this time around rather than holding up the
+            // rest of the bucket
+            skip = !stream_message_allowed(next);
+            if (skip && stream_stats.skipped[next] < UINT16_MAX) {
+                stream_stats.skipped[next]++;
+            }
+#endif
+            if (!skip && !do_try_send_message(next)) {
                 break;
             }
             bucket_message_ids_to_send.clear(next);
@@ -1678,6 +1901,10 @@ void GCS_MAVLINK::update_send()
     // between the last pass through here
     send_packet_count += uint8_t(_channel_status.current_tx_seq - last_tx_seq);
     last_tx_seq = _channel_status.current_tx_seq;
+
+#if AP_MAVLINK_STREAM_SCHEDULER_ENABLED
+    link_model.txspace_at_last_update = txspace();
+#endif
 }
 
 void GCS_MAVLINK::remove_message_from_bucket(int8_t bucket, ap_message id)
@@ -2109,7 +2336,34 @@ void GCS_MAVLINK::log_mavlink_stats()
 
     AP::logger().WriteBlock(&pkt, sizeof(pkt));
 }
-#endif
+
+#if AP_MAVLINK_STREAM_SCHEDULER_ENABLED
+/*
+  record requested and achieved rates of each streamed message
+*/
+void GCS_MAVLINK::log_stream_rates()
+{
+    const uint64_t now_us = AP_HAL::micros64();
+    for (uint8_t i=0; i<MSG_LAST; i++) {
+        float requested_hz, achieved_hz;
+        if (!get_stream_rates((ap_message)i, requested_hz, achieved_hz)) {
+            continue;
+        }
+        const struct log_MAVR pkt{
+            LOG_PACKET_HEADER_INIT(LOG_MAVR_MSG),
+            time_us      : now_us,
+            chan         : (uint8_t)chan,
+            id           : i,
+            requested_hz : requested_hz,
+            achieved_hz  : achieved_hz,
+            skipped      : stream_stats.skipped[i],
+            link_bw      : (uint16_t)MIN(link_model.bytes_per_second, UINT16_MAX),
+        };
+        AP::logger().WriteBlock(&pkt, sizeof(pkt));
+    }
+}
+#endif  // AP_MAVLINK_STREAM_SCHEDULER_ENABLED
+#endif  // HAL_LOGGING_ENABLED
 
 /*
   send the SYSTEM_TIME message
@@ -2767,7 +3021,45 @@ void GCS::update_receive(void)
     }
     // also update UART pass-thru, if enabled
     update_passthru();
+
+#if HAL_LOGGING_ENABLED
+    const uint32_t now_ms = AP_HAL::millis();
+    if (now_ms - last_routes_logged_ms > 10000) {
+        last_routes_logged_ms = now_ms;
+        log_routes();
+    }
+#endif
+}
+
+#if HAL_LOGGING_ENABLED
+/*
+  record each learned route with the time since it was last heard
+  from and the number of messages forwarded along it
+*/
+void GCS::log_routes()
+{
+    const MAVLink_routing &routing = GCS_MAVLINK::routing;
+    const uint64_t now_us = AP_HAL::micros64();
+    for (uint8_t i=0; i<routing.get_num_routes(); i++) {
+        uint8_t sysid, compid;
+        mavlink_channel_t channel;
+        uint32_t age_ms, forward_count;
+        if (!routing.get_route(i, sysid, compid, channel, age_ms, forward_count)) {
+            continue;
+        }
+        const struct log_MAVT pkt{
+            LOG_PACKET_HEADER_INIT(LOG_MAVT_MSG),
+            time_us       : now_us,
+            sysid         : sysid,
+            compid        : compid,
+            chan          : (uint8_t)channel,
+            age_ms        : age_ms,
+            forward_count : forward_count,
+        };
+        AP::logger().WriteBlock(&pkt, sizeof(pkt));
+    }
 }
+#endif  // HAL_LOGGING_ENABLED
 
 void GCS::send_mission_item_reached_message(uint16_t mission_index)
 {
@@ -26,6 +26,7 @@
 #include <AP_Filesystem/AP_Filesystem.h>
 #include <AP_HAL/utility/sparse-endian.h>
 #include <AP_BoardConfig/AP_BoardConfig.h>
+#include <AP_Logger/AP_Logger.h>
 
 extern const AP_HAL::HAL& hal;
 
@@ -34,6 +35,18 @@ struct GCS_MAVLINK::ftp_state GCS_MAVLINK::ftp;
 // timeout for session inactivity
 #define FTP_SESSION_TIMEOUT 3000
 
+// number of packets sent in response to a burst read request. This
+// is enough for a full parameter file with max parameters
+#define FTP_BURST_TRANSFER_SIZE 500
+
+// limits on the share of link bandwidth used by burst reads on links
+// without flow control.  The share starts at 1/3, grows with each
+// burst the GCS receives in full and halves when it has to re-request
+// data
+#define FTP_BURST_BW_PERCENT_MIN 10
+#define FTP_BURST_BW_PERCENT_INITIAL 33
+#define FTP_BURST_BW_PERCENT_MAX 90
+
 bool GCS_MAVLINK::ftp_init(void) {
 
     // check if ftp is disabled for memory savings
@@ -48,13 +61,13 @@ bool GCS_MAVLINK::ftp_init(void) {
         return true;
     }
 
-    ftp.requests = NEW_NOTHROW ObjectBuffer<pending_ftp>(5);
+    ftp.requests = NEW_NOTHROW ObjectBuffer<pending_ftp>(4 + AP_MAVLINK_FTP_MAX_SESSIONS);
     if (ftp.requests == nullptr || ftp.requests->get_size() == 0) {
         goto failed;
     }
 
     if (!hal.scheduler->thread_create(FUNCTOR_BIND_MEMBER(&GCS_MAVLINK::ftp_worker, void),
-                                      "FTP", 2560, AP_HAL::Scheduler::PRIORITY_IO, 0)) {
+                                      "FTP", 3072, AP_HAL::Scheduler::PRIORITY_IO, 0)) {
         goto failed;
     }
 
@@ -95,13 +108,23 @@ void GCS_MAVLINK::handle_file_transfer_protocol(const mavlink_message_t &msg) {
     }
 }
 
+/*
+  check the radio on the link a reply goes out on has room for it
+ */
+bool GCS_MAVLINK::ftp_link_txbuf_ok(mavlink_channel_t reply_chan)
+{
+    const GCS_MAVLINK *link = gcs().chan(reply_chan);
+    // It helps avoid GCS timeout if this is less than the threshold where we slow down normal streams (<=49)
+    return link != nullptr && link->txbuf_is_greater(33);
+}
+
 bool GCS_MAVLINK::send_ftp_reply(const pending_ftp &reply)
 {
-    if (!last_txbuf_is_greater(33)) { // It helps avoid GCS timeout if this is less than the threshold where we slow down normal streams (<=49)
+    if (!ftp_link_txbuf_ok(reply.chan)) {
         return false;
     }
     WITH_SEMAPHORE(comm_chan_lock(reply.chan));
-    if (!HAVE_PAYLOAD_SPACE(chan, FILE_TRANSFER_PROTOCOL)) {
+    if (!HAVE_PAYLOAD_SPACE(reply.chan, FILE_TRANSFER_PROTOCOL)) {
         return false;
     }
     uint8_t payload[251] = {};
@@ -122,22 +145,27 @@ bool GCS_MAVLINK::send_ftp_reply(const pending_ftp &reply)
 
 void GCS_MAVLINK::ftp_error(struct pending_ftp &response, FTP_ERROR error) {
     response.opcode = FTP_OP::Nack;
-    response.data[0] = static_cast<uint8_t>(error);
-    response.size = 1;
+    ftp_error_data(response.data, response.size, error);
+}
+
+// pack the data of a NAK
+void GCS_MAVLINK::ftp_error_data(uint8_t *data, uint8_t &size, FTP_ERROR error) {
+    data[0] = static_cast<uint8_t>(error);
+    size = 1;
 
     // FIXME: errno's are not thread-local as they should be on ChibiOS
     if (error == FTP_ERROR::FailErrno) {
         // translate the errno's that we have useful messages for
         switch (errno) {
             case EEXIST:
-                response.data[0] = static_cast<uint8_t>(FTP_ERROR::FileExists);
+                data[0] = static_cast<uint8_t>(FTP_ERROR::FileExists);
                 break;
             case ENOENT:
-                response.data[0] = static_cast<uint8_t>(FTP_ERROR::FileNotFound);
+                data[0] = static_cast<uint8_t>(FTP_ERROR::FileNotFound);
                 break;
             default:
-                response.data[1] = static_cast<uint8_t>(errno);
-                response.size = 2;
+                data[1] = static_cast<uint8_t>(errno);
+                size = 2;
                 break;
         }
     }
@@ -163,8 +191,321 @@ void GCS_MAVLINK::ftp_push_replies(pending_ftp &reply)
     */
     if (ftp.need_banner_send_mask & (1U<<reply.chan)) {
         ftp.need_banner_send_mask &= ~(1U<<reply.chan);
-        send_banner();
+        GCS_MAVLINK *link = gcs().chan(reply.chan);
+        if (link != nullptr) {
+            link->send_banner();
+        }
+    }
+}
+
+/*
+  update the throughput counters after sending a reply carrying
+  data_bytes of file data
+ */
+void GCS_MAVLINK::ftp_count_sent(uint8_t data_bytes)
+{
+    ftp.stats.packets_sent++;
+    ftp.stats.bytes_sent += data_bytes;
+    ftp.stats_window_bytes += data_bytes;
+
+    const uint32_t now_ms = AP_HAL::millis();
+    const uint32_t dt_ms = now_ms - ftp.stats_window_start_ms;
+    if (dt_ms >= 1000) {
+        ftp.stats.bytes_per_second = ftp.stats_window_bytes * 1000ULL / dt_ms;
+        ftp.stats_window_bytes = 0;
+        ftp.stats_window_start_ms = now_ms;
+#if HAL_LOGGING_ENABLED
+        // @LoggerMessage: FTP
+        // @Description: MAVLink file transfer throughput
+        // @Field: TimeUS: Time since system startup
+        // @Field: Rate: file data sent over the last second
+        // @Field: Bytes: total file data sent
+        // @Field: Pkts: total replies sent
+        // @Field: Burst: total replies sent as part of burst reads
+        // @Field: ReReq: total reads of data already sent in a burst
+        AP::logger().Write("FTP", "TimeUS,Rate,Bytes,Pkts,Burst,ReReq", "s-b---", "F-0---", "QIIIII",
+                           AP_HAL::micros64(),
+                           ftp.stats.bytes_per_second,
+                           ftp.stats.bytes_sent,
+                           ftp.stats.packets_sent,
+                           ftp.stats.burst_packets,
+                           ftp.stats.rerequests);
+#endif
+    }
+}
+
+/*
+  find the open session a request refers to
+ */
+GCS_MAVLINK::ftp_session *GCS_MAVLINK::ftp_find_session(const pending_ftp &request)
+{
+    for (auto &session : ftp.sessions) {
+        if (session.id == request.session &&
+            session.sysid == request.sysid &&
+            session.compid == request.compid) {
+            return &session;
+        }
+    }
+    return nullptr;
+}
+
+void GCS_MAVLINK::ftp_close_session(ftp_session &session)
+{
+    if (session.fd != -1) {
+        AP::FS().close(session.fd);
+        session.fd = -1;
+    }
+    delete[] session.readahead;
+    session.readahead = nullptr;
+    session.readahead_len = 0;
+    session.burst.remaining = 0;
+    session.id = -1;
+}
+
+/*
+  allocate a session for a request to open a file, closing sessions
+  which have been idle for longer than the timeout if needed.
+  Returns nullptr if no session is available
+ */
+GCS_MAVLINK::ftp_session *GCS_MAVLINK::ftp_open_session(const pending_ftp &request, uint32_t now_ms)
+{
+    ftp_session *session = ftp_find_session(request);
+    if (session != nullptr) {
+        // only allow one file to be open per session
+        if (now_ms - session->last_send_ms <= FTP_SESSION_TIMEOUT) {
+            return nullptr;
+        }
+        // no activity for 3s, assume client has timed out receiving
+        // open reply, close the file
+        ftp_close_session(*session);
+        return session;
+    }
+    for (auto &s : ftp.sessions) {
+        if (s.id == -1) {
+            return &s;
+        }
+    }
+    for (auto &s : ftp.sessions) {
+        if (now_ms - s.last_send_ms >= FTP_SESSION_TIMEOUT) {
+            // the old session has been idle for more than the
+            // timeout so force close it
+            ftp_close_session(s);
+            return &s;
+        }
+    }
+    return nullptr;
+}
+
+/*
+  read up to len bytes of the file at offset.  Sequential reads are
+  served from the session's read-ahead buffer so the filesystem sees
+  a few large reads rather than one small read per packet
+ */
+ssize_t GCS_MAVLINK::ftp_read(ftp_session &session, uint32_t offset, uint8_t *data, uint8_t len)
+{
+    if (session.readahead != nullptr) {
+        // a read may span two blocks, so a short read only happens at
+        // the end of the file
+        uint8_t total = 0;
+        while (total < len) {
+            const uint32_t ofs = offset + total;
+            if (ofs < session.readahead_offset ||
+                ofs >= session.readahead_offset + session.readahead_len) {
+                // refill the buffer from the block holding ofs.
+                // Keeping every read the same size and aligned
+                // matters for @PARAM files, which place pad bytes
+                // relative to the read size
+                const uint32_t block_offset = ofs - (ofs % AP_MAVLINK_FTP_READAHEAD_SIZE);
+                session.readahead_len = 0;
+                if (session.file_pos != block_offset) {
+                    if (AP::FS().lseek(session.fd, block_offset, SEEK_SET) == -1) {
+                        return -1;
+                    }
+                    session.file_pos = block_offset;
+                }
+                const ssize_t read_bytes = AP::FS().read(session.fd, session.readahead, AP_MAVLINK_FTP_READAHEAD_SIZE);
+                if (read_bytes == -1) {
+                    return -1;
+                }
+                session.file_pos += read_bytes;
+                session.readahead_offset = block_offset;
+                session.readahead_len = read_bytes;
+                if (ofs >= session.readahead_offset + session.readahead_len) {
+                    // end of the file
+                    break;
+                }
+            }
+            const uint32_t available = session.readahead_offset + session.readahead_len - ofs;
+            const uint8_t n = MIN(uint32_t(len - total), available);
+            memcpy(&data[total], &session.readahead[ofs - session.readahead_offset], n);
+            total += n;
+        }
+        return total;
+    }
+
+    if (session.file_pos != offset) {
+        if (AP::FS().lseek(session.fd, offset, SEEK_SET) == -1) {
+            return -1;
+        }
+        session.file_pos = offset;
+    }
+    const ssize_t read_bytes = AP::FS().read(session.fd, data, len);
+    if (read_bytes > 0) {
+        session.file_pos += read_bytes;
+    }
+    return read_bytes;
+}
+
+/*
+  start sending a burst of packets in response to a burst read
+  request.  A new request replaces any burst still in progress
+ */
+void GCS_MAVLINK::ftp_start_burst(ftp_session &session, const pending_ftp &request)
+{
+    auto &burst = session.burst;
+
+    if (burst.bw_percent == 0) {
+        burst.bw_percent = FTP_BURST_BW_PERCENT_INITIAL;
+    } else if (request.offset < burst.end_offset) {
+        // the GCS is asking again for data we have sent; assume we
+        // were sending too fast for the link
+        ftp.stats.rerequests++;
+        burst.bw_percent = MAX(burst.bw_percent / 2, FTP_BURST_BW_PERCENT_MIN);
+    } else if (request.offset == burst.end_offset) {
+        // the last burst arrived intact
+        burst.bw_percent = MIN(burst.bw_percent + 10, FTP_BURST_BW_PERCENT_MAX);
+    }
+
+    burst.max_read = (request.size == 0 || request.size > sizeof(request.data)) ? sizeof(request.data) : request.size;
+    burst.remaining = FTP_BURST_TRANSFER_SIZE;
+    burst.seq_number = request.seq_number + 1;
+    burst.offset = request.offset;
+    burst.end_offset = request.offset;
+    burst.chan = request.chan;
+
+    /*
+      calculate a burst delay so that FTP burst transfer doesn't use
+      more than its share of available bandwidth on links that don't
+      have flow control. This reduces the chance of lost packets a
+      lot, which results in overall faster transfers
+     */
+    burst.interval_us = 0;
+    if (valid_channel(request.chan)) {
+        auto *port = mavlink_comm_port[request.chan];
+        if (port != nullptr && port->get_flow_control() != AP_HAL::UARTDriver::FLOW_CONTROL_ENABLE) {
+            const uint32_t bw = MAX(port->bw_in_bytes_per_second(), 1U);
+            const uint16_t pkt_size = PAYLOAD_SIZE(request.chan, FILE_TRANSFER_PROTOCOL) - (sizeof(request.data) - burst.max_read);
+            burst.interval_us = uint64_t(pkt_size) * 100000000ULL / (uint64_t(bw) * burst.bw_percent);
+        }
+    }
+    burst.last_send_us = AP_HAL::micros() - burst.interval_us;
+}
+
+/*
+  send the next packet of a burst read.  The file data goes straight
+  into the outgoing payload.  Returns false if the link has no room
+  for it yet
+ */
+bool GCS_MAVLINK::ftp_send_burst_packet(ftp_session &session)
+{
+    auto &burst = session.burst;
+    const mavlink_channel_t reply_chan = burst.chan;
+
+    // check for space before reading so we don't hold the channel
+    // lock over filesystem access.  We check again under the lock
+    if (!ftp_link_txbuf_ok(reply_chan) ||
+        comm_get_txspace(reply_chan) < PAYLOAD_SIZE(reply_chan, FILE_TRANSFER_PROTOCOL)) {
+        return false;
+    }
+
+    uint8_t payload[251] {};
+    ssize_t read_bytes = ftp_read(session, burst.offset, &payload[12], burst.max_read);
+
+    FTP_OP opcode = FTP_OP::Ack;
+    uint8_t size;
+    bool complete;
+    if (read_bytes > 0) {
+        size = read_bytes;
+        complete = (read_bytes < burst.max_read) || (burst.remaining == 1);
+    } else {
+        // end of the file or a read error; NACK at the offset the
+        // data ran out
+        opcode = FTP_OP::Nack;
+        ftp_error_data(&payload[12], size, read_bytes == 0 ? FTP_ERROR::EndOfFile : FTP_ERROR::FailErrno);
+        complete = true;
+        read_bytes = 0;
+    }
+
+    {
+        WITH_SEMAPHORE(comm_chan_lock(reply_chan));
+        if (!HAVE_PAYLOAD_SPACE(reply_chan, FILE_TRANSFER_PROTOCOL)) {
+            return false;
+        }
+        put_le16_ptr(payload, burst.seq_number);
+        payload[2] = session.id;
+        payload[3] = static_cast<uint8_t>(opcode);
+        payload[4] = size;
+        payload[5] = static_cast<uint8_t>(FTP_OP::BurstReadFile);
+        payload[6] = complete ? 1 : 0;
+        put_le32_ptr(&payload[8], burst.offset);
+        mavlink_msg_file_transfer_protocol_send(
+            reply_chan,
+            0, session.sysid, session.compid,
+            payload);
+    }
+
+    const uint32_t now_ms = AP_HAL::millis();
+    ftp.last_send_ms = now_ms;
+    session.last_send_ms = now_ms;
+    ftp.stats.burst_packets++;
+    ftp_count_sent(read_bytes);
+
+    burst.seq_number++;
+    burst.offset += read_bytes;
+    burst.end_offset = burst.offset;
+    if (complete) {
+        burst.remaining = 0;
+    } else {
+        burst.remaining--;
+    }
+    return true;
+}
+
+/*
+  send the next packet of each burst read which is due.  Returns the
+  number of microseconds until another packet is due, or UINT32_MAX
+  if there are no burst reads in progress
+ */
+uint32_t GCS_MAVLINK::ftp_service_bursts(void)
+{
+    uint32_t wait_us = UINT32_MAX;
+    for (auto &session : ftp.sessions) {
+        auto &burst = session.burst;
+        if (session.id == -1 || burst.remaining == 0) {
+            continue;
+        }
+        const uint32_t now_us = AP_HAL::micros();
+        const uint32_t since_us = now_us - burst.last_send_us;
+        if (since_us < burst.interval_us) {
+            wait_us = MIN(wait_us, burst.interval_us - since_us);
+            continue;
+        }
+        if (!ftp_send_burst_packet(session)) {
+            // no room on the link, try again shortly
+            wait_us = MIN(wait_us, 1000U);
+            continue;
+        }
+        // keep the packets on a regular clock, but don't try to catch
+        // up after a stall
+        burst.last_send_us += burst.interval_us;
+        if (now_us - burst.last_send_us > burst.interval_us) {
+            burst.last_send_us = now_us;
+        }
+        if (burst.remaining != 0) {
+            wait_us = MIN(wait_us, burst.interval_us);
+        }
     }
+    return wait_us;
 }
 
 void GCS_MAVLINK::ftp_worker(void) {
@@ -175,9 +516,18 @@ void GCS_MAVLINK::ftp_worker(void) {
     while (true) {
         bool skip_push_reply = false;
 
-        while (ftp.requests == nullptr || !ftp.requests->pop(request)) {
+        // burst reads are sent a packet at a time between requests so
+        // several sessions can make progress at once
+        const uint32_t burst_wait_us = ftp_service_bursts();
+
+        if (ftp.requests == nullptr || !ftp.requests->pop(request)) {
             // nothing to handle, delay ourselves a bit then check again. Ideally we'd use conditional waits here
-            hal.scheduler->delay(2);
+            if (burst_wait_us >= 2000) {
+                hal.scheduler->delay(2);
+            } else if (burst_wait_us > 0) {
+                hal.scheduler->delay_microseconds(burst_wait_us);
+            }
+            continue;
         }
 
         // if it's a rerequest and we still have the last response then send it
@@ -205,381 +555,327 @@ void GCS_MAVLINK::ftp_worker(void) {
 
         uint32_t now = AP_HAL::millis();
 
-        // check for session termination
-        if (request.session != ftp.current_session &&
-            (request.opcode == FTP_OP::TerminateSession || request.opcode == FTP_OP::ResetSessions)) {
-            // terminating a different session, just ack
-            reply.opcode = FTP_OP::Ack;
-        } else if (ftp.fd != -1 && request.session != ftp.current_session &&
-                   now - ftp.last_send_ms < FTP_SESSION_TIMEOUT) {
-            // if we have an open file and the session isn't right
-            // then reject. This prevents IO on the wrong file
-            ftp_error(reply, FTP_ERROR::InvalidSession);
-        } else {
-            if (ftp.fd != -1 &&
-                request.session != ftp.current_session &&
-                now - ftp.last_send_ms >= FTP_SESSION_TIMEOUT) {
-                // if a new session appears and the old session has
-                // been idle for more than the timeout then force
-                // close the old session
-                AP::FS().close(ftp.fd);
-                ftp.fd = -1;
-                ftp.current_session = -1;
-            }
-            // dispatch the command as needed
-            switch (request.opcode) {
-                case FTP_OP::None:
-                    reply.opcode = FTP_OP::Ack;
-                    break;
-                case FTP_OP::TerminateSession:
-                case FTP_OP::ResetSessions:
-                    // we already handled this, just listed for completeness
-                    if (ftp.fd != -1) {
-                        AP::FS().close(ftp.fd);
-                        ftp.fd = -1;
-                    }
-                    ftp.current_session = -1;
-                    reply.opcode = FTP_OP::Ack;
-                    break;
-                case FTP_OP::ListDirectory:
-                    ftp_list_dir(request, reply);
-                    break;
-                case FTP_OP::OpenFileRO:
-                    {
-                        // only allow one file to be open per session
-                        if (ftp.fd != -1 && now - ftp.last_send_ms > FTP_SESSION_TIMEOUT) {
-                            // no activity for 3s, assume client has
-                            // timed out receiving open reply, close
-                            // the file
-                            AP::FS().close(ftp.fd);
-                            ftp.fd = -1;
-                            ftp.current_session = -1;
-                        }
-                        if (ftp.fd != -1) {
-                            ftp_error(reply, FTP_ERROR::Fail);
-                            break;
-                        }
-
-                        // sanity check that our the request looks well formed
-                        const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
-                        if ((file_name_len != request.size) || (request.size == 0)) {
-                            ftp_error(reply, FTP_ERROR::InvalidDataSize);
-                            break;
-                        }
-
-                        request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
+        ftp_session *session = ftp_find_session(request);
 
-                        // get the file size
-                        struct stat st;
-                        if (AP::FS().stat((char *)request.data, &st)) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
-                        const size_t file_size = st.st_size;
-
-                        // actually open the file
-                        ftp.fd = AP::FS().open((char *)request.data, O_RDONLY);
-                        if (ftp.fd == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
-                        ftp.mode = FTP_FILE_MODE::Read;
-                        ftp.current_session = request.session;
+        // dispatch the command as needed
+        switch (request.opcode) {
+            case FTP_OP::None:
+                reply.opcode = FTP_OP::Ack;
+                break;
+            case FTP_OP::TerminateSession:
+                if (session != nullptr) {
+                    ftp_close_session(*session);
+                }
+                reply.opcode = FTP_OP::Ack;
+                break;
+            case FTP_OP::ResetSessions:
+                // close every session belonging to this GCS
+                for (auto &s : ftp.sessions) {
+                    if (s.id != -1 && s.sysid == request.sysid && s.compid == request.compid) {
+                        ftp_close_session(s);
+                    }
+                }
+                reply.opcode = FTP_OP::Ack;
+                break;
+            case FTP_OP::ListDirectory:
+                ftp_list_dir(request, reply);
+                break;
+            case FTP_OP::OpenFileRO:
+                {
+                    // sanity check that our the request looks well formed
+                    const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
+                    if ((file_name_len != request.size) || (request.size == 0)) {
+                        ftp_error(reply, FTP_ERROR::InvalidDataSize);
+                        break;
+                    }
 
-                        reply.opcode = FTP_OP::Ack;
-                        reply.size = sizeof(uint32_t);
-                        put_le32_ptr(reply.data, (uint32_t)file_size);
+                    request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
 
-                        // provide compatibility with old protocol banner download
-                        if (strncmp((const char *)request.data, "@PARAM/param.pck", 16) == 0) {
-                            ftp.need_banner_send_mask |= 1U<<reply.chan;
-                        }
+                    session = ftp_open_session(request, now);
+                    if (session == nullptr) {
+                        ftp_error(reply, FTP_ERROR::Fail);
                         break;
                     }
-                case FTP_OP::ReadFile:
-                    {
-                        // must actually be working on a file
-                        if (ftp.fd == -1) {
-                            ftp_error(reply, FTP_ERROR::FileNotFound);
-                            break;
-                        }
 
-                        // must have the file in read mode
-                        if ((ftp.mode != FTP_FILE_MODE::Read)) {
-                            ftp_error(reply, FTP_ERROR::Fail);
-                            break;
-                        }
+                    // get the file size
+                    struct stat st;
+                    if (AP::FS().stat((char *)request.data, &st)) {
+                        ftp_error(reply, FTP_ERROR::FailErrno);
+                        break;
+                    }
+                    const size_t file_size = st.st_size;
 
-                        // seek to requested offset
-                        if (AP::FS().lseek(ftp.fd, request.offset, SEEK_SET) == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
+                    // actually open the file
+                    session->fd = AP::FS().open((char *)request.data, O_RDONLY);
+                    if (session->fd == -1) {
+                        ftp_error(reply, FTP_ERROR::FailErrno);
+                        break;
+                    }
+                    session->id = request.session;
+                    session->sysid = request.sysid;
+                    session->compid = request.compid;
+                    session->mode = FTP_FILE_MODE::Read;
+                    session->file_pos = 0;
+                    session->last_send_ms = now;
+                    session->burst.remaining = 0;
+                    session->burst.end_offset = 0;
+#if AP_MAVLINK_FTP_READAHEAD_SIZE > 0
+                    // without a read-ahead buffer we read straight into each reply
+                    session->readahead = NEW_NOTHROW uint8_t[AP_MAVLINK_FTP_READAHEAD_SIZE];
+                    session->readahead_len = 0;
+#endif
 
-                        // fill the buffer
-                        const ssize_t read_bytes = AP::FS().read(ftp.fd, reply.data, MIN(sizeof(reply.data),request.size));
-                        if (read_bytes == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
-                        if (read_bytes == 0) {
-                            ftp_error(reply, FTP_ERROR::EndOfFile);
-                            break;
-                        }
+                    reply.opcode = FTP_OP::Ack;
+                    reply.size = sizeof(uint32_t);
+                    put_le32_ptr(reply.data, (uint32_t)file_size);
 
-                        reply.opcode = FTP_OP::Ack;
-                        reply.offset = request.offset;
-                        reply.size = (uint8_t)read_bytes;
-                        break;
+                    // provide compatibility with old protocol banner download
+                    if (strncmp((const char *)request.data, "@PARAM/param.pck", 16) == 0) {
+                        ftp.need_banner_send_mask |= 1U<<reply.chan;
                     }
-                case FTP_OP::Ack:
-                case FTP_OP::Nack:
-                    // eat these, we just didn't expect them
-                    continue;
                     break;
-                case FTP_OP::OpenFileWO:
-                case FTP_OP::CreateFile:
-                    {
-                        // only allow one file to be open per session
-                        if (ftp.fd != -1) {
-                            ftp_error(reply, FTP_ERROR::Fail);
-                            break;
-                        }
-
-                        // sanity check that our the request looks well formed
-                        const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
-                        if ((file_name_len != request.size) || (request.size == 0)) {
-                            ftp_error(reply, FTP_ERROR::InvalidDataSize);
-                            break;
-                        }
+                }
+            case FTP_OP::ReadFile:
+                {
+                    // must actually be working on a file
+                    if (session == nullptr) {
+                        ftp_error(reply, FTP_ERROR::FileNotFound);
+                        break;
+                    }
 
-                        request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
+                    // must have the file in read mode
+                    if ((session->mode != FTP_FILE_MODE::Read)) {
+                        ftp_error(reply, FTP_ERROR::Fail);
+                        break;
+                    }
 
-                        // actually open the file
-                        ftp.fd = AP::FS().open((char *)request.data,
-                                               (request.opcode == FTP_OP::CreateFile) ? O_WRONLY|O_CREAT|O_TRUNC : O_WRONLY);
-                        if (ftp.fd == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
-                        ftp.mode = FTP_FILE_MODE::Write;
-                        ftp.current_session = request.session;
+                    if (request.offset < session->burst.end_offset) {
+                        // filling in a gap left by a burst read
+                        ftp.stats.rerequests++;
+                    }
 
-                        reply.opcode = FTP_OP::Ack;
+                    // fill the buffer
+                    const ssize_t read_bytes = ftp_read(*session, request.offset, reply.data, MIN(sizeof(reply.data),request.size));
+                    if (read_bytes == -1) {
+                        ftp_error(reply, FTP_ERROR::FailErrno);
+                        break;
+                    }
+                    if (read_bytes == 0) {
+                        ftp_error(reply, FTP_ERROR::EndOfFile);
                         break;
                     }
-                case FTP_OP::WriteFile:
-                    {
-                        // must actually be working on a file
-                        if (ftp.fd == -1) {
-                            ftp_error(reply, FTP_ERROR::FileNotFound);
-                            break;
-                        }
-
-                        // must have the file in write mode
-                        if ((ftp.mode != FTP_FILE_MODE::Write)) {
-                            ftp_error(reply, FTP_ERROR::Fail);
-                            break;
-                        }
 
-                        // seek to requested offset
-                        if (AP::FS().lseek(ftp.fd, request.offset, SEEK_SET) == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
+                    reply.opcode = FTP_OP::Ack;
+                    reply.offset = request.offset;
+                    reply.size = (uint8_t)read_bytes;
+                    break;
+                }
+            case FTP_OP::Ack:
+            case FTP_OP::Nack:
+                // eat these, we just didn't expect them
+                continue;
+                break;
+            case FTP_OP::OpenFileWO:
+            case FTP_OP::CreateFile:
+                {
+                    // sanity check that our the request looks well formed
+                    const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
+                    if ((file_name_len != request.size) || (request.size == 0)) {
+                        ftp_error(reply, FTP_ERROR::InvalidDataSize);
+                        break;
+                    }
 
-                        // fill the buffer
-                        const ssize_t write_bytes = AP::FS().write(ftp.fd, request.data, request.size);
-                        if (write_bytes == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
+                    request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
 
-                        reply.opcode = FTP_OP::Ack;
-                        reply.offset = request.offset;
+                    // only allow one file to be open per session
+                    session = ftp_open_session(request, now);
+                    if (session == nullptr) {
+                        ftp_error(reply, FTP_ERROR::Fail);
                         break;
                     }
-                case FTP_OP::CreateDirectory:
-                    {
-                        // sanity check that our the request looks well formed
-                        const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
-                        if ((file_name_len != request.size) || (request.size == 0)) {
-                            ftp_error(reply, FTP_ERROR::InvalidDataSize);
-                            break;
-                        }
-
-                        request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
 
-                        // actually make the directory
-                        if (AP::FS().mkdir((char *)request.data) == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
+                    // actually open the file
+                    session->fd = AP::FS().open((char *)request.data,
+                                                (request.opcode == FTP_OP::CreateFile) ? O_WRONLY|O_CREAT|O_TRUNC : O_WRONLY);
+                    if (session->fd == -1) {
+                        ftp_error(reply, FTP_ERROR::FailErrno);
+                        break;
+                    }
+                    session->id = request.session;
+                    session->sysid = request.sysid;
+                    session->compid = request.compid;
+                    session->mode = FTP_FILE_MODE::Write;
+                    session->file_pos = 0;
+                    session->last_send_ms = now;
+                    session->burst.remaining = 0;
 
-                        reply.opcode = FTP_OP::Ack;
+                    reply.opcode = FTP_OP::Ack;
+                    break;
+                }
+            case FTP_OP::WriteFile:
+                {
+                    // must actually be working on a file
+                    if (session == nullptr) {
+                        ftp_error(reply, FTP_ERROR::FileNotFound);
                         break;
                     }
-                case FTP_OP::RemoveDirectory:
-                case FTP_OP::RemoveFile:
-                    {
-                        // sanity check that our the request looks well formed
-                        const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
-                        if ((file_name_len != request.size) || (request.size == 0)) {
-                            ftp_error(reply, FTP_ERROR::InvalidDataSize);
-                            break;
-                        }
 
-                        request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
+                    // must have the file in write mode
+                    if ((session->mode != FTP_FILE_MODE::Write)) {
+                        ftp_error(reply, FTP_ERROR::Fail);
+                        break;
+                    }
 
-                        // remove the file/dir
-                        if (AP::FS().unlink((char *)request.data) == -1) {
+                    // seek to requested offset
+                    if (session->file_pos != request.offset) {
+                        if (AP::FS().lseek(session->fd, request.offset, SEEK_SET) == -1) {
                             ftp_error(reply, FTP_ERROR::FailErrno);
                             break;
                         }
+                        session->file_pos = request.offset;
+                    }
 
-                        reply.opcode = FTP_OP::Ack;
+                    // fill the buffer
+                    const ssize_t write_bytes = AP::FS().write(session->fd, request.data, request.size);
+                    if (write_bytes == -1) {
+                        ftp_error(reply, FTP_ERROR::FailErrno);
                         break;
                     }
-                case FTP_OP::CalcFileCRC32:
-                    {
-                        // sanity check that our the request looks well formed
-                        const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
-                        if ((file_name_len != request.size) || (request.size == 0)) {
-                            ftp_error(reply, FTP_ERROR::InvalidDataSize);
-                            break;
-                        }
-
-                        request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
-
-                        uint32_t checksum = 0;
-                        if (!AP::FS().crc32((char *)request.data, checksum)) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
+                    session->file_pos += write_bytes;
 
-                        // reset our scratch area so we don't leak data, and can leverage trimming
-                        memset(reply.data, 0, sizeof(reply.data));
-                        reply.size = sizeof(uint32_t);
-                        put_le32_ptr(reply.data, checksum);
-                        reply.opcode = FTP_OP::Ack;
+                    reply.opcode = FTP_OP::Ack;
+                    reply.offset = request.offset;
+                    break;
+                }
+            case FTP_OP::CreateDirectory:
+                {
+                    // sanity check that our the request looks well formed
+                    const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
+                    if ((file_name_len != request.size) || (request.size == 0)) {
+                        ftp_error(reply, FTP_ERROR::InvalidDataSize);
                         break;
                     }
-                case FTP_OP::BurstReadFile:
-                    {
-                        const uint16_t max_read = (request.size == 0?sizeof(reply.data):request.size);
-                        // must actually be working on a file
-                        if (ftp.fd == -1) {
-                            ftp_error(reply, FTP_ERROR::FileNotFound);
-                            break;
-                        }
 
-                        // must have the file in read mode
-                        if ((ftp.mode != FTP_FILE_MODE::Read)) {
-                            ftp_error(reply, FTP_ERROR::Fail);
-                            break;
-                        }
+                    request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
 
-                        // seek to requested offset
-                        if (AP::FS().lseek(ftp.fd, request.offset, SEEK_SET) == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
+                    // actually make the directory
+                    if (AP::FS().mkdir((char *)request.data) == -1) {
+                        ftp_error(reply, FTP_ERROR::FailErrno);
+                        break;
+                    }
 
-                        /*
-                          calculate a burst delay so that FTP burst
-                          transfer doesn't use more than 1/3 of
-                          available bandwidth on links that don't have
-                          flow control. This reduces the chance of
-                          lost packets a lot, which results in overall
-                          faster transfers
-                         */
-                        uint32_t burst_delay_ms = 0;
-                        if (valid_channel(request.chan)) {
-                            auto *port = mavlink_comm_port[request.chan];
-                            if (port != nullptr && port->get_flow_control() != AP_HAL::UARTDriver::FLOW_CONTROL_ENABLE) {
-                                const uint32_t bw = port->bw_in_bytes_per_second();
-                                const uint16_t pkt_size = PAYLOAD_SIZE(request.chan, FILE_TRANSFER_PROTOCOL) - (sizeof(reply.data) - max_read);
-                                burst_delay_ms = 3000 * pkt_size / bw;
-                            }
-                        }
+                    reply.opcode = FTP_OP::Ack;
+                    break;
+                }
+            case FTP_OP::RemoveDirectory:
+            case FTP_OP::RemoveFile:
+                {
+                    // sanity check that our the request looks well formed
+                    const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
+                    if ((file_name_len != request.size) || (request.size == 0)) {
+                        ftp_error(reply, FTP_ERROR::InvalidDataSize);
+                        break;
+                    }
 
-                        // this transfer size is enough for a full parameter file with max parameters
-                        const uint32_t transfer_size = 500;
-                        for (uint32_t i = 0; (i < transfer_size); i++) {
-                            // fill the buffer
-                            const ssize_t read_bytes = AP::FS().read(ftp.fd, reply.data, MIN(sizeof(reply.data), max_read));
-                            if (read_bytes == -1) {
-                                ftp_error(reply, FTP_ERROR::FailErrno);
-                                break;
-                            }
-
-                            if (read_bytes != sizeof(reply.data)) {
-                                // don't send any old data
-                                memset(reply.data + read_bytes, 0, sizeof(reply.data) - read_bytes);
-                            }
-
-                            if (read_bytes == 0) {
-                                ftp_error(reply, FTP_ERROR::EndOfFile);
-                                break;
-                            }
-
-                            reply.opcode = FTP_OP::Ack;
-                            reply.offset = request.offset + i * max_read;
-                            reply.burst_complete = ((read_bytes < max_read) || (i == (transfer_size - 1)));
-                            reply.size = (uint8_t)read_bytes;
-
-                            ftp_push_replies(reply);
-
-                            if (read_bytes < max_read) {
-                                // ensure the NACK which we send next is at the right offset
-                                reply.offset += read_bytes;
-                            }
-
-                            // prep the reply to be used again
-                            reply.seq_number++;
-
-                            hal.scheduler->delay(burst_delay_ms);
-                        }
+                    request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
 
-                        if (reply.opcode != FTP_OP::Nack) {
-                            // prevent a duplicate packet send for
-                            // normal replies of burst reads
-                            skip_push_reply = true;
-                        }
+                    // remove the file/dir
+                    if (AP::FS().unlink((char *)request.data) == -1) {
+                        ftp_error(reply, FTP_ERROR::FailErrno);
                         break;
                     }
 
-                case FTP_OP::Rename: {
-                    // sanity check that the request looks well formed
-                    const char *filename1 = (char*)request.data;
-                    const size_t len1 = strnlen(filename1, sizeof(request.data)-2);
-                    const char *filename2 = (char*)&request.data[len1+1];
-                    const size_t len2 = strnlen(filename2, sizeof(request.data)-(len1+1));
-                    if (filename1[len1] != 0 || (len1+len2+1 != request.size) || (request.size == 0)) {
+                    reply.opcode = FTP_OP::Ack;
+                    break;
+                }
+            case FTP_OP::CalcFileCRC32:
+                {
+                    // sanity check that our the request looks well formed
+                    const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
+                    if ((file_name_len != request.size) || (request.size == 0)) {
                         ftp_error(reply, FTP_ERROR::InvalidDataSize);
                         break;
                     }
-                    request.data[sizeof(request.data) - 1] = 0; // ensure the 2nd path is null terminated
-                    // remove the file/dir
-                    if (AP::FS().rename(filename1, filename2) != 0) {
+
+                    request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
+
+                    uint32_t checksum = 0;
+                    if (!AP::FS().crc32((char *)request.data, checksum)) {
                         ftp_error(reply, FTP_ERROR::FailErrno);
                         break;
                     }
+
+                    // reset our scratch area so we don't leak data, and can leverage trimming
+                    memset(reply.data, 0, sizeof(reply.data));
+                    reply.size = sizeof(uint32_t);
+                    put_le32_ptr(reply.data, checksum);
                     reply.opcode = FTP_OP::Ack;
                     break;
                 }
+            case FTP_OP::BurstReadFile:
+                {
+                    // must actually be working on a file
+                    if (session == nullptr) {
+                        ftp_error(reply, FTP_ERROR::FileNotFound);
+                        break;
+                    }
 
-                case FTP_OP::TruncateFile:
-                default:
-                    // this was bad data, just nack it
-                    GCS_SEND_TEXT(MAV_SEVERITY_DEBUG, "Unsupported FTP: %d", static_cast<int>(request.opcode));
-                    ftp_error(reply, FTP_ERROR::Fail);
+                    // must have the file in read mode
+                    if ((session->mode != FTP_FILE_MODE::Read)) {
+                        ftp_error(reply, FTP_ERROR::Fail);
+                        break;
+                    }
+
+                    // the packets are sent by ftp_service_bursts()
+                    ftp_start_burst(*session, request);
+                    session->last_send_ms = now;
+                    ftp.last_send_ms = now;
+                    skip_push_reply = true;
+                    // nothing was sent, so a repeat of this request
+                    // restarts the burst rather than resending reply
+                    reply.session = -1;
+                    break;
+                }
+
+            case FTP_OP::Rename: {
+                // sanity check that the request looks well formed
+                const char *filename1 = (char*)request.data;
+                const size_t len1 = strnlen(filename1, sizeof(request.data)-2);
+                const char *filename2 = (char*)&request.data[len1+1];
+                const size_t len2 = strnlen(filename2, sizeof(request.data)-(len1+1));
+                if (filename1[len1] != 0 || (len1+len2+1 != request.size) || (request.size == 0)) {
+                    ftp_error(reply, FTP_ERROR::InvalidDataSize);
+                    break;
+                }
+                request.data[sizeof(request.data) - 1] = 0; // ensure the 2nd path is null terminated
+                // remove the file/dir
+                if (AP::FS().rename(filename1, filename2) != 0) {
+                    ftp_error(reply, FTP_ERROR::FailErrno);
                     break;
+                }
+                reply.opcode = FTP_OP::Ack;
+                break;
             }
+
+            case FTP_OP::TruncateFile:
+            default:
+                // this was bad data, just nack it
+                GCS_SEND_TEXT(MAV_SEVERITY_DEBUG, "Unsupported FTP: %d", static_cast<int>(request.opcode));
+                ftp_error(reply, FTP_ERROR::Fail);
+                break;
+        }
+
+        // a session which failed to open is released again
+        if (session != nullptr && session->fd == -1) {
+            ftp_close_session(*session);
         }
 
         if (!skip_push_reply) {
+            if (session != nullptr && session->id != -1) {
+                session->last_send_ms = now;
+            }
             ftp_push_replies(reply);
+            ftp_count_sent(reply.opcode == FTP_OP::Ack && reply.req_opcode == FTP_OP::ReadFile ? reply.size : 0);
         }
 
         continue;
@@ -27,10 +27,6 @@
 
 extern const AP_HAL::HAL& hal;
 
-// queue of pending parameter requests and replies
-ObjectBuffer<GCS_MAVLINK::pending_param_request> GCS_MAVLINK::param_requests(20);
-ObjectBuffer<GCS_MAVLINK::pending_param_reply> GCS_MAVLINK::param_replies(5);
-
 bool GCS_MAVLINK::param_timer_registered;
 
 /**
@@ -66,15 +62,32 @@ GCS_MAVLINK::queued_param_send()
     uint32_t count = bytes_allowed / size_for_one_param_value_msg;
 
     // when we don't have flow control we really need to keep the
-    // param download very slow, or it tends to stall
-    if (!have_flow_control() && count > 5) {
-        count = 5;
+    // param download slow, or it tends to stall. Adjust the batch
+    // size to what the link has shown it can drain
+    if (!have_flow_control()) {
+        const uint16_t space = txspace();
+        if (param_last_batch_bytes != 0) {
+            if (!last_txbuf_is_greater(33) || space < param_txspace_after_send) {
+                // the last batch hasn't drained, back off
+                param_batch_limit /= 2;
+                if (param_batch_limit < PARAM_BATCH_MIN) {
+                    param_batch_limit = PARAM_BATCH_MIN;
+                }
+            } else if (space >= param_txspace_after_send + param_last_batch_bytes &&
+                       param_batch_limit < PARAM_BATCH_MAX) {
+                param_batch_limit++;
+            }
+        }
+        if (count > param_batch_limit) {
+            count = param_batch_limit;
+        }
     }
     if (async_replies_sent_count >= count) {
         return;
     }
     count -= async_replies_sent_count;
 
+    uint16_t sent_count = 0;
     while (count && _queued_parameter != nullptr && last_txbuf_is_greater(33)) {
         char param_name[AP_MAX_NAME_SIZE];
         _queued_parameter->copy_name_token(_queued_parameter_token, param_name, sizeof(param_name), true);
@@ -89,6 +102,7 @@ GCS_MAVLINK::queued_param_send()
 
         _queued_parameter = AP_Param::next_scalar(&_queued_parameter_token, &_queued_parameter_type);
         _queued_parameter_index++;
+        sent_count++;
 
         if (AP_HAL::micros() - tstart > 1000) {
             // don't use more than 1ms sending blocks of parameters
@@ -97,6 +111,8 @@ GCS_MAVLINK::queued_param_send()
         count--;
     }
     _queued_parameter_send_time_ms = tnow;
+    param_last_batch_bytes = sent_count * size_for_one_param_value_msg;
+    param_txspace_after_send = txspace();
 }
 
 /*
@@ -220,6 +236,7 @@ void GCS_MAVLINK::handle_param_request_list(const mavlink_message_t &msg)
     _queued_parameter_index = 0;
     _queued_parameter_count = AP_Param::count_parameters();
     _queued_parameter_send_time_ms = AP_HAL::millis(); // avoid initial flooding
+    param_last_batch_bytes = 0;
 }
 
 void GCS_MAVLINK::handle_param_request_read(const mavlink_message_t &msg)
@@ -245,7 +262,6 @@ void GCS_MAVLINK::handle_param_request_read(const mavlink_message_t &msg)
     }
 
     struct pending_param_request req;
-    req.chan = chan;
     req.param_index = packet.param_index;
     memcpy(req.param_name, packet.param_id, MIN(sizeof(packet.param_id), sizeof(req.param_name)));
     req.param_name[AP_MAX_NAME_SIZE] = 0;
@@ -362,52 +378,58 @@ void GCS::send_parameter_value(const char *param_name, ap_var_type param_type, f
 
 
 /*
-  timer callback for async parameter requests
+  timer callback for async parameter requests. Each link has its own
+  request and reply queues so a slow link can't hold up replies on
+  the others
  */
 void GCS_MAVLINK::param_io_timer(void)
 {
-    struct pending_param_request req;
-
     // this is mostly a no-op, but doing this here means we won't
     // block the main thread counting parameters (~30ms on PH)
     AP_Param::count_parameters();
 
-    if (param_replies.space() == 0) {
-        // no room
-        return;
-    }
-    
-    if (!param_requests.pop(req)) {
-        // nothing to do
-        return;
+    for (uint8_t i=0; i<gcs().num_gcs(); i++) {
+        GCS_MAVLINK *c = gcs().chan(i);
+        if (c != nullptr) {
+            c->process_param_requests();
+        }
     }
+}
 
-    struct pending_param_reply reply;
-    AP_Param *vp;
+/*
+  answer queued parameter requests for this link while there is room
+  for the replies
+ */
+void GCS_MAVLINK::process_param_requests(void)
+{
+    struct pending_param_request req;
+    while (param_replies.space() != 0 && param_requests.pop(req)) {
+        struct pending_param_reply reply;
+        AP_Param *vp;
 
-    if (req.param_index != -1) {
-        AP_Param::ParamToken token {};
-        vp = AP_Param::find_by_index(req.param_index, &reply.p_type, &token);
-        if (vp == nullptr) {
-            return;
-        }
-        vp->copy_name_token(token, reply.param_name, AP_MAX_NAME_SIZE, true);
-    } else {
-        strncpy(reply.param_name, req.param_name, AP_MAX_NAME_SIZE+1);
-        vp = AP_Param::find(req.param_name, &reply.p_type);
-        if (vp == nullptr) {
-            return;
+        if (req.param_index != -1) {
+            AP_Param::ParamToken token {};
+            vp = AP_Param::find_by_index(req.param_index, &reply.p_type, &token);
+            if (vp == nullptr) {
+                continue;
+            }
+            vp->copy_name_token(token, reply.param_name, AP_MAX_NAME_SIZE, true);
+        } else {
+            strncpy(reply.param_name, req.param_name, AP_MAX_NAME_SIZE+1);
+            vp = AP_Param::find(req.param_name, &reply.p_type);
+            if (vp == nullptr) {
+                continue;
+            }
         }
-    }
 
-    reply.chan = req.chan;
-    reply.param_name[AP_MAX_NAME_SIZE] = 0;
-    reply.value = vp->cast_to_float(reply.p_type);
-    reply.param_index = req.param_index;
-    reply.count = AP_Param::count_parameters();
+        reply.param_name[AP_MAX_NAME_SIZE] = 0;
+        reply.value = vp->cast_to_float(reply.p_type);
+        reply.param_index = req.param_index;
+        reply.count = AP_Param::count_parameters();
 
-    // queue for transmission
-    param_replies.push(reply);
+        // queue for transmission
+        param_replies.push(reply);
+    }
 }
 
 /*
@@ -429,14 +451,14 @@ uint8_t GCS_MAVLINK::send_parameter_async_replies()
         */
         uint32_t saved_reserve_param_space_start_ms = reserve_param_space_start_ms;
         reserve_param_space_start_ms = 0; // bypass packet_overhead_chan reservation checking
-        if (!HAVE_PAYLOAD_SPACE(reply.chan, PARAM_VALUE)) {
+        if (!HAVE_PAYLOAD_SPACE(chan, PARAM_VALUE)) {
             reserve_param_space_start_ms = AP_HAL::millis();
             return async_replies_sent_count;
         }
         reserve_param_space_start_ms = saved_reserve_param_space_start_ms;
 
         mavlink_msg_param_value_send(
-            reply.chan,
+            chan,
             reply.param_name,
             reply.value,
             mav_param_type(reply.p_type),
@@ -136,3 +136,20 @@
 #ifndef AP_MAVLINK_SET_GPS_GLOBAL_ORIGIN_MESSAGE_ENABLED
 #define AP_MAVLINK_SET_GPS_GLOBAL_ORIGIN_MESSAGE_ENABLED (HAL_GCS_ENABLED && AP_AHRS_ENABLED)
 #endif  // AP_MAVLINK_SET_GPS_GLOBAL_ORIGIN_MESSAGE_ENABLED
+
+// share each link's bandwidth between streamed messages by priority,
+// using a throughput estimate made from txspace() and RADIO_STATUS
+#ifndef AP_MAVLINK_STREAM_SCHEDULER_ENABLED
+#define AP_MAVLINK_STREAM_SCHEDULER_ENABLED (HAL_GCS_ENABLED && HAL_MEM_CLASS >= HAL_MEM_CLASS_500)
+#endif
+
+// number of files MAVLink FTP clients may have open at once
+#ifndef AP_MAVLINK_FTP_MAX_SESSIONS
+#define AP_MAVLINK_FTP_MAX_SESSIONS ((HAL_MEM_CLASS >= HAL_MEM_CLASS_500) ? 4 : 1)
+#endif
+
+// size of the buffer each MAVLink FTP read session reads ahead into,
+// 0 to read straight into each reply
+#ifndef AP_MAVLINK_FTP_READAHEAD_SIZE
+#define AP_MAVLINK_FTP_READAHEAD_SIZE ((HAL_MEM_CLASS >= HAL_MEM_CLASS_500) ? 2048 : 0)
+#endif
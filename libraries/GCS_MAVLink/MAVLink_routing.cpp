@@ -33,7 +33,10 @@ extern const AP_HAL::HAL& hal;
 #define ROUTING_DEBUG 0
 
 // constructor
-MAVLink_routing::MAVLink_routing(void) : num_routes(0) {}
+MAVLink_routing::MAVLink_routing(void) : num_routes(0)
+{
+    memset(route_hash, ROUTE_NONE, sizeof(route_hash));
+}
 
 /*
   forward a MAVLink message to the right port. This also
@@ -171,43 +174,63 @@ bool MAVLink_routing::check_and_forward(GCS_MAVLINK &in_link, const mavlink_mess
         return true;
     }
 
-    // forward on any channels matching the targets
+    // forward on any channels matching the targets. The message is
+    // sent once per channel, but is counted against every matching
+    // route on that channel
     bool forwarded = false;
-    bool sent_to_chan[MAVLINK_COMM_NUM_BUFFERS];
-    memset(sent_to_chan, 0, sizeof(sent_to_chan));
-    for (uint8_t i=0; i<num_routes; i++) {
-
+    bool handled_chan[MAVLINK_COMM_NUM_BUFFERS] {};
+    bool sent_to_chan[MAVLINK_COMM_NUM_BUFFERS] {};
+    auto forward_to_route = [&](struct route &r) {
         // Skip if channel is private and the target system or component IDs do not match
-        GCS_MAVLINK *out_link = gcs().chan(routes[i].channel);
+        GCS_MAVLINK *out_link = gcs().chan(r.channel);
         if (out_link == nullptr) {
             // this is bad
-            continue;
+            return;
         }
         if (out_link->is_private() &&
-            (target_system != routes[i].sysid ||
-             target_component != routes[i].compid)) {
-            continue;
+            (target_system != r.sysid ||
+             target_component != r.compid)) {
+            return;
         }
 
-        if (broadcast_system || (target_system == routes[i].sysid &&
-                                 (broadcast_component || 
-                                  target_component == routes[i].compid ||
-                                  !match_system))) {
+        const bool route_matches = broadcast_system ||
+            (target_system == r.sysid &&
+             (broadcast_component ||
+              target_component == r.compid ||
+              !match_system));
+        if (!route_matches || &in_link == out_link) {
+            return;
+        }
 
-            if (&in_link != out_link && !sent_to_chan[routes[i].channel]) {
-                if (out_link->check_payload_size(msg.len)) {
+        if (!handled_chan[r.channel]) {
+            if (out_link->check_payload_size(msg.len)) {
 #if ROUTING_DEBUG
-                    ::printf("fwd msg %u from chan %u on chan %u sysid=%d compid=%d\n",
-                             msg.msgid,
-                             (unsigned)in_link.get_chan(),
-                             (unsigned)routes[i].channel,
-                             (int)target_system,
-                             (int)target_component);
+                ::printf("fwd msg %u from chan %u on chan %u sysid=%d compid=%d\n",
+                         msg.msgid,
+                         (unsigned)in_link.get_chan(),
+                         (unsigned)r.channel,
+                         (int)target_system,
+                         (int)target_component);
 #endif
-                    _mavlink_resend_uart(routes[i].channel, &msg);
-                }
-                sent_to_chan[routes[i].channel] = true;
-                forwarded = true;
+                _mavlink_resend_uart(r.channel, &msg);
+                sent_to_chan[r.channel] = true;
+            }
+            handled_chan[r.channel] = true;
+            forwarded = true;
+        }
+        if (sent_to_chan[r.channel]) {
+            r.forward_count++;
+        }
+    };
+    if (broadcast_system) {
+        for (uint8_t i=0; i<num_routes; i++) {
+            forward_to_route(routes[i]);
+        }
+    } else {
+        // only routes to the target system can match
+        for (uint8_t i=route_hash[route_hash_index(target_system)]; i!=ROUTE_NONE; i=routes[i].next) {
+            if (routes[i].sysid == target_system) {
+                forward_to_route(routes[i]);
             }
         }
     }
@@ -239,13 +262,15 @@ void MAVLink_routing::send_to_components(const char *pkt, const mavlink_msg_entr
     bool sent_to_chan[MAVLINK_COMM_NUM_BUFFERS] {};
 
     // check learned routes
-    for (uint8_t i=0; i<num_routes; i++) {
+    for (uint8_t i=route_hash[route_hash_index(mavlink_system.sysid)]; i!=ROUTE_NONE; i=routes[i].next) {
         if (routes[i].sysid != mavlink_system.sysid) {
             // our system ID hasn't been seen on this link
             continue;
         }
         if (sent_to_chan[routes[i].channel]) {
-            // we've already send it on this link
+            // we've already sent it on this link, which also reaches
+            // this component
+            routes[i].forward_count++;
             continue;
         }
         if (comm_get_txspace(routes[i].channel) <
@@ -273,6 +298,7 @@ void MAVLink_routing::send_to_components(const char *pkt, const mavlink_msg_entr
                                         MIN(entry->max_msg_len, pkt_len),
                                         entry->crc_extra);
         sent_to_chan[routes[i].channel] = true;
+        routes[i].forward_count++;
     }
 }
 
@@ -312,12 +338,72 @@ bool MAVLink_routing::find_by_mavtype_and_compid(uint8_t mavtype, uint8_t compid
     return false;
 }
 
+bool MAVLink_routing::get_route(uint8_t idx, uint8_t &sysid, uint8_t &compid, mavlink_channel_t &channel,
+                                uint32_t &age_ms, uint32_t &forward_count) const
+{
+    if (idx >= num_routes) {
+        return false;
+    }
+    sysid = routes[idx].sysid;
+    compid = routes[idx].compid;
+    channel = routes[idx].channel;
+    age_ms = AP_HAL::millis() - routes[idx].last_seen_ms;
+    forward_count = routes[idx].forward_count;
+    return true;
+}
+
+/*
+  remove a route from its hash chain
+*/
+void MAVLink_routing::unlink_route(uint8_t idx)
+{
+    uint8_t *p = &route_hash[route_hash_index(routes[idx].sysid)];
+    while (*p != ROUTE_NONE) {
+        if (*p == idx) {
+            *p = routes[idx].next;
+            return;
+        }
+        p = &routes[*p].next;
+    }
+}
+
+/*
+  find a slot for a new route. When the table is full the route which
+  has gone longest without a message is replaced, provided it has
+  expired
+*/
+uint8_t MAVLink_routing::allocate_route(uint32_t now_ms)
+{
+    if (num_routes < MAVLINK_MAX_ROUTES) {
+        return num_routes++;
+    }
+    uint8_t oldest = ROUTE_NONE;
+    uint32_t oldest_age_ms = 0;
+    for (uint8_t i=0; i<num_routes; i++) {
+        const uint32_t age_ms = now_ms - routes[i].last_seen_ms;
+        if (age_ms >= oldest_age_ms) {
+            oldest = i;
+            oldest_age_ms = age_ms;
+        }
+    }
+    if (oldest == ROUTE_NONE || oldest_age_ms < MAVLINK_ROUTE_EXPIRY_MS) {
+        return ROUTE_NONE;
+    }
+#if ROUTING_DEBUG
+    ::printf("expired route %u %u via %u\n",
+             (unsigned)routes[oldest].sysid,
+             (unsigned)routes[oldest].compid,
+             (unsigned)routes[oldest].channel);
+#endif
+    unlink_route(oldest);
+    return oldest;
+}
+
 /*
   see if the message is for a new route and learn it
 */
 void MAVLink_routing::learn_route(GCS_MAVLINK &in_link, const mavlink_message_t &msg)
 {
-    uint8_t i;
     if (msg.sysid == 0) {
         // don't learn routes to the broadcast system
         return;
@@ -335,24 +421,33 @@ void MAVLink_routing::learn_route(GCS_MAVLINK &in_link, const mavlink_message_t
         return;
     }
     const mavlink_channel_t in_channel = in_link.get_chan();
-    for (i=0; i<num_routes; i++) {
+    const uint32_t now_ms = AP_HAL::millis();
+    const uint8_t hash = route_hash_index(msg.sysid);
+    for (uint8_t i=route_hash[hash]; i!=ROUTE_NONE; i=routes[i].next) {
         if (routes[i].sysid == msg.sysid &&
             routes[i].compid == msg.compid &&
             routes[i].channel == in_channel) {
             if (routes[i].mavtype == 0 && msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
                 routes[i].mavtype = mavlink_msg_heartbeat_get_type(&msg);
             }
-            break;
+            routes[i].last_seen_ms = now_ms;
+            return;
         }
     }
-    if (i == num_routes && i<MAVLINK_MAX_ROUTES) {
+
+    const uint8_t i = allocate_route(now_ms);
+    if (i != ROUTE_NONE) {
         routes[i].sysid = msg.sysid;
         routes[i].compid = msg.compid;
         routes[i].channel = in_channel;
+        routes[i].mavtype = 0;
         if (msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
             routes[i].mavtype = mavlink_msg_heartbeat_get_type(&msg);
         }
-        num_routes++;
+        routes[i].last_seen_ms = now_ms;
+        routes[i].forward_count = 0;
+        routes[i].next = route_hash[hash];
+        route_hash[hash] = i;
 #if ROUTING_DEBUG
         ::printf("learned route %u %u via %u\n",
                  (unsigned)msg.sysid,
@@ -382,7 +477,7 @@ void MAVLink_routing::handle_heartbeat(GCS_MAVLINK &link, const mavlink_message_
     mask &= ~no_route_mask;
     
     // mask out channels that are known sources for this sysid/compid
-    for (uint8_t i=0; i<num_routes; i++) {
+    for (uint8_t i=route_hash[route_hash_index(msg.sysid)]; i!=ROUTE_NONE; i=routes[i].next) {
         if (routes[i].sysid == msg.sysid && routes[i].compid == msg.compid) {
             mask &= ~(1U<<((unsigned)(routes[i].channel-MAVLINK_COMM_0)));
         }
@@ -5,9 +5,21 @@
 #include <AP_Common/AP_Common.h>
 #include "GCS_MAVLink.h"
 
-// 20 routes should be enough for now. This may need to increase as
-// we make more extensive use of MAVLink forwarding
+// maximum number of sysid/compid/channel routes. Boards with more
+// memory allow for larger numbers of vehicles on a shared link
+#ifndef MAVLINK_MAX_ROUTES
+#if HAL_MEM_CLASS >= HAL_MEM_CLASS_500
+#define MAVLINK_MAX_ROUTES 100
+#else
 #define MAVLINK_MAX_ROUTES 20
+#endif
+#endif
+
+// a route not seen for this long may be replaced by a new one when
+// the table is full
+#ifndef MAVLINK_ROUTE_EXPIRY_MS
+#define MAVLINK_ROUTE_EXPIRY_MS 30000
+#endif
 
 /*
   object to handle MAVLink packet routing
@@ -49,16 +61,46 @@ public:
      */
     bool find_by_mavtype_and_compid(uint8_t mavtype, uint8_t compid, uint8_t &sysid, mavlink_channel_t &channel) const;
 
+    // number of routes learned
+    uint8_t get_num_routes() const { return num_routes; }
+
+    /*
+      retrieve a learned route, the time since a message was last
+      received on it and the number of messages forwarded to it
+      returns false if idx is out of range
+     */
+    bool get_route(uint8_t idx, uint8_t &sysid, uint8_t &compid, mavlink_channel_t &channel,
+                   uint32_t &age_ms, uint32_t &forward_count) const;
+
 private:
-    // a simple linear routing table. We don't expect to have a lot of
-    // routes, so a scalable structure isn't worthwhile yet.
+    // routes are held in an array and chained by sysid from a small
+    // hash table, so a packet for one system only needs to look at
+    // that system's routes
+    static_assert(MAVLINK_MAX_ROUTES < 255, "MAVLINK_MAX_ROUTES too large");
+    static const uint8_t ROUTE_NONE = 255;
+    static const uint8_t ROUTE_HASH_SIZE = 32;
     uint8_t num_routes;
     struct route {
         uint8_t sysid;
         uint8_t compid;
         mavlink_channel_t channel;
         uint8_t mavtype;
+        uint8_t next;               // next route with the same sysid hash, or ROUTE_NONE
+        uint32_t last_seen_ms;      // time a message was last received via this route
+        uint32_t forward_count;     // number of messages forwarded to this route
     } routes[MAVLINK_MAX_ROUTES];
+    uint8_t route_hash[ROUTE_HASH_SIZE];
+
+    static uint8_t route_hash_index(uint8_t sysid) {
+        return (sysid ^ (sysid >> 5)) & (ROUTE_HASH_SIZE - 1);
+    }
+
+    // find a slot for a new route, replacing an expired route if the
+    // table is full.  Returns ROUTE_NONE if there is no space
+    uint8_t allocate_route(uint32_t now_ms);
+
+    // remove a route from its hash chain
+    void unlink_route(uint8_t idx);
     
     // a channel mask to block routing as required
     uint8_t no_route_mask;
@@ -5,6 +5,7 @@
 #include "MissionItemProtocol.h"
 
 #include "GCS.h"
+#include <StorageManager/StorageManager.h>
 
 void MissionItemProtocol::init_send_requests(GCS_MAVLINK &_link,
                                              const mavlink_message_t &msg,
@@ -323,6 +324,8 @@ void MissionItemProtocol::handle_mission_item(const mavlink_message_t &msg, cons
 void MissionItemProtocol::transfer_is_complete(const GCS_MAVLINK &_link, const mavlink_message_t &msg)
 {
     const MAV_MISSION_RESULT result = complete(_link);
+    // make sure the upload is on storage before it is acknowledged
+    StorageManager::flush();
     send_mission_ack(_link, msg, result);
     free_upload_resources();
     receiving = false;
@@ -25,6 +25,7 @@
 #include <AP_Vehicle/AP_Vehicle_Type.h>
 #include <AP_BoardConfig/AP_BoardConfig.h>
 #include <AP_Filesystem/AP_Filesystem.h>
+#include <AP_Common/ExpandingString.h>
 #include <GCS_MAVLink/GCS.h>
 
 #include "StorageManager.h"
@@ -35,6 +36,20 @@ extern const AP_HAL::HAL& hal;
 
 bool StorageManager::last_io_failed;
 
+#if STORAGE_WRITEBACK_ENABLED
+StorageManager::WriteRange StorageManager::wb_ranges[STORAGE_WRITEBACK_NUM_RANGES];
+StorageManager::WriteBackStats StorageManager::wb_stats;
+uint32_t StorageManager::wb_last_write_ms;
+bool StorageManager::wb_io_registered;
+HAL_Semaphore StorageManager::wb_sem;
+
+// object used to register the write-back flush with the IO thread
+static StorageManager writeback_dummy;
+
+// unchanged gaps shorter than this don't split a flush into two writes
+#define STORAGE_WRITEBACK_MIN_GAP 8
+#endif
+
 /*
   the layouts below are carefully designed to ensure backwards
   compatibility with older firmwares
@@ -108,11 +123,258 @@ const StorageManager::StorageArea StorageManager::layout[STORAGE_NUM_AREAS] = {
  */
 void StorageManager::erase(void)
 {
+#if STORAGE_WRITEBACK_ENABLED
+    // discard pending writes, they must not land on erased storage
+    WITH_SEMAPHORE(wb_sem);
+    for (auto &r : wb_ranges) {
+        r.length = 0;
+    }
+#endif
     if (!hal.storage->erase()) {
         ::printf("StorageManager: erase failed\n");
     }
 }
 
+/*
+  read from storage by physical offset, including any writes that are
+  still pending
+ */
+void StorageManager::read_physical(uint16_t loc, uint8_t *dst, uint16_t n)
+{
+#if STORAGE_WRITEBACK_ENABLED
+    WITH_SEMAPHORE(wb_sem);
+#endif
+    hal.storage->read_block(dst, loc, n);
+#if STORAGE_WRITEBACK_ENABLED
+    for (const auto &r : wb_ranges) {
+        const uint16_t start = MAX(loc, r.start);
+        const uint32_t end = MIN(uint32_t(loc) + n, uint32_t(r.start) + r.length);
+        if (start < end) {
+            memcpy(&dst[start-loc], &r.data[start-r.start], end-start);
+        }
+    }
+#endif
+}
+
+/*
+  write to storage by physical offset. With write-back enabled the
+  data is held in a pending range until the range is flushed
+ */
+void StorageManager::write_physical(uint16_t loc, const uint8_t *src, uint16_t n)
+{
+#if !STORAGE_WRITEBACK_ENABLED
+    hal.storage->write_block(loc, src, n);
+#else
+    WITH_SEMAPHORE(wb_sem);
+
+    if (!wb_io_registered) {
+        wb_io_registered = true;
+        hal.scheduler->register_io_process(FUNCTOR_BIND((&writeback_dummy), &StorageManager::writeback_io, void));
+    }
+
+    const uint32_t now_ms = AP_HAL::millis();
+    wb_stats.write_calls++;
+    wb_stats.write_bytes += n;
+    wb_last_write_ms = now_ms;
+
+    while (n > 0) {
+        // extend or overwrite a range which has room for this offset
+        WriteRange *r = nullptr;
+        for (auto &wr : wb_ranges) {
+            if (wr.length != 0 &&
+                loc >= wr.start &&
+                loc <= wr.start + wr.length &&
+                loc < wr.start + STORAGE_WRITEBACK_RANGE_SIZE) {
+                r = &wr;
+                break;
+            }
+        }
+        if (r == nullptr) {
+            r = writeback_alloc(loc, now_ms);
+        }
+        const uint16_t count = MIN(n, uint16_t(r->start + STORAGE_WRITEBACK_RANGE_SIZE - loc));
+
+        // keep ranges disjoint so the newest data for an offset is
+        // only ever held in one place
+        writeback_flush_overlapping(loc, count, r);
+
+        memcpy(&r->data[loc - r->start], src, count);
+        r->length = MAX(r->length, uint16_t(loc + count - r->start));
+
+        loc += count;
+        src += count;
+        n -= count;
+    }
+
+    // a steady stream of writes never goes idle, so check the
+    // deadline here as well as from the IO thread
+    if (writeback_due(now_ms)) {
+        writeback_flush_all();
+    }
+#endif
+}
+
+#if STORAGE_WRITEBACK_ENABLED
+/*
+  get a free range starting at loc, flushing the oldest range if
+  they are all in use
+ */
+StorageManager::WriteRange *StorageManager::writeback_alloc(uint16_t loc, uint32_t now_ms)
+{
+    WriteRange *ret = nullptr;
+    for (auto &r : wb_ranges) {
+        if (r.length == 0) {
+            ret = &r;
+            break;
+        }
+        if (ret == nullptr || now_ms - r.dirty_ms > now_ms - ret->dirty_ms) {
+            ret = &r;
+        }
+    }
+    if (ret->length != 0) {
+        writeback_flush_range(*ret);
+    }
+    ret->start = loc;
+    ret->length = 0;
+    ret->dirty_ms = now_ms;
+    return ret;
+}
+
+/*
+  pass a pending range to hal.storage. Only the parts which differ
+  from what is already in storage are written, so unchanged storage
+  lines are not marked dirty
+ */
+void StorageManager::writeback_flush_range(WriteRange &r)
+{
+    int32_t run_start = -1;
+    uint16_t last_changed = 0;
+    uint16_t written = 0;
+
+    for (uint16_t ofs = 0; ofs < r.length; ) {
+        uint8_t current[32];
+        const uint16_t count = MIN(uint16_t(sizeof(current)), uint16_t(r.length - ofs));
+        hal.storage->read_block(current, r.start + ofs, count);
+        for (uint16_t i = 0; i < count; i++, ofs++) {
+            if (current[i] == r.data[ofs]) {
+                continue;
+            }
+            if (run_start >= 0 && ofs - last_changed > STORAGE_WRITEBACK_MIN_GAP) {
+                const uint16_t len = last_changed + 1 - run_start;
+                hal.storage->write_block(r.start + run_start, &r.data[run_start], len);
+                wb_stats.hal_writes++;
+                written += len;
+                run_start = -1;
+            }
+            if (run_start < 0) {
+                run_start = ofs;
+            }
+            last_changed = ofs;
+        }
+    }
+    if (run_start >= 0) {
+        const uint16_t len = last_changed + 1 - run_start;
+        hal.storage->write_block(r.start + run_start, &r.data[run_start], len);
+        wb_stats.hal_writes++;
+        written += len;
+    }
+
+    wb_stats.flushes++;
+    wb_stats.hal_bytes += written;
+    wb_stats.unchanged_bytes += r.length - written;
+    r.length = 0;
+}
+
+/*
+  flush any pending range other than keep which overlaps n bytes at loc
+ */
+void StorageManager::writeback_flush_overlapping(uint16_t loc, uint16_t n, const WriteRange *keep)
+{
+    for (auto &r : wb_ranges) {
+        if (&r != keep &&
+            r.length != 0 &&
+            uint32_t(r.start) + r.length > loc &&
+            uint32_t(loc) + n > r.start) {
+            writeback_flush_range(r);
+        }
+    }
+}
+
+void StorageManager::writeback_flush_all(void)
+{
+    for (auto &r : wb_ranges) {
+        if (r.length != 0) {
+            writeback_flush_range(r);
+        }
+    }
+}
+
+/*
+  return true if pending writes have been idle long enough, or the
+  oldest of them has waited long enough, to be flushed
+ */
+bool StorageManager::writeback_due(uint32_t now_ms)
+{
+    bool pending = false;
+    for (const auto &r : wb_ranges) {
+        if (r.length == 0) {
+            continue;
+        }
+        if (now_ms - r.dirty_ms >= STORAGE_WRITEBACK_DEADLINE_MS) {
+            return true;
+        }
+        pending = true;
+    }
+    return pending && now_ms - wb_last_write_ms >= STORAGE_WRITEBACK_IDLE_MS;
+}
+
+/*
+  called from the IO thread to flush on idle or deadline
+ */
+void StorageManager::writeback_io(void)
+{
+    WITH_SEMAPHORE(wb_sem);
+    if (writeback_due(AP_HAL::millis())) {
+        writeback_flush_all();
+    }
+}
+
+/*
+  write all pending writes to hal.storage
+ */
+void StorageManager::flush(void)
+{
+    WITH_SEMAPHORE(wb_sem);
+    writeback_flush_all();
+}
+
+void StorageManager::get_writeback_stats(WriteBackStats &stats)
+{
+    WITH_SEMAPHORE(wb_sem);
+    stats = wb_stats;
+}
+
+void StorageManager::reset_writeback_stats(void)
+{
+    WITH_SEMAPHORE(wb_sem);
+    wb_stats = {};
+}
+
+void StorageManager::writeback_info(ExpandingString &str)
+{
+    WriteBackStats stats;
+    get_writeback_stats(stats);
+    // a header to allow for machine parsers to determine format
+    str.printf("StorageV1\n");
+    str.printf("write_calls %u\n", unsigned(stats.write_calls));
+    str.printf("write_bytes %u\n", unsigned(stats.write_bytes));
+    str.printf("flushes %u\n", unsigned(stats.flushes));
+    str.printf("hal_writes %u\n", unsigned(stats.hal_writes));
+    str.printf("hal_bytes %u\n", unsigned(stats.hal_bytes));
+    str.printf("unchanged_bytes %u\n", unsigned(stats.unchanged_bytes));
+}
+#endif // STORAGE_WRITEBACK_ENABLED
+
 /*
   constructor for StorageAccess
  */
@@ -169,7 +431,7 @@ bool StorageAccess::read_block(void *data, uint16_t addr, size_t n) const
             // the data crosses a boundary between two areas
             count = length - addr;
         }
-        hal.storage->read_block(b, addr+offset, count);
+        StorageManager::read_physical(addr+offset, b, count);
         n -= count;
 
         if (n == 0) {
@@ -227,7 +489,7 @@ bool StorageAccess::write_block(uint16_t addr, const void *data, size_t n) const
             // the data crosses a boundary between two areas
             count = length - addr;
         }
-        hal.storage->write_block(addr+offset, b, count);
+        StorageManager::write_physical(addr+offset, b, count);
         n -= count;
 
         if (n == 0) {
@@ -45,6 +45,30 @@
 #error "Unsupported storage size"
 #endif
 
+/*
+  combine small writes in RAM before they are passed to hal.storage,
+  so that bursts of writes (mission, fence and parameter uploads)
+  touch each storage line once rather than once per write
+ */
+#ifndef STORAGE_WRITEBACK_ENABLED
+#define STORAGE_WRITEBACK_ENABLED (HAL_MEM_CLASS >= HAL_MEM_CLASS_300)
+#endif
+
+#if STORAGE_WRITEBACK_ENABLED
+// number and size of the pending write ranges
+#define STORAGE_WRITEBACK_NUM_RANGES 4
+#define STORAGE_WRITEBACK_RANGE_SIZE 256
+// flush when no write has arrived for this long
+#define STORAGE_WRITEBACK_IDLE_MS 50
+// flush when the oldest pending write is this old. Together with
+// the HAL's own delay before writing dirty lines this is how long a
+// write can be lost to a power failure, so writes which must be on
+// storage when they return, such as AP_Param::save_sync(), flush()
+#define STORAGE_WRITEBACK_DEADLINE_MS 500
+#endif
+
+class ExpandingString;
+
 /*
   The StorageManager holds the layout of non-volatile storage
  */
@@ -69,9 +93,61 @@ public:
         return last_io_failed;
     }
 
+#if STORAGE_WRITEBACK_ENABLED
+    // write all pending writes to hal.storage
+    static void flush(void);
+
+    /*
+      counters for measuring write amplification. write_calls and
+      write_bytes count requests from StorageAccess, hal_writes and
+      hal_bytes count what was passed on to hal.storage
+     */
+    struct WriteBackStats {
+        uint32_t write_calls;
+        uint32_t write_bytes;
+        uint32_t flushes;
+        uint32_t hal_writes;
+        uint32_t hal_bytes;
+        uint32_t unchanged_bytes;
+    };
+    static void get_writeback_stats(WriteBackStats &stats);
+    static void reset_writeback_stats(void);
+
+    // counters as text for @SYS/storage.txt
+    static void writeback_info(ExpandingString &str);
+#else
+    static void flush(void) {}
+#endif
+
 private:
     static bool last_io_failed;
 
+    // access to storage by physical offset
+    static void read_physical(uint16_t loc, uint8_t *dst, uint16_t n);
+    static void write_physical(uint16_t loc, const uint8_t *src, uint16_t n);
+
+#if STORAGE_WRITEBACK_ENABLED
+    struct WriteRange {
+        uint32_t dirty_ms;
+        uint16_t start;
+        // zero length marks a free range
+        uint16_t length;
+        uint8_t data[STORAGE_WRITEBACK_RANGE_SIZE];
+    };
+    static WriteRange wb_ranges[STORAGE_WRITEBACK_NUM_RANGES];
+    static WriteBackStats wb_stats;
+    static uint32_t wb_last_write_ms;
+    static bool wb_io_registered;
+    static HAL_Semaphore wb_sem;
+
+    static WriteRange *writeback_alloc(uint16_t loc, uint32_t now_ms);
+    static void writeback_flush_range(WriteRange &r);
+    static void writeback_flush_overlapping(uint16_t loc, uint16_t n, const WriteRange *keep);
+    static void writeback_flush_all(void);
+    static bool writeback_due(uint32_t now_ms);
+    void writeback_io(void);
+#endif
+
     struct StorageArea {
         StorageType type;
         uint16_t    offset;
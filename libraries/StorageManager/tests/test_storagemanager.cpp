@@ -0,0 +1,129 @@
+#include <AP_gtest.h>
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
+
+#include <StorageManager/StorageManager.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if STORAGE_WRITEBACK_ENABLED
+
+// size of a mission command in storage, as used by AP_Mission
+#define MISSION_COMMAND_SIZE 15
+
+/*
+  write a mission the way AP_Mission::write_cmd_to_storage() does,
+  with three small writes per command
+ */
+static uint16_t write_mission(const StorageAccess &storage, uint16_t num_cmds, uint8_t seed)
+{
+    const uint16_t n = MIN(num_cmds, (storage.size() - 4) / MISSION_COMMAND_SIZE);
+    for (uint16_t i=0; i<n; i++) {
+        const uint16_t pos = 4 + i * MISSION_COMMAND_SIZE;
+        uint8_t packed[12];
+        for (uint8_t j=0; j<sizeof(packed); j++) {
+            packed[j] = seed + i + j;
+        }
+        storage.write_byte(pos, 16);
+        storage.write_uint16(pos+1, seed + i);
+        storage.write_block(pos+3, packed, sizeof(packed));
+    }
+    return n;
+}
+
+static bool check_mission(const StorageAccess &storage, uint16_t n, uint8_t seed)
+{
+    for (uint16_t i=0; i<n; i++) {
+        const uint16_t pos = 4 + i * MISSION_COMMAND_SIZE;
+        uint8_t packed[12];
+        if (storage.read_byte(pos) != 16 ||
+            storage.read_uint16(pos+1) != uint16_t(seed + i) ||
+            !storage.read_block(packed, pos+3, sizeof(packed))) {
+            return false;
+        }
+        for (uint8_t j=0; j<sizeof(packed); j++) {
+            if (packed[j] != uint8_t(seed + i + j)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+TEST(StorageManager, MissionUploadFlushes)
+{
+    const StorageAccess storage(StorageManager::StorageMission);
+    StorageManager::flush();
+
+    // make sure every command differs from what is already stored
+    const uint8_t seed = storage.read_byte(5) + 1;
+
+    StorageManager::reset_writeback_stats();
+    const uint16_t n = write_mission(storage, 700, seed);
+    ASSERT_GT(n, 0);
+
+    // pending writes are visible to reads before they are flushed
+    EXPECT_TRUE(check_mission(storage, n, seed));
+
+    StorageManager::flush();
+    StorageManager::WriteBackStats stats;
+    StorageManager::get_writeback_stats(stats);
+
+    // without write-back each of these would be a write to hal.storage
+    EXPECT_EQ(stats.write_calls, 3U * n);
+    EXPECT_EQ(stats.write_bytes, uint32_t(n) * MISSION_COMMAND_SIZE);
+
+    // the writes don't overlap, so every byte is flushed exactly once
+    EXPECT_EQ(stats.hal_bytes + stats.unchanged_bytes, stats.write_bytes);
+    EXPECT_GE(stats.flushes, stats.write_bytes / STORAGE_WRITEBACK_RANGE_SIZE);
+    EXPECT_GT(stats.hal_writes, 0U);
+    EXPECT_LT(stats.hal_writes * 10, stats.write_calls);
+    EXPECT_LE(stats.hal_bytes, stats.write_bytes);
+    EXPECT_TRUE(check_mission(storage, n, seed));
+
+    // uploading the same mission again writes nothing
+    StorageManager::reset_writeback_stats();
+    write_mission(storage, 700, seed);
+    StorageManager::flush();
+    StorageManager::get_writeback_stats(stats);
+    EXPECT_EQ(stats.hal_writes, 0U);
+    EXPECT_EQ(stats.unchanged_bytes, stats.write_bytes);
+}
+
+TEST(StorageManager, WriteBackConsistent)
+{
+    const StorageAccess storage(StorageManager::StorageRally);
+    static uint8_t shadow[1024];
+    const uint16_t size = MIN(storage.size(), sizeof(shadow));
+    ASSERT_TRUE(storage.read_block(shadow, 0, size));
+
+    uint32_t r = 1234;
+    for (uint32_t i=0; i<20000; i++) {
+        r = r * 1103515245U + 12345U;
+        const uint16_t ofs = (r >> 8) % size;
+        const uint16_t len = MIN(1U + ((r >> 20) % 40U), unsigned(size - ofs));
+        uint8_t b[40];
+        if (i % 3 != 0) {
+            for (uint16_t j=0; j<len; j++) {
+                b[j] = i + j;
+            }
+            EXPECT_TRUE(storage.write_block(ofs, b, len));
+            memcpy(&shadow[ofs], b, len);
+        } else {
+            EXPECT_TRUE(storage.read_block(b, ofs, len));
+            EXPECT_EQ(memcmp(b, &shadow[ofs], len), 0);
+        }
+        if (i % 997 == 0) {
+            StorageManager::flush();
+        }
+    }
+
+    StorageManager::flush();
+    static uint8_t b[sizeof(shadow)];
+    ASSERT_TRUE(storage.read_block(b, 0, size));
+    EXPECT_EQ(memcmp(b, shadow, size), 0);
+}
+
+#endif // STORAGE_WRITEBACK_ENABLED
+
+AP_GTEST_MAIN()